@@ -358,6 +358,7 @@ enum SHT
   SHT_PREINIT_ARRAY = 16,
   SHT_GROUP = 17,
   SHT_SYMTAB_SHNDX = 18,
+  SHT_RELR = 19,
   SHT_LOOS = 0x60000000,
   SHT_HIOS = 0x6fffffff,
   SHT_LOPROC = 0x70000000,
@@ -370,6 +371,8 @@ enum SHT
   SHT_GNU_INCREMENTAL_SYMTAB = 0x6fff4701,
   SHT_GNU_INCREMENTAL_RELOCS = 0x6fff4702,
   SHT_GNU_INCREMENTAL_GOT_PLT = 0x6fff4703,
+  // Call graph profile written by LLVM.
+  SHT_LLVM_CALL_GRAPH_PROFILE = 0x6fff4c09,
   // Object attributes.
   SHT_GNU_ATTRIBUTES = 0x6ffffff5,
   // GNU style dynamic hash table.
@@ -727,6 +730,9 @@ enum DT
 
   DT_PREINIT_ARRAY = 32,
   DT_PREINIT_ARRAYSZ = 33,
+  DT_RELRSZ = 35,
+  DT_RELR = 36,
+  DT_RELRENT = 37,
   DT_LOOS = 0x6000000d,
   DT_HIOS = 0x6ffff000,
   DT_LOPROC = 0x70000000,
@@ -29,6 +29,7 @@
 #include "elfcpp.h"
 #include "dwarf.h"
 #include "parameters.h"
+#include "gold-threads.h"
 #include "reloc.h"
 #include "aarch64.h"
 #include "object.h"
@@ -1764,13 +1765,36 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
   typedef Erratum_stub<size, big_endian> The_erratum_stub;
   typedef typename The_stub_table::Erratum_stub_set_iter Erratum_stub_set_iter;
   typedef std::vector<The_stub_table*> Stub_table_list;
+  typedef typename AArch64_insn_utilities<big_endian>::Insntype Insntype;
   static const AArch64_address invalid_address =
       static_cast<AArch64_address>(-1);
 
+  // An erratum sequence found in a section.
+  struct Erratum_hit
+  {
+    Erratum_hit(int a_type, section_size_type an_insn_offset,
+		Insntype an_insn, section_size_type an_adrp_offset)
+      : type(a_type), insn_offset(an_insn_offset), insn(an_insn),
+	adrp_offset(an_adrp_offset)
+    { }
+
+    // ST_E_843419 or ST_E_835769.
+    int type;
+    // The section offset of the instruction which is moved to the stub.
+    section_size_type insn_offset;
+    // That instruction.
+    Insntype insn;
+    // For ST_E_843419, the section offset of the ADRP instruction.
+    section_size_type adrp_offset;
+  };
+
+  typedef std::vector<Erratum_hit> Erratum_hits;
+
   AArch64_relobj(const std::string& name, Input_file* input_file, off_t offset,
 		 const typename elfcpp::Ehdr<size, big_endian>& ehdr)
     : Sized_relobj_file<size, big_endian>(name, input_file, offset, ehdr),
-      stub_tables_()
+      stub_tables_(), stub_scan_limits_(), errata_sections_(),
+      erratum_scans_()
   { }
 
   ~AArch64_relobj()
@@ -1792,17 +1816,38 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
     this->stub_tables_[shndx] = stub_table;
   }
 
-  // Entrance to errata scanning.
+  // Errata scanning is done in three steps.  First, with the object
+  // locked, find the sections to scan in this relaxation pass and get
+  // the contents of those whose last scan no longer holds.  Then
+  // scan_errata_section may be called for those sections, from any
+  // thread.  Last, again with the object locked, add the stubs for
+  // the sequences found.
   void
-  scan_errata(unsigned int shndx,
-	      const elfcpp::Shdr<size, big_endian>&,
-	      Output_section*, const Symbol_table*,
-	      The_target_aarch64*);
+  find_errata_sections(const Symbol_table*);
 
-  // Scan all relocation sections for stub generation.
+  // Return the number of sections to scan again for errata.
+  unsigned int
+  errata_section_count() const
+  { return this->errata_sections_.size(); }
+
+  // Scan the I-th section found by find_errata_sections, if its
+  // contents were read.
+  void
+  scan_errata_section(unsigned int i, The_target_aarch64*);
+
+  // Add the erratum stubs of the sections found by
+  // find_errata_sections.
+  void
+  add_erratum_stubs(The_target_aarch64*);
+
+  // Scan all relocation sections for stub generation.  Skip those
+  // which only referred to addresses below UNCHANGED_BELOW in the
+  // previous pass.  Add the number of sections scanned and skipped to
+  // *PSCANNED and *PSKIPPED.
   void
   scan_sections_for_stubs(The_target_aarch64*, const Symbol_table*,
-			  const Layout*);
+			  const Layout*, AArch64_address unchanged_below,
+			  unsigned int* pscanned, unsigned int* pskipped);
 
   // Whether a section is a scannable text section.
   bool
@@ -1889,8 +1934,54 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
   // List of stub tables.
   Stub_table_list stub_tables_;
 
+  // For each relocation section, the highest address that its scan
+  // for stubs depended on in the last pass: the end of the section it
+  // applies to, or the highest branch destination.  This is -1 for a
+  // section which has not been scanned.
+  std::vector<AArch64_address> stub_scan_limits_;
+
+  // A section to scan for errata in this relaxation pass.
+  struct Errata_section
+  {
+    Errata_section(unsigned int a_shndx, AArch64_address an_address,
+		   section_size_type a_size, File_view* a_contents)
+      : shndx(a_shndx), address(an_address), view_size(a_size),
+	contents(a_contents)
+    { }
+
+    // The section index.
+    unsigned int shndx;
+    // The output address of the section.
+    AArch64_address address;
+    // The size of the section.
+    section_size_type view_size;
+    // The contents, if the section must be scanned again, else NULL.
+    File_view* contents;
+  };
+
+  // The result of the last errata scan of a section.
+  struct Erratum_scan
+  {
+    Erratum_scan()
+      : page_offset(-1U), hits()
+    { }
+
+    // The output address of the section modulo 4 KiB, or -1U if the
+    // section has not been scanned.  Only erratum 843419 depends on
+    // the address, and only on its page offset.
+    unsigned int page_offset;
+    // The erratum sequences found.
+    Erratum_hits hits;
+  };
+
   // Mapping symbol information sorted by (section index, section_offset).
   Mapping_symbol_info mapping_symbol_info_;
+
+  // The sections to scan for errata in this relaxation pass.
+  std::vector<Errata_section> errata_sections_;
+
+  // The result of the last errata scan of each section.
+  std::vector<Erratum_scan> erratum_scans_;
 };  // End of AArch64_relobj
 
 
@@ -2288,51 +2379,101 @@ AArch64_relobj<size, big_endian>::section_needs_reloc_stub_scanning(
 }
 
 
-// Scan section SHNDX for erratum 843419 and 835769.
+// Find the sections to scan for erratum 843419 and 835769 in this
+// relaxation pass, and get the contents of those which must be
+// scanned again.
 
 template<int size, bool big_endian>
 void
-AArch64_relobj<size, big_endian>::scan_errata(
-    unsigned int shndx, const elfcpp::Shdr<size, big_endian>& shdr,
-    Output_section* os, const Symbol_table* symtab,
-    The_target_aarch64* target)
+AArch64_relobj<size, big_endian>::find_errata_sections(
+    const Symbol_table* symtab)
 {
-  if (shdr.get_sh_size() == 0
-      || (shdr.get_sh_flags() &
-	  (elfcpp::SHF_ALLOC | elfcpp::SHF_EXECINSTR)) == 0
-      || shdr.get_sh_type() != elfcpp::SHT_PROGBITS)
-    return;
+  gold_assert(this->errata_sections_.empty());
+  unsigned int shnum = this->shnum();
+  if (this->erratum_scans_.empty())
+    this->erratum_scans_.resize(shnum);
+  const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
+  const unsigned char* pshdrs = this->get_view(this->elf_file()->shoff(),
+					       shnum * shdr_size,
+					       true, true);
+  const Relobj::Output_sections& out_sections(this->output_sections());
+  const unsigned char* p = pshdrs + shdr_size;
+  for (unsigned int shndx = 1; shndx < shnum; ++shndx, p += shdr_size)
+    {
+      const elfcpp::Shdr<size, big_endian> shdr(p);
+      if (shdr.get_sh_size() == 0
+	  || (shdr.get_sh_flags() &
+	      (elfcpp::SHF_ALLOC | elfcpp::SHF_EXECINSTR)) == 0
+	  || shdr.get_sh_type() != elfcpp::SHT_PROGBITS)
+	continue;
 
-  if (!os || symtab->is_section_folded(this, shndx)) return;
+      Output_section* os = out_sections[shndx];
+      if (!os || symtab->is_section_folded(this, shndx))
+	continue;
 
-  AArch64_address output_offset = this->get_output_section_offset(shndx);
-  AArch64_address output_address;
-  if (output_offset != invalid_address)
-    output_address = os->address() + output_offset;
-  else
-    {
-      const Output_relaxed_input_section* poris =
-	os->find_relaxed_input_section(this, shndx);
-      if (!poris) return;
-      output_address = poris->address();
-    }
+      AArch64_address output_offset = this->get_output_section_offset(shndx);
+      AArch64_address output_address;
+      if (output_offset != invalid_address)
+	output_address = os->address() + output_offset;
+      else
+	{
+	  const Output_relaxed_input_section* poris =
+	    os->find_relaxed_input_section(this, shndx);
+	  if (!poris)
+	    continue;
+	  output_address = poris->address();
+	}
 
-  // Update the addresses in previously generated erratum stubs. Unlike when
-  // we scan relocations for stubs, if section addresses have changed due to
-  // other relaxations we are unlikely to scan the same erratum instances
-  // again.
-  The_stub_table* stub_table = this->stub_table(shndx);
-  if (stub_table)
-    {
-      std::pair<Erratum_stub_set_iter, Erratum_stub_set_iter>
-	  ipair(stub_table->find_erratum_stubs_for_input_section(this, shndx));
-      for (Erratum_stub_set_iter p = ipair.first;  p != ipair.second; ++p)
-          (*p)->update_erratum_address(output_address);
+      // Update the addresses in previously generated erratum stubs.
+      // Unlike when we scan relocations for stubs, if section addresses
+      // have changed due to other relaxations we are unlikely to scan
+      // the same erratum instances again.
+      The_stub_table* stub_table = this->stub_table(shndx);
+      if (stub_table)
+	{
+	  std::pair<Erratum_stub_set_iter, Erratum_stub_set_iter>
+	    ipair(stub_table->find_erratum_stubs_for_input_section(this,
+								   shndx));
+	  for (Erratum_stub_set_iter q = ipair.first; q != ipair.second; ++q)
+	    (*q)->update_erratum_address(output_address);
+	}
+
+      // The last scan still holds unless the section has moved within
+      // its page and we look for erratum 843419.
+      const Erratum_scan& scan(this->erratum_scans_[shndx]);
+      unsigned int page_offset = output_address & 0xfff;
+      File_view* contents = NULL;
+      if (scan.page_offset == -1U
+	  || (parameters->options().fix_cortex_a53_843419()
+	      && scan.page_offset != page_offset))
+	contents = this->get_lasting_view(shdr.get_sh_offset(),
+					  shdr.get_sh_size(), true, false);
+
+      this->errata_sections_.push_back(
+	Errata_section(shndx, output_address,
+		       convert_to_section_size_type(shdr.get_sh_size()),
+		       contents));
     }
+}
+
+// Scan the I-th section found by find_errata_sections for erratum
+// 843419 and 835769.  This may be called from any thread.
+
+template<int size, bool big_endian>
+void
+AArch64_relobj<size, big_endian>::scan_errata_section(
+    unsigned int i, The_target_aarch64* target)
+{
+  const Errata_section& es(this->errata_sections_[i]);
+  if (es.contents == NULL)
+    return;
 
-  section_size_type input_view_size = 0;
-  const unsigned char* input_view =
-    this->section_contents(shndx, &input_view_size, false);
+  unsigned int shndx = es.shndx;
+  Erratum_scan& scan(this->erratum_scans_[shndx]);
+  scan.page_offset = es.address & 0xfff;
+  scan.hits.clear();
+
+  const unsigned char* input_view = es.contents->data();
 
   Mapping_symbol_position section_start(shndx, 0);
   // Find the first mapping symbol record within section shndx.
@@ -2352,25 +2493,57 @@ AArch64_relobj<size, big_endian>::scan_errata(
 	      && p->first.shndx_ == shndx)
 	    span_end = convert_to_section_size_type(p->first.offset_);
 	  else
-	    span_end = convert_to_section_size_type(shdr.get_sh_size());
+	    span_end = es.view_size;
 
 	  // Here we do not share the scanning code of both errata. For 843419,
 	  // only the last few insns of each page are examined, which is fast,
 	  // whereas, for 835769, every insn pair needs to be checked.
 
 	  if (parameters->options().fix_cortex_a53_843419())
-	    target->scan_erratum_843419_span(
-	      this, shndx, span_start, span_end,
-	      const_cast<unsigned char*>(input_view), output_address);
+	    target->scan_erratum_843419_span(span_start, span_end, input_view,
+					     es.address, &scan.hits);
 
 	  if (parameters->options().fix_cortex_a53_835769())
-	    target->scan_erratum_835769_span(
-	      this, shndx, span_start, span_end,
-	      const_cast<unsigned char*>(input_view), output_address);
+	    target->scan_erratum_835769_span(span_start, span_end, input_view,
+					     es.address, &scan.hits);
 	}
     }
 }
 
+// Add the erratum stubs for the sequences found in the sections of
+// this relaxation pass, in section order.
+
+template<int size, bool big_endian>
+void
+AArch64_relobj<size, big_endian>::add_erratum_stubs(
+    The_target_aarch64* target)
+{
+  const int BPI = AArch64_insn_utilities<big_endian>::BYTES_PER_INSN;
+  for (typename std::vector<Errata_section>::const_iterator p =
+	 this->errata_sections_.begin();
+       p != this->errata_sections_.end();
+       ++p)
+    {
+      delete p->contents;
+
+      const Erratum_hits& hits(this->erratum_scans_[p->shndx].hits);
+      for (typename Erratum_hits::const_iterator q = hits.begin();
+	   q != hits.end();
+	   ++q)
+	{
+	  if (q->type == ST_E_835769)
+	    gold_info(_("Erratum 835769 found and fixed at \"%s\", "
+			"section %d, offset 0x%08x."),
+		      this->name().c_str(), p->shndx,
+		      (unsigned int)(q->insn_offset - BPI));
+	  target->create_erratum_stub(this, p->shndx, q->insn_offset,
+				      p->address + q->insn_offset, q->insn,
+				      q->type, q->adrp_offset);
+	}
+    }
+  this->errata_sections_.clear();
+}
+
 
 // Scan relocations for stub generation.
 
@@ -2379,9 +2552,14 @@ void
 AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
     The_target_aarch64* target,
     const Symbol_table* symtab,
-    const Layout* layout)
+    const Layout* layout,
+    AArch64_address unchanged_below,
+    unsigned int* pscanned,
+    unsigned int* pskipped)
 {
   unsigned int shnum = this->shnum();
+  if (this->stub_scan_limits_.empty())
+    this->stub_scan_limits_.resize(shnum, static_cast<AArch64_address>(-1));
   const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
 
   // Read the section headers.
@@ -2405,12 +2583,19 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
   for (unsigned int i = 1; i < shnum; ++i, p += shdr_size)
     {
       const elfcpp::Shdr<size, big_endian> shdr(p);
-      if (parameters->options().fix_cortex_a53_843419()
-	  || parameters->options().fix_cortex_a53_835769())
-	scan_errata(i, shdr, out_sections[i], symtab, target);
       if (this->section_needs_reloc_stub_scanning(shdr, out_sections, symtab,
 						  pshdrs))
 	{
+	  // If the branches in this section and their destinations were
+	  // all below the lowest address which may have moved, a new
+	  // scan would find the same stubs.
+	  if (this->stub_scan_limits_[i] < unchanged_below)
+	    {
+	      ++*pskipped;
+	      continue;
+	    }
+	  ++*pscanned;
+
 	  unsigned int index = this->adjust_shndx(shdr.get_sh_info());
 	  AArch64_address output_offset =
 	      this->get_output_section_offset(index);
@@ -2446,12 +2631,15 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
 	  reloc_size = elfcpp::Elf_sizes<size>::rela_size;
 
 	  Output_section* os = out_sections[index];
-	  target->scan_section_for_stubs(&relinfo, sh_type, prelocs,
-					 shdr.get_sh_size() / reloc_size,
-					 os,
-					 output_offset == invalid_address,
-					 input_view, output_address,
-					 input_view_size);
+	  AArch64_address limit =
+	    target->scan_section_for_stubs(&relinfo, sh_type, prelocs,
+					   shdr.get_sh_size() / reloc_size,
+					   os,
+					   output_offset == invalid_address,
+					   input_view, output_address,
+					   input_view_size);
+	  AArch64_address section_end = output_address + input_view_size;
+	  this->stub_scan_limits_[i] = std::max(limit, section_end);
 	}
     }
 }
@@ -2925,7 +3113,8 @@ class Target_aarch64 : public Sized_target<size, big_endian>
       rela_irelative_(NULL), copy_relocs_(elfcpp::R_AARCH64_COPY),
       got_mod_index_offset_(-1U),
       tlsdesc_reloc_info_(), tls_base_symbol_defined_(false),
-      stub_tables_(), stub_group_size_(0), aarch64_input_section_map_()
+      stub_tables_(), stub_group_size_(0), aarch64_input_section_map_(),
+      relax_extents_(), changed_stubs_address_(invalid_address)
   { }
 
   // Scan the relocations to determine unreferenced sections for
@@ -3084,8 +3273,9 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   unsigned int
   tcb_size() const { return This::TCB_SIZE; }
 
-  // Scan a section for stub generation.
-  void
+  // Scan a section for stub generation.  Return the highest branch
+  // destination, or 0 if there is none.
+  Address
   scan_section_for_stubs(const Relocate_info<size, big_endian>*, unsigned int,
 			 const unsigned char*, size_t, Output_section*,
 			 bool, const unsigned char*,
@@ -3094,7 +3284,7 @@ class Target_aarch64 : public Sized_target<size, big_endian>
 
   // Scan a relocation section for stub.
   template<int sh_type>
-  void
+  Address
   scan_reloc_section_for_stubs(
       const The_relocate_info* relinfo,
       const unsigned char* prelocs,
@@ -3122,25 +3312,36 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   }
 
 
-  // Scan erratum 843419 for a part of a section.
+  // Scan erratum 843419 for a part of a section, adding the sequences
+  // found to the list.  This may be called from any thread.
   void
   scan_erratum_843419_span(
-    AArch64_relobj<size, big_endian>*,
-    unsigned int,
     const section_size_type,
     const section_size_type,
-    unsigned char*,
-    Address);
+    const unsigned char*,
+    Address,
+    typename The_aarch64_relobj::Erratum_hits*);
 
-  // Scan erratum 835769 for a part of a section.
+  // Scan erratum 835769 for a part of a section, adding the sequences
+  // found to the list.  This may be called from any thread.
   void
   scan_erratum_835769_span(
-    AArch64_relobj<size, big_endian>*,
-    unsigned int,
     const section_size_type,
     const section_size_type,
-    unsigned char*,
-    Address);
+    const unsigned char*,
+    Address,
+    typename The_aarch64_relobj::Erratum_hits*);
+
+  // Helper method to create erratum stubs for ST_E_843419 and ST_E_835769. For
+  // ST_E_843419, we need an additional field for adrp offset.
+  void create_erratum_stub(
+    AArch64_relobj<size, big_endian>* relobj,
+    unsigned int shndx,
+    section_size_type erratum_insn_offset,
+    Address erratum_address,
+    typename Insn_utilities::Insntype erratum_insn,
+    int erratum_type,
+    unsigned int e843419_adrp_offset=0);
 
  protected:
   void
@@ -3200,13 +3401,24 @@ class Target_aarch64 : public Sized_target<size, big_endian>
 		 bool stubs_always_after_branch,
 		 const Task* task);
 
-  void
+  Address
   scan_reloc_for_stub(const The_relocate_info*, unsigned int,
 		      const Sized_symbol<size>*, unsigned int,
 		      const Symbol_value<size>*,
 		      typename elfcpp::Elf_types<size>::Elf_Swxword,
 		      Address Elf_Addr);
 
+  // Return the lowest address which may have moved since the last
+  // relaxation pass.
+  Address
+  stub_scan_threshold(const Layout*) const;
+
+  // Record the layout at the end of a relaxation pass, so that the
+  // next pass can find what moved.
+  void
+  save_relax_extents(const Layout*,
+		     const Unordered_set<const Output_section*>&);
+
   // Make an output section.
   Output_section*
   do_make_output_section(const char* name, elfcpp::Elf_Word type,
@@ -3424,16 +3636,10 @@ class Target_aarch64 : public Sized_target<size, big_endian>
     return this->plt_;
   }
 
-  // Helper method to create erratum stubs for ST_E_843419 and ST_E_835769. For
-  // ST_E_843419, we need an additional field for adrp offset.
-  void create_erratum_stub(
-    AArch64_relobj<size, big_endian>* relobj,
-    unsigned int shndx,
-    section_size_type erratum_insn_offset,
-    Address erratum_address,
-    typename Insn_utilities::Insntype erratum_insn,
-    int erratum_type,
-    unsigned int e843419_adrp_offset=0);
+  // Scan the input sections for erratum 843419 and 835769, and add
+  // stubs for the sequences found.
+  void
+  scan_errata(const Input_objects*, const Symbol_table*, const Task*);
 
   // Return whether this is a 3-insn erratum sequence.
   bool is_erratum_843419_sequence(
@@ -3538,6 +3744,29 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   // Actual stub group size
   section_size_type stub_group_size_;
   AArch64_input_section_map aarch64_input_section_map_;
+
+  // The address and size of an allocated output section at the end of
+  // a relaxation pass, and whether it holds a stub table whose size
+  // changed in that pass.
+  struct Relax_extent
+  {
+    Relax_extent(const Output_section* a_os, Address a_address,
+		 off_t a_data_size, bool a_has_changed_stubs)
+      : os(a_os), address(a_address), data_size(a_data_size),
+	has_changed_stubs(a_has_changed_stubs)
+    { }
+
+    const Output_section* os;
+    Address address;
+    off_t data_size;
+    bool has_changed_stubs;
+  };
+
+  // The output sections at the end of the last relaxation pass.
+  std::vector<Relax_extent> relax_extents_;
+  // The lowest address of a stub table whose size changed in the last
+  // relaxation pass, or -1 if none did.
+  Address changed_stubs_address_;
 };  // End of Target_aarch64
 
 
@@ -3766,6 +3995,14 @@ Target_aarch64<size, big_endian>::rela_dyn_section(Layout* layout)
       layout->add_output_section_data(".rela.dyn", elfcpp::SHT_RELA,
 				      elfcpp::SHF_ALLOC, this->rela_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<elfcpp::SHT_RELA, size, big_endian>* relr =
+	    new Output_data_relr<elfcpp::SHT_RELA, size, big_endian>(
+		elfcpp::R_AARCH64_RELATIVE, layout, this->rela_dyn_);
+	  this->rela_dyn_->set_relr_section(relr);
+	}
     }
   return this->rela_dyn_;
 }
@@ -3840,7 +4077,7 @@ Target_aarch64<size, big_endian>::do_make_elf_object(
 // Scan a relocation for stub generation.
 
 template<int size, bool big_endian>
-void
+typename Target_aarch64<size, big_endian>::Address
 Target_aarch64<size, big_endian>::scan_reloc_for_stub(
     const Relocate_info<size, big_endian>* relinfo,
     unsigned int r_type,
@@ -3871,7 +4108,7 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
           gold_debug(DEBUG_TARGET,
                      "stub: not creating a stub for undefined symbol %s in file %s",
                      gsym->name(), aarch64_relobj->name().c_str());
-          return;
+          return 0;
 	}
     }
 
@@ -3894,7 +4131,7 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
   int stub_type = The_reloc_stub::
       stub_type_for_reloc(r_type, address, destination);
   if (stub_type == ST_NONE)
-    return;
+    return destination;
 
   The_stub_table* stub_table = aarch64_relobj->stub_table(relinfo->data_shndx);
   gold_assert(stub_table != NULL);
@@ -3907,6 +4144,7 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
       stub_table->add_reloc_stub(stub, key);
     }
   stub->set_destination_address(destination);
+  return destination;
 }  // End of Target_aarch64::scan_reloc_for_stub
 
 
@@ -3930,7 +4168,7 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
 
 template<int size, bool big_endian>
 template<int sh_type>
-void inline
+typename Target_aarch64<size, big_endian>::Address inline
 Target_aarch64<size, big_endian>::scan_reloc_section_for_stubs(
     const Relocate_info<size, big_endian>* relinfo,
     const unsigned char* prelocs,
@@ -3951,6 +4189,7 @@ Target_aarch64<size, big_endian>::scan_reloc_section_for_stubs(
 
   gold::Default_comdat_behavior default_comdat_behavior;
   Comdat_behavior comdat_behavior = CB_UNDETERMINED;
+  Address limit = 0;
 
   for (size_t i = 0; i < reloc_count; ++i, prelocs += reloc_size)
     {
@@ -4092,16 +4331,19 @@ Target_aarch64<size, big_endian>::scan_reloc_section_for_stubs(
 	  psymval = &symval2;
 	}
 
-      this->scan_reloc_for_stub(relinfo, r_type, sym, r_sym, psymval,
-				addend, view_address + offset);
+      Address destination =
+	this->scan_reloc_for_stub(relinfo, r_type, sym, r_sym, psymval,
+				  addend, view_address + offset);
+      limit = std::max(limit, destination);
     }  // End of iterating relocs in a section
+  return limit;
 }  // End of Target_aarch64::scan_reloc_section_for_stubs
 
 
 // Scan an input section for stub generation.
 
 template<int size, bool big_endian>
-void
+typename Target_aarch64<size, big_endian>::Address
 Target_aarch64<size, big_endian>::scan_section_for_stubs(
     const Relocate_info<size, big_endian>* relinfo,
     unsigned int sh_type,
@@ -4114,7 +4356,7 @@ Target_aarch64<size, big_endian>::scan_section_for_stubs(
     section_size_type view_size)
 {
   gold_assert(sh_type == elfcpp::SHT_RELA);
-  this->scan_reloc_section_for_stubs<elfcpp::SHT_RELA>(
+  return this->scan_reloc_section_for_stubs<elfcpp::SHT_RELA>(
       relinfo,
       prelocs,
       reloc_count,
@@ -5633,6 +5875,73 @@ Target_aarch64<size, big_endian>::new_aarch64_input_section(
 }
 
 
+// A class to scan input sections for errata with several threads.
+// The sections are handed out to the threads one at a time.
+
+template<int size, bool big_endian>
+class Parallel_scan_errata : public Parallel_run
+{
+ public:
+  typedef AArch64_relobj<size, big_endian> The_aarch64_relobj;
+  typedef Target_aarch64<size, big_endian> The_target_aarch64;
+
+  Parallel_scan_errata(The_target_aarch64* target)
+    : target_(target), sections_(), next_section_(0), lock_(NULL)
+  { }
+
+  // Add the sections found by find_errata_sections in RELOBJ.
+  void
+  add_object(The_aarch64_relobj* relobj)
+  {
+    unsigned int count = relobj->errata_section_count();
+    for (unsigned int i = 0; i < count; ++i)
+      this->sections_.push_back(std::make_pair(relobj, i));
+  }
+
+  // Scan the sections.
+  void
+  scan()
+  {
+    if (this->sections_.empty())
+      return;
+    Lock lock;
+    this->lock_ = &lock;
+    unsigned int thread_count =
+      Parallel_run::thread_count(Parallel_run::MIDDLE_PHASE);
+    if (thread_count > this->sections_.size())
+      thread_count = this->sections_.size();
+    this->run(thread_count);
+    this->lock_ = NULL;
+  }
+
+ protected:
+  void
+  do_run(unsigned int)
+  {
+    while (true)
+      {
+	size_t i;
+	{
+	  Hold_lock hl(*this->lock_);
+	  if (this->next_section_ >= this->sections_.size())
+	    return;
+	  i = this->next_section_;
+	  ++this->next_section_;
+	}
+	this->sections_[i].first->scan_errata_section(this->sections_[i].second,
+						      this->target_);
+      }
+  }
+
+ private:
+  The_target_aarch64* target_;
+  // The objects and the indexes of their sections to scan.
+  std::vector<std::pair<The_aarch64_relobj*, unsigned int> > sections_;
+  // The next section to scan, protected by LOCK_.
+  size_t next_section_;
+  Lock* lock_;
+};
+
 // Relaxation hook.  This is where we do stub generation.
 
 template<int size, bool big_endian>
@@ -5675,6 +5984,16 @@ Target_aarch64<size, big_endian>::do_relax(
 	}
     }
 
+  if (parameters->options().fix_cortex_a53_843419()
+      || parameters->options().fix_cortex_a53_835769())
+    this->scan_errata(input_objects, symtab, task);
+
+  // In the first pass we scan every section.  After that, only the
+  // sections which refer to an address which may have moved.
+  Address unchanged_below = (pass == 1 ? 0 : this->stub_scan_threshold(layout));
+  unsigned int scanned = 0;
+  unsigned int skipped = 0;
+
   // Scan relocs for relocation stubs
   for (Input_objects::Relobj_iterator op = input_objects->relobj_begin();
        op != input_objects->relobj_end();
@@ -5685,25 +6004,43 @@ Target_aarch64<size, big_endian>::do_relax(
       // Lock the object so we can read from it.  This is only called
       // single-threaded from Layout::finalize, so it is OK to lock.
       Task_lock_obj<Object> tl(task, aarch64_relobj);
-      aarch64_relobj->scan_sections_for_stubs(this, symtab, layout);
+      aarch64_relobj->scan_sections_for_stubs(this, symtab, layout,
+					      unchanged_below,
+					      &scanned, &skipped);
     }
 
-  bool any_stub_table_changed = false;
+  // Update the size of every stub table which grew in this pass, so
+  // that the next pass lays them all out at once.
+  unsigned int changed_groups = 0;
+  Unordered_set<const Output_section*> changed_sections;
+  this->changed_stubs_address_ = invalid_address;
   for (Stub_table_iterator siter = this->stub_tables_.begin();
-       siter != this->stub_tables_.end() && !any_stub_table_changed; ++siter)
+       siter != this->stub_tables_.end(); ++siter)
     {
       The_stub_table* stub_table = *siter;
       if (stub_table->update_data_size_changed_p())
 	{
+	  Address stub_address = stub_table->address();
+	  this->changed_stubs_address_ = std::min(this->changed_stubs_address_,
+						  stub_address);
 	  The_aarch64_input_section* owner = stub_table->owner();
+	  changed_sections.insert(owner->relobj()->output_section(
+				    owner->shndx()));
 	  uint64_t address = owner->address();
 	  off_t offset = owner->offset();
 	  owner->reset_address_and_file_offset();
 	  owner->set_address_and_file_offset(address, offset);
 
-	  any_stub_table_changed = true;
+	  ++changed_groups;
 	}
     }
+  bool any_stub_table_changed = changed_groups > 0;
+
+  if (!layout->script_options()->saw_sections_clause())
+    this->save_relax_extents(layout, changed_sections);
+
+  if (parameters->options().stats())
+    layout->record_relaxation_pass(changed_groups, scanned, skipped);
 
   // Do not continue relaxation.
   bool continue_relaxation = any_stub_table_changed;
@@ -5717,6 +6054,106 @@ Target_aarch64<size, big_endian>::do_relax(
 }
 
 
+// Scan the input sections for erratum 843419 and 835769.  Reading the
+// objects and adding the stubs are done in input order, with one
+// object locked at a time; the scans in between may run in parallel.
+// A section is only scanned again if its address has changed modulo
+// 4 KiB, which is all that erratum 843419 depends on.
+
+template<int size, bool big_endian>
+void
+Target_aarch64<size, big_endian>::scan_errata(
+    const Input_objects* input_objects,
+    const Symbol_table* symtab,
+    const Task* task)
+{
+  Parallel_scan_errata<size, big_endian> scanner(this);
+  for (Input_objects::Relobj_iterator op = input_objects->relobj_begin();
+       op != input_objects->relobj_end();
+       ++op)
+    {
+      The_aarch64_relobj* aarch64_relobj =
+	  static_cast<The_aarch64_relobj*>(*op);
+      Task_lock_obj<Object> tl(task, aarch64_relobj);
+      aarch64_relobj->find_errata_sections(symtab);
+      scanner.add_object(aarch64_relobj);
+    }
+
+  scanner.scan();
+
+  for (Input_objects::Relobj_iterator op = input_objects->relobj_begin();
+       op != input_objects->relobj_end();
+       ++op)
+    {
+      The_aarch64_relobj* aarch64_relobj =
+	  static_cast<The_aarch64_relobj*>(*op);
+      Task_lock_obj<Object> tl(task, aarch64_relobj);
+      aarch64_relobj->add_erratum_stubs(this);
+    }
+}
+
+// Return the lowest address, in the layout of the last relaxation
+// pass, which may have moved.  Everything below the first stub table
+// which grew is laid out as before, unless an output section has moved
+// or changed size for some other reason, for instance because
+// .relr.dyn grew.  A linker script may place sections anywhere, so we
+// do not skip anything if there is a SECTIONS clause.
+
+template<int size, bool big_endian>
+typename Target_aarch64<size, big_endian>::Address
+Target_aarch64<size, big_endian>::stub_scan_threshold(
+    const Layout* layout) const
+{
+  if (layout->script_options()->saw_sections_clause()
+      || this->relax_extents_.empty())
+    return 0;
+
+  Address threshold = this->changed_stubs_address_;
+  for (typename std::vector<Relax_extent>::const_iterator p =
+	 this->relax_extents_.begin();
+       p != this->relax_extents_.end();
+       ++p)
+    {
+      if (p->address >= threshold)
+	continue;
+      const Output_section* os = p->os;
+      if (!os->is_address_valid()
+	  || os->address() != p->address
+	  || (!p->has_changed_stubs
+	      && (!os->is_data_size_valid()
+		  || os->data_size() != p->data_size)))
+	threshold = p->address;
+    }
+  return threshold;
+}
+
+// Record the address and size of the allocated output sections.
+
+template<int size, bool big_endian>
+void
+Target_aarch64<size, big_endian>::save_relax_extents(
+    const Layout* layout,
+    const Unordered_set<const Output_section*>& changed_sections)
+{
+  this->relax_extents_.clear();
+  const Layout::Section_list& sections(layout->section_list());
+  for (Layout::Section_list::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    {
+      const Output_section* os = *p;
+      if ((os->flags() & elfcpp::SHF_ALLOC) == 0
+	  || !os->is_address_valid()
+	  || !os->is_data_size_valid())
+	continue;
+      bool has_changed_stubs = (changed_sections.find(os)
+				!= changed_sections.end());
+      this->relax_extents_.push_back(Relax_extent(os, os->address(),
+						  os->data_size(),
+						  has_changed_stubs));
+    }
+}
+
 // Make a new Stub_table.
 
 template<int size, bool big_endian>
@@ -8446,45 +8883,46 @@ Target_aarch64<size, big_endian>::create_erratum_stub(
 template<int size, bool big_endian>
 void
 Target_aarch64<size, big_endian>::scan_erratum_835769_span(
-    AArch64_relobj<size, big_endian>*  relobj,
-    unsigned int shndx,
     const section_size_type span_start,
     const section_size_type span_end,
-    unsigned char* input_view,
-    Address output_address)
+    const unsigned char* input_view,
+    Address,
+    typename The_aarch64_relobj::Erratum_hits* hits)
 {
   typedef typename Insn_utilities::Insntype Insntype;
 
   const int BPI = AArch64_insn_utilities<big_endian>::BYTES_PER_INSN;
 
-  // Adjust output_address and view to the start of span.
-  output_address += span_start;
-  input_view += span_start;
-
+  const Insntype* ip = reinterpret_cast<const Insntype*>(input_view
+							 + span_start);
   section_size_type span_length = span_end - span_start;
-  section_size_type offset = 0;
-  for (offset = 0; offset + BPI < span_length; offset += BPI)
+  section_size_type insn_count = (span_length + BPI - 1) / BPI;
+
+  // Only a multiply-accumulate insn can end a sequence, so skip over
+  // the others four at a time, in a loop which the compiler can
+  // vectorize, and only check the pairs which end with one.  An insn
+  // which ends a sequence does not start another.
+  section_size_type last = 0;
+  section_size_type i = 1;
+  while (i < insn_count)
     {
-      Insntype* ip = reinterpret_cast<Insntype*>(input_view + offset);
-      Insntype insn1 = ip[0];
-      Insntype insn2 = ip[1];
-      if (is_erratum_835769_sequence(insn1, insn2))
+      while (i + 4 <= insn_count
+	     && !(Insn_utilities::aarch64_mac(ip[i])
+		  | Insn_utilities::aarch64_mac(ip[i + 1])
+		  | Insn_utilities::aarch64_mac(ip[i + 2])
+		  | Insn_utilities::aarch64_mac(ip[i + 3])))
+	i += 4;
+      if (i >= insn_count)
+	break;
+      if (Insn_utilities::aarch64_mac(ip[i])
+	  && (last == 0 || last != i - 1)
+	  && is_erratum_835769_sequence(ip[i - 1], ip[i]))
 	{
-	  Insntype erratum_insn = insn2;
-	  // "span_start + offset" is the offset for insn1. So for insn2, it is
-	  // "span_start + offset + BPI".
-	  section_size_type erratum_insn_offset = span_start + offset + BPI;
-	  Address erratum_address = output_address + offset + BPI;
-	  gold_info(_("Erratum 835769 found and fixed at \"%s\", "
-			 "section %d, offset 0x%08x."),
-		       relobj->name().c_str(), shndx,
-		       (unsigned int)(span_start + offset));
-
-	  this->create_erratum_stub(relobj, shndx,
-				    erratum_insn_offset, erratum_address,
-				    erratum_insn, ST_E_835769);
-	  offset += BPI;  // Skip mac insn.
+	  hits->push_back(typename The_aarch64_relobj::Erratum_hit(
+	    ST_E_835769, span_start + i * BPI, ip[i], 0));
+	  last = i;
 	}
+      ++i;
     }
 }  // End of "Target_aarch64::scan_erratum_835769_span".
 
@@ -8495,12 +8933,11 @@ Target_aarch64<size, big_endian>::scan_erratum_835769_span(
 template<int size, bool big_endian>
 void
 Target_aarch64<size, big_endian>::scan_erratum_843419_span(
-    AArch64_relobj<size, big_endian>*  relobj,
-    unsigned int shndx,
     const section_size_type span_start,
     const section_size_type span_end,
-    unsigned char* input_view,
-    Address output_address)
+    const unsigned char* input_view,
+    Address output_address,
+    typename The_aarch64_relobj::Erratum_hits* hits)
 {
   typedef typename Insn_utilities::Insntype Insntype;
 
@@ -8521,7 +8958,8 @@ Target_aarch64<size, big_endian>::scan_erratum_843419_span(
     offset = 0xff8 - page_offset;
   while (offset + 3 * Insn_utilities::BYTES_PER_INSN <= span_length)
     {
-      Insntype* ip = reinterpret_cast<Insntype*>(input_view + offset);
+      const Insntype* ip = reinterpret_cast<const Insntype*>(input_view
+							     + offset);
       Insntype insn1 = ip[0];
       if (Insn_utilities::is_adrp(insn1))
 	{
@@ -8560,16 +8998,9 @@ Target_aarch64<size, big_endian>::scan_erratum_843419_span(
 		}
 	    }
 	  if (do_report)
-	    {
-	      unsigned int erratum_insn_offset =
-		span_start + offset + insn_offset;
-	      Address erratum_address =
-		output_address + offset + insn_offset;
-	      create_erratum_stub(relobj, shndx,
-				  erratum_insn_offset, erratum_address,
-				  erratum_insn, ST_E_843419,
-				  span_start + offset);
-	    }
+	    hits->push_back(typename The_aarch64_relobj::Erratum_hit(
+	      ST_E_843419, span_start + offset + insn_offset, erratum_insn,
+	      span_start + offset));
 	}
 
       // Advance to next candidate instruction. We only consider instruction
@@ -26,8 +26,16 @@
 #include <cstring>
 #include <climits>
 #include <vector>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "libiberty.h"
 #include "filenames.h"
+#include "descriptors.h"
+#include "gold-threads.h"
 
 #include "elfcpp.h"
 #include "options.h"
@@ -167,10 +175,51 @@ struct Archive::Archive_header
   char ar_fmag[2];
 };
 
+// The header of an entry in the --archive-cache directory.  An entry
+// holds the archive map, the extended name table and the index of the
+// archive map by name of one archive.  We only use it if the archive
+// still has the same name, size, modification time and inode.  The
+// header is followed by the archive map and its index, as pairs of
+// 64-bit words, and then by the name of the archive, the symbol names
+// and the extended name table.  Everything is in host byte order, so
+// that the entry can be used from a mapping of the file.
+
+struct Archive::Armap_cache_header
+{
+  char magic[8];
+  uint64_t word_size;
+  uint64_t file_size;
+  uint64_t mtime_seconds;
+  uint64_t mtime_nanoseconds;
+  uint64_t inode;
+  uint64_t device;
+  uint64_t name_size;
+  // The sizes of the data which follows the header.
+  uint64_t armap_count;
+  uint64_t member_count;
+  uint64_t names_size;
+  uint64_t extended_names_size;
+  uint64_t index_count;
+};
+
+static const char armap_cache_magic[8] =
+{
+  'g', 'o', 'l', 'd', 'a', 'r', 'm', '1'
+};
+
 // Class Archive static variables.
 unsigned int Archive::total_archives;
 unsigned int Archive::total_members;
 unsigned int Archive::total_members_loaded;
+uint64_t Archive::total_armap_lookups;
+unsigned int Archive::total_cache_hits;
+unsigned int Archive::total_cache_misses;
+
+// A lock for the archive map cache counts, as archives are set up by
+// several threads.
+static Lock* armap_cache_counts_lock = NULL;
+static Initialize_lock armap_cache_counts_initialize_lock(
+    &armap_cache_counts_lock);
 
 // Archive methods.
 
@@ -192,6 +241,7 @@ Archive::Archive(const std::string& name, Input_file* input_file,
                  bool is_thin_archive, Dirsearch* dirpath, Task* task)
   : Library_base(task), name_(name), input_file_(input_file), armap_(),
     armap_names_(), extended_names_(), armap_checked_(), seen_offsets_(),
+    armap_index_(), scanned_armap_(false), undefined_seen_(0),
     members_(), is_thin_archive_(is_thin_archive), included_member_(false),
     nested_archives_(), dirpath_(dirpath), num_members_(0),
     included_all_members_(false)
@@ -210,46 +260,77 @@ Archive::setup()
   if (this->input_file_->file().filesize() == sarmag)
     return;
 
-  // The first member of the archive should be the symbol table.
-  std::string armap_name;
-  off_t header_size = this->read_header(sarmag, false, &armap_name, NULL);
-  if (header_size == -1)
-    return;
-
-  section_size_type armap_size = convert_to_section_size_type(header_size);
-  off_t off = sarmag;
-  if (armap_name.empty())
+  // With --archive-cache, we may be able to use the archive map which
+  // we read in an earlier link.
+  std::string cache_name;
+  Armap_cache_header cache_key;
+  bool use_cache = (parameters->options().user_set_archive_cache()
+		    && this->armap_cache_key(&cache_key, &cache_name));
+  bool from_cache = use_cache && this->read_armap_cache(cache_key,
+							 cache_name);
+  if (use_cache)
     {
-      this->read_armap<32>(sarmag + sizeof(Archive_header), armap_size);
-      off = sarmag + sizeof(Archive_header) + armap_size;
+      armap_cache_counts_initialize_lock.initialize();
+      Hold_optional_lock hl(armap_cache_counts_lock);
+      if (from_cache)
+	++Archive::total_cache_hits;
+      else
+	++Archive::total_cache_misses;
     }
-  else if (armap_name == "/SYM64/")
+
+  if (!from_cache)
     {
-      this->read_armap<64>(sarmag + sizeof(Archive_header), armap_size);
-      off = sarmag + sizeof(Archive_header) + armap_size;
-    }
-  else if (!this->input_file_->options().whole_archive())
-    gold_error(_("%s: no archive symbol table (run ranlib)"),
-	       this->name().c_str());
+      // The first member of the archive should be the symbol table.
+      std::string armap_name;
+      off_t header_size = this->read_header(sarmag, false, &armap_name,
+					    NULL);
+      if (header_size == -1)
+	return;
 
-  // See if there is an extended name table.  We cache these views
-  // because it is likely that we will want to read the following
-  // header in the add_symbols routine.
-  if ((off & 1) != 0)
-    ++off;
-  std::string xname;
-  header_size = this->read_header(off, true, &xname, NULL);
-  if (header_size == -1)
-    return;
+      section_size_type armap_size =
+	convert_to_section_size_type(header_size);
+      off_t off = sarmag;
+      bool has_armap = false;
+      if (armap_name.empty())
+	{
+	  this->read_armap<32>(sarmag + sizeof(Archive_header), armap_size);
+	  off = sarmag + sizeof(Archive_header) + armap_size;
+	  has_armap = true;
+	}
+      else if (armap_name == "/SYM64/")
+	{
+	  this->read_armap<64>(sarmag + sizeof(Archive_header), armap_size);
+	  off = sarmag + sizeof(Archive_header) + armap_size;
+	  has_armap = true;
+	}
+      else if (!this->input_file_->options().whole_archive())
+	gold_error(_("%s: no archive symbol table (run ranlib)"),
+		   this->name().c_str());
+
+      // See if there is an extended name table.  We cache these views
+      // because it is likely that we will want to read the following
+      // header in the add_symbols routine.
+      if ((off & 1) != 0)
+	++off;
+      std::string xname;
+      header_size = this->read_header(off, true, &xname, NULL);
+      if (header_size == -1)
+	return;
 
-  section_size_type extended_size = convert_to_section_size_type(header_size);
-  if (xname == "/")
-    {
-      const unsigned char* p = this->get_view(off + sizeof(Archive_header),
-                                              extended_size, false, true);
-      const char* px = reinterpret_cast<const char*>(p);
-      this->extended_names_.assign(px, extended_size);
+      section_size_type extended_size =
+	convert_to_section_size_type(header_size);
+      if (xname == "/")
+	{
+	  const unsigned char* p = this->get_view(off + sizeof(Archive_header),
+						  extended_size, false, true);
+	  const char* px = reinterpret_cast<const char*>(p);
+	  this->extended_names_.assign(px, extended_size);
+	}
+
+      if (use_cache && has_armap)
+	this->write_armap_cache(cache_key, cache_name);
     }
+
   bool preread_syms = (parameters->options().threads()
                        && parameters->options().preread_archive_symbols());
 #ifndef ENABLE_THREADS
@@ -329,6 +410,214 @@ Archive::read_armap(off_t start, section_size_type size)
   this->armap_checked_.resize(nsyms);
 }
 
+// Set *HDR to the key of the cache entry for this archive, and
+// *CACHE_NAME to the name of the entry.
+
+bool
+Archive::armap_cache_key(Armap_cache_header* hdr, std::string* cache_name)
+{
+  struct stat st;
+  if (::fstat(this->input_file_->file().descriptor(), &st) < 0)
+    return false;
+
+  memset(hdr, 0, sizeof(*hdr));
+  memcpy(hdr->magic, armap_cache_magic, sizeof(hdr->magic));
+  hdr->word_size = sizeof(size_t);
+  hdr->file_size = st.st_size;
+#ifdef HAVE_STAT_ST_MTIM
+  hdr->mtime_seconds = st.st_mtim.tv_sec;
+  hdr->mtime_nanoseconds = st.st_mtim.tv_nsec;
+#else
+  hdr->mtime_seconds = st.st_mtime;
+#endif
+  hdr->inode = st.st_ino;
+  hdr->device = st.st_dev;
+  const std::string& filename(this->input_file_->found_name());
+  hdr->name_size = filename.size();
+
+  char buf[64];
+  snprintf(buf, sizeof(buf), "/%016llx-%llx.armap",
+	   static_cast<unsigned long long>(
+	       Stringpool::string_hash(filename.data(), filename.size())),
+	   static_cast<unsigned long long>(hdr->inode));
+  cache_name->assign(parameters->options().archive_cache());
+  cache_name->append(buf);
+  return true;
+}
+
+// Read the archive map from the cache entry CACHE_NAME, if it is the
+// entry for KEY.  We check everything we use, so that a damaged entry
+// is just ignored.
+
+bool
+Archive::read_armap_cache(const Armap_cache_header& key,
+			  const std::string& cache_name)
+{
+  int o = open_descriptor(-1, cache_name.c_str(), O_RDONLY);
+  if (o < 0)
+    return false;
+
+  // Read the file into 64-bit words, so that the header and the
+  // archive map are aligned.
+  std::vector<uint64_t> words;
+  struct stat st;
+  bool ok = (::fstat(o, &st) == 0
+	     && static_cast<uint64_t>(st.st_size) >= sizeof(key));
+  if (ok)
+    {
+      size_t size = st.st_size;
+      words.resize((size + 7) / 8);
+      unsigned char* p = reinterpret_cast<unsigned char*>(&words[0]);
+      while (ok && size > 0)
+	{
+	  ssize_t got = ::read(o, p, size);
+	  if (got <= 0)
+	    ok = false;
+	  else
+	    {
+	      p += got;
+	      size -= got;
+	    }
+	}
+    }
+  release_descriptor(o, true);
+  if (!ok)
+    return false;
+
+  Armap_cache_header hdr;
+  memcpy(&hdr, &words[0], sizeof(hdr));
+  if (memcmp(&hdr, &key, offsetof(Armap_cache_header, armap_count)) != 0)
+    return false;
+
+  const uint64_t count = hdr.armap_count;
+  const uint64_t index_count = hdr.index_count;
+  if (count > static_cast<uint64_t>(st.st_size)
+      || (index_count != 0 && index_count != count)
+      || hdr.names_size == 0)
+    return false;
+  const uint64_t strings = sizeof(hdr) + (count + index_count) * 16;
+  if (strings + hdr.name_size + hdr.names_size + hdr.extended_names_size
+      != static_cast<uint64_t>(st.st_size))
+    return false;
+
+  const uint64_t* pw = &words[sizeof(hdr) / 8];
+  const char* pnames = (reinterpret_cast<const char*>(&words[0])
+			+ strings);
+  const std::string& filename(this->input_file_->found_name());
+  if (memcmp(pnames, filename.data(), filename.size()) != 0)
+    return false;
+  pnames += hdr.name_size;
+  if (pnames[hdr.names_size - 1] != '\0')
+    return false;
+
+  std::vector<Armap_entry> armap(count);
+  for (uint64_t i = 0; i < count; ++i, pw += 2)
+    {
+      if (pw[0] >= hdr.names_size)
+	return false;
+      armap[i].name_offset = pw[0];
+      armap[i].file_offset = pw[1];
+    }
+  std::vector<Armap_index_entry> index(index_count);
+  for (uint64_t i = 0; i < index_count; ++i, pw += 2)
+    {
+      if (pw[1] >= count)
+	return false;
+      index[i] = std::make_pair(static_cast<size_t>(pw[0]),
+				static_cast<unsigned int>(pw[1]));
+    }
+
+  this->armap_.swap(armap);
+  this->armap_index_.swap(index);
+  this->armap_names_.assign(pnames, hdr.names_size);
+  this->extended_names_.assign(pnames + hdr.names_size,
+			       hdr.extended_names_size);
+  this->num_members_ = hdr.member_count;
+  this->armap_checked_.resize(count);
+  return true;
+}
+
+// Write the archive map to the cache entry CACHE_NAME.  We write a
+// temporary file and rename it, so that other links never see part
+// of an entry.  Failing to write the cache is not an error.
+
+void
+Archive::write_armap_cache(const Armap_cache_header& key,
+			   const std::string& cache_name)
+{
+  if (this->armap_.empty())
+    return;
+  if (this->armap_index_.empty())
+    this->build_armap_index();
+
+  Armap_cache_header hdr = key;
+  hdr.armap_count = this->armap_.size();
+  hdr.member_count = this->num_members_;
+  hdr.names_size = this->armap_names_.size();
+  hdr.extended_names_size = this->extended_names_.size();
+  hdr.index_count = this->armap_index_.size();
+
+  std::vector<uint64_t> words;
+  words.reserve(sizeof(hdr) / 8 + (hdr.armap_count + hdr.index_count) * 2);
+  words.resize(sizeof(hdr) / 8);
+  memcpy(&words[0], &hdr, sizeof(hdr));
+  for (std::vector<Armap_entry>::const_iterator p = this->armap_.begin();
+       p != this->armap_.end();
+       ++p)
+    {
+      words.push_back(p->name_offset);
+      words.push_back(p->file_offset);
+    }
+  for (std::vector<Armap_index_entry>::const_iterator p =
+	 this->armap_index_.begin();
+       p != this->armap_index_.end();
+       ++p)
+    {
+      words.push_back(p->first);
+      words.push_back(p->second);
+    }
+
+  std::string tmpname(cache_name);
+  tmpname.append(".XXXXXX");
+  int o = mkstemps(&tmpname[0], 0);
+  if (o < 0)
+    return;
+
+  const std::string& filename(this->input_file_->found_name());
+  const struct
+  {
+    const void* data;
+    size_t size;
+  } parts[] =
+  {
+    { &words[0], words.size() * 8 },
+    { filename.data(), filename.size() },
+    { this->armap_names_.data(), this->armap_names_.size() },
+    { this->extended_names_.data(), this->extended_names_.size() }
+  };
+  bool ok = true;
+  for (size_t i = 0; ok && i < sizeof(parts) / sizeof(parts[0]); ++i)
+    {
+      const char* p = static_cast<const char*>(parts[i].data);
+      size_t size = parts[i].size;
+      while (ok && size > 0)
+	{
+	  ssize_t wrote = ::write(o, p, size);
+	  if (wrote <= 0)
+	    ok = false;
+	  else
+	    {
+	      p += wrote;
+	      size -= wrote;
+	    }
+	}
+    }
+  if (::close(o) < 0)
+    ok = false;
+  if (!ok || ::rename(tmpname.c_str(), cache_name.c_str()) < 0)
+    ::unlink(tmpname.c_str());
+}
+
 // Read the header of an archive member at OFF.  Fail if something
 // goes wrong.  Return the size of the member.  Set *PNAME to the name
 // of the member.
@@ -769,6 +1058,14 @@ Archive::read_symbols(off_t off)
 // the normal case, false if the first member we tried to add from
 // this archive had an incompatible target.
 
+// Only the first pass over the archive map has to look at every
+// symbol.  After that a symbol can only pull in its element if a
+// symbol with the same name has since become a strong undefined
+// symbol, so later passes, including the passes made when the
+// archive is seen again in a group, only look up the symbols named
+// by the new undefined symbols.  They are still looked up in archive
+// map order, so the same elements are included in the same order.
+
 bool
 Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 		     Input_objects* input_objects, Mapfile* mapfile)
@@ -785,6 +1082,20 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 
   const size_t armap_size = this->armap_.size();
 
+  // When using plugins, defines_symbol relies on armap_checked_
+  // recording every symbol we found to be defined, so we always look
+  // at the whole archive map.
+  const bool use_index = !parameters->options().has_plugins();
+  bool scan_all = !use_index || !this->scanned_armap_;
+  this->scanned_armap_ = true;
+
+  size_t undefined_pos = this->undefined_seen_;
+  std::vector<unsigned int> candidates;
+  if (!scan_all)
+    this->find_undefined_armap_symbols(symtab, &undefined_pos, &candidates);
+  else
+    undefined_pos = symtab->new_undefined_symbols().size();
+
   // This is a quick optimization, since we usually see many symbols
   // in a row with the same offset.  last_seen_offset holds the last
   // offset we saw that was present in the seen_offsets_ set.
@@ -799,8 +1110,58 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   do
     {
       added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+
+      // The symbols which become undefined after this point are
+      // looked up again in the next pass.
+      const size_t pass_start = undefined_pos;
+
+      std::priority_queue<unsigned int, std::vector<unsigned int>,
+			  std::greater<unsigned int> > queue;
+      if (!scan_all)
 	{
+	  // Script references and the entry symbol are not in the
+	  // list of undefined symbols.  There are only a few of them.
+	  const Script_options* so = layout->script_options();
+	  for (Script_options::referenced_const_iterator p =
+		 so->referenced_begin();
+	       p != so->referenced_end();
+	       ++p)
+	    this->find_armap_symbols(p->data(), p->length(), &candidates);
+	  const char* entry_sym = parameters->entry();
+	  if (entry_sym != NULL && !parameters->options().relocatable())
+	    this->find_armap_symbols(entry_sym, strlen(entry_sym),
+				     &candidates);
+
+	  for (std::vector<unsigned int>::const_iterator p =
+		 candidates.begin();
+	       p != candidates.end();
+	       ++p)
+	    queue.push(*p);
+	}
+      candidates.clear();
+
+      size_t next = 0;
+      size_t last_index = armap_size;
+      while (true)
+	{
+	  size_t i;
+	  if (scan_all)
+	    {
+	      if (next >= armap_size)
+		break;
+	      i = next++;
+	    }
+	  else
+	    {
+	      if (queue.empty())
+		break;
+	      i = queue.top();
+	      queue.pop();
+	      if (i == last_index)
+		continue;
+	      last_index = i;
+	    }
+
           if (this->armap_checked_[i])
             continue;
 	  if (this->armap_[i].file_offset == last_seen_offset)
@@ -821,6 +1182,7 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 
           Symbol* sym;
           std::string why;
+	  ++Archive::total_armap_lookups;
           Archive::Should_include t =
 	    Archive::should_include_member(symtab, layout, sym_name, &sym,
 					   &why, &tmpbuf, &tmpbuflen);
@@ -846,10 +1208,35 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 	    }
 
 	  added_new_object = true;
+
+	  // A scan of the whole archive map would still see the
+	  // symbols later in the map which have just become
+	  // undefined, so look them up in this pass.
+	  if (!scan_all)
+	    {
+	      std::vector<unsigned int> more;
+	      this->find_undefined_armap_symbols(symtab, &undefined_pos,
+						 &more);
+	      for (std::vector<unsigned int>::const_iterator p = more.begin();
+		   p != more.end();
+		   ++p)
+		if (*p > i)
+		  queue.push(*p);
+	    }
+	}
+
+      if (added_new_object && use_index)
+	{
+	  scan_all = false;
+	  undefined_pos = pass_start;
+	  this->find_undefined_armap_symbols(symtab, &undefined_pos,
+					     &candidates);
 	}
     }
   while (added_new_object);
 
+  this->undefined_seen_ = undefined_pos;
+
   if (tmpbuf != NULL)
     free(tmpbuf);
 
@@ -858,6 +1245,76 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   return true;
 }
 
+// Push onto CANDIDATES the index of each symbol in the archive map
+// whose name without any version is the LEN characters of NAME, and
+// which we may still need to look at.
+
+void
+Archive::find_armap_symbols(const char* name, size_t len,
+			    std::vector<unsigned int>* candidates)
+{
+  if (this->armap_index_.empty())
+    {
+      if (this->armap_.empty())
+	return;
+      this->build_armap_index();
+    }
+
+  size_t hash = Stringpool::string_hash(name, len);
+  for (std::vector<Armap_index_entry>::const_iterator p =
+	 std::lower_bound(this->armap_index_.begin(),
+			  this->armap_index_.end(),
+			  std::make_pair(hash, 0U));
+       p != this->armap_index_.end() && p->first == hash;
+       ++p)
+    {
+      unsigned int i = p->second;
+      if (this->armap_checked_[i])
+	continue;
+      const char* sym_name = (this->armap_names_.data()
+			      + this->armap_[i].name_offset);
+      if (strncmp(sym_name, name, len) == 0
+	  && (sym_name[len] == '\0' || sym_name[len] == '@'))
+	candidates->push_back(i);
+    }
+}
+
+// Build the index of the archive map by symbol name.
+
+void
+Archive::build_armap_index()
+{
+  const size_t armap_size = this->armap_.size();
+  this->armap_index_.reserve(armap_size);
+  for (size_t i = 0; i < armap_size; ++i)
+    {
+      const char* sym_name = (this->armap_names_.data()
+			      + this->armap_[i].name_offset);
+      size_t sym_len = strcspn(sym_name, "@");
+      this->armap_index_.push_back(
+	  std::make_pair(Stringpool::string_hash(sym_name, sym_len),
+			 static_cast<unsigned int>(i)));
+    }
+  std::sort(this->armap_index_.begin(), this->armap_index_.end());
+}
+
+// Push onto CANDIDATES the symbols in the archive map with the names
+// of the new undefined symbols from *UNDEFINED_POS onward.
+
+void
+Archive::find_undefined_armap_symbols(Symbol_table* symtab,
+				      size_t* undefined_pos,
+				      std::vector<unsigned int>* candidates)
+{
+  const std::vector<Symbol*>& undefs(symtab->new_undefined_symbols());
+  for (size_t i = *undefined_pos; i < undefs.size(); ++i)
+    {
+      const char* name = undefs[i]->name();
+      this->find_armap_symbols(name, strlen(name), candidates);
+    }
+  *undefined_pos = undefs.size();
+}
+
 // Return whether the archive includes a member which defines the
 // symbol SYM.
 
@@ -1089,6 +1546,13 @@ Archive::print_stats()
           program_name, Archive::total_members);
   fprintf(stderr, _("%s: loaded archive members: %u\n"),
           program_name, Archive::total_members_loaded);
+  fprintf(stderr, _("%s: archive symbol lookups: %llu\n"),
+          program_name,
+	  static_cast<unsigned long long>(Archive::total_armap_lookups));
+  if (parameters->options().user_set_archive_cache())
+    fprintf(stderr, _("%s: archive map cache hits: %u; misses: %u\n"),
+	    program_name, Archive::total_cache_hits,
+	    Archive::total_cache_misses);
 }
 
 // Add_archive_symbols methods.
@@ -1135,6 +1599,7 @@ Add_archive_symbols::run(Workqueue* workqueue)
   bool added = this->archive_->add_symbols(this->symtab_, this->layout_,
 					   this->input_objects_,
 					   this->mapfile_);
+  this->symtab_->queue_pending_symbols(workqueue);
   this->archive_->unlock_nested_archives();
 
   this->archive_->release();
@@ -1342,7 +1807,7 @@ Add_lib_group_symbols::locks(Task_locker* tl)
 }
 
 void
-Add_lib_group_symbols::run(Workqueue*)
+Add_lib_group_symbols::run(Workqueue* workqueue)
 {
   // For an incremental link, begin recording layout information.
   Incremental_inputs* incremental_inputs = this->layout_->incremental_inputs();
@@ -1350,6 +1815,7 @@ Add_lib_group_symbols::run(Workqueue*)
     incremental_inputs->report_archive_begin(this->lib_, 0, NULL);
 
   this->lib_->add_symbols(this->symtab_, this->layout_, this->input_objects_);
+  this->symtab_->queue_pending_symbols(workqueue);
 
   if (incremental_inputs != NULL)
     incremental_inputs->report_archive_end(this->lib_);
@@ -286,6 +286,11 @@ class Archive : public Library_base
   static unsigned int total_members;
   // Number of archive members loaded.
   static unsigned int total_members_loaded;
+  // Number of archive map symbols looked up in the symbol table.
+  static uint64_t total_armap_lookups;
+  // Number of archive maps found and not found in the cache.
+  static unsigned int total_cache_hits;
+  static unsigned int total_cache_misses;
 
   // Get a view into the underlying file.
   const unsigned char*
@@ -297,6 +302,33 @@ class Archive : public Library_base
   void
   read_armap(off_t start, section_size_type size);
 
+  // The header of an entry in the archive map cache.
+  struct Armap_cache_header;
+
+  // Set *HDR to the header which an entry in the --archive-cache
+  // directory must have for this archive, and *CACHE_NAME to the
+  // name of the entry.  Returns false if the archive can not be
+  // cached.
+  bool
+  armap_cache_key(Armap_cache_header* hdr, std::string* cache_name);
+
+  // Read the archive map, extended name table and archive map index
+  // from the cache entry CACHE_NAME.  Returns false if there is no
+  // usable entry.
+  bool
+  read_armap_cache(const Armap_cache_header& key,
+		   const std::string& cache_name);
+
+  // Write the archive map, extended name table and archive map index
+  // to the cache entry CACHE_NAME.
+  void
+  write_armap_cache(const Armap_cache_header& key,
+		    const std::string& cache_name);
+
+  // Build armap_index_.
+  void
+  build_armap_index();
+
   // Read an archive member header at OFF.  CACHE is whether to cache
   // the file view.  Return the size of the member, and set *PNAME to
   // the name.
@@ -340,6 +372,20 @@ class Archive : public Library_base
   include_member(Symbol_table*, Layout*, Input_objects*, off_t off,
 		 Mapfile*, Symbol*, const char* why);
 
+  // Push onto CANDIDATES the index of each symbol in the archive map
+  // whose name, without any version, is the LEN characters of NAME.
+  void
+  find_armap_symbols(const char* name, size_t len,
+		     std::vector<unsigned int>* candidates);
+
+  // Push onto CANDIDATES the archive map symbols which may now cause
+  // a member to be included, because their names are those of the
+  // strong undefined symbols recorded from *UNDEFINED_POS onward.
+  // This updates *UNDEFINED_POS.
+  void
+  find_undefined_armap_symbols(Symbol_table*, size_t* undefined_pos,
+			       std::vector<unsigned int>* candidates);
+
   // Return whether we found this archive by searching a directory.
   bool
   searched_for() const
@@ -369,6 +415,10 @@ class Archive : public Library_base
     off_t file_offset;
   };
 
+  // An entry in the index of the archive map by symbol name, which is
+  // sorted by hash code.  The hash code does not include any version.
+  typedef std::pair<size_t, unsigned int> Armap_index_entry;
+
   // A simple hash code for off_t values.
   class Seen_hash
   {
@@ -395,6 +445,14 @@ class Archive : public Library_base
   std::vector<bool> armap_checked_;
   // Track which elements have been included by offset.
   Unordered_set<off_t, Seen_hash> seen_offsets_;
+  // The index of the archive map by symbol name.  This is built the
+  // first time we look at the archive again, or read from the cache.
+  std::vector<Armap_index_entry> armap_index_;
+  // Whether we have looked at every symbol in the archive map.
+  bool scanned_armap_;
+  // The number of entries in the symbol table's list of new undefined
+  // symbols which we have already looked at.
+  size_t undefined_seen_;
   // Table of objects whose symbols have been pre-read.
   std::map<off_t, Archive_member> members_;
   // True if this is a thin archive.
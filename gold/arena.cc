@@ -0,0 +1,82 @@
+// arena.cc -- memory arenas for gold
+
+// Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include "arena.h"
+
+namespace gold
+{
+
+// Class Arena.
+
+const size_t Arena::alignment;
+const size_t Arena::min_block_size;
+const size_t Arena::max_block_size;
+
+void*
+Arena::allocate(size_t len)
+{
+  len = (len + alignment - 1) & ~(alignment - 1);
+  this->allocated_ += len;
+
+  // A large allocation gets a block of its own, so that it does not
+  // waste the rest of the current block.
+  if (len > max_block_size / 4)
+    {
+      unsigned char* block = new unsigned char[len];
+      this->blocks_.push_back(block);
+      return block;
+    }
+
+  if (len > this->left_)
+    {
+      size_t block_size = this->next_block_size_;
+      while (block_size < len)
+	block_size *= 2;
+      if (this->next_block_size_ < max_block_size)
+	this->next_block_size_ *= 2;
+      this->next_ = new unsigned char[block_size];
+      this->left_ = block_size;
+      this->blocks_.push_back(this->next_);
+    }
+
+  void* ret = this->next_;
+  this->next_ += len;
+  this->left_ -= len;
+  return ret;
+}
+
+void
+Arena::release()
+{
+  for (std::vector<unsigned char*>::iterator p = this->blocks_.begin();
+       p != this->blocks_.end();
+       ++p)
+    delete[] *p;
+  std::vector<unsigned char*>().swap(this->blocks_);
+  this->next_ = NULL;
+  this->left_ = 0;
+  this->next_block_size_ = min_block_size;
+  this->allocated_ = 0;
+}
+
+} // End namespace gold.
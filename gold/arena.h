@@ -0,0 +1,203 @@
+// arena.h -- memory arenas for gold   -*- C++ -*-
+
+// Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_ARENA_H
+#define GOLD_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace gold
+{
+
+// An arena hands out memory carved from large blocks, which saves the
+// malloc overhead of each allocation and keeps related data close
+// together.  The memory is never freed piece by piece: it is all freed
+// at once by release or by the destructor.  An arena is not locked, so
+// it may only be used by one thread at a time.
+
+class Arena
+{
+ public:
+  // The alignment of the memory returned by allocate.  This is enough
+  // for the pointers and 64-bit values which gold stores in an arena.
+  static const size_t alignment = 8;
+
+  Arena()
+    : blocks_(), next_(NULL), left_(0), next_block_size_(min_block_size),
+      allocated_(0)
+  { }
+
+  ~Arena()
+  { this->release(); }
+
+  // Return LEN bytes of memory, aligned to ALIGNMENT.
+  void*
+  allocate(size_t len);
+
+  // Free all the memory handed out by this arena.  The arena may be
+  // used again afterward.
+  void
+  release();
+
+  // Return the number of bytes handed out.
+  size_t
+  allocated() const
+  { return this->allocated_; }
+
+  // Return the number of blocks.
+  size_t
+  block_count() const
+  { return this->blocks_.size(); }
+
+ private:
+  Arena(const Arena&);
+  Arena& operator=(const Arena&);
+
+  // The size of the first block.  Each new block is twice the size of
+  // the one before, up to MAX_BLOCK_SIZE, so that an arena which is
+  // used for a few small allocations stays small.
+  static const size_t min_block_size = 1024;
+  // The size of the largest block.  An allocation larger than a
+  // quarter of this gets a block of its own.
+  static const size_t max_block_size = 64 * 1024;
+
+  // The blocks allocated so far.
+  std::vector<unsigned char*> blocks_;
+  // The next free byte in the current block.
+  unsigned char* next_;
+  // The number of free bytes in the current block.
+  size_t left_;
+  // The size of the next block to allocate.
+  size_t next_block_size_;
+  // The number of bytes handed out.
+  size_t allocated_;
+};
+
+// An allocator for the standard containers which takes its memory
+// from an Arena.  Since an arena does not free memory piece by piece,
+// deallocate does nothing; the memory is freed when the arena is
+// released.  A container using this allocator must therefore not be
+// used after its arena has been released, except to be destroyed.
+
+template<typename T>
+class Arena_allocator
+{
+ public:
+  typedef T value_type;
+
+  explicit Arena_allocator(Arena* arena)
+    : arena_(arena)
+  { }
+
+  template<typename U>
+  Arena_allocator(const Arena_allocator<U>& other)
+    : arena_(other.arena())
+  { }
+
+  T*
+  allocate(size_t n)
+  { return static_cast<T*>(this->arena_->allocate(n * sizeof(T))); }
+
+  void
+  deallocate(T*, size_t)
+  { }
+
+  // Return the arena.
+  Arena*
+  arena() const
+  { return this->arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+template<typename T, typename U>
+inline bool
+operator==(const Arena_allocator<T>& a, const Arena_allocator<U>& b)
+{ return a.arena() == b.arena(); }
+
+template<typename T, typename U>
+inline bool
+operator!=(const Arena_allocator<T>& a, const Arena_allocator<U>& b)
+{ return a.arena() != b.arena(); }
+
+// An allocator for the node-based containers, such as Unordered_map,
+// which takes the nodes from an Arena.  Each node is allocated by
+// itself, so a request for a single object comes from the arena, while
+// a request for an array, such as the bucket array of a hash table,
+// comes from operator new and is freed normally when the table grows.
+// As with Arena_allocator, a node which is erased is not freed until
+// the arena is released.
+
+template<typename T>
+class Arena_node_allocator
+{
+ public:
+  typedef T value_type;
+
+  explicit Arena_node_allocator(Arena* arena)
+    : arena_(arena)
+  { }
+
+  template<typename U>
+  Arena_node_allocator(const Arena_node_allocator<U>& other)
+    : arena_(other.arena())
+  { }
+
+  T*
+  allocate(size_t n)
+  {
+    if (n == 1)
+      return static_cast<T*>(this->arena_->allocate(sizeof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void
+  deallocate(T* p, size_t n)
+  {
+    if (n != 1)
+      ::operator delete(p);
+  }
+
+  // Return the arena.
+  Arena*
+  arena() const
+  { return this->arena_; }
+
+ private:
+  Arena* arena_;
+};
+
+template<typename T, typename U>
+inline bool
+operator==(const Arena_node_allocator<T>& a, const Arena_node_allocator<U>& b)
+{ return a.arena() == b.arena(); }
+
+template<typename T, typename U>
+inline bool
+operator!=(const Arena_node_allocator<T>& a, const Arena_node_allocator<U>& b)
+{ return a.arena() != b.arena(); }
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_ARENA_H)
@@ -12485,11 +12485,12 @@ Target_arm<big_endian>::do_relax(
 
   // Check all stub tables to see if any of them have their data sizes
   // or addresses alignments changed.  These are the only things that
-  // matter.
-  bool any_stub_table_changed = false;
+  // matter.  We update all of them, so that the next pass lays out
+  // every stub table which grew at once.
+  unsigned int changed_groups = 0;
   Unordered_set<const Output_section*> sections_needing_adjustment;
   for (Stub_table_iterator sp = this->stub_tables_.begin();
-       (sp != this->stub_tables_.end()) && !any_stub_table_changed;
+       sp != this->stub_tables_.end();
        ++sp)
     {
       if ((*sp)->update_data_size_and_addralign())
@@ -12502,9 +12503,13 @@ Target_arm<big_endian>::do_relax(
 	  owner->set_address_and_file_offset(address, offset);
 
 	  sections_needing_adjustment.insert(owner->output_section());
-	  any_stub_table_changed = true;
+	  ++changed_groups;
 	}
     }
+  bool any_stub_table_changed = changed_groups > 0;
+
+  if (parameters->options().stats())
+    layout->record_relaxation_pass(changed_groups, 0, 0);
 
   // Output_section_data::output_section() returns a const pointer but we
   // need to update output sections, so we record all output sections needing
@@ -0,0 +1,475 @@
+// call-graph.cc -- order sections by a call graph profile for gold
+
+// Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "parameters.h"
+#include "options.h"
+#include "fileread.h"
+#include "symtab.h"
+#include "object.h"
+#include "icf.h"
+#include "layout.h"
+#include "output.h"
+#include "call-graph.h"
+
+namespace gold
+{
+
+// A cluster may not grow beyond this many bytes.
+const uint64_t max_cluster_size = 1024 * 1024;
+
+// Nor may merging a cluster into its caller's cluster make the density
+// of the latter drop by more than this factor.
+const double max_density_degradation = 8.0;
+
+// A section in the call graph.  Every section starts out as the leader
+// of a cluster which only holds itself.
+
+struct Call_graph::Node
+{
+  Node(const Section_id& a_section, unsigned int index)
+    : section(a_section), size(0), weight(0), initial_weight(0),
+      best_pred(-1U), best_pred_weight(0), leader(index), next(index),
+      prev(index)
+  { }
+
+  // The density of the cluster which this node leads.
+  double
+  density() const
+  { return this->size == 0 ? 0 : double(this->weight) / double(this->size); }
+
+  // The input section.
+  Section_id section;
+  // The size of the cluster.  This is zero if the node no longer
+  // leads a cluster.
+  uint64_t size;
+  // The number of calls into the cluster.
+  uint64_t weight;
+  // The number of calls into the section.
+  uint64_t initial_weight;
+  // The node which calls the section most often, or -1U, and the
+  // number of those calls.
+  unsigned int best_pred;
+  uint64_t best_pred_weight;
+  // The leader of the cluster, if this node has been merged into
+  // another cluster.  The leaders form a union-find forest.
+  unsigned int leader;
+  // The next and previous nodes in the circular list of the sections
+  // of the cluster.  The list is only meaningful for a leader.
+  unsigned int next;
+  unsigned int prev;
+};
+
+// Sort the leaders of clusters by decreasing density.
+
+class Call_graph_density_compare
+{
+ public:
+  Call_graph_density_compare(const std::vector<double>& densities)
+    : densities_(densities)
+  { }
+
+  bool
+  operator()(unsigned int i, unsigned int j) const
+  { return this->densities_[i] > this->densities_[j]; }
+
+ private:
+  const std::vector<double>& densities_;
+};
+
+// Read the call graph and record the order of the input sections in
+// LAYOUT.
+
+void
+Call_graph::order_sections(const Task* task,
+			   const Input_objects* input_objects,
+			   const Symbol_table* symtab,
+			   Layout* layout)
+{
+  if (parameters->options().call_graph_profile_sort())
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  Task_lock_obj<Object> tlo(task, *p);
+	  (*p)->read_call_graph_profile(symtab, this);
+	}
+    }
+
+  const char* filename = parameters->options().call_graph_ordering_file();
+  if (filename != NULL)
+    this->read_file(filename, task, input_objects, symtab);
+
+  if (!this->edges_.empty())
+    this->compute_order(task, input_objects, symtab, layout);
+}
+
+// Set *PSECTION to the input section which defines SYM.
+
+bool
+Call_graph::symbol_section(const Symbol_table* symtab, const Symbol* sym,
+			   Section_id* psection)
+{
+  if (sym->is_forwarder())
+    sym = symtab->resolve_forwards(sym);
+  if (sym->source() != Symbol::FROM_OBJECT)
+    return false;
+
+  bool is_ordinary;
+  unsigned int shndx = sym->shndx(&is_ordinary);
+  if (!is_ordinary || shndx == elfcpp::SHN_UNDEF)
+    return false;
+
+  Object* object = sym->object();
+  if (object->is_dynamic() || object->pluginobj() != NULL)
+    return false;
+
+  *psection = Section_id(static_cast<Relobj*>(object), shndx);
+  return true;
+}
+
+// Record that the local symbol NAME is defined in SECTION.
+
+void
+Call_graph::add_local_symbol(const char* name, const Section_id& section)
+{
+  Unordered_map<std::string, Section_id>::iterator p =
+    this->local_symbols_.find(name);
+  if (p != this->local_symbols_.end() && p->second.first == NULL)
+    p->second = section;
+}
+
+// A line of --call-graph-ordering-file: the names of the caller and
+// the callee, the sections which define them, and the weight.
+
+struct Call_graph_file_line
+{
+  std::string name[2];
+  Section_id section[2];
+  uint64_t weight;
+};
+
+// Read the edges from --call-graph-ordering-file.  Each line holds the
+// names of a caller and a callee and the number of calls, separated by
+// white space.  A name is looked up in the global symbol table first,
+// and then among the local symbols of the input objects.  Lines naming
+// symbols which are not defined in an input section are ignored, since
+// a profile may be older than the program.
+
+void
+Call_graph::read_file(const char* filename, const Task* task,
+		      const Input_objects* input_objects,
+		      const Symbol_table* symtab)
+{
+  std::ifstream in;
+  in.open(filename);
+  if (!in)
+    gold_fatal(_("unable to open --call-graph-ordering-file file %s: %s"),
+	       filename, strerror(errno));
+
+  File_read::record_file_read(filename);
+
+  std::vector<Call_graph_file_line> lines;
+
+  std::string text;
+  unsigned int lineno = 0;
+  while (std::getline(in, text))
+    {
+      ++lineno;
+      if (!text.empty() && text[text.length() - 1] == '\r')   // Windows
+	text.resize(text.length() - 1);
+      // Ignore comments, beginning with '#', and empty lines.
+      size_t first = text.find_first_not_of(" \t");
+      if (first == std::string::npos || text[first] == '#')
+	continue;
+
+      std::istringstream fields(text);
+      Call_graph_file_line line;
+      std::string weight;
+      std::string extra;
+      bool ok = false;
+      if ((fields >> line.name[0] >> line.name[1] >> weight)
+	  && !(fields >> extra)
+	  && weight[0] != '-')
+	{
+	  char* end;
+	  line.weight = strtoull(weight.c_str(), &end, 10);
+	  ok = *end == '\0';
+	}
+      if (!ok)
+	{
+	  gold_error(_("%s:%u: expected a caller, a callee and a weight"),
+		     filename, lineno);
+	  continue;
+	}
+
+      for (int i = 0; i < 2; ++i)
+	{
+	  line.section[i] = Section_id(NULL, 0);
+	  const Symbol* sym = symtab->lookup(line.name[i].c_str());
+	  if (sym == NULL
+	      || !Call_graph::symbol_section(symtab, sym, &line.section[i]))
+	    this->local_symbols_[line.name[i]] = Section_id(NULL, 0);
+	}
+      lines.push_back(line);
+    }
+
+  // Look for the names which are not global symbols among the local
+  // symbols.
+  if (!this->local_symbols_.empty())
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  Task_lock_obj<Object> tlo(task, *p);
+	  (*p)->find_call_graph_local_symbols(this);
+	}
+    }
+
+  for (std::vector<Call_graph_file_line>::iterator p = lines.begin();
+       p != lines.end();
+       ++p)
+    {
+      for (int i = 0; i < 2; ++i)
+	if (p->section[i].first == NULL)
+	  p->section[i] = this->local_symbols_[p->name[i]];
+      if (p->section[0].first != NULL && p->section[1].first != NULL)
+	this->add_edge(p->section[0], p->section[1], p->weight);
+    }
+}
+
+// Compute the order of the input sections, and store it in the
+// section order map of LAYOUT.
+
+void
+Call_graph::compute_order(const Task* task,
+			  const Input_objects* input_objects,
+			  const Symbol_table* symtab,
+			  Layout* layout)
+{
+  std::vector<Node> nodes;
+  Unordered_map<Section_id, unsigned int, Section_id_hash> node_map;
+
+  // The total weight of the edges between each pair of nodes, in the
+  // order in which the pairs were first seen.
+  typedef std::pair<unsigned int, unsigned int> Node_pair;
+  std::map<Node_pair, size_t> pair_map;
+  std::vector<std::pair<Node_pair, uint64_t> > pairs;
+
+  for (std::vector<Edge>::const_iterator p = this->edges_.begin();
+       p != this->edges_.end();
+       ++p)
+    {
+      if (p->weight == 0)
+	continue;
+
+      // Use the sections which ICF kept, and ignore the edges between
+      // sections which are discarded or go to different output
+      // sections.
+      Section_id ends[2] = { p->from, p->to };
+      Output_section* os[2];
+      for (int i = 0; i < 2; ++i)
+	{
+	  if (symtab->is_section_folded(ends[i].first, ends[i].second))
+	    ends[i] = symtab->icf()->get_folded_section(ends[i].first,
+							ends[i].second);
+	  os[i] = ends[i].first->output_section(ends[i].second);
+	}
+      if (os[0] == NULL || os[0] != os[1])
+	continue;
+
+      unsigned int index[2];
+      for (int i = 0; i < 2; ++i)
+	{
+	  std::pair<Unordered_map<Section_id, unsigned int,
+				  Section_id_hash>::iterator, bool> ins =
+	    node_map.insert(std::make_pair(ends[i], nodes.size()));
+	  if (ins.second)
+	    nodes.push_back(Node(ends[i], nodes.size()));
+	  index[i] = ins.first->second;
+	}
+
+      std::pair<std::map<Node_pair, size_t>::iterator, bool> ins =
+	pair_map.insert(std::make_pair(Node_pair(index[0], index[1]),
+				       pairs.size()));
+      if (ins.second)
+	pairs.push_back(std::make_pair(Node_pair(index[0], index[1]),
+				       p->weight));
+      else
+	pairs[ins.first->second].second += p->weight;
+    }
+
+  if (nodes.empty())
+    return;
+
+  // Get the section sizes, locking each object in turn.
+  Unordered_map<Relobj*, std::vector<unsigned int> > object_nodes;
+  for (unsigned int i = 0; i < nodes.size(); ++i)
+    object_nodes[nodes[i].section.first].push_back(i);
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Unordered_map<Relobj*, std::vector<unsigned int> >::const_iterator q =
+	object_nodes.find(*p);
+      if (q == object_nodes.end())
+	continue;
+      Task_lock_obj<Object> tlo(task, *p);
+      for (std::vector<unsigned int>::const_iterator r = q->second.begin();
+	   r != q->second.end();
+	   ++r)
+	nodes[*r].size = (*p)->section_size(nodes[*r].section.second);
+    }
+
+  // Find the most frequent caller of each section.
+  for (std::vector<std::pair<Node_pair, uint64_t> >::const_iterator p =
+	 pairs.begin();
+       p != pairs.end();
+       ++p)
+    {
+      unsigned int from = p->first.first;
+      unsigned int to = p->first.second;
+      uint64_t weight = p->second;
+      Node& to_node(nodes[to]);
+      to_node.weight += weight;
+      if (from == to)
+	continue;
+      if (to_node.best_pred == -1U || to_node.best_pred_weight < weight)
+	{
+	  to_node.best_pred = from;
+	  to_node.best_pred_weight = weight;
+	}
+    }
+  for (std::vector<Node>::iterator p = nodes.begin(); p != nodes.end(); ++p)
+    p->initial_weight = p->weight;
+
+  std::vector<double> densities(nodes.size());
+  std::vector<unsigned int> sorted(nodes.size());
+  for (unsigned int i = 0; i < nodes.size(); ++i)
+    {
+      densities[i] = nodes[i].density();
+      sorted[i] = i;
+    }
+  std::stable_sort(sorted.begin(), sorted.end(),
+		   Call_graph_density_compare(densities));
+
+  // Merge each section into the cluster of its most frequent caller.
+  for (std::vector<unsigned int>::const_iterator p = sorted.begin();
+       p != sorted.end();
+       ++p)
+    {
+      // A node is only merged into another cluster when it is visited
+      // itself, so L still leads its own cluster here.  Callees visited
+      // earlier may already have been merged into it, so C's size and
+      // weight are those of the whole cluster.
+      unsigned int l = *p;
+      Node& c(nodes[l]);
+
+      // Ignore unlikely callers.
+      if (c.best_pred == -1U || c.best_pred_weight * 10 <= c.initial_weight)
+	continue;
+
+      // Find the leader of the caller's cluster, halving the paths.
+      unsigned int pred_l = c.best_pred;
+      while (nodes[pred_l].leader != pred_l)
+	{
+	  nodes[pred_l].leader = nodes[nodes[pred_l].leader].leader;
+	  pred_l = nodes[pred_l].leader;
+	}
+      if (pred_l == l)
+	continue;
+
+      Node& pred_c(nodes[pred_l]);
+      if (c.size + pred_c.size > max_cluster_size)
+	continue;
+      double new_density = (double(c.weight + pred_c.weight)
+			    / double(c.size + pred_c.size));
+      if (new_density < pred_c.density() / max_density_degradation)
+	continue;
+
+      // Append the sections of C to the cluster of PRED_C.
+      c.leader = pred_l;
+      unsigned int tail1 = pred_c.prev;
+      unsigned int tail2 = c.prev;
+      pred_c.prev = tail2;
+      nodes[tail2].next = pred_l;
+      c.prev = tail1;
+      nodes[tail1].next = l;
+      pred_c.size += c.size;
+      pred_c.weight += c.weight;
+      c.size = 0;
+      c.weight = 0;
+    }
+
+  // Lay out the clusters by decreasing density.  Those which are never
+  // called come last.
+  sorted.clear();
+  for (unsigned int i = 0; i < nodes.size(); ++i)
+    {
+      if (nodes[i].leader == i)
+	{
+	  densities[i] = nodes[i].density();
+	  sorted.push_back(i);
+	}
+    }
+  std::stable_sort(sorted.begin(), sorted.end(),
+		   Call_graph_density_compare(densities));
+
+  std::map<Section_id, unsigned int>* order_map =
+    layout->get_section_order_map();
+  Unordered_set<Output_section*> output_sections;
+  unsigned int position = 0;
+  for (std::vector<unsigned int>::const_iterator p = sorted.begin();
+       p != sorted.end();
+       ++p)
+    {
+      unsigned int i = *p;
+      do
+	{
+	  const Section_id& section(nodes[i].section);
+	  (*order_map)[section] = ++position;
+	  output_sections.insert(section.first->output_section(section.second));
+	  i = nodes[i].next;
+	}
+      while (i != *p);
+    }
+
+  // Put the other input sections of the output sections after the
+  // sections in the graph.
+  for (Unordered_set<Output_section*>::const_iterator p =
+	 output_sections.begin();
+       p != output_sections.end();
+       ++p)
+    (*p)->update_section_layout(order_map, position + 1);
+}
+
+} // End namespace gold.
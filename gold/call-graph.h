@@ -0,0 +1,119 @@
+// call-graph.h -- order sections by a call graph profile for gold
+
+// Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_CALL_GRAPH_H
+#define GOLD_CALL_GRAPH_H
+
+#include <string>
+#include <vector>
+
+#include "object.h"
+
+namespace gold
+{
+
+class Input_objects;
+class Layout;
+class Symbol;
+class Symbol_table;
+class Task;
+
+// A weighted call graph between input sections, used to order the
+// sections for --call-graph-ordering-file and --call-graph-profile-sort.
+// The edges come from a file in which each line names a caller and a
+// callee and gives the number of calls, or from the
+// .llvm.call-graph-profile sections of the input objects.
+
+// The sections are ordered with the C3 heuristic of Ottoni and Maher.
+// In order of decreasing call density, each section is appended to the
+// cluster of its most frequent caller, as long as the cluster stays
+// small and dense.  The clusters are then laid out by decreasing
+// density.  In each output section, the sections in the graph come
+// first, followed by the other input sections in input order, so that
+// the code which runs is kept apart from the code which does not.
+
+class Call_graph
+{
+ public:
+  Call_graph()
+    : edges_(), local_symbols_()
+  { }
+
+  // Read the call graph and record the order of the input sections
+  // in LAYOUT.
+  void
+  order_sections(const Task*, const Input_objects*, const Symbol_table*,
+		 Layout*);
+
+  // Add an edge of weight WEIGHT from the section FROM to the section
+  // TO.
+  void
+  add_edge(const Section_id& from, const Section_id& to, uint64_t weight)
+  { this->edges_.push_back(Edge(from, to, weight)); }
+
+  // Set *PSECTION to the input section which defines SYM.  Return
+  // false if SYM is not defined in a section of a regular object.
+  static bool
+  symbol_section(const Symbol_table*, const Symbol* sym,
+		 Section_id* psection);
+
+  // Record that the local symbol NAME is defined in SECTION, if we are
+  // looking for it and have not found it yet.
+  void
+  add_local_symbol(const char* name, const Section_id& section);
+
+ private:
+  // An edge of the call graph.
+  struct Edge
+  {
+    Edge(const Section_id& a_from, const Section_id& a_to, uint64_t a_weight)
+      : from(a_from), to(a_to), weight(a_weight)
+    { }
+
+    Section_id from;
+    Section_id to;
+    uint64_t weight;
+  };
+
+  // A section in the graph, and the cluster it leads, if any.
+  struct Node;
+
+  // Read the edges from --call-graph-ordering-file.
+  void
+  read_file(const char* filename, const Task*, const Input_objects*,
+	    const Symbol_table*);
+
+  // Compute the order of the input sections and store it in LAYOUT.
+  void
+  compute_order(const Task*, const Input_objects*, const Symbol_table*,
+		Layout*);
+
+  // The edges in the order in which they were found.
+  std::vector<Edge> edges_;
+  // The local symbols named in --call-graph-ordering-file which are
+  // not global symbols, and the sections which define them.  The
+  // section is (NULL, 0) until the symbol is found.
+  Unordered_map<std::string, Section_id> local_symbols_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_CALL_GRAPH_H)
@@ -21,22 +21,289 @@
 // MA 02110-1301, USA.
 
 #include "gold.h"
+#include <algorithm>
+#include <vector>
 #include <zlib.h>
 #ifdef HAVE_ZSTD
 #include <zstd.h>
 #endif
 #include "parameters.h"
 #include "options.h"
+#include "gold-threads.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
+// Sections larger than this are compressed in chunks of this size,
+// so that the chunks can be compressed in parallel.  The chunks do
+// not depend on the number of threads, so neither does the output.
+// A zlib chunk is primed with the last 32K bytes of the previous
+// chunk, so chunking costs almost nothing in compression ratio.  A
+// zstd chunk is a separate frame, so zstd chunks are larger.
+
+static const unsigned long zlib_chunk_size = 1024 * 1024;
+#ifdef HAVE_ZSTD
+static const unsigned long zstd_chunk_size = 4 * 1024 * 1024;
+#endif
+
+// The size of the zlib window, which is the most that a chunk can
+// refer back into the previous chunk.
+
+static const unsigned long zlib_window_size = 32 * 1024;
+
+// This class compresses a buffer in chunks, using several threads.
+// Each chunk is compressed into its own buffer.  For zlib, each chunk
+// is raw deflate data ending at a sync flush point, except the last
+// one, which ends the deflate stream; the caller adds the zlib header
+// and trailer.  For zstd, each chunk is a complete frame.
+
+class Compress_chunks : public Parallel_run
+{
+ public:
+  enum Method
+  {
+    COMPRESS_ZLIB,
+    COMPRESS_ZSTD
+  };
+
+  Compress_chunks(Method method, int level, const unsigned char* data,
+		  unsigned long size, unsigned long chunk_size)
+    : method_(method), level_(level), data_(data), size_(size),
+      chunk_size_(chunk_size), chunks_((size + chunk_size - 1) / chunk_size),
+      thread_count_(1)
+  { }
+
+  ~Compress_chunks()
+  {
+    for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+      delete[] this->chunks_[i].data;
+  }
+
+  // Compress all the chunks.  Returns false if any chunk failed.
+  bool
+  compress();
+
+  // The number of chunks.
+  unsigned int
+  chunk_count() const
+  { return this->chunks_.size(); }
+
+  // The compressed data of chunk I.
+  const unsigned char*
+  chunk_data(unsigned int i) const
+  { return this->chunks_[i].data; }
+
+  // The compressed size of chunk I.
+  unsigned long
+  chunk_size(unsigned int i) const
+  { return this->chunks_[i].size; }
+
+  // The Adler-32 checksum of the uncompressed data of chunk I.  This
+  // is only set for zlib.
+  unsigned long
+  chunk_adler(unsigned int i) const
+  { return this->chunks_[i].adler; }
+
+  // The uncompressed size of chunk I.
+  unsigned long
+  chunk_input_size(unsigned int i) const
+  {
+    return std::min(this->chunk_size_,
+		    this->size_ - static_cast<unsigned long>(i)
+				  * this->chunk_size_);
+  }
+
+ protected:
+  void
+  do_run(unsigned int index);
+
+ private:
+  // A compressed chunk.
+  struct Chunk
+  {
+    Chunk()
+      : data(NULL), size(0), adler(0), ok(false)
+    { }
+
+    unsigned char* data;
+    unsigned long size;
+    unsigned long adler;
+    bool ok;
+  };
+
+  // Compress chunk I.
+  bool
+  compress_chunk(unsigned int i, Chunk* chunk);
+
+  Method method_;
+  int level_;
+  const unsigned char* data_;
+  unsigned long size_;
+  unsigned long chunk_size_;
+  std::vector<Chunk> chunks_;
+  unsigned int thread_count_;
+};
+
+bool
+Compress_chunks::compress()
+{
+  this->thread_count_ =
+    std::min(Parallel_run::thread_count(Parallel_run::FINAL_PHASE),
+	     this->chunk_count());
+  this->run(this->thread_count_);
+  for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+    if (!this->chunks_[i].ok)
+      return false;
+  return true;
+}
+
+// Each thread compresses every THREAD_COUNT_th chunk, starting at
+// INDEX.
+
+void
+Compress_chunks::do_run(unsigned int index)
+{
+  for (unsigned int i = index;
+       i < this->chunks_.size();
+       i += this->thread_count_)
+    this->chunks_[i].ok = this->compress_chunk(i, &this->chunks_[i]);
+}
+
+bool
+Compress_chunks::compress_chunk(unsigned int i, Chunk* chunk)
+{
+  const unsigned long start = static_cast<unsigned long>(i) * this->chunk_size_;
+  const unsigned char* in = this->data_ + start;
+  const unsigned long in_size = this->chunk_input_size(i);
+
+#ifdef HAVE_ZSTD
+  if (this->method_ == COMPRESS_ZSTD)
+    {
+      size_t size = ZSTD_compressBound(in_size);
+      chunk->data = new unsigned char[size];
+      size = ZSTD_compress(chunk->data, size, in, in_size, this->level_);
+      if (ZSTD_isError(size))
+	return false;
+      chunk->size = size;
+      return true;
+    }
+#endif
+
+  gold_assert(this->method_ == COMPRESS_ZLIB);
+
+  z_stream strm;
+  memset(&strm, 0, sizeof strm);
+  // A negative window size asks for raw deflate data, without a zlib
+  // header or trailer.
+  if (deflateInit2(&strm, this->level_, Z_DEFLATED, -15, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  // Let this chunk refer back to the end of the previous one, as it
+  // could if the whole buffer were compressed at once.
+  if (start > 0)
+    {
+      unsigned long dict_size = std::min(start, zlib_window_size);
+      if (deflateSetDictionary(&strm,
+			       reinterpret_cast<const Bytef*>(in - dict_size),
+			       dict_size) != Z_OK)
+	{
+	  deflateEnd(&strm);
+	  return false;
+	}
+    }
+
+  // Allow for the empty stored block written by the sync flush.
+  unsigned long out_size = deflateBound(&strm, in_size) + 16;
+  chunk->data = new unsigned char[out_size];
+  strm.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(in));
+  strm.avail_in = in_size;
+  strm.next_out = reinterpret_cast<Bytef*>(chunk->data);
+  strm.avail_out = out_size;
+
+  const bool is_last = i + 1 == this->chunks_.size();
+  int rc = deflate(&strm, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool ok = (is_last
+	     ? rc == Z_STREAM_END
+	     : rc == Z_OK && strm.avail_in == 0 && strm.avail_out > 0);
+  chunk->size = out_size - strm.avail_out;
+  if (deflateEnd(&strm) != Z_OK && rc != Z_STREAM_END && rc != Z_OK)
+    ok = false;
+
+  chunk->adler = adler32(adler32(0, NULL, 0),
+			 reinterpret_cast<const Bytef*>(in), in_size);
+  return ok;
+}
+
+// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE in chunks,
+// producing a single zlib stream.  This is like zlib_compress, below.
+
+static bool
+zlib_compress_chunks(int header_size,
+		     int compress_level,
+		     const unsigned char* uncompressed_data,
+		     unsigned long uncompressed_size,
+		     unsigned char** compressed_data,
+		     unsigned long* compressed_size)
+{
+  Compress_chunks chunks(Compress_chunks::COMPRESS_ZLIB, compress_level,
+			 uncompressed_data, uncompressed_size,
+			 zlib_chunk_size);
+  if (!chunks.compress())
+    {
+      *compressed_data = NULL;
+      *compressed_size = 0;
+      return false;
+    }
+
+  // The zlib header is two bytes, and the trailer is the four byte
+  // Adler-32 checksum of the uncompressed data.
+  unsigned long size = 2 + 4;
+  for (unsigned int i = 0; i < chunks.chunk_count(); ++i)
+    size += chunks.chunk_size(i);
+
+  *compressed_data = new unsigned char[size + header_size];
+  unsigned char* p = *compressed_data + header_size;
+
+  // Write the header the way deflate would for this level: a 32K
+  // window, the level hint, and the check bits.
+  unsigned int level_flags;
+  if (compress_level < 2)
+    level_flags = 0;
+  else if (compress_level < 6)
+    level_flags = 1;
+  else if (compress_level == 6)
+    level_flags = 2;
+  else
+    level_flags = 3;
+  unsigned int header = (0x78 << 8) | (level_flags << 6);
+  header += 31 - header % 31;
+  *p++ = header >> 8;
+  *p++ = header & 0xff;
+
+  uLong adler = chunks.chunk_adler(0);
+  for (unsigned int i = 0; i < chunks.chunk_count(); ++i)
+    {
+      memcpy(p, chunks.chunk_data(i), chunks.chunk_size(i));
+      p += chunks.chunk_size(i);
+      if (i > 0)
+	adler = adler32_combine(adler, chunks.chunk_adler(i),
+				chunks.chunk_input_size(i));
+    }
+  elfcpp::Swap_unaligned<32, true>::writeval(p, adler);
+
+  *compressed_size = size + header_size;
+  return true;
+}
+
 // Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
 // if it successfully compressed, false if it failed for any reason
 // (including not having zlib support in the library).  If it returns
 // true, it allocates memory for the compressed data using new, and
 // sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.
+// If it returns false, it sets *COMPRESSED_DATA to NULL and
+// *COMPRESSED_SIZE to zero.
 // It also writes a header before COMPRESSED_DATA: 4 bytes saying
 // "ZLIB", and 8 bytes indicating the uncompressed size, in big-endian
 // order.
@@ -48,15 +315,20 @@ zlib_compress(int header_size,
               unsigned char** compressed_data,
               unsigned long* compressed_size)
 {
-  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
-  *compressed_data = new unsigned char[*compressed_size + header_size];
-
   int compress_level;
   if (parameters->options().optimize() >= 1)
     compress_level = 9;
   else
     compress_level = 1;
 
+  if (uncompressed_size > zlib_chunk_size)
+    return zlib_compress_chunks(header_size, compress_level,
+				uncompressed_data, uncompressed_size,
+				compressed_data, compressed_size);
+
+  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
+  *compressed_data = new unsigned char[*compressed_size + header_size];
+
   int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
                      compressed_size,
                      reinterpret_cast<const Bytef*>(uncompressed_data),
@@ -71,6 +343,7 @@ zlib_compress(int header_size,
     {
       delete[] *compressed_data;
       *compressed_data = NULL;
+      *compressed_size = 0;
       return false;
     }
 }
@@ -81,6 +354,33 @@ zstd_compress(int header_size, const unsigned char *uncompressed_data,
 	      unsigned long uncompressed_size,
 	      unsigned char **compressed_data, unsigned long *compressed_size)
 {
+  if (uncompressed_size > zstd_chunk_size)
+    {
+      // Compress the chunks as separate frames.  A reader decompresses
+      // concatenated frames as a single buffer.
+      Compress_chunks chunks(Compress_chunks::COMPRESS_ZSTD,
+			     ZSTD_CLEVEL_DEFAULT, uncompressed_data,
+			     uncompressed_size, zstd_chunk_size);
+      if (!chunks.compress())
+	{
+	  *compressed_data = NULL;
+	  *compressed_size = 0;
+	  return false;
+	}
+      unsigned long size = 0;
+      for (unsigned int i = 0; i < chunks.chunk_count(); ++i)
+	size += chunks.chunk_size(i);
+      *compressed_data = new unsigned char[size + header_size];
+      unsigned char* p = *compressed_data + header_size;
+      for (unsigned int i = 0; i < chunks.chunk_count(); ++i)
+	{
+	  memcpy(p, chunks.chunk_data(i), chunks.chunk_size(i));
+	  p += chunks.chunk_size(i);
+	}
+      *compressed_size = header_size + size;
+      return true;
+    }
+
   size_t size = ZSTD_compressBound(uncompressed_size);
   *compressed_data = new unsigned char[size + header_size];
   size = ZSTD_compress(*compressed_data + header_size, size, uncompressed_data,
@@ -88,6 +388,8 @@ zstd_compress(int header_size, const unsigned char *uncompressed_data,
   if (ZSTD_isError(size))
     {
       delete[] *compressed_data;
+      *compressed_data = NULL;
+      *compressed_size = 0;
       return false;
     }
   *compressed_size = header_size + size;
@@ -24,6 +24,7 @@
 
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #include "elfcpp.h"
 #include "parameters.h"
@@ -81,6 +82,10 @@ Sized_dynobj<size, big_endian>::Sized_dynobj(
   : Dynobj(name, input_file, offset),
     elf_file_(this, ehdr),
     dynsym_shndx_(-1U),
+    gnu_hash_shndx_(-1U),
+    gnu_hash_(NULL),
+    gnu_hash_size_(0),
+    lazy_symbols_(NULL),
     symbols_(NULL),
     defined_count_(0)
 {
@@ -140,6 +145,10 @@ Sized_dynobj<size, big_endian>::find_dynsym_sections(
 	  symtab_shndx = i;
 	  pi = NULL;
 	  break;
+	case elfcpp::SHT_GNU_HASH:
+	  this->gnu_hash_shndx_ = i;
+	  pi = NULL;
+	  break;
 	case elfcpp::SHT_GNU_versym:
 	  pi = pversym_shndx;
 	  break;
@@ -439,6 +448,24 @@ Sized_dynobj<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
       this->read_dynsym_section(pshdrs, verneed_shndx, elfcpp::SHT_GNU_verneed,
 				strtab_shndx, &sd->verneed, &sd->verneed_size,
 				&sd->verneed_info);
+
+      // With --lazy-dynamic-symbols we look up definitions in the GNU
+      // hash table.
+      if (parameters->options().lazy_dynamic_symbols()
+	  && this->gnu_hash_shndx_ != -1U)
+	{
+	  typename This::Shdr hashshdr(pshdrs
+				       + this->gnu_hash_shndx_ * This::shdr_size);
+	  if (this->adjust_shndx(hashshdr.get_sh_link())
+	      == this->dynsym_shndx_)
+	    {
+	      this->gnu_hash_ = this->get_lasting_view(hashshdr.get_sh_offset(),
+						       hashshdr.get_sh_size(),
+						       true, false);
+	      this->gnu_hash_size_ =
+		convert_to_section_size_type(hashshdr.get_sh_size());
+	    }
+	}
     }
 
   // Read the SHT_DYNAMIC section to find whether this shared object
@@ -731,9 +758,6 @@ Sized_dynobj<size, big_endian>::do_add_symbols(Symbol_table* symtab,
       return;
     }
 
-  Version_map version_map;
-  this->make_version_map(sd, &version_map);
-
   // If printing symbol counts or a cross reference table or
   // preparing for an incremental link, we want to track symbols.
   if (parameters->options().user_set_print_symbol_counts()
@@ -744,6 +768,57 @@ Sized_dynobj<size, big_endian>::do_add_symbols(Symbol_table* symtab,
       this->symbols_->resize(symcount);
     }
 
+  // With --lazy-dynamic-symbols, we add the symbols which are not in
+  // the GNU hash table now, which includes all the undefined symbols.
+  // We also add definitions of names which we have already seen.
+  // The remaining definitions are added if we see their names later.
+  if (this->gnu_hash_ != NULL)
+    {
+      if (this->symbols_ == NULL
+	  && !parameters->options().any_wrap()
+	  && this->setup_lazy_symbols(sd, symcount))
+	{
+	  Lazy_symbols* lazy = this->lazy_symbols_;
+	  const unsigned char* syms = lazy->symbols->data();
+	  const char* names =
+	    reinterpret_cast<const char*>(lazy->symbol_names->data());
+	  const unsigned char* versym = (lazy->versym == NULL
+					 ? NULL
+					 : lazy->versym->data());
+	  symtab->add_from_dynobj(this, syms, symcount, names,
+				  lazy->symbol_names_size, versym,
+				  symcount * 2, &lazy->version_map,
+				  &lazy->is_deferred, NULL,
+				  &this->defined_count_);
+
+	  std::vector<unsigned int> indexes;
+	  for (size_t i = lazy->symoffset; i < symcount; ++i)
+	    {
+	      if (!lazy->is_deferred[i])
+		continue;
+	      elfcpp::Sym<size, big_endian> sym(syms + i * sym_size);
+	      unsigned int st_name = sym.get_st_name();
+	      if (st_name < lazy->symbol_names_size
+		  && symtab->is_known_symbol_name(names + st_name))
+		indexes.push_back(i);
+	    }
+	  this->add_lazy_symbols(symtab, &indexes);
+
+	  symtab->add_lazy_dynobj(this);
+
+	  // This is normally the last time we will read any data from
+	  // this file.
+	  this->clear_view_cache_marks();
+	  return;
+	}
+
+      delete this->gnu_hash_;
+      this->gnu_hash_ = NULL;
+    }
+
+  Version_map version_map;
+  this->make_version_map(sd, &version_map);
+
   const char* sym_names =
     reinterpret_cast<const char*>(sd->symbol_names->data());
   symtab->add_from_dynobj(this, sd->symbols->data(), symcount,
@@ -753,6 +828,7 @@ Sized_dynobj<size, big_endian>::do_add_symbols(Symbol_table* symtab,
 			   : sd->versym->data()),
 			  sd->versym_size,
 			  &version_map,
+			  NULL,
 			  this->symbols_,
 			  &this->defined_count_);
 
@@ -781,6 +857,246 @@ Sized_dynobj<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   this->clear_view_cache_marks();
 }
 
+// Check the GNU hash table, and move the symbol data from SD to a new
+// Lazy_symbols structure.  Returns false, leaving SD unchanged, if
+// the hash table is not usable.
+
+template<int size, bool big_endian>
+bool
+Sized_dynobj<size, big_endian>::setup_lazy_symbols(Read_symbols_data* sd,
+						   size_t symcount)
+{
+  if (sd->versym != NULL && sd->versym_size / 2 < symcount)
+    return false;
+
+  const unsigned char* phash = this->gnu_hash_->data();
+  if (this->gnu_hash_size_ < 16)
+    return false;
+  const uint32_t bucket_count = elfcpp::Swap<32, big_endian>::readval(phash);
+  const uint32_t symoffset = elfcpp::Swap<32, big_endian>::readval(phash + 4);
+  const uint32_t bloom_size = elfcpp::Swap<32, big_endian>::readval(phash + 8);
+  const uint32_t bloom_shift =
+    elfcpp::Swap<32, big_endian>::readval(phash + 12);
+  if (bucket_count == 0
+      || symoffset == 0
+      || symoffset > symcount
+      || bloom_size == 0
+      || (bloom_size & (bloom_size - 1)) != 0
+      || bloom_shift >= 32)
+    return false;
+  uint64_t needed = (16
+		     + static_cast<uint64_t>(bloom_size) * (size / 8)
+		     + static_cast<uint64_t>(bucket_count) * 4
+		     + static_cast<uint64_t>(symcount - symoffset) * 4);
+  if (needed > this->gnu_hash_size_)
+    return false;
+
+  Lazy_symbols* lazy = new Lazy_symbols();
+  this->make_version_map(sd, &lazy->version_map);
+  lazy->symbols = sd->symbols;
+  lazy->symcount = symcount;
+  lazy->symbol_names = sd->symbol_names;
+  lazy->symbol_names_size = sd->symbol_names_size;
+  lazy->versym = sd->versym;
+  lazy->bucket_count = bucket_count;
+  lazy->symoffset = symoffset;
+  lazy->bloom_size = bloom_size;
+  lazy->bloom_shift = bloom_shift;
+
+  // Defer the definitions in the hash table.  We add absolute symbols
+  // now, as they include the version definition symbols, which may be
+  // looked up by name.
+  lazy->is_deferred.resize(symcount);
+  const unsigned char* p = lazy->symbols->data() + symoffset * sym_size;
+  for (size_t i = symoffset; i < symcount; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      unsigned int shndx = sym.get_st_shndx();
+      lazy->is_deferred[i] = (shndx != elfcpp::SHN_UNDEF
+			      && shndx != elfcpp::SHN_ABS);
+    }
+
+  sd->symbols = NULL;
+  sd->symbol_names = NULL;
+  sd->versym = NULL;
+  if (sd->verdef != NULL)
+    {
+      delete sd->verdef;
+      sd->verdef = NULL;
+    }
+  if (sd->verneed != NULL)
+    {
+      delete sd->verneed;
+      sd->verneed = NULL;
+    }
+
+  this->lazy_symbols_ = lazy;
+  return true;
+}
+
+// Look up NAME in the GNU hash table.  This follows the lookup done by
+// the dynamic linker.
+
+template<int size, bool big_endian>
+void
+Sized_dynobj<size, big_endian>::find_lazy_symbols(
+    const char* name,
+    size_t namelen,
+    uint32_t hash,
+    std::vector<unsigned int>* indexes) const
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_WXword Word;
+
+  const Lazy_symbols* lazy = this->lazy_symbols_;
+  const unsigned char* phash = this->gnu_hash_->data();
+
+  const unsigned char* pbloom = phash + 16;
+  Word word = elfcpp::Swap<size, big_endian>::readval(
+      pbloom + ((hash / size) & (lazy->bloom_size - 1)) * (size / 8));
+  Word mask = ((static_cast<Word>(1) << (hash % size))
+	       | (static_cast<Word>(1) << ((hash >> lazy->bloom_shift) % size)));
+  if ((word & mask) != mask)
+    return;
+
+  const unsigned char* pbuckets = pbloom + lazy->bloom_size * (size / 8);
+  const unsigned char* pchain = pbuckets + lazy->bucket_count * 4;
+  uint32_t i = elfcpp::Swap<32, big_endian>::readval(pbuckets
+						      + ((hash
+							  % lazy->bucket_count)
+							 * 4));
+  if (i < lazy->symoffset)
+    return;
+
+  const unsigned char* syms = lazy->symbols->data();
+  const char* names =
+    reinterpret_cast<const char*>(lazy->symbol_names->data());
+  for (; i < lazy->symcount; ++i)
+    {
+      uint32_t h = elfcpp::Swap<32, big_endian>::readval(pchain
+							  + ((i
+							      - lazy->symoffset)
+							     * 4));
+      if ((h | 1) == (hash | 1) && lazy->is_deferred[i])
+	{
+	  elfcpp::Sym<size, big_endian> sym(syms + i * sym_size);
+	  unsigned int st_name = sym.get_st_name();
+	  if (st_name + namelen < lazy->symbol_names_size
+	      && memcmp(names + st_name, name, namelen) == 0
+	      && names[st_name + namelen] == '\0')
+	    indexes->push_back(i);
+	}
+      if ((h & 1) != 0)
+	break;
+    }
+}
+
+// Add the deferred symbols in INDEXES to SYMTAB.  If the dynamic
+// object has several names for a variable and we copy it, the
+// dynamic linker must see all of them in the executable, so we add
+// any STT_OBJECT definitions at the same address as well.
+
+template<int size, bool big_endian>
+void
+Sized_dynobj<size, big_endian>::add_lazy_symbols(
+    Symbol_table* symtab,
+    std::vector<unsigned int>* indexes)
+{
+  if (indexes->empty())
+    return;
+
+  Lazy_symbols* lazy = this->lazy_symbols_;
+  const unsigned char* syms = lazy->symbols->data();
+  const char* names =
+    reinterpret_cast<const char*>(lazy->symbol_names->data());
+
+  for (std::vector<unsigned int>::const_iterator p = indexes->begin();
+       p != indexes->end();
+       ++p)
+    lazy->is_deferred[*p] = false;
+
+  std::vector<const char*> alias_names;
+  const size_t count = indexes->size();
+  for (size_t k = 0; k < count; ++k)
+    {
+      elfcpp::Sym<size, big_endian> sym(syms + (*indexes)[k] * sym_size);
+      if (sym.get_st_type() != elfcpp::STT_OBJECT
+	  || sym.get_st_shndx() >= elfcpp::SHN_LORESERVE)
+	continue;
+
+      if (!lazy->has_objects)
+	{
+	  for (size_t i = lazy->symoffset; i < lazy->symcount; ++i)
+	    {
+	      elfcpp::Sym<size, big_endian> osym(syms + i * sym_size);
+	      unsigned int shndx = osym.get_st_shndx();
+	      if (osym.get_st_type() == elfcpp::STT_OBJECT
+		  && shndx != elfcpp::SHN_UNDEF
+		  && shndx < elfcpp::SHN_LORESERVE)
+		{
+		  Lazy_object lo;
+		  lo.shndx = shndx;
+		  lo.value = osym.get_st_value();
+		  lo.index = i;
+		  lazy->objects.push_back(lo);
+		}
+	    }
+	  std::sort(lazy->objects.begin(), lazy->objects.end());
+	  lazy->has_objects = true;
+	}
+
+      Lazy_object key;
+      key.shndx = sym.get_st_shndx();
+      key.value = sym.get_st_value();
+      key.index = 0;
+      for (typename std::vector<Lazy_object>::const_iterator p =
+	     std::lower_bound(lazy->objects.begin(), lazy->objects.end(), key);
+	   (p != lazy->objects.end()
+	    && p->shndx == key.shndx
+	    && p->value == key.value);
+	   ++p)
+	{
+	  if (!lazy->is_deferred[p->index])
+	    continue;
+	  lazy->is_deferred[p->index] = false;
+	  indexes->push_back(p->index);
+	  elfcpp::Sym<size, big_endian> asym(syms + p->index * sym_size);
+	  if (asym.get_st_name() < lazy->symbol_names_size)
+	    alias_names.push_back(names + asym.get_st_name());
+	}
+    }
+
+  std::sort(indexes->begin(), indexes->end());
+
+  // Any other dynamic objects which define the aliases come first.
+  for (std::vector<const char*>::const_iterator p = alias_names.begin();
+       p != alias_names.end();
+       ++p)
+    symtab->import_lazy_symbols(*p, strlen(*p));
+
+  symtab->add_lazy_dynobj_symbols(this, *indexes, syms, names,
+				  lazy->symbol_names_size,
+				  (lazy->versym == NULL
+				   ? NULL
+				   : lazy->versym->data()),
+				  &lazy->version_map, &this->defined_count_);
+}
+
+// Add the symbols named NAME which were left out of the symbol table.
+
+template<int size, bool big_endian>
+void
+Sized_dynobj<size, big_endian>::do_import_lazy_symbols(Symbol_table* symtab,
+						       const char* name,
+						       size_t namelen,
+						       uint32_t hash)
+{
+  if (this->lazy_symbols_ == NULL)
+    return;
+  std::vector<unsigned int> indexes;
+  this->find_lazy_symbols(name, namelen, hash, &indexes);
+  this->add_lazy_symbols(symtab, &indexes);
+}
+
 template<int size, bool big_endian>
 Archive::Should_include
 Sized_dynobj<size, big_endian>::do_should_include_member(Symbol_table*,
@@ -1052,6 +1368,18 @@ Dynobj::gnu_hash(const char* name)
   return h;
 }
 
+// Likewise, for the first LEN characters of NAME.
+
+uint32_t
+Dynobj::gnu_hash(const char* name, size_t len)
+{
+  const unsigned char* nameu = reinterpret_cast<const unsigned char*>(name);
+  uint32_t h = 5381;
+  for (size_t i = 0; i < len; ++i)
+    h = (h << 5) + h + nameu[i];
+  return h;
+}
+
 // Create a GNU hash table, setting *PPHASH and *PHASHLEN.  GNU hash
 // tables are an extension to ELF which are recognized by the GNU
 // dynamic linker.  They are referenced using dynamic tag DT_GNU_HASH.
@@ -1095,7 +1423,9 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
       else
 	{
 	  hashed_dynsyms.push_back(sym);
-	  dynsym_hashvals.push_back(Dynobj::gnu_hash(sym->name()));
+	  // The hash code of the name computed when the symbol was added
+	  // to the symbol table is the GNU hash code.
+	  dynsym_hashvals.push_back(sym->name_hash());
 	}
     }
 
@@ -1376,6 +1706,20 @@ Verneed::add_name(const char* name)
   return vv;
 }
 
+// Return whether any of the version names starts with PREFIX.
+
+bool
+Verneed::has_name_prefix(const char* prefix) const
+{
+  size_t len = strlen(prefix);
+  for (Need_versions::const_iterator p = this->need_versions_.begin();
+       p != this->need_versions_.end();
+       ++p)
+    if (strncmp((*p)->version(), prefix, len) == 0)
+      return true;
+  return false;
+}
+
 // Set the version indexes starting at INDEX.
 
 unsigned int
@@ -1439,7 +1783,7 @@ Versions::Versions(const Version_script_info& version_script,
                    Stringpool* dynpool)
   : defs_(), needs_(), version_table_(),
     is_finalized_(false), version_script_(version_script),
-    needs_base_version_(true)
+    needs_base_version_(true), uses_dt_relr_(false)
 {
   if (!this->version_script_.empty())
     {
@@ -1636,6 +1980,37 @@ Versions::add_need(Stringpool* dynpool, const char* filename, const char* name,
   ins.first->second = vn->add_name(name);
 }
 
+// Add a reference to GLIBC_ABI_DT_RELR to the C library, if we
+// already refer to a GLIBC_2 version of it.  This is for
+// -z pack-relative-relocs.
+
+void
+Versions::add_dt_relr_need(Stringpool* dynpool)
+{
+  gold_assert(!this->is_finalized_);
+
+  // Adding a need may add to NEEDS_, so find the file first.
+  const char* filename = NULL;
+  for (Needs::const_iterator p = this->needs_.begin();
+       p != this->needs_.end();
+       ++p)
+    {
+      if (strncmp((*p)->filename(), "libc.so.", 8) == 0
+	  && (*p)->has_name_prefix("GLIBC_2."))
+	{
+	  filename = (*p)->filename();
+	  break;
+	}
+    }
+  if (filename == NULL)
+    return;
+
+  Stringpool::Key version_key;
+  const char* version = dynpool->add("GLIBC_ABI_DT_RELR", false,
+				     &version_key);
+  this->add_need(dynpool, filename, version, version_key);
+}
+
 // Set the version indexes.  Create a new dynamic version symbol for
 // each new version definition.
 
@@ -105,12 +105,30 @@ class Dynobj : public Object
 			unsigned int local_dynsym_count,
 			unsigned char** pphash, unsigned int* phashlen);
 
+  // Compute the GNU hash code for the first LEN characters of NAME.
+  static uint32_t
+  gnu_hash(const char* name, size_t len);
+
+  // Add the symbols named NAME, which is NAMELEN characters long and
+  // has the GNU hash code HASH, to SYMTAB, if they were left out when
+  // the other symbols were added because of --lazy-dynamic-symbols.
+  void
+  import_lazy_symbols(Symbol_table* symtab, const char* name,
+		      size_t namelen, uint32_t hash)
+  { this->do_import_lazy_symbols(symtab, name, namelen, hash); }
+
  protected:
   // Return a pointer to this object.
   virtual Dynobj*
   do_dynobj()
   { return this; }
 
+  // Add the symbols named NAME which were not yet added to SYMTAB.
+  // By default all the symbols were added when the object was read.
+  virtual void
+  do_import_lazy_symbols(Symbol_table*, const char*, size_t, uint32_t)
+  { }
+
   // Set the DT_SONAME string.
   void
   set_soname_string(const char* s)
@@ -280,6 +298,11 @@ class Sized_dynobj : public Dynobj
   do_get_global_symbols() const
   { return this->symbols_; }
 
+  // Add the symbols named NAME which were not yet added to SYMTAB.
+  void
+  do_import_lazy_symbols(Symbol_table* symtab, const char* name,
+			 size_t namelen, uint32_t hash);
+
  protected:
   // Read the symbols.  This is common code for all target-specific
   // overrides of do_read_symbols().
@@ -345,10 +368,90 @@ class Sized_dynobj : public Dynobj
   void
   set_version_map(Version_map*, unsigned int ndx, const char* name) const;
 
+  // An STT_OBJECT definition in the GNU hash table, used to find
+  // aliases.  These are sorted by address.
+  struct Lazy_object
+  {
+    unsigned int shndx;
+    typename elfcpp::Elf_types<size>::Elf_Addr value;
+    unsigned int index;
+
+    bool
+    operator<(const Lazy_object& o) const
+    {
+      if (this->shndx != o.shndx)
+	return this->shndx < o.shndx;
+      if (this->value != o.value)
+	return this->value < o.value;
+      return this->index < o.index;
+    }
+  };
+
+  // The symbols of an object whose definitions are only added to the
+  // symbol table when something refers to them, for
+  // --lazy-dynamic-symbols.  The definitions are found through the
+  // GNU hash table, which holds all of them.
+  struct Lazy_symbols
+  {
+    Lazy_symbols()
+      : symbols(NULL), symcount(0), symbol_names(NULL),
+	symbol_names_size(0), versym(NULL), version_map(), bucket_count(0),
+	symoffset(0), bloom_size(0), bloom_shift(0), is_deferred(),
+	objects(), has_objects(false)
+    { }
+
+    ~Lazy_symbols()
+    {
+      delete this->symbols;
+      delete this->symbol_names;
+      delete this->versym;
+    }
+
+    File_view* symbols;
+    size_t symcount;
+    File_view* symbol_names;
+    section_size_type symbol_names_size;
+    File_view* versym;
+    Version_map version_map;
+    // The header of the GNU hash table.
+    uint32_t bucket_count;
+    uint32_t symoffset;
+    uint32_t bloom_size;
+    uint32_t bloom_shift;
+    // For each symbol, whether it has not yet been added.
+    std::vector<bool> is_deferred;
+    // The STT_OBJECT definitions, built when first needed.
+    std::vector<Lazy_object> objects;
+    bool has_objects;
+  };
+
+  // Check the GNU hash table, and set up lazy_symbols_ from SD.
+  // Returns false if the symbols must all be added now.
+  bool
+  setup_lazy_symbols(Read_symbols_data* sd, size_t symcount);
+
+  // Find the symbols named NAME in the GNU hash table which have not
+  // been added, and push their indexes on INDEXES.
+  void
+  find_lazy_symbols(const char* name, size_t namelen, uint32_t hash,
+		    std::vector<unsigned int>* indexes) const;
+
+  // Add the deferred symbols in INDEXES to SYMTAB, along with any
+  // aliases of them.
+  void
+  add_lazy_symbols(Symbol_table* symtab, std::vector<unsigned int>* indexes);
+
   // General access to the ELF file.
   elfcpp::Elf_file<size, big_endian, Object> elf_file_;
   // The section index of the dynamic symbol table.
   unsigned int dynsym_shndx_;
+  // The section index of the GNU hash table, and its contents if we
+  // read it for --lazy-dynamic-symbols.
+  unsigned int gnu_hash_shndx_;
+  File_view* gnu_hash_;
+  section_size_type gnu_hash_size_;
+  // The symbols which were not added to the symbol table, or NULL.
+  Lazy_symbols* lazy_symbols_;
   // The entries in the symbol table for the symbols.  We only keep
   // this if we need it to print symbol information.
   Symbols* symbols_;
@@ -529,6 +632,10 @@ class Verneed
   Verneed_version*
   add_name(const char* name);
 
+  // Return whether any of the version names starts with PREFIX.
+  bool
+  has_name_prefix(const char* prefix) const;
+
   // Set the version indexes, starting at INDEX.  Return the updated
   // INDEX.
   unsigned int
@@ -576,6 +683,22 @@ class Versions
   finalize(Symbol_table* symtab, unsigned int dynsym_index,
 	   std::vector<Symbol*>* syms);
 
+  // Add a reference to the GLIBC_ABI_DT_RELR version of the C
+  // library, which tells an old dynamic linker that it can not load
+  // an object using DT_RELR.
+  void
+  add_dt_relr_need(Stringpool*);
+
+  // Record that the output file has a DT_RELR section.
+  void
+  set_uses_dt_relr()
+  { this->uses_dt_relr_ = true; }
+
+  // Return whether the output file has a DT_RELR section.
+  bool
+  uses_dt_relr() const
+  { return this->uses_dt_relr_; }
+
   // Return whether there are any version definitions.
   bool
   any_defs() const
@@ -681,6 +804,8 @@ class Versions
   // Whether we need to insert a base version.  This is only used for
   // shared libraries and is cleared when the base version is defined.
   bool needs_base_version_;
+  // Whether the output file has a DT_RELR section.
+  bool uses_dt_relr_;
 };
 
 } // End namespace gold.
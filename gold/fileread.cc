@@ -24,6 +24,7 @@
 
 #include <cstring>
 #include <cerrno>
+#include <algorithm>
 #include <climits>
 #include <fcntl.h>
 #include <unistd.h>
@@ -40,6 +41,7 @@
 #include "filenames.h"
 
 #include "debug.h"
+#include "gold-threads.h"
 #include "parameters.h"
 #include "options.h"
 #include "dirsearch.h"
@@ -125,6 +127,8 @@ unsigned long long File_read::total_mapped_bytes;
 unsigned long long File_read::current_mapped_bytes;
 unsigned long long File_read::maximum_mapped_bytes;
 std::vector<std::string> File_read::files_read;
+unsigned long long File_read::total_prefetch_hits;
+unsigned long long File_read::total_prefetch_misses;
 
 // Class File_read::View.
 
@@ -271,9 +275,13 @@ File_read::release()
       File_read::current_mapped_bytes += this->mapped_bytes_;
       if (File_read::current_mapped_bytes > File_read::maximum_mapped_bytes)
 	File_read::maximum_mapped_bytes = File_read::current_mapped_bytes;
+      File_read::total_prefetch_hits += this->prefetch_hits_;
+      File_read::total_prefetch_misses += this->prefetch_misses_;
     }
 
   this->mapped_bytes_ = 0;
+  this->prefetch_hits_ = 0;
+  this->prefetch_misses_ = 0;
 
   // Only clear views if there is only one attached object.  Otherwise
   // we waste time trying to clear cached archive views.  Similarly
@@ -435,6 +443,8 @@ File_read::do_read(off_t start, section_size_type size, void* p)
 void
 File_read::read(off_t start, section_size_type size, void* p)
 {
+  Hold_optional_lock hl(this->view_lock_);
+  this->record_prefetch_access(start, size);
   const File_read::View* pv = this->find_view(start, size, -1U, NULL);
   if (pv != NULL)
     {
@@ -552,6 +562,8 @@ File_read::find_or_make_view(off_t offset, off_t start,
 		   static_cast<long long>(size),
 		   static_cast<long long>(start));
 
+  this->record_prefetch_access(offset + start, size);
+
   unsigned int byteshift;
   if (offset == 0)
     byteshift = 0;
@@ -625,6 +637,7 @@ const unsigned char*
 File_read::get_view(off_t offset, off_t start, section_size_type size,
 		    bool aligned, bool cache)
 {
+  Hold_optional_lock hl(this->view_lock_);
   File_read::View* pv = this->find_or_make_view(offset, start, size,
 						aligned, cache);
   return pv->data() + (offset + start - pv->start() + pv->byteshift());
@@ -634,6 +647,7 @@ File_view*
 File_read::get_lasting_view(off_t offset, off_t start, section_size_type size,
 			    bool aligned, bool cache)
 {
+  Hold_optional_lock hl(this->view_lock_);
   File_read::View* pv = this->find_or_make_view(offset, start, size,
 						aligned, cache);
   pv->lock();
@@ -743,6 +757,7 @@ File_read::read_multiple(off_t base, const Read_multiple& rm)
 	this->read(base + i_off, i_entry.size, i_entry.buffer);
       else
 	{
+	  this->record_prefetch_access(base + i_off, end_off - i_off);
 	  File_read::View* view = this->find_view(base + i_off,
 						  end_off - i_off,
 						  -1U, NULL);
@@ -772,6 +787,128 @@ File_read::read_multiple(off_t base, const Read_multiple& rm)
     }
 }
 
+// Prefetch the ranges in *RANGES.  We merge ranges which are close
+// together, and remember them so that --stats can report how many of
+// the later reads were prefetched.
+
+void
+File_read::prefetch(off_t base, Prefetch_ranges* ranges)
+{
+  gold_assert(this->is_locked());
+
+  // There is nothing to gain if the contents are already in memory.
+  if (ranges->empty()
+      || (this->whole_file_view_ != NULL
+	  && this->whole_file_view_->is_permanent_view()))
+    return;
+
+  Hold_optional_lock hl(this->view_lock_);
+
+  std::sort(ranges->begin(), ranges->end());
+
+  size_t first_new = this->prefetched_.size();
+  for (Prefetch_ranges::const_iterator p = ranges->begin();
+       p != ranges->end();
+       ++p)
+    {
+      off_t start = base + p->first;
+      off_t end = start + p->second;
+      if (end > this->size_)
+	end = this->size_;
+      if (start >= end)
+	continue;
+      if (this->prefetched_.size() > first_new)
+	{
+	  std::pair<off_t, section_size_type>& last(this->prefetched_.back());
+	  off_t last_end = last.first + last.second;
+	  if (start <= last_end + File_read::page_size)
+	    {
+	      if (end > last_end)
+		last.second = end - last.first;
+	      continue;
+	    }
+	}
+      this->prefetched_.push_back(std::make_pair(start, end - start));
+    }
+
+  if (this->prefetched_.size() == first_new)
+    return;
+
+#ifdef POSIX_FADV_WILLNEED
+  this->reopen_descriptor();
+  for (size_t i = first_new; i < this->prefetched_.size(); ++i)
+    ::posix_fadvise(this->descriptor_, this->prefetched_[i].first,
+		    this->prefetched_[i].second, POSIX_FADV_WILLNEED);
+#endif
+
+  // Keep the full list sorted and without overlaps, so that
+  // do_record_prefetch_access can use a binary search.  This only
+  // matters for an archive, where we prefetch once per member.
+  if (first_new > 0)
+    {
+      std::sort(this->prefetched_.begin(), this->prefetched_.end());
+      size_t out = 0;
+      for (size_t i = 1; i < this->prefetched_.size(); ++i)
+	{
+	  std::pair<off_t, section_size_type>& last(this->prefetched_[out]);
+	  const std::pair<off_t, section_size_type>& cur(this->prefetched_[i]);
+	  off_t last_end = last.first + last.second;
+	  if (cur.first <= last_end)
+	    {
+	      off_t cur_end = cur.first + cur.second;
+	      if (cur_end > last_end)
+		last.second = cur_end - last.first;
+	    }
+	  else
+	    this->prefetched_[++out] = cur;
+	}
+      this->prefetched_.resize(out + 1);
+    }
+}
+
+// Count a read of SIZE bytes at START as a prefetch hit if it is
+// entirely within a prefetched range.
+
+void
+File_read::do_record_prefetch_access(off_t start, section_size_type size)
+{
+  Prefetch_ranges::const_iterator p =
+    std::upper_bound(this->prefetched_.begin(), this->prefetched_.end(),
+		     std::make_pair(start, static_cast<section_size_type>(-1)));
+  if (p != this->prefetched_.begin())
+    {
+      --p;
+      if (start + static_cast<off_t>(size)
+	  <= p->first + static_cast<off_t>(p->second))
+	{
+	  ++this->prefetch_hits_;
+	  return;
+	}
+    }
+  ++this->prefetch_misses_;
+}
+
+// Release the pages of the mapped views.
+
+void
+File_read::release_pages()
+{
+  gold_assert(this->is_locked());
+
+#ifdef MADV_DONTNEED
+  Hold_optional_lock hl(this->view_lock_);
+  for (Views::iterator p = this->views_.begin();
+       p != this->views_.end();
+       ++p)
+    {
+      const View* v = p->second;
+      if (v->is_mapped())
+	::madvise(const_cast<unsigned char*>(v->data()), v->size(),
+		  MADV_DONTNEED);
+    }
+#endif
+}
+
 // Mark all views as no longer cached.
 
 void
@@ -866,6 +1003,10 @@ File_read::print_stats()
 	  program_name, File_read::total_mapped_bytes);
   fprintf(stderr, _("%s: maximum bytes mapped for read at one time: %llu\n"),
 	  program_name, File_read::maximum_mapped_bytes);
+  if (parameters->options_valid() && parameters->options().readahead())
+    fprintf(stderr, _("%s: readahead hits: %llu; misses: %llu\n"),
+	    program_name, File_read::total_prefetch_hits,
+	    File_read::total_prefetch_misses);
 }
 
 // Class File_view.
@@ -873,6 +1014,7 @@ File_read::print_stats()
 File_view::~File_view()
 {
   gold_assert(this->file_.is_locked());
+  Hold_optional_lock hl(this->file_.view_lock_);
   this->view_->unlock();
 }
 
@@ -62,6 +62,7 @@ class Position_dependent_options;
 class Input_file_argument;
 class Dirsearch;
 class File_view;
+class Lock;
 
 // File_read manages a file descriptor and mappings for a file we are
 // reading.
@@ -72,7 +73,8 @@ class File_read
   File_read()
     : name_(), descriptor_(-1), is_descriptor_opened_(false), object_count_(0),
       size_(0), token_(false), views_(), saved_views_(), mapped_bytes_(0),
-      released_(true), whole_file_view_(NULL)
+      released_(true), whole_file_view_(NULL), view_lock_(NULL),
+      prefetched_(), prefetch_hits_(0), prefetch_misses_(0)
   { }
 
   ~File_read();
@@ -137,6 +139,14 @@ class File_read
   filesize() const
   { return this->size_; }
 
+  // Set a lock to hold while finding or making a view, or NULL.  This
+  // is used while several threads of the task which has locked the
+  // file read from it at the same time.  read_multiple may not be
+  // called while the lock is set.
+  void
+  set_view_lock(Lock* lock)
+  { this->view_lock_ = lock; }
+
   // Return a view into the file starting at file offset START for
   // SIZE bytes.  OFFSET is the offset into the input file for the
   // file we are reading; this is zero for a normal object file,
@@ -203,6 +213,23 @@ class File_read
   void
   read_multiple(off_t base, const Read_multiple&);
 
+  // A list of file ranges, each a file offset and a size.
+  typedef std::vector<std::pair<off_t, section_size_type> > Prefetch_ranges;
+
+  // Tell the system that we are going to read the ranges in *RANGES
+  // soon, so that it can start reading them in the background.  BASE
+  // is added to all the offsets.  This sorts *RANGES.  This is only a
+  // hint, used for --readahead.  The file must be locked.
+  void
+  prefetch(off_t base, Prefetch_ranges* ranges);
+
+  // Tell the system that we do not need the pages of the mapped views
+  // any more.  The views remain valid; any page which is accessed
+  // again is read back from the file.  This is used for --readahead
+  // once an object has been relocated.  The file must be locked.
+  void
+  release_pages();
+
   // Dump statistical information to stderr.
   static void
   print_stats();
@@ -259,6 +286,13 @@ class File_read
   // Set of names of all files read.
   static std::vector<std::string> files_read;
 
+  // Number of reads of prefetched data if --readahead and --stats.
+  static unsigned long long total_prefetch_hits;
+
+  // Number of reads of data which was not prefetched, after the first
+  // prefetch of the file, if --readahead and --stats.
+  static unsigned long long total_prefetch_misses;
+
   // A view into the file.
   class View
   {
@@ -339,6 +373,11 @@ class File_read
     is_permanent_view() const
     { return this->data_ownership_ == DATA_NOT_OWNED; }
 
+    // Returns TRUE if the data was mapped from the file.
+    bool
+    is_mapped() const
+    { return this->data_ownership_ == DATA_MMAPPED; }
+
    private:
     View(const View&);
     View& operator=(const View&);
@@ -404,6 +443,18 @@ class File_read
   void
   clear_views(Clear_views_mode);
 
+  // Record whether a read of SIZE bytes at file offset START was
+  // prefetched.
+  void
+  record_prefetch_access(off_t start, section_size_type size)
+  {
+    if (!this->prefetched_.empty())
+      this->do_record_prefetch_access(start, size);
+  }
+
+  void
+  do_record_prefetch_access(off_t start, section_size_type size);
+
   // The size of a file page for buffering data.
   static const off_t page_size = 8192;
 
@@ -454,6 +505,15 @@ class File_read
   // - The contents was specified in the constructor.  Used only for
   //   testing purposes).
   View* whole_file_view_;
+  // The lock to hold while finding or making a view, or NULL.
+  Lock* view_lock_;
+  // The ranges of the file which we have prefetched, sorted by
+  // offset and not overlapping.
+  Prefetch_ranges prefetched_;
+  // The number of reads of prefetched and not prefetched data.  Like
+  // mapped_bytes_, these are transferred to the totals on release.
+  unsigned int prefetch_hits_;
+  unsigned int prefetch_misses_;
 };
 
 // A view of file data that persists even when the file is unlocked.
@@ -22,47 +22,370 @@
 
 
 #include "gold.h"
+
+#include <cstdio>
+#include <string>
+
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
+#include "gold-threads.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
-// Garbage collection uses a worklist style algorithm to determine the 
-// transitive closure of all referenced sections.
-void 
-Garbage_collection::do_transitive_closure()
+// The mark tasks mark sections in a shared bitmap with atomic
+// operations.  Without them, only one mark task is used.
+
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+const bool gc_parallel_mark = true;
+#else
+const bool gc_parallel_mark = false;
+#endif
+
+// A mark task visits the sections held by one worker, and then takes
+// sections from the other workers until no section is left to visit.
+
+class Gc_mark_task : public Task
+{
+ public:
+  Gc_mark_task(Garbage_collection* gc, unsigned int worker,
+	       Task_token* gc_blocker)
+    : gc_(gc), worker_(worker), gc_blocker_(gc_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->gc_blocker_); }
+
+  void
+  run(Workqueue*)
+  {
+    this->gc_->mark(this->worker_);
+    this->gc_->finish_mark_task();
+  }
+
+  std::string
+  get_name() const
+  { return "Gc_mark_task"; }
+
+ private:
+  Garbage_collection* gc_;
+  unsigned int worker_;
+  Task_token* gc_blocker_;
+};
+
+Garbage_collection::~Garbage_collection()
+{
+  for (std::vector<Mark_worker>::iterator p = this->workers_.begin();
+       p != this->workers_.end();
+       ++p)
+    delete p->lock;
+  delete this->idle_condvar_;
+  delete this->idle_lock_;
+}
+
+// Return the node of a section.  The sections of an object get their
+// nodes the first time one of them is seen, which happens before
+// marking starts.
+
+unsigned int
+Garbage_collection::section_node(Relobj* object, unsigned int shndx)
+{
+  unsigned int shnum = object->shnum();
+  if (shndx >= shnum)
+    return -1U;
+  std::pair<Object_bases::iterator, bool> ins =
+    this->object_bases_.insert(std::make_pair(object, this->section_count_));
+  if (ins.second)
+    {
+      gold_assert(!this->is_worklist_ready_);
+      unsigned int words = (shnum + mark_word_bits - 1) / mark_word_bits;
+      this->section_count_ += words * mark_word_bits;
+    }
+  return ins.first->second + shndx;
+}
+
+// Set the mark bit of NODE, and return whether it was clear.  Testing
+// the bit first avoids the atomic operation for the sections which
+// many others refer to.
+
+inline bool
+Garbage_collection::set_mark(unsigned int node)
 {
-  while (!this->worklist().empty())
+  uint32_t* word = &this->marked_[node / mark_word_bits];
+  uint32_t bit = 1U << (node % mark_word_bits);
+  if ((*word & bit) != 0)
+    return false;
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  return (__sync_fetch_and_or(word, bit) & bit) == 0;
+#else
+  *word |= bit;
+  return true;
+#endif
+}
+
+// Garbage collection uses a worklist style algorithm to determine the
+// transitive closure of all referenced sections.  The references are
+// first sorted by source section, so that the sections referenced by
+// a section are adjacent.  Then the sections in the worklist are
+// marked and shared out among the mark tasks, which visit them and
+// mark what they refer to.
+
+void
+Garbage_collection::do_transitive_closure(Workqueue* workqueue,
+					  Task_token* gc_blocker,
+					  unsigned int mark_task_count)
+{
+  // Number the sections in the worklist first, since that may add
+  // objects.
+  std::vector<unsigned int> roots;
+  roots.reserve(this->work_list_.size());
+  for (Worklist_type::const_iterator p = this->work_list_.begin();
+       p != this->work_list_.end();
+       ++p)
+    {
+      unsigned int node = this->section_node(p->first, p->second);
+      if (node != -1U)
+	roots.push_back(node);
+    }
+  Worklist_type().swap(this->work_list_);
+
+  // Sort the references by source with a counting sort.
+  unsigned int count = this->section_count_;
+  this->reference_count_ = this->references_.size();
+  this->reference_index_.assign(count + 1, 0);
+  for (size_t i = 0; i < this->references_.size(); ++i)
+    ++this->reference_index_[this->references_[i].first + 1];
+  for (unsigned int i = 0; i < count; ++i)
+    this->reference_index_[i + 1] += this->reference_index_[i];
+  std::vector<unsigned int> fill(this->reference_index_.begin(),
+				 this->reference_index_.end() - 1);
+  this->reference_targets_.resize(this->references_.size());
+  for (size_t i = 0; i < this->references_.size(); ++i)
+    this->reference_targets_[fill[this->references_[i].first]++] =
+      this->references_[i].second;
+  std::vector<std::pair<unsigned int, unsigned int> >().swap(this->references_);
+
+  this->marked_.assign(count / mark_word_bits, 0);
+
+  if (!gc_parallel_mark || mark_task_count == 0)
+    mark_task_count = 1;
+  this->workers_.resize(mark_task_count);
+  for (unsigned int i = 0; i < mark_task_count; ++i)
+    this->workers_[i].lock = new Lock();
+  if (mark_task_count > 1)
     {
-      // Add elements from the work list to the referenced list
-      // one by one.
-      Section_id entry = this->worklist().back();
-      this->worklist().pop_back();
-      if (!this->referenced_list().insert(entry).second)
-        continue;
-      Garbage_collection::Section_ref::iterator find_it = 
-                this->section_reloc_map().find(entry);
-      if (find_it == this->section_reloc_map().end()) 
-          continue;
-      const Garbage_collection::Sections_reachable &v = find_it->second;
-      // Scan the vector of references for each work_list entry. 
-      for (Garbage_collection::Sections_reachable::const_iterator it_v =
-               v.begin();
-           it_v != v.end();
-           ++it_v)
-        {
-          // Do not add already processed sections to the work_list. 
-          if (this->referenced_list().find(*it_v)
-              == this->referenced_list().end())
-            {
-              this->worklist().push_back(*it_v);
-            }
-        }
+      this->idle_lock_ = new Lock();
+      this->idle_condvar_ = new Condvar(*this->idle_lock_);
     }
+
+  // Deal the roots out to the shared stacks, so that an idle task can
+  // start on roots dealt to a task which has not started yet.
+  unsigned int next = 0;
+  for (std::vector<unsigned int>::const_iterator p = roots.begin();
+       p != roots.end();
+       ++p)
+    {
+      if (this->set_mark(*p))
+	{
+	  this->workers_[next].shared.push_back(*p);
+	  ++this->pending_;
+	  next = (next + 1) % mark_task_count;
+	}
+    }
+
+  this->running_tasks_ = mark_task_count;
+  for (unsigned int i = 0; i < mark_task_count; ++i)
+    {
+      gc_blocker->add_blocker();
+      workqueue->queue(new Gc_mark_task(this, i, gc_blocker));
+    }
+}
+
+// Move sections to the local stack of WORKER.  Take all the sections
+// in its own shared stack, or else half of the sections in the shared
+// stack of another task.
+
+bool
+Garbage_collection::refill_worker(unsigned int worker)
+{
+  unsigned int count = this->workers_.size();
+  Mark_worker* w = &this->workers_[worker];
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      Mark_worker* victim = &this->workers_[(worker + i) % count];
+      Hold_lock hl(*victim->lock);
+      if (victim->shared.empty())
+	continue;
+      size_t take = victim->shared.size();
+      if (victim != w)
+	take = (take + 1) / 2;
+      w->local.insert(w->local.end(), victim->shared.end() - take,
+		      victim->shared.end());
+      victim->shared.resize(victim->shared.size() - take);
+      return true;
+    }
+  return false;
+}
+
+// Visit sections until there are none left anywhere.  PENDING_
+// counts the sections which are marked but not yet visited; when it
+// drops to zero, every reachable section is marked.
+
+void
+Garbage_collection::mark(unsigned int worker)
+{
+  // How many sections to visit before offering some to other tasks.
+  const unsigned int share_interval = 64;
+
+  Mark_worker* w = &this->workers_[worker];
+  while (true)
+    {
+      while (!w->local.empty())
+	{
+	  unsigned int node = w->local.back();
+	  w->local.pop_back();
+
+	  int added = -1;
+	  for (unsigned int i = this->reference_index_[node];
+	       i < this->reference_index_[node + 1];
+	       ++i)
+	    {
+	      unsigned int target = this->reference_targets_[i];
+	      if (this->set_mark(target))
+		{
+		  w->local.push_back(target);
+		  ++added;
+		}
+	    }
+	  if (added != 0)
+	    {
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+	      if (__sync_add_and_fetch(&this->pending_, added) == 0
+		  && this->idle_lock_ != NULL)
+		{
+		  // Every section has been visited; wake the idle tasks
+		  // so that they can finish.
+		  Hold_lock hl(*this->idle_lock_);
+		  this->idle_condvar_->broadcast();
+		}
+#else
+	      this->pending_ += added;
+#endif
+	    }
+
+	  // Keep the oldest half of a long stack where other tasks can
+	  // find it.
+	  if (++w->visited % share_interval == 0
+	      && w->local.size() > 1
+	      && this->workers_.size() > 1)
+	    {
+	      bool shared = false;
+	      {
+		Hold_lock hl(*w->lock);
+		if (w->shared.empty())
+		  {
+		    size_t half = w->local.size() / 2;
+		    w->shared.assign(w->local.begin(),
+				     w->local.begin() + half);
+		    w->local.erase(w->local.begin(), w->local.begin() + half);
+		    shared = true;
+		  }
+	      }
+	      if (shared)
+		{
+		  Hold_lock hl(*this->idle_lock_);
+		  ++this->share_count_;
+		  if (this->idle_tasks_ > 0)
+		    this->idle_condvar_->broadcast();
+		}
+	    }
+	}
+
+      // Note how many times sections have been shared before looking
+      // for them, so that we do not wait if more are shared after we
+      // looked.
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+      unsigned int share_count = 0;
+      if (this->idle_lock_ != NULL)
+	{
+	  Hold_lock hl(*this->idle_lock_);
+	  share_count = this->share_count_;
+	}
+#endif
+
+      if (this->refill_worker(worker))
+	continue;
+
+      // Nothing is left to take, but other tasks may still be
+      // visiting sections that refer to unmarked sections.  Wait
+      // until they share some of them, or until they are done.
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+      if (this->idle_lock_ == NULL)
+	{
+	  gold_assert(this->pending_ == 0);
+	  break;
+	}
+      Hold_lock hl(*this->idle_lock_);
+      while (__sync_fetch_and_add(&this->pending_, 0) != 0
+	     && this->share_count_ == share_count)
+	{
+	  ++this->idle_tasks_;
+	  this->idle_condvar_->wait();
+	  --this->idle_tasks_;
+	}
+      if (this->share_count_ == share_count)
+	break;
+#else
+      gold_assert(this->pending_ == 0);
+      break;
+#endif
+    }
+}
+
+// When the last mark task is done, the graph is no longer needed.
+
+void
+Garbage_collection::finish_mark_task()
+{
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  if (__sync_sub_and_fetch(&this->running_tasks_, 1) != 0)
+    return;
+#else
+  if (--this->running_tasks_ != 0)
+    return;
+#endif
+
+  // Each marked section was visited by exactly one task.
+  this->live_count_ = 0;
+  for (std::vector<Mark_worker>::const_iterator p = this->workers_.begin();
+       p != this->workers_.end();
+       ++p)
+    this->live_count_ += p->visited;
+
+  std::vector<unsigned int>().swap(this->reference_index_);
+  std::vector<unsigned int>().swap(this->reference_targets_);
   this->worklist_ready();
 }
 
-} // End namespace gold.
+// Print statistical information to stderr.  This is used for --stats.
 
+void
+Garbage_collection::print_stats() const
+{
+  fprintf(stderr,
+	  _("%s: gc objects: %zu; referenced sections: %u; references: %zu; "
+	    "mark tasks: %zu\n"),
+	  program_name, this->object_bases_.size(), this->live_count_,
+	  this->reference_count_, this->workers_.size());
+}
+
+} // End namespace gold.
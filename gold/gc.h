@@ -41,13 +41,16 @@ class Sized_relobj_file;
 class Output_section;
 class General_options;
 class Layout;
+class Workqueue;
+class Task_token;
+class Lock;
+class Condvar;
 
 class Garbage_collection
 {
  public:
 
   typedef Unordered_set<Section_id, Section_id_hash> Sections_reachable;
-  typedef std::map<Section_id, Sections_reachable> Section_ref;
   typedef std::vector<Section_id> Worklist_type;
   // This maps the name of the section which can be represented as a C
   // identifier (cident) to the list of sections that have that name.
@@ -55,19 +58,19 @@ class Garbage_collection
   typedef std::map<std::string, Sections_reachable> Cident_section_map;
 
   Garbage_collection()
-  : is_worklist_ready_(false)
+  : is_worklist_ready_(false), object_bases_(), section_count_(0),
+    references_(), reference_index_(), reference_targets_(), marked_(),
+    workers_(), idle_lock_(NULL), idle_condvar_(NULL), share_count_(0),
+    idle_tasks_(0), pending_(0), running_tasks_(0), live_count_(0),
+    reference_count_(0)
   { }
 
-  // Accessor methods for the private members.
-
-  Sections_reachable&
-  referenced_list()
-  { return referenced_list_; }
+  ~Garbage_collection();
 
-  Section_ref&
-  section_reloc_map()
-  { return this->section_reloc_map_; }
+  // Accessor methods for the private members.
 
+  // The sections which are known to be referenced before the
+  // transitive closure is computed.
   Worklist_type&
   worklist()
   { return this->work_list_; }
@@ -80,13 +83,32 @@ class Garbage_collection
   worklist_ready()
   { this->is_worklist_ready_ = true; }
 
+  // Mark every section reachable from the worklist.  This queues
+  // MARK_TASK_COUNT tasks on WORKQUEUE, each of which unblocks
+  // GC_BLOCKER when it is done.
+  void
+  do_transitive_closure(Workqueue* workqueue, Task_token* gc_blocker,
+			unsigned int mark_task_count);
+
+  // Mark the sections reachable from the sections held by mark task
+  // WORKER.  This is called by the mark tasks.
+  void
+  mark(unsigned int worker);
+
+  // Called by each mark task when it is done.
   void
-  do_transitive_closure();
+  finish_mark_task();
 
   bool
-  is_section_garbage(Relobj* obj, unsigned int shndx)
-  { return (this->referenced_list().find(Section_id(obj, shndx))
-            == this->referenced_list().end()); }
+  is_section_garbage(Relobj* obj, unsigned int shndx) const
+  {
+    Object_bases::const_iterator p = this->object_bases_.find(obj);
+    if (p == this->object_bases_.end() || shndx >= obj->shnum())
+      return true;
+    unsigned int node = p->second + shndx;
+    return (this->marked_[node / mark_word_bits]
+	    & (1U << (node % mark_word_bits))) == 0;
+  }
 
   Cident_section_map*
   cident_sections()
@@ -103,19 +125,94 @@ class Garbage_collection
   add_reference(Relobj* src_object, unsigned int src_shndx,
 		Relobj* dst_object, unsigned int dst_shndx)
   {
-    Section_id src_id(src_object, src_shndx);
-    Section_id dst_id(dst_object, dst_shndx);
-    Sections_reachable& reachable = this->section_reloc_map_[src_id];
-    reachable.insert(dst_id);
+    unsigned int src = this->section_node(src_object, src_shndx);
+    unsigned int dst = this->section_node(dst_object, dst_shndx);
+    if (src != -1U && dst != -1U)
+      this->references_.push_back(std::make_pair(src, dst));
   }
 
+  // Print statistical information to stderr.  This is used for --stats.
+  void
+  print_stats() const;
+
  private:
+  // Each section is a node in the reference graph.  The sections of
+  // an object are numbered consecutively from a multiple of
+  // MARK_WORD_BITS, so that each object has a bitmap of its own
+  // within MARKED_.
+  typedef Unordered_map<const Relobj*, unsigned int> Object_bases;
+
+  // The number of bits in a word of MARKED_.
+  static const unsigned int mark_word_bits = 32;
+
+  // The stacks of sections to visit of a mark task.  LOCAL is only
+  // used by the task itself; other tasks may take sections from
+  // SHARED while holding LOCK.
+  struct Mark_worker
+  {
+    Mark_worker()
+      : lock(NULL), local(), shared(), visited(0)
+    { }
+
+    Lock* lock;
+    std::vector<unsigned int> local;
+    std::vector<unsigned int> shared;
+    // The number of sections visited by the task.
+    unsigned int visited;
+  };
+
+  // Return the node for the SHNDX-th section of OBJECT, numbering
+  // the sections of OBJECT if needed.  Returns -1U for an invalid
+  // section index.
+  unsigned int
+  section_node(Relobj* object, unsigned int shndx);
+
+  // Set the mark bit of NODE.  Returns false if it was already set.
+  bool
+  set_mark(unsigned int node);
+
+  // Move sections to the local stack of mark task WORKER from its
+  // shared stack, or from the shared stack of another mark task.
+  // Returns false if there was nothing to move.
+  bool
+  refill_worker(unsigned int worker);
 
   Worklist_type work_list_;
   bool is_worklist_ready_;
-  Section_ref section_reloc_map_;
-  Sections_reachable referenced_list_;
   Cident_section_map cident_sections_;
+  // The first node of each object.
+  Object_bases object_bases_;
+  // The number of nodes.
+  unsigned int section_count_;
+  // The references added by add_reference, as pairs of nodes.  These
+  // are sorted into REFERENCE_INDEX_ and REFERENCE_TARGETS_ before
+  // marking.
+  std::vector<std::pair<unsigned int, unsigned int> > references_;
+  // The sections referenced by node N are REFERENCE_TARGETS_ from
+  // REFERENCE_INDEX_[N] up to REFERENCE_INDEX_[N + 1].
+  std::vector<unsigned int> reference_index_;
+  std::vector<unsigned int> reference_targets_;
+  // One bit for each node, set when the section is found to be
+  // referenced.
+  std::vector<uint32_t> marked_;
+  // The stacks of the mark tasks.
+  std::vector<Mark_worker> workers_;
+  // When there is more than one mark task, a task which finds nothing
+  // to visit waits on IDLE_CONDVAR_ until another task shares some
+  // sections or all the sections have been visited.  IDLE_LOCK_
+  // controls SHARE_COUNT_, the number of times sections have been
+  // shared, and IDLE_TASKS_, the number of waiting tasks.
+  Lock* idle_lock_;
+  Condvar* idle_condvar_;
+  unsigned int share_count_;
+  unsigned int idle_tasks_;
+  // The number of marked sections which have not yet been visited.
+  unsigned int pending_;
+  // The number of mark tasks which have not finished.
+  unsigned int running_tasks_;
+  // The number of marked sections, and of references.
+  unsigned int live_count_;
+  size_t reference_count_;
 };
 
 // Data to pass between successive invocations of do_layout
@@ -358,16 +455,14 @@ gc_process_relocs(
                 symtab->gc()->cident_sections()->find(std::string(cident_section_name));
               if (ele == symtab->gc()->cident_sections()->end())
                 continue;
-	      Section_id src_id(src_obj, src_indx);
-              Garbage_collection::Sections_reachable&
-                v(symtab->gc()->section_reloc_map()[src_id]);
               Garbage_collection::Sections_reachable& cident_secn(ele->second);
               for (Garbage_collection::Sections_reachable::iterator it_v
                      = cident_secn.begin();
                    it_v != cident_secn.end();
                    ++it_v)
                 {
-                  v.insert(*it_v);
+                  symtab->gc()->add_reference(src_obj, src_indx,
+                                              it_v->first, it_v->second);
                 }
             }
         }
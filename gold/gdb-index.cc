@@ -28,6 +28,8 @@
 #include "object.h"
 #include "output.h"
 #include "demangle.h"
+#include "workqueue.h"
+#include "timer.h"
 
 namespace gold
 {
@@ -183,15 +185,39 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0), cu_count_(0),
+      cu_nopubnames_count_(0), tu_count_(0), tu_nopubnames_count_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
+  // Add the counts of units seen by this reader to the statistics.
+  // This is called by the thread which merges the scans.
+  void
+  add_stats(unsigned int* cu_count, unsigned int* cu_nopubnames_count,
+	    unsigned int* tu_count, unsigned int* tu_nopubnames_count) const
+  {
+    *cu_count += this->cu_count_;
+    *cu_nopubnames_count += this->cu_nopubnames_count_;
+    *tu_count += this->tu_count_;
+    *tu_nopubnames_count += this->tu_nopubnames_count_;
+  }
+
+  // Record the counts of units seen by a scan.
+  static void
+  record_stats(unsigned int cu_count, unsigned int cu_nopubnames_count,
+	       unsigned int tu_count, unsigned int tu_nopubnames_count)
+  {
+    Gdb_index_info_reader::dwarf_cu_count += cu_count;
+    Gdb_index_info_reader::dwarf_cu_nopubnames_count += cu_nopubnames_count;
+    Gdb_index_info_reader::dwarf_tu_count += tu_count;
+    Gdb_index_info_reader::dwarf_tu_nopubnames_count += tu_nopubnames_count;
+  }
+
   // Print usage statistics.
   static void
   print_stats();
@@ -285,15 +311,22 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
-  // The current CU index (negative for a TU).
+  // The scan of the object for the Gdb_index section.
+  Gdb_index_scan* scan_;
+  // The current CU index (negative for a TU).  This is an index into
+  // the units of the object; it is adjusted when the scan is merged.
   int cu_index_;
   // The language of the current CU or TU.
   unsigned int cu_language_;
   // Map from DIE offset to (parent offset, name) pair,
   // for DW_AT_specification.
   Declaration_map declarations_;
+  // The units seen by this reader, for statistics.  These are added
+  // to the static counts when the scan is merged.
+  unsigned int cu_count_;
+  unsigned int cu_nopubnames_count_;
+  unsigned int tu_count_;
+  unsigned int tu_nopubnames_count_;
 
   // Statistics.
   // Total number of DWARF compilation units processed.
@@ -306,6 +339,222 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   static unsigned int dwarf_tu_nopubnames_count;
 };
 
+// The .gdb_index information found in the .debug_info and
+// .debug_types sections of one object.  The units are numbered within
+// the object, and the symbols are collected in a table local to the
+// object, so that objects can be scanned in parallel.
+
+class Gdb_index_scan
+{
+ public:
+  typedef Gdb_index::Comp_unit Comp_unit;
+  typedef Gdb_index::Type_unit Type_unit;
+  typedef Gdb_index::Per_cu_range_list Per_cu_range_list;
+  typedef Gdb_index::Cu_vector Cu_vector;
+
+  // A symbol found in the object.
+  struct Scan_symbol
+  {
+    // The name, which is stored in the stringpool of the scan.
+    const char* name;
+    // The length of the name.
+    size_t length;
+    // The Stringpool hash code of the name.
+    uint32_t name_hash;
+    // The gdb_index hash code of the name.
+    unsigned int hashval;
+    // The CUs and TUs which define the name, numbered within the
+    // object.
+    Cu_vector cu_vector;
+  };
+
+  Gdb_index_scan(Relobj* object, const unsigned char* symbols,
+		 off_t symbols_size);
+
+  ~Gdb_index_scan();
+
+  // Return the object.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record an input section to scan.
+  void
+  add_section(bool is_type_unit, unsigned int shndx, unsigned int reloc_shndx,
+	      unsigned int reloc_type)
+  {
+    this->sections_.push_back(Section(is_type_unit, shndx, reloc_shndx,
+				      reloc_type));
+  }
+
+  // Scan the input sections.  The object must be locked.
+  void
+  scan();
+
+  // Return whether the input sections have been scanned.
+  bool
+  is_scanned() const
+  { return this->is_scanned_; }
+
+  // Add a compilation unit.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(Relobj* object, unsigned int cu_index,
+			 Dwarf_range_list* ranges)
+  {
+    this->ranges_.push_back(Per_cu_range_list(object, cu_index, ranges));
+  }
+
+  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
+  // the high-byte of the cu_index field.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set for OBJECT of the CUs and TUS associated with the statement
+  // list at OFFSET.
+  bool
+  pubnames_read(const Relobj* object, off_t offset);
+
+  // Record that we have already read the pubnames associated with
+  // OBJECT and OFFSET.
+  void
+  set_pubnames_read(const Relobj* object, off_t offset);
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return pubtypes_table_; }
+
+  // Accessors for the results, used when merging the scan.
+
+  const std::vector<Comp_unit>&
+  comp_units() const
+  { return this->comp_units_; }
+
+  const std::vector<Type_unit>&
+  type_units() const
+  { return this->type_units_; }
+
+  const std::vector<Per_cu_range_list>&
+  ranges() const
+  { return this->ranges_; }
+
+  const std::vector<Scan_symbol>&
+  symbols() const
+  { return this->symbols_; }
+
+  // Add the statistics of the scan to the totals.
+  void
+  record_stats() const
+  {
+    Gdb_index_info_reader::record_stats(this->cu_count_,
+					this->cu_nopubnames_count_,
+					this->tu_count_,
+					this->tu_nopubnames_count_);
+  }
+
+  // Return the wall clock time spent scanning, in milliseconds.  This
+  // is only set when printing statistics.
+  long
+  scan_time() const
+  { return this->scan_time_; }
+
+ private:
+  Gdb_index_scan(const Gdb_index_scan&);
+  Gdb_index_scan& operator=(const Gdb_index_scan&);
+
+  // An input section to scan.
+  struct Section
+  {
+    Section(bool type_unit, unsigned int index, unsigned int reloc_index,
+	    unsigned int rtype)
+      : is_type_unit(type_unit), shndx(index), reloc_shndx(reloc_index),
+	reloc_type(rtype)
+    { }
+
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Scan the given pubtable and build a map of the various dies it
+  // refers to, so we can process the entries when we encounter the
+  // die.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+                       Gdb_index_info_reader* dwinfo);
+
+  // Wrapper for map_pubtable_to_dies
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo);
+
+  // The object.
+  Relobj* object_;
+  // A copy of the symbol table of the object, or NULL.
+  unsigned char* symtab_;
+  off_t symtab_size_;
+  // The input sections to scan.
+  std::vector<Section> sections_;
+  // Whether the input sections have been scanned.
+  bool is_scanned_;
+  // Tables to store the pubnames section of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // Object, stmt list offset of the CUs and TUs associated with the
+  // last read pubnames and pubtypes sections.
+  const Relobj* pubnames_object_;
+  off_t stmt_list_offset_;
+  // The units and address ranges found in the object.
+  std::vector<Comp_unit> comp_units_;
+  std::vector<Type_unit> type_units_;
+  std::vector<Per_cu_range_list> ranges_;
+  // The symbols found in the object, in the order in which they were
+  // first seen, indexed by the key in NAMES_ minus one.
+  std::vector<Scan_symbol> symbols_;
+  Stringpool names_;
+  // Statistics.
+  unsigned int cu_count_;
+  unsigned int cu_nopubnames_count_;
+  unsigned int tu_count_;
+  unsigned int tu_nopubnames_count_;
+  long scan_time_;
+};
+
 // Total number of DWARF compilation units processed.
 unsigned int Gdb_index_info_reader::dwarf_cu_count = 0;
 // Number of DWARF compilation units without pubnames/pubtypes.
@@ -321,8 +570,8 @@ void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  ++this->cu_count_;
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +582,10 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
+  ++this->tu_count_;
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						    signature);
   this->visit_top_die(root_die);
 }
 
@@ -381,9 +630,9 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 		return;
 	      }
 	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
+	      ++this->cu_nopubnames_count_;
 	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	      ++this->tu_nopubnames_count_;
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -437,8 +686,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
-                                           full_name.c_str(), 0);
+	      this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -477,8 +725,8 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str(), 0);
+		this->scan_->add_symbol(this->cu_index_,
+					full_name.c_str(), 0);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -825,8 +1073,8 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->object(),
+					    this->cu_index_, ranges);
       return;
     }
 
@@ -851,8 +1099,8 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->object(),
+					      this->cu_index_, ranges);
         }
     }
 }
@@ -877,7 +1125,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->scan_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -916,8 +1164,8 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->scan_->pubnames_read(this->object(),
+                                            stmt_list_off);
         }
       else
         {
@@ -928,10 +1176,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->scan_->pubnames_read(this->object(), stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(this->object(), stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -939,12 +1187,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -978,41 +1226,73 @@ Gdb_index_info_reader::print_stats()
           program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
 }
 
-// Class Gdb_index.
-
-// Construct the .gdb_index section.
-
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
+// Class Gdb_index_scan.
+
+Gdb_index_scan::Gdb_index_scan(Relobj* object, const unsigned char* symbols,
+			       off_t symbols_size)
+  : object_(object), symtab_(NULL), symtab_size_(symbols_size),
+    sections_(), is_scanned_(false), pubnames_table_(NULL),
+    pubtypes_table_(NULL), cu_pubname_map_(), cu_pubtype_map_(),
+    pubnames_object_(NULL), stmt_list_offset_(-1), comp_units_(),
+    type_units_(), ranges_(), symbols_(), names_(), cu_count_(0),
+    cu_nopubnames_count_(0), tu_count_(0), tu_nopubnames_count_(0),
+    scan_time_(0)
 {
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  // The symbol table passed to Layout::add_to_gdb_index is only
+  // valid while the object is being laid out, so keep a copy.
+  if (symbols != NULL)
+    {
+      this->symtab_ = new unsigned char[symbols_size];
+      memcpy(this->symtab_, symbols, symbols_size);
+    }
 }
 
-Gdb_index::~Gdb_index()
+Gdb_index_scan::~Gdb_index_scan()
 {
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
+  delete[] this->symtab_;
+  delete this->pubnames_table_;
+  delete this->pubtypes_table_;
 }
 
+// Scan the input sections of the object.
+
+void
+Gdb_index_scan::scan()
+{
+  gold_assert(!this->is_scanned_);
+
+  Timer timer;
+  if (parameters->options().stats())
+    timer.start();
+
+  for (std::vector<Section>::const_iterator p = this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    {
+      Gdb_index_info_reader dwinfo(p->is_type_unit, this->object_,
+				   this->symtab_, this->symtab_size_,
+				   p->shndx, p->reloc_shndx,
+				   p->reloc_type, this);
+      if (this->object_ != this->pubnames_object_)
+	this->map_pubnames_and_types_to_dies(&dwinfo);
+      dwinfo.parse();
+      dwinfo.add_stats(&this->cu_count_, &this->cu_nopubnames_count_,
+		       &this->tu_count_, &this->tu_nopubnames_count_);
+    }
+
+  // The symbol table and the pubnames tables are no longer needed.
+  delete[] this->symtab_;
+  this->symtab_ = NULL;
+  delete this->pubnames_table_;
+  this->pubnames_table_ = NULL;
+  delete this->pubtypes_table_;
+  this->pubtypes_table_ = NULL;
+
+  if (parameters->options().stats())
+    this->scan_time_ = timer.get_elapsed_time().wall;
+
+  this->is_scanned_ = true;
+}
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1020,11 +1300,8 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_scan::map_pubtable_to_dies(unsigned int attr,
+				     Gdb_index_info_reader* dwinfo)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1042,7 +1319,7 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, this->symtab_, this->symtab_size_))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1057,30 +1334,25 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
 // Wrapper for map_pubtable_to_dies
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index_scan::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo)
 {
   // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
+  this->pubnames_object_ = this->object_;
   this->stmt_list_offset_ = -1;
 
   delete this->pubnames_table_;
   this->pubnames_table_
-      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
+      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo);
   delete this->pubtypes_table_;
   this->pubtypes_table_
-      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1092,7 +1364,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1100,81 +1372,302 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
   return -1;
 }
 
-// Scan a .debug_info or .debug_types input section.
+// Return TRUE if we have already processed the pubnames associated
+// with the statement list at the given OFFSET.
+
+bool
+Gdb_index_scan::pubnames_read(const Relobj* object, off_t offset)
+{
+  bool ret = (this->pubnames_object_ == object
+	      && this->stmt_list_offset_ == offset);
+  return ret;
+}
+
+// Record that we have processed the pubnames associated with the
+// statement list for OBJECT at the given OFFSET.
 
 void
-Gdb_index::scan_debug_info(bool is_type_unit,
-			   Relobj* object,
-			   const unsigned char* symbols,
-			   off_t symbols_size,
-			   unsigned int shndx,
-			   unsigned int reloc_shndx,
-			   unsigned int reloc_type)
+Gdb_index_scan::set_pubnames_read(const Relobj* object, off_t offset)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  this->pubnames_object_ = object;
+  this->stmt_list_offset_ = offset;
 }
 
-// Add a symbol.
+// Add a symbol.  The symbol table of the scan has the same layout as
+// the one in Gdb_index, so that merging the scans in order adds the
+// symbols to the index in the same order as scanning the objects
+// one after another.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+Gdb_index_scan::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
-  Gdb_symbol* sym = new Gdb_symbol();
-  this->stringpool_.add(sym_name, true, &sym->name_key);
-  sym->hashval = hash;
-  sym->cu_vector_index = 0;
-
-  Gdb_symbol* found = this->gdb_symtab_->add(sym);
-  if (found == sym)
+  size_t length = strlen(sym_name);
+  uint32_t name_hash = Stringpool::string_hash(sym_name, length);
+  Stringpool::Key name_key;
+  const char* name = this->names_.add_with_hash(sym_name, length, name_hash,
+						true, &name_key);
+  gold_assert(name_key > 0);
+
+  if (name_key > this->symbols_.size())
     {
-      // New symbol -- allocate a new CU index vector.
-      found->cu_vector_index = this->cu_vector_list_.size();
-      this->cu_vector_list_.push_back(new Cu_vector());
-    }
-  else
-    {
-      // Found an existing symbol -- append to the existing
-      // CU index vector.
-      delete sym;
+      // New symbol -- compute its gdb_index hash code, which the
+      // merge will use to place it in the symbol table.
+      gold_assert(name_key == this->symbols_.size() + 1);
+      Scan_symbol sym;
+      sym.name = name;
+      sym.length = length;
+      sym.name_hash = name_hash;
+      sym.hashval = mapped_index_string_hash(
+	  reinterpret_cast<const unsigned char*>(sym_name));
+      this->symbols_.push_back(sym);
     }
 
   // Add the CU index to the vector list for this symbol,
   // if it's not already on the list.  We only need to
   // check the last added entry.
-  Cu_vector* cu_vec = this->cu_vector_list_[found->cu_vector_index];
+  Cu_vector* cu_vec = &this->symbols_[name_key - 1].cu_vector;
   if (cu_vec->size() == 0
       || cu_vec->back().first != cu_index
       || cu_vec->back().second != flags)
     cu_vec->push_back(std::make_pair(cu_index, flags));
 }
 
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
+// A task to scan the .debug_info and .debug_types sections of one
+// object.
 
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
+class Gdb_index_scan_task : public Task
 {
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
+ public:
+  Gdb_index_scan_task(Gdb_index_scan* scan, Task_token* blocker)
+    : scan_(scan), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    Relobj* object = this->scan_->object();
+    return object->is_locked() ? object->token() : NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->scan_->object()->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->scan_->scan();
+    this->scan_->object()->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->scan_->object()->name(); }
+
+ private:
+  Gdb_index_scan* scan_;
+  Task_token* blocker_;
+};
+
+// Class Gdb_index.
+
+// Number of objects scanned.
+unsigned int Gdb_index::scanned_object_count = 0;
+// Wall clock time spent scanning objects.
+long Gdb_index::scan_time = 0;
+// Wall clock time spent merging the scans.
+long Gdb_index::merge_time = 0;
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    gdb_index_section_(gdb_index_section),
+    scans_(),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    symbols_by_key_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0)
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
 }
 
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
+Gdb_index::~Gdb_index()
+{
+  // Free any scans which were not merged.
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    delete this->scans_[i];
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+}
+
+// Record a .debug_info or .debug_types input section.  The sections
+// of an object are recorded together while the object is laid out.
 
 void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
+Gdb_index::add_input_section(bool is_type_unit,
+			     Relobj* object,
+			     const unsigned char* symbols,
+			     off_t symbols_size,
+			     unsigned int shndx,
+			     unsigned int reloc_shndx,
+			     unsigned int reloc_type)
 {
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
+  if (this->scans_.empty() || this->scans_.back()->object() != object)
+    this->scans_.push_back(new Gdb_index_scan(object, symbols,
+					      symbols_size));
+  this->scans_.back()->add_section(is_type_unit, shndx, reloc_shndx,
+				   reloc_type);
+}
+
+// Queue a task to scan each object.
+
+void
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  for (std::vector<Gdb_index_scan*>::const_iterator p = this->scans_.begin();
+       p != this->scans_.end();
+       ++p)
+    {
+      blocker->add_blocker();
+      workqueue->queue(new Gdb_index_scan_task(*p, blocker));
+    }
+}
+
+// Add a symbol.
+
+Gdb_index::Cu_vector*
+Gdb_index::add_symbol(const char* name, size_t length, uint32_t name_hash,
+		      unsigned int hashval)
+{
+  // The stringpool keys are assigned consecutively, so the key tells
+  // us whether we have seen this name before without hashing it a
+  // second time for the symbol table.
+  Stringpool::Key name_key;
+  this->stringpool_.add_with_hash(name, length, name_hash, true, &name_key);
+  gold_assert(name_key > 0);
+
+  Gdb_symbol* found;
+  if (name_key <= this->symbols_by_key_.size())
+    {
+      // Found an existing symbol -- append to the existing
+      // CU index vector.
+      found = this->symbols_by_key_[name_key - 1];
+    }
+  else
+    {
+      // New symbol -- allocate a new CU index vector.
+      gold_assert(name_key == this->symbols_by_key_.size() + 1);
+      Gdb_symbol* sym = new Gdb_symbol();
+      sym->name_key = name_key;
+      sym->hashval = hashval;
+      sym->cu_vector_index = this->cu_vector_list_.size();
+      found = this->gdb_symtab_->add(sym);
+      gold_assert(found == sym);
+      this->symbols_by_key_.push_back(sym);
+      this->cu_vector_list_.push_back(new Cu_vector());
+    }
+
+  return this->cu_vector_list_[found->cu_vector_index];
+}
+
+// Merge the results of scanning an object.  The CU and TU indexes
+// of the scan are numbered within the object, and are renumbered
+// here.
+
+void
+Gdb_index::merge_scan(const Gdb_index_scan* scan)
+{
+  const int cu_base = this->comp_units_.size();
+  const int tu_base = this->type_units_.size();
+
+  this->comp_units_.insert(this->comp_units_.end(),
+			   scan->comp_units().begin(),
+			   scan->comp_units().end());
+  this->type_units_.insert(this->type_units_.end(),
+			   scan->type_units().begin(),
+			   scan->type_units().end());
+
+  const std::vector<Per_cu_range_list>& ranges(scan->ranges());
+  for (unsigned int i = 0; i < ranges.size(); ++i)
+    {
+      int cu_index = ranges[i].cu_index;
+      cu_index = cu_index >= 0 ? cu_index + cu_base : cu_index - tu_base;
+      this->ranges_.push_back(Per_cu_range_list(ranges[i].object, cu_index,
+						ranges[i].ranges));
+    }
+
+  const std::vector<Gdb_index_scan::Scan_symbol>& symbols(scan->symbols());
+  for (unsigned int i = 0; i < symbols.size(); ++i)
+    {
+      const Gdb_index_scan::Scan_symbol& sym(symbols[i]);
+      Cu_vector* cu_vec = this->add_symbol(sym.name, sym.length,
+					   sym.name_hash, sym.hashval);
+      for (unsigned int j = 0; j < sym.cu_vector.size(); ++j)
+	{
+	  int cu_index = sym.cu_vector[j].first;
+	  uint8_t flags = sym.cu_vector[j].second;
+	  cu_index = cu_index >= 0 ? cu_index + cu_base : cu_index - tu_base;
+	  if (cu_vec->size() == 0
+	      || cu_vec->back().first != cu_index
+	      || cu_vec->back().second != flags)
+	    cu_vec->push_back(std::make_pair(cu_index, flags));
+	}
+    }
+
+  scan->record_stats();
+}
+
+// Merge the scans in input order.  Objects whose scan task has not
+// run are scanned here.
+
+void
+Gdb_index::merge_scans()
+{
+  Timer timer;
+  long scanned_here = 0;
+  if (parameters->options().stats())
+    timer.start();
+
+  for (std::vector<Gdb_index_scan*>::iterator p = this->scans_.begin();
+       p != this->scans_.end();
+       ++p)
+    {
+      Gdb_index_scan* scan = *p;
+      if (!scan->is_scanned())
+	{
+	  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+	  Task_lock_obj<Object> tl(dummy_task, scan->object());
+	  scan->scan();
+	  scanned_here += scan->scan_time();
+	}
+      this->merge_scan(scan);
+      ++Gdb_index::scanned_object_count;
+      Gdb_index::scan_time += scan->scan_time();
+      delete scan;
+    }
+  this->scans_.clear();
+
+  if (parameters->options().stats())
+    Gdb_index::merge_time += timer.get_elapsed_time().wall - scanned_here;
 }
 
 // Set the size of the .gdb_index section.
@@ -1182,6 +1675,9 @@ Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
 void
 Gdb_index::set_final_data_size()
 {
+  // Collect the results of the scan tasks.
+  this->merge_scans();
+
   // Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
@@ -1352,8 +1848,15 @@ Gdb_index::do_write(Output_file* of)
 void
 Gdb_index::print_stats()
 {
-  if (parameters->options().gdb_index())
-    Gdb_index_info_reader::print_stats();
+  if (!parameters->options().gdb_index())
+    return;
+  Gdb_index_info_reader::print_stats();
+  fprintf(stderr,
+	  _("%s: gdb_index objects scanned: %u "
+	    "(scan wall: %ld.%06ld merge wall: %ld.%06ld)\n"),
+	  program_name, Gdb_index::scanned_object_count,
+	  Gdb_index::scan_time / 1000, (Gdb_index::scan_time % 1000) * 1000,
+	  Gdb_index::merge_time / 1000, (Gdb_index::merge_time % 1000) * 1000);
 }
 
 } // End namespace gold.
@@ -43,12 +43,22 @@ class Dwarf_range_list;
 template <typename T>
 class Gdb_hashtab;
 class Gdb_index_info_reader;
+class Gdb_index_scan;
 class Dwarf_pubnames_table;
+class Workqueue;
+class Task_token;
 
 // This class manages the .gdb_index section, which is a fast
 // lookup table for DWARF information used by the gdb debugger.
 // The format of this section is described in gdb/doc/gdb.texinfo.
 
+// The .debug_info and .debug_types sections are not read when they
+// are laid out.  They are recorded by object, and scanned by a task
+// for each object, so that the objects may be scanned in parallel.
+// The results are merged in input order when the section size is
+// set, so the output does not depend on the order in which the tasks
+// run.
+
 class Gdb_index : public Output_section_data
 {
  public:
@@ -56,73 +66,21 @@ class Gdb_index : public Output_section_data
 
   ~Gdb_index();
 
-  // Scan a .debug_info or .debug_types input section.
-  void scan_debug_info(bool is_type_unit,
-		       Relobj* object,
-		       const unsigned char* symbols,
-		       off_t symbols_size,
-		       unsigned int shndx,
-		       unsigned int reloc_shndx,
-		       unsigned int reloc_type);
-
-  // Add a compilation unit.
-  int
-  add_comp_unit(off_t cu_offset, off_t cu_length)
-  {
-    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
-    return this->comp_units_.size() - 1;
-  }
-
-  // Add a type unit.
-  int
-  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
-  {
-    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
-    return this->type_units_.size() - 1;
-  }
-
-  // Add an address range.
-  void
-  add_address_range_list(Relobj* object, unsigned int cu_index,
-			 Dwarf_range_list* ranges)
-  {
-    this->ranges_.push_back(Per_cu_range_list(object, cu_index, ranges));
-  }
-
-  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
-  // the high-byte of the cu_index field.
+  // Record a .debug_info or .debug_types input section to be scanned.
+  // SYMBOLS is the symbol table of OBJECT; it is copied.
   void
-  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
-
-  // Return the offset into the pubnames table for the cu at the given
-  // offset.
-  off_t
-  find_pubname_offset(off_t cu_offset);
-
-  // Return the offset into the pubtypes table for the cu at the
-  // given offset.
-  off_t
-  find_pubtype_offset(off_t cu_offset);
-
-  // Return TRUE if we have already processed the pubnames and types
-  // set for OBJECT of the CUs and TUS associated with the statement
-  // list at OFFSET.
-  bool
-  pubnames_read(const Relobj* object, off_t offset);
-
-  // Record that we have already read the pubnames associated with
-  // OBJECT and OFFSET.
+  add_input_section(bool is_type_unit,
+		    Relobj* object,
+		    const unsigned char* symbols,
+		    off_t symbols_size,
+		    unsigned int shndx,
+		    unsigned int reloc_shndx,
+		    unsigned int reloc_type);
+
+  // Queue a task to scan the input sections of each object.  Each
+  // task unblocks BLOCKER when it is done.
   void
-  set_pubnames_read(const Relobj* object, off_t offset);
-
-  // Return a pointer to the given table.
-  Dwarf_pubnames_table*
-  pubnames_table()
-  { return pubnames_table_; }
-
-  Dwarf_pubnames_table*
-  pubtypes_table()
-  { return pubtypes_table_; }
+  queue_scan_tasks(Workqueue* workqueue, Task_token* blocker);
 
   // Print usage statistics.
   static void
@@ -148,22 +106,9 @@ class Gdb_index : public Output_section_data
   do_print_to_mapfile(Mapfile* mapfile) const
   { mapfile->print_output_data(this, _("** gdb_index")); }
 
-  // Create a map from dies to pubnames.
-  Dwarf_pubnames_table*
-  map_pubtable_to_dies(unsigned int attr,
-                       Gdb_index_info_reader* dwinfo,
-                       Relobj* object,
-                       const unsigned char* symbols,
-                       off_t symbols_size);
-
-  // Wrapper for map_pubtable_to_dies
-  void
-  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                 Relobj* object,
-                                 const unsigned char* symbols,
-                                 off_t symbols_size);
-
  private:
+  friend class Gdb_index_scan;
+
   // An entry in the compilation unit list.
   struct Comp_unit
   {
@@ -216,23 +161,27 @@ class Gdb_index : public Output_section_data
 
   typedef std::vector<std::pair<int, uint8_t> > Cu_vector;
 
-  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
-  Pubname_offset_map cu_pubname_map_;
-  Pubname_offset_map cu_pubtype_map_;
+  // Add a symbol named NAME, of length LENGTH, whose Stringpool hash
+  // code is NAME_HASH and whose gdb_index hash code is HASHVAL.
+  // Return the CU vector of the symbol.
+  Cu_vector*
+  add_symbol(const char* name, size_t length, uint32_t name_hash,
+	     unsigned int hashval);
 
-  // Scan the given pubtable and build a map of the various dies it
-  // refers to, so we can process the entries when we encounter the
-  // die.
+  // Merge the results of SCAN into the index.
   void
-  map_pubtable_to_dies(Dwarf_pubnames_table* table,
-                       Pubname_offset_map* map);
+  merge_scan(const Gdb_index_scan* scan);
 
-  // Tables to store the pubnames section of the current object.
-  Dwarf_pubnames_table* pubnames_table_;
-  Dwarf_pubnames_table* pubtypes_table_;
+  // Merge the results of all the scans, scanning any objects which
+  // have not been scanned yet.
+  void
+  merge_scans();
 
   // The .gdb_index section.
   Output_section* gdb_index_section_;
+  // The objects whose input sections remain to be merged, in input
+  // order.
+  std::vector<Gdb_index_scan*> scans_;
   // The list of DWARF compilation units.
   std::vector<Comp_unit> comp_units_;
   // The list of DWARF type units.
@@ -241,6 +190,8 @@ class Gdb_index : public Output_section_data
   std::vector<Per_cu_range_list> ranges_;
   // The symbol table.
   Gdb_hashtab<Gdb_symbol>* gdb_symtab_;
+  // The entries of GDB_SYMTAB_, indexed by stringpool key minus one.
+  std::vector<Gdb_symbol*> symbols_by_key_;
   // The CU vector portion of the constant pool.
   std::vector<Cu_vector*> cu_vector_list_;
   // An array to map from a CU vector index to an offset to the constant pool.
@@ -253,10 +204,15 @@ class Gdb_index : public Output_section_data
   off_t symtab_offset_;
   off_t cu_pool_offset_;
   off_t stringpool_offset_;
-  // Object, stmt list offset of the CUs and TUs associated with the
-  // last read pubnames and pubtypes sections.
-  const Relobj* pubnames_object_;
-  off_t stmt_list_offset_;
+
+  // Statistics.
+  // Number of objects scanned.
+  static unsigned int scanned_object_count;
+  // Wall clock time spent scanning objects, summed over the scan
+  // tasks, in milliseconds.
+  static long scan_time;
+  // Wall clock time spent merging the scans, in milliseconds.
+  static long merge_time;
 };
 
 } // End namespace gold.
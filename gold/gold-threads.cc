@@ -22,7 +22,11 @@
 
 #include "gold.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
+#include <vector>
+#include <unistd.h>
 
 #ifdef ENABLE_THREADS
 #include <pthread.h>
@@ -56,6 +60,14 @@ class Lock_impl_nothreads : public Lock_impl
     this->acquired_ = true;
   }
 
+  bool
+  try_acquire()
+  {
+    gold_assert(!this->acquired_);
+    this->acquired_ = true;
+    return true;
+  }
+
   void
   release()
   {
@@ -83,6 +95,8 @@ class Lock_impl_threads : public Lock_impl
 
   void acquire();
 
+  bool try_acquire();
+
   void release();
 
 private:
@@ -131,6 +145,17 @@ Lock_impl_threads::acquire()
     gold_fatal(_("pthread_mutex_lock failed: %s"), strerror(err));
 }
 
+bool
+Lock_impl_threads::try_acquire()
+{
+  int err = pthread_mutex_trylock(&this->mutex_);
+  if (err == EBUSY)
+    return false;
+  if (err != 0)
+    gold_fatal(_("pthread_mutex_trylock failed: %s"), strerror(err));
+  return true;
+}
+
 void
 Lock_impl_threads::release()
 {
@@ -447,4 +472,186 @@ Initialize_lock::do_run_once(void*)
   *this->pplock_ = new Lock();
 }
 
+#ifdef ENABLE_THREADS
+
+// A routine passed to pthread_create which runs calls of a
+// Parallel_run.
+
+extern "C"
+{
+
+static void*
+c_parallel_run(void* arg)
+{
+  static_cast<Parallel_run*>(arg)->internal_run();
+  return NULL;
+}
+
+}
+
+#endif // defined(ENABLE_THREADS)
+
+// Class Parallel_run.
+
+int Parallel_run::busy_threads;
+
+#if defined(ENABLE_THREADS) && !defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+// Without the sync builtins, this lock controls access to
+// Parallel_run::busy_threads and to the next call of each Parallel_run.
+static Lock* parallel_run_lock = NULL;
+static Initialize_lock parallel_run_initialize_lock(&parallel_run_lock);
+#endif
+
+// Add DELTA to *P, and return the old value of *P.
+
+template<typename Int_type>
+static inline Int_type
+parallel_run_fetch_and_add(Int_type* p, Int_type delta)
+{
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  return __sync_fetch_and_add(p, delta);
+#else
+#ifdef ENABLE_THREADS
+  parallel_run_initialize_lock.initialize();
+  Hold_optional_lock hl(parallel_run_lock);
+#endif
+  Int_type old = *p;
+  *p = old + delta;
+  return old;
+#endif
+}
+
+// If *P is OLDVAL, set it to NEWVAL and return true.  Otherwise
+// return false.
+
+static inline bool
+parallel_run_compare_and_swap(int* p, int oldval, int newval)
+{
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  return __sync_bool_compare_and_swap(p, oldval, newval);
+#else
+#ifdef ENABLE_THREADS
+  parallel_run_initialize_lock.initialize();
+  Hold_optional_lock hl(parallel_run_lock);
+#endif
+  if (*p != oldval)
+    return false;
+  *p = newval;
+  return true;
+#endif
+}
+
+void
+Parallel_run::run(unsigned int thread_count)
+{
+  this->call_count_ = thread_count;
+  this->next_call_ = 0;
+
+#ifdef ENABLE_THREADS
+  if (thread_count > 1
+      && parameters->options_valid()
+      && parameters->options().threads())
+    {
+      // Reserve the threads to start, so that the threads started by
+      // other tasks at the same time leave room for them.  The calling
+      // thread is already counted as busy if it runs a task.
+      int started;
+      while (true)
+	{
+	  int busy = parallel_run_fetch_and_add(&Parallel_run::busy_threads,
+						0);
+	  started = static_cast<int>(thread_count) - std::max(busy, 1);
+	  if (started <= 0)
+	    {
+	      started = 0;
+	      break;
+	    }
+	  if (parallel_run_compare_and_swap(&Parallel_run::busy_threads, busy,
+					    busy + started))
+	    break;
+	}
+
+      std::vector<pthread_t> tids(started);
+      for (int i = 0; i < started; ++i)
+	{
+	  int err = pthread_create(&tids[i], NULL, c_parallel_run, this);
+	  if (err != 0)
+	    gold_fatal(_("pthread_create failed: %s"), strerror(err));
+	}
+
+      // The calling thread takes its share of the calls.
+      this->internal_run();
+
+      for (int i = 0; i < started; ++i)
+	{
+	  int err = pthread_join(tids[i], NULL);
+	  if (err != 0)
+	    gold_fatal(_("pthread_join failed: %s"), strerror(err));
+	}
+      parallel_run_fetch_and_add(&Parallel_run::busy_threads, -started);
+      return;
+    }
+#endif // defined(ENABLE_THREADS)
+
+  this->internal_run();
+}
+
+// Make calls to do_run until they have all been made.
+
+void
+Parallel_run::internal_run()
+{
+  while (true)
+    {
+      unsigned int index = parallel_run_fetch_and_add(&this->next_call_, 1U);
+      if (index >= this->call_count_)
+	break;
+      this->do_run(index);
+    }
+}
+
+// Return the number of threads to use.
+
+unsigned int
+Parallel_run::thread_count(Phase phase)
+{
+  // This is false if we were compiled without thread support.
+  if (!parameters->options_valid() || !parameters->options().threads())
+    return 1;
+  int count = (phase == FINAL_PHASE
+	       ? parameters->options().thread_count_final()
+	       : parameters->options().thread_count_middle());
+  if (count <= 0)
+    {
+#ifdef ENABLE_THREADS
+      long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+      count = nprocs > 0 ? nprocs : 1;
+#else
+      count = 1;
+#endif
+    }
+  return count;
+}
+
+// Return the number of threads that run would use.
+
+unsigned int
+Parallel_run::available_threads(unsigned int thread_count)
+{
+#ifdef ENABLE_THREADS
+  int busy = parallel_run_fetch_and_add(&Parallel_run::busy_threads, 0);
+  if (static_cast<int>(thread_count) > busy)
+    return thread_count - std::max(busy - 1, 0);
+#endif
+  return std::min(thread_count, 1U);
+}
+
+// Record that a thread has started or finished running a task.
+
+void
+Parallel_run::adjust_busy_threads(int delta)
+{
+  parallel_run_fetch_and_add(&Parallel_run::busy_threads, delta);
+}
+
 } // End namespace gold.
@@ -53,6 +53,9 @@ class Lock_impl
   virtual void
   acquire() = 0;
 
+  virtual bool
+  try_acquire() = 0;
+
   virtual void
   release() = 0;
 };
@@ -71,6 +74,12 @@ class Lock
   acquire()
   { this->lock_->acquire(); }
 
+  // Acquire the lock if it is free.  Return whether the lock was
+  // acquired.
+  bool
+  try_acquire()
+  { return this->lock_->try_acquire(); }
+
   // Release the lock.
   void
   release()
@@ -262,6 +271,86 @@ class Initialize_lock : public Once
   Lock** const pplock_;
 };
 
+// Run a function in several threads at once, and wait for all of them
+// to finish.  This is used to split up a large amount of work which is
+// done within a single task, such as sorting a string table.  The
+// child class implements do_run.  If we are not using threads, the
+// calls are simply made one after another.
+//
+// The threads started here are counted together with the workqueue
+// threads which are running a task, so that several tasks using this
+// class at the same time do not each start a full set of threads.
+
+class Parallel_run
+{
+ public:
+  // The phase of the link in which the work is done, which selects
+  // the option giving the number of threads to use.
+  enum Phase
+  {
+    // --thread-count-middle.
+    MIDDLE_PHASE,
+    // --thread-count-final.
+    FINAL_PHASE
+  };
+
+  Parallel_run()
+    : call_count_(0), next_call_(0)
+  { }
+
+  virtual
+  ~Parallel_run()
+  { }
+
+  // Call do_run(I) for each I from 0 to THREAD_COUNT - 1, and wait for
+  // all the calls to return.  The calls are spread over at most
+  // THREAD_COUNT threads, including the calling thread, and over fewer
+  // if other threads are busy, so do_run must not wait for another
+  // call to do_run.
+  void
+  run(unsigned int thread_count);
+
+  // Return the number of threads to use for work split up with this
+  // class in PHASE: the --thread-count-middle or --thread-count-final
+  // option if it was given, otherwise the number of processors.  This
+  // returns 1 if we are not using threads.
+  static unsigned int
+  thread_count(Phase phase);
+
+  // Return the number of threads that run(THREAD_COUNT) would use if
+  // it were called now.
+  static unsigned int
+  available_threads(unsigned int thread_count);
+
+  // Called by the workqueue when a thread starts (DELTA is 1) or
+  // finishes (DELTA is -1) running a task.
+  static void
+  adjust_busy_threads(int delta);
+
+  // This is an internal function, which must be public because it is
+  // run by an extern "C" function called via pthread_create.
+  void
+  internal_run();
+
+ protected:
+  // This must be implemented by the child class.
+  virtual void
+  do_run(unsigned int index) = 0;
+
+ private:
+  // This class can not be copied.
+  Parallel_run(const Parallel_run&);
+  Parallel_run& operator=(const Parallel_run&);
+
+  // The number of calls to do_run, and the index of the next one.
+  unsigned int call_count_;
+  unsigned int next_call_;
+
+  // The number of threads running a workqueue task or a call to
+  // do_run.
+  static int busy_threads;
+};
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_THREADS_H)
@@ -39,11 +39,13 @@
 #include "common.h"
 #include "object.h"
 #include "layout.h"
+#include "merge.h"
 #include "reloc.h"
 #include "defstd.h"
 #include "plugin.h"
 #include "gc.h"
 #include "icf.h"
+#include "call-graph.h"
 #include "incremental.h"
 #include "timer.h"
 
@@ -134,6 +136,122 @@ Middle_runner::run(Workqueue* workqueue, const Task* task)
 		     this->layout_, workqueue, this->mapfile_);
 }
 
+// This class arranges to run the rest of the middle functions after
+// identical code folding.
+
+class Middle_layout_runner : public Task_function_runner
+{
+ public:
+  Middle_layout_runner(const General_options& options,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Middle_layout_runner::run(Workqueue* workqueue, const Task* task)
+{
+  queue_middle_layout_tasks(this->options_, task, this->input_objects_,
+			    this->symtab_, this->layout_, workqueue,
+			    this->mapfile_);
+}
+
+// This class merges the strings of the mergeable string sections and
+// scans the debug info for the .gdb_index section, and then queues
+// the layout task.  Each object's input sections are handled by a
+// separate task, so the objects are processed in parallel.
+
+class Merge_strings_runner : public Task_function_runner
+{
+ public:
+  Merge_strings_runner(const General_options& options,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Target* target,
+		       Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      target_(target), layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Target* target_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Merge_strings_runner::run(Workqueue* workqueue, const Task*)
+{
+  std::vector<Output_merge_base*> merge_sections;
+  this->layout_->get_merge_string_sections(&merge_sections);
+
+  Task_token* merge_blocker = new Task_token(true);
+  Output_merge_base::queue_merge_tasks(merge_sections, workqueue,
+				       merge_blocker);
+  this->layout_->queue_gdb_index_tasks(workqueue, merge_blocker);
+
+  workqueue->queue(new Task_function(new Layout_task_runner(this->options_,
+							    this->input_objects_,
+							    this->symtab_,
+							    this->target_,
+							    this->layout_,
+							    this->mapfile_),
+				     merge_blocker,
+				     "Task_function Layout_task_runner"));
+}
+
+// This class arranges to run the rest of the middle functions after
+// garbage collection.
+
+class Middle_icf_runner : public Task_function_runner
+{
+ public:
+  Middle_icf_runner(const General_options& options,
+		    const Input_objects* input_objects,
+		    Symbol_table* symtab,
+		    Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Middle_icf_runner::run(Workqueue* workqueue, const Task* task)
+{
+  queue_middle_icf_tasks(this->options_, task, this->input_objects_,
+			 this->symtab_, this->layout_, workqueue,
+			 this->mapfile_);
+}
+
 // This class arranges the tasks to process the relocs for garbage collection.
 
 class Gc_runner : public Task_function_runner
@@ -443,6 +561,9 @@ queue_middle_gc_tasks(const General_options& options,
 		      Workqueue* workqueue,
 		      Mapfile* mapfile)
 {
+  // All the symbols have been read; make sure they have been added.
+  symtab->add_pending_symbols();
+
   // Read_relocs for all the objects must be done and processed to find
   // unused sections before any scanning of the relocs can take place.
   Task_token* this_blocker = NULL;
@@ -492,6 +613,9 @@ queue_middle_tasks(const General_options& options,
   if (timer != NULL)
     timer->stamp(0);
 
+  // All the symbols have been read; make sure they have been added.
+  symtab->add_pending_symbols();
+
   // We have to support the case of not seeing any input objects, and
   // generate an empty file.  Existing builds depend on being able to
   // pass an empty archive to the linker and get an empty object file
@@ -521,18 +645,85 @@ queue_middle_tasks(const General_options& options,
       // Symbols named with -u should not be considered garbage.
       symtab->gc_mark_undef_symbols(layout);
       gold_assert(symtab->gc() != NULL);
-      // Do a transitive closure on all references to determine the worklist.
-      symtab->gc()->do_transitive_closure();
+
+      // Do a transitive closure on all references to determine the
+      // referenced sections.  This is done by separate tasks, so the
+      // rest of the middle tasks are queued when it is done.
+      // Every idle mark task looks for work in every other one, so
+      // there is no point in having very many.
+      int mark_task_count = 1;
+      if (options.threads())
+	{
+	  mark_task_count = options.thread_count_middle();
+	  if (mark_task_count == 0)
+	    mark_task_count = std::min(input_objects->number_of_relobjs(), 16);
+	}
+      Task_token* gc_blocker = new Task_token(true);
+      symtab->gc()->do_transitive_closure(workqueue, gc_blocker,
+					  mark_task_count);
+      workqueue->queue(new Task_function(new Middle_icf_runner(options,
+							       input_objects,
+							       symtab,
+							       layout,
+							       mapfile),
+					 gc_blocker,
+					 "Task_function Middle_icf_runner"));
+      return;
     }
 
+  queue_middle_icf_tasks(options, task, input_objects, symtab, layout,
+			 workqueue, mapfile);
+}
+
+// Queue up the middle tasks which run after garbage collection, if
+// any.
+
+void
+queue_middle_icf_tasks(const General_options& options,
+		       const Task* task,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout,
+		       Workqueue* workqueue,
+		       Mapfile* mapfile)
+{
   // If identical code folding (--icf) is chosen it makes sense to do it
   // only after garbage collection (--gc-sections) as we do not want to
-  // be folding sections that will be garbage.
+  // be folding sections that will be garbage.  The sections are hashed
+  // by separate tasks, so the rest of the middle tasks are queued when
+  // ICF is done.
   if (parameters->options().icf_enabled())
     {
-      symtab->icf()->find_identical_sections(input_objects, symtab);
+      Task_token* icf_blocker = new Task_token(true);
+      icf_blocker->add_blocker();
+      symtab->icf()->find_identical_sections(input_objects, symtab,
+					     workqueue, icf_blocker);
+      workqueue->queue(new Task_function(new Middle_layout_runner(options,
+								  input_objects,
+								  symtab,
+								  layout,
+								  mapfile),
+					 icf_blocker,
+					 "Task_function Middle_layout_runner"));
+      return;
     }
 
+  queue_middle_layout_tasks(options, task, input_objects, symtab, layout,
+			    workqueue, mapfile);
+}
+
+// Queue up the rest of the middle set of tasks.  These run after
+// identical code folding, if any.
+
+void
+queue_middle_layout_tasks(const General_options& options,
+			  const Task* task,
+			  const Input_objects* input_objects,
+			  Symbol_table* symtab,
+			  Layout* layout,
+			  Workqueue* workqueue,
+			  Mapfile* mapfile)
+{
   // Call Object::layout for the second time to determine the
   // output_sections for all referenced input sections.  When
   // --gc-sections or --icf is turned on, or when certain input
@@ -549,6 +740,11 @@ queue_middle_tasks(const General_options& options,
 	{
 	  Task_lock_obj<Object> tlo(task, *p);
 	  (*p)->layout(symtab, layout, NULL);
+	  // With --no-keep-memory, the copy of the symbols data is no
+	  // longer needed.  section_entsize requires it, so nothing
+	  // after this point may call it.
+	  if (parameters->options().no_keep_memory())
+	    (*p)->free_symbols_data();
 	}
     }
 
@@ -577,6 +773,18 @@ queue_middle_tasks(const General_options& options,
 	(*p)->update_section_layout(layout->get_section_order_map());
     }
 
+  // Order the sections by the call graph profile, unless they have
+  // already been ordered by --section-ordering-file or a plugin.
+  if ((parameters->options().call_graph_ordering_file() != NULL
+       || parameters->options().call_graph_profile_sort())
+      && !parameters->options().relocatable()
+      && !parameters->options().section_ordering_file()
+      && layout->get_section_order_map()->empty())
+    {
+      Call_graph call_graph;
+      call_graph.order_sections(task, input_objects, symtab, layout);
+    }
+
   if (parameters->options().gc_sections()
       || parameters->options().icf_enabled())
     {
@@ -777,16 +985,17 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
-  // When all those tasks are complete, we can start laying out the
-  // output file.
-  workqueue->queue(new Task_function(new Layout_task_runner(options,
-							    input_objects,
-							    symtab,
-							    target,
-							    layout,
-							    mapfile),
+  // When all those tasks are complete, we can merge the strings of
+  // the mergeable string sections and scan the debug info for
+  // .gdb_index, and then start laying out the output file.
+  workqueue->queue(new Task_function(new Merge_strings_runner(options,
+							      input_objects,
+							      symtab,
+							      target,
+							      layout,
+							      mapfile),
 				     this_blocker,
-				     "Task_function Layout_task_runner"));
+				     "Task_function Merge_strings_runner"));
 }
 
 // Queue up the final set of tasks.  This is called at the end of
@@ -885,8 +1094,10 @@ queue_final_tasks(const General_options& options,
       final_blocker = new_final_blocker;
     }
 
-  // Create tasks for tree-style build ID computation, if necessary.
-  if (strcmp(options.build_id(), "tree") == 0)
+  // Create tasks for tree-style or fast build ID computation, if
+  // necessary.
+  if (strcmp(options.build_id(), "tree") == 0
+      || strcmp(options.build_id(), "fast") == 0)
     {
       // Queue a task to compute the build id.  This will be blocked by
       // FINAL_BLOCKER, and will in turn schedule the task to close
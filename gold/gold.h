@@ -236,6 +236,28 @@ queue_middle_tasks(const General_options&,
 		   Workqueue*,
 		   Mapfile*);
 
+// Queue up the middle tasks which run once garbage collection, if any,
+// is done.
+extern void
+queue_middle_icf_tasks(const General_options&,
+		       const Task*,
+		       const Input_objects*,
+		       Symbol_table*,
+		       Layout*,
+		       Workqueue*,
+		       Mapfile*);
+
+// Queue up the rest of the middle set of tasks, once identical code
+// folding, if any, is done.
+extern void
+queue_middle_layout_tasks(const General_options&,
+			  const Task*,
+			  const Input_objects*,
+			  Symbol_table*,
+			  Layout*,
+			  Workqueue*,
+			  Mapfile*);
+
 // Queue up the final set of tasks.
 extern void
 queue_final_tasks(const General_options&,
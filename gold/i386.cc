@@ -489,6 +489,12 @@ class Target_i386 : public Sized_target<32, false>
   do_plt_address_for_local(const Relobj* relobj, unsigned int symndx) const
   { return this->plt_section()->address_for_local(relobj, symndx); }
 
+  // Relocating a section only reads the target state, so the sections
+  // of a large object may be relocated by several threads.
+  bool
+  do_relocate_sections_in_parallel() const
+  { return true; }
+
   // We can tell whether we take the address of a function.
   inline bool
   do_can_check_for_function_pointers() const
@@ -1015,6 +1021,14 @@ Target_i386::rel_dyn_section(Layout* layout)
       layout->add_output_section_data(".rel.dyn", elfcpp::SHT_REL,
 				      elfcpp::SHF_ALLOC, this->rel_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<elfcpp::SHT_REL, 32, false>* relr =
+	    new Output_data_relr<elfcpp::SHT_REL, 32, false>(
+		elfcpp::R_386_RELATIVE, layout, this->rel_dyn_);
+	  this->rel_dyn_->set_relr_section(relr);
+	}
     }
   return this->rel_dyn_;
 }
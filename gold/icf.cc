@@ -23,15 +23,23 @@
 // Identical Code Folding Algorithm
 // ----------------------------------
 // Detecting identical functions is done here and the basic algorithm
-// is as follows.  A checksum is computed on each foldable section using
+// is as follows.  A digest is computed on each foldable section using
 // its contents and relocations.  If the symbol name corresponding to
-// a relocation is known it is used to compute the checksum.  If the
+// a relocation is known it is used to compute the digest.  If the
 // symbol name is not known the stringified name of the object and the
-// section number pointed to by the relocation is used.  The checksums
+// section number pointed to by the relocation is used.  The digests
 // are stored as keys in a hash map and a section is identical to some
-// other section if its checksum is already present in the hash map.
-// Checksum collisions are handled by using a multimap and explicitly
-// checking the contents when two sections have the same checksum.
+// other section if its digest is already present in the hash map.
+// Digest collisions are handled by using a multimap and explicitly
+// checking the contents when two sections have the same digest.
+//
+// Everything in the digest except the identity of the foldable
+// sections that the relocations refer to is fixed, so it is computed
+// only once, in parallel, by an Icf_hash_task for each object.  The
+// iterations below then only combine that fixed digest with the
+// current kept section of each foldable section that is referred to,
+// which is cheap and is done serially so that the groups formed do
+// not depend on the number of threads.
 //
 // However, two functions A and B with identical text but with
 // relocations pointing to different foldable sections can be identical if
@@ -83,15 +91,25 @@
 // mentioned above.  It can detect all cases that Algorithm I can and more.
 // However, the caveat is that it has to be run to convergence.  It cannot
 // be stopped arbitrarily like Algorithm I as correctness cannot be
-// guaranteed.  Algorithm II is not implemented.
+// guaranteed.
+//
+// Algorithm I is used by default because experiments show that about
+// three iterations are more than enough to achieve convergence.
+// Algorithm I can handle recursive calls if it is changed to use a
+// special common symbol for recursive relocs.  This seems to be the most
+// common case that Algorithm I could not catch as is.  Mutually
+// recursive calls are not frequent and Algorithm I wins because of its
+// ability to be stopped arbitrarily.
 //
-// Algorithm I is used because experiments show that about three
-// iterations are more than enough to achieve convergence. Algorithm I can
-// handle recursive calls if it is changed to use a special common symbol
-// for recursive relocs.  This seems to be the most common case that
-// Algorithm I could not catch as is.  Mutually recursive calls are not
-// frequent and Algorithm I wins because of its ability to be stopped
-// arbitrarily.
+// Algorithm II is used with --icf-algorithm=partition.  The sections
+// start out in classes of sections with the same digest, ignoring which
+// foldable sections their relocations refer to.  A class is split when
+// its sections have relocations referring to sections in different
+// classes, using Hopcroft's partition refinement algorithm: each time a
+// class is split, only the smaller parts need to be used to split other
+// classes.  Each section is thus looked at O(log n) times, rather than
+// once per iteration, and the result is the coarsest stable partition,
+// which is reached without a fixed limit on the number of iterations.
 //
 // Caveat with using function pointers :
 // ------------------------------------
@@ -154,6 +172,7 @@
 //
 // How to run  : --icf=[safe|all|none]
 // Optional parameters : --icf-iterations <num> --print-icf-sections
+//                       --icf-algorithm=[iterative|partition]
 //
 // Performance : Less than 20 % link-time overhead on industry strength
 // applications.  Up to 6 %  text size reductions.
@@ -167,7 +186,10 @@
 #include "demangle.h"
 #include "elfcpp.h"
 #include "int_encoding.h"
+#include "md5.h"
+#include "workqueue.h"
 
+#include <algorithm>
 #include <limits>
 
 namespace gold
@@ -177,52 +199,30 @@ namespace gold
 // sections has unique contents.  Such unique sections or groups can be
 // declared final and need not be processed any further.
 // Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
+// SECTION_DIGESTS : The digest of each section.  Before the first
+//                   iteration of icf this is the digest of the raw
+//                   section contents; after, it is the digest of the
+//                   section's text and relocs to sections that cannot
+//                   be folded.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
 
 static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
+preprocess_for_unique_sections(
+    const std::vector<Icf::Section_digest>& section_digests,
+    std::vector<bool>* is_secn_or_group_unique)
 {
-  Unordered_map<uint32_t, unsigned int> uniq_map;
-  std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
-    uniq_map_insert;
+  typedef Unordered_map<Icf::Section_digest, unsigned int,
+			Icf::Section_digest_hash> Uniq_map;
+  Uniq_map uniq_map;
+  std::pair<Uniq_map::iterator, bool> uniq_map_insert;
 
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < section_digests.size(); i++)
     {
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
-      uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
+      uniq_map_insert = uniq_map.insert(std::make_pair(section_digests[i], i));
       if (uniq_map_insert.second)
         {
           (*is_secn_or_group_unique)[i] = true;
@@ -274,51 +274,53 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
     }
 }
 
-// This returns the buffer containing the section's contents, both
-// text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
-// subsequent invocations of this function.
+// This appends to CONTENTS the section's contents, both text and
+// relocs.  Relocs are differentiated as those pointing to sections
+// that could be folded and those that cannot.  For relocs pointing to
+// sections that could be folded, only the addend is appended to
+// CONTENTS; the id of the section pointed to is appended to
+// TRACKED_SECTION_IDS, as the section it is folded into can change
+// from iteration to iteration.
 // Parameters  :
-// FIRST_ITERATION    : true if it is the first invocation.
-// FIXED_CACHE        : String that stores the portion of the result that
-//                      does not change from iteration to iteration;
-//                      written if first_iteration is true, read if it's false.
 // SECN               : Section for which contents are desired.
 // SELF_SECN          : Relocations that target this section will be
 //                      considered "relocations to self" so that recursive
 //                      functions can be folded. Should normally be the
 //                      same as `secn` except when processing extra identity
 //                      regions.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
+// CAN_READ_OTHER_OBJECTS : Whether the contents of sections in objects
+//                      other than the one containing SELF_SECN may be
+//                      read.  If this is false and such contents are
+//                      needed, this returns false.
+// CONTENTS           : String to which the contents are appended.
+// TRACKED_SECTION_IDS : Vector to which the ids of the sections that
+//                      could be folded are appended.
 // START_OFFSET       : Only consider the part of the section at and after
 //                      this offset.
 // END_OFFSET         : Only consider the part of the section before this
 //                      offset.
 
-static std::string
-get_section_contents(bool first_iteration,
-		     std::string* fixed_cache,
-                     const Section_id& secn,
+static bool
+get_section_contents(const Section_id& secn,
 		     const Section_id& self_secn,
-                     unsigned int* num_tracked_relocs,
                      Symbol_table* symtab,
-                     const std::vector<unsigned int>& kept_section_id,
+		     bool can_read_other_objects,
+		     std::string* contents_buffer,
+		     std::vector<unsigned int>* tracked_section_ids,
 		     section_offset_type start_offset = 0,
 		     section_offset_type end_offset =
 		       std::numeric_limits<section_offset_type>::max())
 {
+  if (!can_read_other_objects && secn.first != self_secn.first)
+    return false;
+
   section_size_type plen;
-  const unsigned char* contents = NULL;
-  if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
+  const unsigned char* contents;
+  contents = secn.first->section_contents(secn.second, &plen, false);
 
-  // The buffer to hold all the contents including relocs.  A checksum
+  // The buffer to hold all the contents including relocs.  A digest
   // is then computed on this buffer.
-  std::string buffer;
-  std::string icf_reloc_buffer;
+  std::string& buffer(*contents_buffer);
 
   Icf::Reloc_info_list& reloc_info_list = 
     symtab->icf()->reloc_info_list();
@@ -326,9 +328,6 @@ get_section_contents(bool first_iteration,
   Icf::Reloc_info_list::iterator it_reloc_info_list =
     reloc_info_list.find(secn);
 
-  buffer.clear();
-  icf_reloc_buffer.clear();
-
   // Process relocs and put them into the buffer.
 
   if (it_reloc_info_list != reloc_info_list.end())
@@ -367,8 +366,7 @@ get_section_contents(bool first_iteration,
 	      gsym = NULL;
 	    }
 
-	  if (first_iteration
-	      && it_v->first != NULL)
+	  if (it_v->first != NULL)
 	    {
 	      Symbol_location loc;
 	      loc.object = it_v->first;
@@ -404,15 +402,12 @@ get_section_contents(bool first_iteration,
 	  // object is NULL.
 	  if (it_v->first == NULL)
             {
-	      if (first_iteration)
-                {
-		  // If the symbol name is available, use it.
-                  if (gsym != NULL)
-                      buffer.append(gsym->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
-		}
+	      // If the symbol name is available, use it.
+	      if (gsym != NULL)
+		buffer.append(gsym->name());
+	      // Append the addend.
+	      buffer.append(addend_str);
+	      buffer.append("@");
 	      continue;
 	    }
 
@@ -423,12 +418,9 @@ get_section_contents(bool first_iteration,
           if (reloc_secn.first == self_secn.first
               && reloc_secn.second == self_secn.second)
             {
-              if (first_iteration)
-                {
-                  buffer.append("R");
-                  buffer.append(addend_str);
-                  buffer.append("@");
-                }
+              buffer.append("R");
+              buffer.append(addend_str);
+              buffer.append("@");
               continue;
             }
           Icf::Uniq_secn_id_map& section_id_map =
@@ -443,30 +435,15 @@ get_section_contents(bool first_iteration,
               && section_id_map_it != section_id_map.end())
             {
               // This is a reloc to a section that might be folded.
-              if (num_tracked_relocs)
-                (*num_tracked_relocs)++;
-
-              char kept_section_str[10];
-              unsigned int secn_id = section_id_map_it->second;
-              snprintf(kept_section_str, sizeof(kept_section_str), "%u",
-                       kept_section_id[secn_id]);
-              if (first_iteration)
-                {
-                  buffer.append("ICF_R");
-                  buffer.append(addend_str);
-                }
-              icf_reloc_buffer.append(kept_section_str);
-              // Append the addend.
-              icf_reloc_buffer.append(addend_str);
-              icf_reloc_buffer.append("@");
+              // The section it is folded into is added to the
+              // digest in each iteration.
+              buffer.append("ICF_R");
+              buffer.append(addend_str);
+              tracked_section_ids->push_back(section_id_map_it->second);
             }
           else
             {
               // This is a reloc to a section that cannot be folded.
-              // Process it only in the first iteration.
-              if (!first_iteration)
-                continue;
-
               uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
               // This reloc points to a merge section.  Hash the
               // contents of this section.
@@ -512,6 +489,12 @@ get_section_contents(bool first_iteration,
 			offset = offset + reloc_addend_value;
 		    }
 
+                  // Reading the contents of another object requires
+                  // locking it.
+                  if (!can_read_other_objects
+                      && it_v->first != self_secn.first)
+                    return false;
+
                   section_size_type secn_len;
 
                   const unsigned char* str_contents =
@@ -595,18 +578,15 @@ get_section_contents(bool first_iteration,
         }
     }
 
-  if (first_iteration)
-    {
-      buffer.append("Contents = ");
+  buffer.append("Contents = ");
 
-      const unsigned char* slice_end =
-	contents + std::min<section_offset_type>(plen, end_offset);
+  const unsigned char* slice_end =
+    contents + std::min<section_offset_type>(plen, end_offset);
 
-      if (contents + start_offset < slice_end)
-	{
-	  buffer.append(reinterpret_cast<const char*>(contents + start_offset),
-			slice_end - (contents + start_offset));
-	}
+  if (contents + start_offset < slice_end)
+    {
+      buffer.append(reinterpret_cast<const char*>(contents + start_offset),
+		    slice_end - (contents + start_offset));
     }
 
   // Add any extra identity regions.
@@ -616,188 +596,236 @@ get_section_contents(bool first_iteration,
   for (Icf::Extra_identity_list::const_iterator it_ext = extra_range.first;
        it_ext != extra_range.second; ++it_ext)
     {
-      std::string external_fixed;
-      std::string external_all =
-	get_section_contents(first_iteration, &external_fixed,
-			     it_ext->second.section, self_secn,
-			     num_tracked_relocs, symtab,
-			     kept_section_id, it_ext->second.offset,
-			     it_ext->second.offset + it_ext->second.length);
-      buffer.append(external_fixed);
-      icf_reloc_buffer.append(external_all, external_fixed.length(),
-			      std::string::npos);
+      if (!get_section_contents(it_ext->second.section, self_secn, symtab,
+				can_read_other_objects, contents_buffer,
+				tracked_section_ids, it_ext->second.offset,
+				(it_ext->second.offset
+				 + it_ext->second.length)))
+	return false;
     }
 
-  if (first_iteration)
+  return true;
+}
+
+// Compute in *DIGEST the digest of a section for this iteration, from
+// FIXED_DIGEST, the digest of its contents and relocs to sections that
+// cannot be folded, and from the sections that the sections in
+// TRACKED_SECTION_IDS are currently folded into.
+
+static void
+get_section_digest(const Icf::Section_digest& fixed_digest,
+		   const std::vector<unsigned int>& tracked_section_ids,
+		   const std::vector<unsigned int>& kept_section_id,
+		   Icf::Section_digest* digest)
+{
+  struct md5_ctx ctx;
+  md5_init_ctx(&ctx);
+  md5_process_bytes(fixed_digest.bytes, sizeof fixed_digest.bytes, &ctx);
+  for (std::vector<unsigned int>::const_iterator p =
+	 tracked_section_ids.begin();
+       p != tracked_section_ids.end();
+       ++p)
     {
-      // Store the section contents that don't change to avoid recomputing
-      // during the next call to this function.
-      *fixed_cache = buffer;
+      unsigned int kept = kept_section_id[*p];
+      md5_process_bytes(&kept, sizeof kept, &ctx);
     }
-  else
-    {
-      gold_assert(buffer.empty());
+  md5_finish_ctx(&ctx, digest->bytes);
+}
 
-      // Reuse the contents computed in the previous iteration.
-      buffer.append(*fixed_cache);
-    }
+// Two sections with different contents can have the same digest, so
+// sections are only put in the same group after their contents have
+// been compared.  A Section_contents_checker does that, and keeps the
+// contents of the sections compared against, which are the kept
+// sections of the groups, so that they are only read once.
+
+class Section_contents_checker
+{
+ public:
+  Section_contents_checker(Symbol_table* symtab,
+			   const std::vector<Section_id>& id_section)
+    : symtab_(symtab), id_section_(id_section), kept_contents_()
+  { }
+
+  // Return whether the text and relocs to sections that cannot be
+  // folded of section SECTION_NUM are the same as those of section
+  // KEPT_SECTION.
+  bool
+  same_contents(unsigned int section_num, unsigned int kept_section);
+
+ private:
+  typedef Unordered_map<unsigned int, std::string> Contents_map;
+
+  // Store in *CONTENTS the contents of section SECTION_NUM.
+  void
+  get_contents(unsigned int section_num, std::string* contents);
+
+  Symbol_table* symtab_;
+  const std::vector<Section_id>& id_section_;
+  // The contents of the sections compared against.
+  Contents_map kept_contents_;
+};
 
-  buffer.append(icf_reloc_buffer);
-  return buffer;
+bool
+Section_contents_checker::same_contents(unsigned int section_num,
+					unsigned int kept_section)
+{
+  std::pair<Contents_map::iterator, bool> ins =
+    this->kept_contents_.insert(std::make_pair(kept_section, std::string()));
+  if (ins.second)
+    this->get_contents(kept_section, &ins.first->second);
+
+  std::string contents;
+  this->get_contents(section_num, &contents);
+  return contents == ins.first->second;
 }
 
-// This function computes a checksum on each section to detect and form
-// groups of identical sections.  The first iteration does this for all 
+void
+Section_contents_checker::get_contents(unsigned int section_num,
+				       std::string* contents)
+{
+  const Section_id& secn(this->id_section_[section_num]);
+
+  // Lock the object so we can read from it.  This is only called
+  // single-threaded from an Icf_match_task, so it is OK to lock.
+  // Unfortunately we have no way to pass in a Task token.
+  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+  Task_lock_obj<Object> tl(dummy_task, secn.first);
+  std::vector<unsigned int> tracked_section_ids;
+  bool got = get_section_contents(secn, secn, this->symtab_, true, contents,
+				  &tracked_section_ids);
+  gold_assert(got);
+}
+
+// Return whether the relocs to foldable sections of sections I and J
+// refer to sections which are folded into the same sections.
+
+static bool
+same_tracked_sections(unsigned int i, unsigned int j,
+		      const std::vector<unsigned int>& kept_section_id,
+		      const std::vector<std::vector<unsigned int> >&
+			tracked_section_ids)
+{
+  const std::vector<unsigned int>& ti(tracked_section_ids[i]);
+  const std::vector<unsigned int>& tj(tracked_section_ids[j]);
+  if (ti.size() != tj.size())
+    return false;
+  for (unsigned int k = 0; k < ti.size(); ++k)
+    if (kept_section_id[ti[k]] != kept_section_id[tj[k]])
+      return false;
+  return true;
+}
+
+// This function computes a digest on each section to detect and form
+// groups of identical sections.  The first iteration does this for all
 // sections.
 // Further iterations do this only for the kept sections from each group to
 // determine if larger groups of identical sections could be formed.  The
 // first section in each group is the kept section for that group.
 //
-// CRC32 is the checksumming algorithm and can have collisions.  That is,
-// two sections with different contents can have the same checksum. Hence,
-// a multimap is used to maintain more than one group of checksum
-// identical sections.  A section is added to a group only after its
-// contents are explicitly compared with the kept section of the group.
+// Sections are visited in order and the section each relocation refers
+// to is looked up when the section is visited, so sections folded
+// earlier in an iteration are taken into account by later sections in
+// the same iteration.
+//
+// As two sections with different contents can have the same digest, a
+// multimap is used to maintain more than one group of sections with
+// the same digest.  A section is added to a group only after its
+// contents and the sections its relocs refer to are explicitly
+// compared with those of the kept section of the group.
 //
 // Parameters  :
 // ITERATION_NUM           : Invocation instance of this function.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
 // KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// ID_SECTION         : Vector mapping a section to an unique integer.
+// SECTION_ADDRALIGNS : The alignment of each section.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
+// SECTION_DIGESTS    : The digest of each section's text and relocs to
+//                      non-ICF sections.
+// TRACKED_SECTION_IDS : The ICF sections each section's relocs refer to.
+// CHECKER            : Used to compare the contents of sections.
 
 static bool
 match_sections(unsigned int iteration_num,
-               Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
                std::vector<unsigned int>* kept_section_id,
-               const std::vector<Section_id>& id_section,
 	       const std::vector<uint64_t>& section_addraligns,
                std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+	       const std::vector<Icf::Section_digest>& section_digests,
+	       const std::vector<std::vector<unsigned int> >&
+		 tracked_section_ids,
+	       Section_contents_checker* checker)
 {
-  Unordered_multimap<uint32_t, unsigned int> section_cksum;
-  std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
-            Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
+  typedef Unordered_multimap<Icf::Section_digest, unsigned int,
+			     Icf::Section_digest_hash> Section_group_map;
+  Section_group_map section_groups;
+  std::pair<Section_group_map::iterator,
+	    Section_group_map::iterator> key_range;
   bool converged = true;
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
+  // The unique sections before the first iteration have been found by
+  // the Icf_hash_tasks.
+  if (iteration_num > 1)
+    preprocess_for_unique_sections(section_digests, is_secn_or_group_unique);
 
-  std::vector<std::string> full_section_contents;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < section_digests.size(); i++)
     {
-      full_section_contents.push_back("");
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      Section_id secn = id_section[i];
-
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from queue_middle_tasks, so it is OK to lock.
-      // Unfortunately we have no way to pass in a Task token.
-      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-      Task_lock_obj<Object> tl(dummy_task, secn.first);
-
-      std::string this_secn_contents;
-      uint32_t cksum;
-      std::string* this_secn_cache = &((*section_contents)[i]);
-      if (iteration_num == 1)
+      if (iteration_num > 1 && (*kept_section_id)[i] != i)
         {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, this_secn_cache,
-						    secn, secn, &num_relocs,
-						    symtab, (*kept_section_id));
-          (*num_tracked_relocs)[i] = num_relocs;
-        }
-      else
-        {
-          if ((*kept_section_id)[i] != i)
-            {
-              // This section is already folded into something.
-              continue;
-            }
-          this_secn_contents = get_section_contents(false, this_secn_cache,
-						    secn, secn, NULL,
-						    symtab, (*kept_section_id));
+          // This section is already folded into something.
+          continue;
         }
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
-      size_t count = section_cksum.count(cksum);
+      Icf::Section_digest digest;
+      get_section_digest(section_digests[i], tracked_section_ids[i],
+			 *kept_section_id, &digest);
 
-      if (count == 0)
+      key_range = section_groups.equal_range(digest);
+      Section_group_map::iterator it;
+      // Search all the groups with this digest for a match.
+      for (it = key_range.first; it != key_range.second; ++it)
         {
-          // Start a group with this cksum.
-          section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
+          unsigned int kept_section = it->second;
+          if (!(section_digests[i] == section_digests[kept_section])
+              || !same_tracked_sections(i, kept_section, *kept_section_id,
+                                        tracked_section_ids)
+              || !checker->same_contents(i, kept_section))
+            continue;
+
+	  // Check section alignment here.
+	  // The section with the larger alignment requirement
+	  // should be kept.  We assume alignment can only be 
+	  // zero or positive integral powers of two.
+	  uint64_t align_i = section_addraligns[i];
+	  uint64_t align_kept = section_addraligns[kept_section];
+	  if (align_i <= align_kept)
+	    {
+	      (*kept_section_id)[i] = kept_section;
+	    }
+	  else
+	    {
+	      (*kept_section_id)[kept_section] = i;
+	      it->second = i;
+	    }
+
+          converged = false;
+          break;
         }
-      else
+      if (it == key_range.second)
         {
-          key_range = section_cksum.equal_range(cksum);
-          Unordered_multimap<uint32_t, unsigned int>::iterator it;
-          // Search all the groups with this cksum for a match.
-          for (it = key_range.first; it != key_range.second; ++it)
-            {
-              unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
-                  continue;
-
-	      // Check section alignment here.
-	      // The section with the larger alignment requirement
-	      // should be kept.  We assume alignment can only be 
-	      // zero or positive integral powers of two.
-	      uint64_t align_i = section_addraligns[i];
-	      uint64_t align_kept = section_addraligns[kept_section];
-	      if (align_i <= align_kept)
-		{
-		  (*kept_section_id)[i] = kept_section;
-		}
-	      else
-		{
-		  (*kept_section_id)[kept_section] = i;
-		  it->second = i;
-		  full_section_contents[kept_section].swap(
-		      full_section_contents[i]);
-		}
-
-              converged = false;
-              break;
-            }
-          if (it == key_range.second)
-            {
-              // Create a new group for this cksum.
-              section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
-            }
+          // Create a new group for this digest.
+          section_groups.insert(std::make_pair(digest, i));
         }
       // If there are no relocs to foldable sections do not process
       // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
+      if (iteration_num == 1 && tracked_section_ids[i].empty())
         (*is_secn_or_group_unique)[i] = true;
     }
 
   // If a section was folded into another section that was later folded
   // again then the former has to be updated.
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < section_digests.size(); i++)
     {
       // Find the end of the folding chain
       unsigned int kept = i;
@@ -818,6 +846,411 @@ match_sections(unsigned int iteration_num,
   return converged;
 }
 
+// A partition of the candidate sections into classes of sections
+// which may be identical, used by --icf-algorithm=partition.  The
+// sections of each class are kept together in ELEMENTS_, so that a
+// class can be split in time proportional to the number of its
+// sections that move to new classes.
+
+class Section_partition
+{
+ public:
+  Section_partition(const std::vector<bool>& is_secn_or_group_unique,
+		    const std::vector<Icf::Section_digest>& section_digests,
+		    const std::vector<std::vector<unsigned int> >&
+		      tracked_section_ids,
+		    Section_contents_checker* checker);
+
+  // Split classes until every section in a class has relocations
+  // referring to the same classes as the other sections in its class.
+  // Returns the number of classes used to split other classes.
+  unsigned int
+  refine();
+
+  // The class of section SECTION_NUM.
+  unsigned int
+  class_of(unsigned int section_num) const
+  { return this->class_of_[section_num]; }
+
+  // The number of classes.
+  unsigned int
+  class_count() const
+  { return this->first_.size(); }
+
+ private:
+  // A relocation from section SOURCE, the LABEL'th relocation in that
+  // section to a foldable section.
+  struct Edge
+  {
+    Edge(unsigned int s, unsigned int l)
+      : source(s), label(l)
+    { }
+
+    bool
+    operator<(const Edge& e) const
+    {
+      if (this->source != e.source)
+	return this->source < e.source;
+      return this->label < e.label;
+    }
+
+    unsigned int source;
+    unsigned int label;
+  };
+
+  // A section with relocations referring to the class being used to
+  // split the other classes.  Its relocations are the entries
+  // [FIRST, LAST) of the sorted vector of Edges.
+  struct Touched_section
+  {
+    unsigned int cls;
+    unsigned int section;
+    unsigned int first;
+    unsigned int last;
+  };
+
+  // Order Touched_sections by class, then by the labels of their
+  // relocations.
+  class Touched_section_less
+  {
+   public:
+    Touched_section_less(const std::vector<Edge>& edges)
+      : edges_(edges)
+    { }
+
+    bool
+    operator()(const Touched_section& a, const Touched_section& b) const
+    {
+      if (a.cls != b.cls)
+	return a.cls < b.cls;
+      int c = this->compare_labels(a, b);
+      if (c != 0)
+	return c < 0;
+      return a.section < b.section;
+    }
+
+    // Compare the labels of the relocations of A and B.
+    int
+    compare_labels(const Touched_section& a, const Touched_section& b) const
+    {
+      unsigned int i = a.first;
+      unsigned int j = b.first;
+      for (; i < a.last && j < b.last; ++i, ++j)
+	{
+	  if (this->edges_[i].label != this->edges_[j].label)
+	    return this->edges_[i].label < this->edges_[j].label ? -1 : 1;
+	}
+      if (i < a.last)
+	return 1;
+      if (j < b.last)
+	return -1;
+      return 0;
+    }
+
+   private:
+    const std::vector<Edge>& edges_;
+  };
+
+  // Create a new class for the sections in ELEMENTS_[FIRST, LAST).
+  unsigned int
+  add_class(unsigned int first, unsigned int last);
+
+  // Split classes using class SPLITTER.
+  void
+  split(unsigned int splitter);
+
+  // Split class CLS using the sections in TOUCHED[FIRST, LAST), which
+  // all belong to CLS.
+  void
+  split_class(unsigned int cls, const std::vector<Touched_section>& touched,
+	      unsigned int first, unsigned int last,
+	      const Touched_section_less& less);
+
+  // The sections, grouped by class.
+  std::vector<unsigned int> elements_;
+  // The index of each section in ELEMENTS_.
+  std::vector<unsigned int> location_;
+  // The class of each section.
+  std::vector<unsigned int> class_of_;
+  // The range of ELEMENTS_ holding the sections of each class.
+  std::vector<unsigned int> first_;
+  std::vector<unsigned int> last_;
+  // The classes still to be used to split other classes.
+  std::vector<unsigned int> worklist_;
+  std::vector<bool> in_worklist_;
+  // The relocations referring to each section, as the range
+  // [IN_FIRST_[i], IN_FIRST_[i + 1]) of IN_EDGES_.
+  std::vector<unsigned int> in_first_;
+  std::vector<Edge> in_edges_;
+  // Scratch space used by split.
+  std::vector<unsigned int> splitter_sections_;
+  std::vector<Edge> touched_edges_;
+  std::vector<Touched_section> touched_sections_;
+};
+
+// Start with a class for each distinct section contents.  Sections
+// with the same digest are compared with CHECKER, as their contents
+// may still differ.  Sections which are known to be unique, whose
+// digests only cover their raw contents, each get a class of their own.
+
+Section_partition::Section_partition(
+    const std::vector<bool>& is_secn_or_group_unique,
+    const std::vector<Icf::Section_digest>& section_digests,
+    const std::vector<std::vector<unsigned int> >& tracked_section_ids,
+    Section_contents_checker* checker)
+  : elements_(), location_(), class_of_(), first_(), last_(), worklist_(),
+    in_worklist_(), in_first_(), in_edges_(), splitter_sections_(),
+    touched_edges_(), touched_sections_()
+{
+  unsigned int count = section_digests.size();
+  typedef Unordered_multimap<Icf::Section_digest, unsigned int,
+			     Icf::Section_digest_hash> Class_map;
+  Class_map class_map;
+  std::vector<unsigned int> class_size;
+  // The first section of each class.
+  std::vector<unsigned int> class_first;
+  this->class_of_.resize(count);
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      unsigned int cls = class_size.size();
+      if (!is_secn_or_group_unique[i])
+	{
+	  std::pair<Class_map::iterator, Class_map::iterator> range =
+	    class_map.equal_range(section_digests[i]);
+	  for (Class_map::iterator p = range.first; p != range.second; ++p)
+	    {
+	      if (tracked_section_ids[i].size()
+		    == tracked_section_ids[class_first[p->second]].size()
+		  && checker->same_contents(i, class_first[p->second]))
+		{
+		  cls = p->second;
+		  break;
+		}
+	    }
+	  if (cls == class_size.size())
+	    class_map.insert(std::make_pair(section_digests[i], cls));
+	}
+      if (cls == class_size.size())
+	{
+	  class_size.push_back(0);
+	  class_first.push_back(i);
+	}
+      ++class_size[cls];
+      this->class_of_[i] = cls;
+    }
+
+  // Lay out the sections by class, and remember the largest class.
+  unsigned int largest = 0;
+  unsigned int first = 0;
+  for (unsigned int cls = 0; cls < class_size.size(); ++cls)
+    {
+      this->first_.push_back(first);
+      this->last_.push_back(first);
+      first += class_size[cls];
+      if (class_size[cls] > class_size[largest])
+	largest = cls;
+    }
+  this->elements_.resize(count);
+  this->location_.resize(count);
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      unsigned int loc = this->last_[this->class_of_[i]]++;
+      this->elements_[loc] = i;
+      this->location_[i] = loc;
+    }
+
+  // Record the relocations referring to each section.
+  this->in_first_.assign(count + 1, 0);
+  for (unsigned int i = 0; i < count; ++i)
+    for (std::vector<unsigned int>::const_iterator p =
+	   tracked_section_ids[i].begin();
+	 p != tracked_section_ids[i].end();
+	 ++p)
+      ++this->in_first_[*p + 1];
+  for (unsigned int i = 0; i < count; ++i)
+    this->in_first_[i + 1] += this->in_first_[i];
+  std::vector<unsigned int> fill(this->in_first_.begin(),
+				 this->in_first_.end() - 1);
+  this->in_edges_.resize(this->in_first_[count], Edge(0, 0));
+  for (unsigned int i = 0; i < count; ++i)
+    for (unsigned int j = 0; j < tracked_section_ids[i].size(); ++j)
+      this->in_edges_[fill[tracked_section_ids[i][j]]++] = Edge(i, j);
+
+  // The sections of each class have the same number of relocations to
+  // foldable sections, as that is part of the digest, so splitting
+  // with all the sections would not split anything.  Hence it is
+  // enough to split with all the classes but one.
+  this->in_worklist_.resize(class_size.size(), false);
+  for (unsigned int cls = 0; cls < class_size.size(); ++cls)
+    {
+      if (cls != largest)
+	{
+	  this->worklist_.push_back(cls);
+	  this->in_worklist_[cls] = true;
+	}
+    }
+}
+
+// Add a new class for ELEMENTS_[FIRST, LAST).
+
+unsigned int
+Section_partition::add_class(unsigned int first, unsigned int last)
+{
+  unsigned int cls = this->first_.size();
+  this->first_.push_back(first);
+  this->last_.push_back(last);
+  this->in_worklist_.push_back(false);
+  for (unsigned int i = first; i < last; ++i)
+    this->class_of_[this->elements_[i]] = cls;
+  return cls;
+}
+
+unsigned int
+Section_partition::refine()
+{
+  unsigned int rounds = 0;
+  while (!this->worklist_.empty())
+    {
+      unsigned int splitter = this->worklist_.back();
+      this->worklist_.pop_back();
+      this->in_worklist_[splitter] = false;
+      this->split(splitter);
+      ++rounds;
+    }
+  return rounds;
+}
+
+// Split every class whose sections do not agree on which of their
+// relocations refer to a section in class SPLITTER.
+
+void
+Section_partition::split(unsigned int splitter)
+{
+  // SPLITTER may itself be split below, so copy its sections first.
+  this->splitter_sections_.assign(
+      this->elements_.begin() + this->first_[splitter],
+      this->elements_.begin() + this->last_[splitter]);
+
+  std::vector<Edge>& edges(this->touched_edges_);
+  edges.clear();
+  for (std::vector<unsigned int>::const_iterator p =
+	 this->splitter_sections_.begin();
+       p != this->splitter_sections_.end();
+       ++p)
+    edges.insert(edges.end(),
+		 this->in_edges_.begin() + this->in_first_[*p],
+		 this->in_edges_.begin() + this->in_first_[*p + 1]);
+  if (edges.empty())
+    return;
+  std::sort(edges.begin(), edges.end());
+
+  std::vector<Touched_section>& touched(this->touched_sections_);
+  touched.clear();
+  for (unsigned int i = 0; i < edges.size(); )
+    {
+      Touched_section t;
+      t.section = edges[i].source;
+      t.cls = this->class_of_[t.section];
+      t.first = i;
+      while (i < edges.size() && edges[i].source == t.section)
+	++i;
+      t.last = i;
+      touched.push_back(t);
+    }
+
+  Touched_section_less less(edges);
+  std::sort(touched.begin(), touched.end(), less);
+
+  for (unsigned int i = 0; i < touched.size(); )
+    {
+      unsigned int first = i;
+      unsigned int cls = touched[i].cls;
+      while (i < touched.size() && touched[i].cls == cls)
+	++i;
+      this->split_class(cls, touched, first, i, less);
+    }
+}
+
+// Split class CLS.  The sections TOUCHED[FIRST, LAST) are the sections
+// of CLS with relocations referring to the splitter, sorted by which of
+// their relocations do.
+
+void
+Section_partition::split_class(unsigned int cls,
+			       const std::vector<Touched_section>& touched,
+			       unsigned int first, unsigned int last,
+			       const Touched_section_less& less)
+{
+  unsigned int cls_first = this->first_[cls];
+  unsigned int cls_last = this->last_[cls];
+  unsigned int untouched = (cls_last - cls_first) - (last - first);
+  if (untouched == 0
+      && less.compare_labels(touched[first], touched[last - 1]) == 0)
+    return;
+
+  // Move the touched sections to the end of the class, in order.
+  unsigned int loc = cls_last;
+  for (unsigned int i = first; i < last; ++i)
+    {
+      unsigned int section = touched[i].section;
+      --loc;
+      unsigned int other = this->elements_[loc];
+      unsigned int section_loc = this->location_[section];
+      this->elements_[section_loc] = other;
+      this->location_[other] = section_loc;
+      this->elements_[loc] = section;
+      this->location_[section] = loc;
+    }
+  loc = cls_last - (last - first);
+  for (unsigned int i = first; i < last; ++i, ++loc)
+    {
+      this->elements_[loc] = touched[i].section;
+      this->location_[touched[i].section] = loc;
+    }
+
+  // The untouched sections, if any, stay in CLS.  Otherwise the first
+  // group of touched sections does.  Each other group gets a new
+  // class.
+  bool was_in_worklist = this->in_worklist_[cls];
+  unsigned int largest = cls;
+  unsigned int start = cls_last - (last - first);
+  unsigned int i = first;
+  if (untouched == 0)
+    {
+      while (i < last && less.compare_labels(touched[first], touched[i]) == 0)
+	++i;
+      start += i - first;
+    }
+  this->last_[cls] = start;
+  while (i < last)
+    {
+      unsigned int group = i;
+      while (i < last && less.compare_labels(touched[group], touched[i]) == 0)
+	++i;
+      unsigned int new_cls = this->add_class(start, start + (i - group));
+      start += i - group;
+      if (was_in_worklist)
+	{
+	  this->worklist_.push_back(new_cls);
+	  this->in_worklist_[new_cls] = true;
+	}
+      else
+	{
+	  // Hopcroft's trick: the class is already accounted for as a
+	  // splitter, so all but the largest part will do.
+	  unsigned int add = new_cls;
+	  if (this->last_[new_cls] - this->first_[new_cls]
+	      > this->last_[largest] - this->first_[largest])
+	    {
+	      add = largest;
+	      largest = new_cls;
+	    }
+	  this->worklist_.push_back(add);
+	  this->in_worklist_[add] = true;
+	}
+    }
+}
+
 // During safe icf (--icf=safe), only fold functions that are ctors or dtors.
 // This function returns true if the section name is that of a ctor or a dtor.
 
@@ -943,19 +1376,119 @@ Icf::add_ehframe_links(Relobj* object, unsigned int ehframe_shndx,
   return true;
 }
 
-// This is the main ICF function called in gold.cc.  This does the
-// initialization and calls match_sections repeatedly (thrice by default)
-// which computes the crc checksums and detects identical functions.
+// An Icf_hash_task computes the digests of the candidate sections of
+// a single object.
+
+class Icf_hash_task : public Task
+{
+ public:
+  Icf_hash_task(Icf* icf, Symbol_table* symtab, Relobj* object,
+		unsigned int object_index, Task_token* hash_blocker)
+    : icf_(icf), symtab_(symtab), object_(object),
+      object_index_(object_index), hash_blocker_(hash_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return this->object_->is_locked() ? this->object_->token() : NULL; }
+
+  // Lock the object, and unblock HASH_BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->object_->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->hash_blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->icf_->hash_object_sections(this->symtab_, this->object_index_);
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Icf_hash_task " + this->object_->name(); }
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  Relobj* object_;
+  unsigned int object_index_;
+  Task_token* hash_blocker_;
+};
+
+// An Icf_match_task runs when all the Icf_hash_tasks of a round have
+// completed.  It either queues another round, or forms the groups of
+// identical sections and unblocks ICF_BLOCKER.
+
+class Icf_match_task : public Task
+{
+ public:
+  Icf_match_task(Icf* icf, Symbol_table* symtab, Task_token* hash_blocker,
+		 Task_token* icf_blocker)
+    : icf_(icf), symtab_(symtab), hash_blocker_(hash_blocker),
+      icf_blocker_(icf_blocker)
+  { }
+
+  ~Icf_match_task()
+  { delete this->hash_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->hash_blocker_->is_blocked())
+      return this->hash_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->icf_blocker_); }
+
+  void
+  run(Workqueue* workqueue)
+  {
+    if (this->icf_->match_hashed_sections(this->symtab_))
+      {
+	// We are releasing ICF_BLOCKER_ as this task completes, but
+	// the next round needs to keep it blocked.
+	workqueue->add_blocker(this->icf_blocker_);
+	this->icf_->queue_hash_tasks(this->symtab_, workqueue,
+				     this->icf_blocker_);
+      }
+  }
+
+  std::string
+  get_name() const
+  { return "Icf_match_task"; }
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  Task_token* hash_blocker_;
+  Task_token* icf_blocker_;
+};
+
+// This is the main ICF function called in gold.cc.  This decides
+// which sections are candidates for folding and queues the tasks which
+// compute their digests.  The last of those calls match_sections
+// repeatedly (thrice by default) to detect identical functions, and
+// unblocks ICF_BLOCKER.
 
 void
 Icf::find_identical_sections(const Input_objects* input_objects,
-                             Symbol_table* symtab)
+                             Symbol_table* symtab, Workqueue* workqueue,
+                             Task_token* icf_blocker)
 {
   unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
-  std::vector<uint64_t> section_addraligns;
-  std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
   const Target& target = parameters->target();
 
   // Decide which sections are possible candidates first.
@@ -970,6 +1503,7 @@ Icf::find_identical_sections(const Input_objects* input_objects,
       const Task* dummy_task = reinterpret_cast<const Task*>(-1);
       Task_lock_obj<Object> tl(dummy_task, *p);
       std::vector<unsigned int> eh_frame_ind;
+      Object_sections object_sections(*p, section_num);
 
       for (unsigned int i = 0; i < (*p)->shnum(); ++i)
         {
@@ -1001,13 +1535,15 @@ Icf::find_identical_sections(const Input_objects* input_objects,
           this->id_section_.push_back(Section_id(*p, i));
           this->section_id_[Section_id(*p, i)] = section_num;
           this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
-	  section_addraligns.push_back((*p)->section_addralign(i));
-          is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
+	  this->section_addraligns_.push_back((*p)->section_addralign(i));
+	  this->section_sizes_.push_back((*p)->section_size(i));
           section_num++;
         }
 
+      object_sections.last = section_num;
+      if (object_sections.last > object_sections.first)
+	this->object_sections_.push_back(object_sections);
+
       for (std::vector<unsigned int>::iterator it_eh_ind = eh_frame_ind.begin();
 	   it_eh_ind != eh_frame_ind.end(); ++it_eh_ind)
 	{
@@ -1034,6 +1570,129 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 	}
     }
 
+  this->is_secn_or_group_unique_.resize(section_num, false);
+  this->section_digests_.resize(section_num);
+  this->tracked_section_ids_.resize(section_num);
+
+  this->queue_hash_tasks(symtab, workqueue, icf_blocker);
+}
+
+// Queue an Icf_hash_task for each object with candidate sections.
+// They all unblock HASH_BLOCKER, which the Icf_match_task waits for.
+
+void
+Icf::queue_hash_tasks(Symbol_table* symtab, Workqueue* workqueue,
+                      Task_token* icf_blocker)
+{
+  Task_token* hash_blocker = new Task_token(true);
+  hash_blocker->add_blockers(this->object_sections_.size());
+  for (unsigned int i = 0; i < this->object_sections_.size(); ++i)
+    workqueue->queue(new Icf_hash_task(this, symtab,
+				       this->object_sections_[i].object, i,
+				       hash_blocker));
+  workqueue->queue(new Icf_match_task(this, symtab, hash_blocker,
+				      icf_blocker));
+}
+
+// Compute the digests of the candidate sections of an object.  The
+// first time this is called for an object, the digests of the raw
+// section contents are computed, to find the sections which are
+// unique.  The second time, the digests of the contents and relocs of
+// the remaining sections are computed.  This is called with the
+// object locked, possibly in parallel for different objects.
+
+void
+Icf::hash_object_sections(Symbol_table* symtab, unsigned int object_index)
+{
+  Object_sections& os(this->object_sections_[object_index]);
+  for (unsigned int i = os.first; i < os.last; ++i)
+    {
+      if (this->is_secn_or_group_unique_[i])
+        continue;
+
+      if (!this->contents_hashed_)
+        {
+          const Section_id& secn(this->id_section_[i]);
+          section_size_type plen;
+          const unsigned char* contents =
+            secn.first->section_contents(secn.second, &plen, false);
+          md5_buffer(reinterpret_cast<const char*>(contents), plen,
+                     this->section_digests_[i].bytes);
+        }
+      else if (!this->hash_section_contents(symtab, i, false))
+        os.deferred.push_back(i);
+    }
+}
+
+// Compute the digest and the tracked relocs of section SECTION_NUM.
+// If CAN_READ_OTHER_OBJECTS is false, this returns false if that would
+// require reading an object other than the one containing the section.
+
+bool
+Icf::hash_section_contents(Symbol_table* symtab, unsigned int section_num,
+                           bool can_read_other_objects)
+{
+  const Section_id& secn(this->id_section_[section_num]);
+  std::vector<unsigned int>* tracked_section_ids =
+    &this->tracked_section_ids_[section_num];
+  std::string contents;
+  tracked_section_ids->clear();
+  if (!get_section_contents(secn, secn, symtab, can_read_other_objects,
+                            &contents, tracked_section_ids))
+    return false;
+  md5_buffer(contents.data(), contents.length(),
+             this->section_digests_[section_num].bytes);
+  return true;
+}
+
+// Called by the Icf_match_task when all the Icf_hash_tasks have
+// completed.  The first time, use the digests of the raw contents to
+// find the unique sections, and request another round of hashing.
+// The second time, run the ICF iterations.
+
+bool
+Icf::match_hashed_sections(Symbol_table* symtab)
+{
+  if (!this->contents_hashed_)
+    {
+      preprocess_for_unique_sections(this->section_digests_,
+                                     &this->is_secn_or_group_unique_);
+      this->contents_hashed_ = true;
+      return true;
+    }
+
+  // Hash the sections which refer to other objects, now that nothing
+  // else is running.
+  for (std::vector<Object_sections>::const_iterator p =
+         this->object_sections_.begin();
+       p != this->object_sections_.end();
+       ++p)
+    {
+      if (p->deferred.empty())
+        continue;
+
+      // Lock the object so we can read from it.  This is only called
+      // single-threaded from an Icf_match_task, so it is OK to lock.
+      // Unfortunately we have no way to pass in a Task token.
+      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+      Task_lock_obj<Object> tl(dummy_task, p->object);
+      for (std::vector<unsigned int>::const_iterator q = p->deferred.begin();
+           q != p->deferred.end();
+           ++q)
+        {
+          bool hashed = this->hash_section_contents(symtab, *q, true);
+          gold_assert(hashed);
+        }
+    }
+
+  if (strcmp(parameters->options().icf_algorithm(), "partition") == 0)
+    {
+      this->refine_sections(symtab);
+      this->finish_identical_sections(symtab, this->num_rounds_, true);
+      return false;
+    }
+
+  Section_contents_checker checker(symtab, this->id_section_);
   unsigned int num_iterations = 0;
 
   // Default number of iterations to run ICF is 3.
@@ -1046,15 +1705,63 @@ Icf::find_identical_sections(const Input_objects* input_objects,
   while (!converged && (num_iterations < max_iterations))
     {
       num_iterations++;
-      converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, section_addraligns,
-                                 &is_secn_or_group_unique, &section_contents);
+      converged = match_sections(num_iterations, &this->kept_section_id_,
+                                 this->section_addraligns_,
+                                 &this->is_secn_or_group_unique_,
+                                 this->section_digests_,
+                                 this->tracked_section_ids_,
+                                 &checker);
+    }
+
+  this->num_rounds_ = num_iterations;
+  this->finish_identical_sections(symtab, num_iterations, converged);
+  return false;
+}
+
+// Find identical sections by partition refinement: start by assuming
+// that all sections with the same digest are identical, and split
+// the classes of sections apart until the sections of each class
+// refer to the same classes.  Unlike match_sections, this finds
+// mutually recursive functions which are identical, and always runs
+// to convergence.
+
+void
+Icf::refine_sections(Symbol_table* symtab)
+{
+  Section_contents_checker checker(symtab, this->id_section_);
+  Section_partition partition(this->is_secn_or_group_unique_,
+                              this->section_digests_,
+                              this->tracked_section_ids_,
+                              &checker);
+  this->num_rounds_ = partition.refine();
+  this->num_classes_ = partition.class_count();
+
+  // Keep the first section with the largest alignment in each class.
+  std::vector<unsigned int> kept(this->num_classes_, -1U);
+  for (unsigned int i = 0; i < this->kept_section_id_.size(); ++i)
+    {
+      unsigned int& k(kept[partition.class_of(i)]);
+      if (k == -1U
+          || this->section_addraligns_[i] > this->section_addraligns_[k])
+        k = i;
     }
+  for (unsigned int i = 0; i < this->kept_section_id_.size(); ++i)
+    this->kept_section_id_[i] = kept[partition.class_of(i)];
+}
+
+// Called when the groups of identical sections have been formed.
 
+void
+Icf::finish_identical_sections(Symbol_table* symtab,
+                               unsigned int num_iterations, bool converged)
+{
   if (parameters->options().print_icf_sections())
     {
-      if (converged)
+      if (strcmp(parameters->options().icf_algorithm(), "partition") == 0)
+        gold_info(_("%s: ICF partition refinement converged after"
+                    " %u round(s)"),
+                  program_name, num_iterations);
+      else if (converged)
         gold_info(_("%s: ICF Converged after %u iteration(s)"),
                   program_name, num_iterations);
       else
@@ -1088,9 +1795,46 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 
     }
 
+  for (unsigned int i = 0; i < this->kept_section_id_.size(); ++i)
+    {
+      if (this->kept_section_id_[i] != i)
+        {
+          ++this->num_folded_;
+          this->bytes_folded_ += this->section_sizes_[i];
+        }
+    }
+
+  // The digests are no longer needed.
+  std::vector<Object_sections>().swap(this->object_sections_);
+  std::vector<uint64_t>().swap(this->section_addraligns_);
+  std::vector<uint64_t>().swap(this->section_sizes_);
+  std::vector<bool>().swap(this->is_secn_or_group_unique_);
+  std::vector<Section_digest>().swap(this->section_digests_);
+  std::vector<std::vector<unsigned int> >().swap(this->tracked_section_ids_);
+
   this->icf_ready();
 }
 
+// Print statistical information to stderr.  This is used for --stats.
+
+void
+Icf::print_stats() const
+{
+  const char* algorithm = parameters->options().icf_algorithm();
+  fprintf(stderr, _("%s: ICF algorithm: %s; candidate sections: %zu\n"),
+          program_name, algorithm, this->id_section_.size());
+  if (strcmp(algorithm, "partition") == 0)
+    fprintf(stderr, _("%s: ICF rounds: %u; classes: %u\n"),
+            program_name, this->num_rounds_, this->num_classes_);
+  else
+    fprintf(stderr, _("%s: ICF iterations: %u\n"),
+            program_name, this->num_rounds_);
+  fprintf(stderr,
+          _("%s: ICF sections folded: %u; bytes folded: %llu\n"),
+          program_name, this->num_folded_,
+          static_cast<unsigned long long>(this->bytes_folded_));
+}
+
 // Unfolds the section denoted by OBJ and SHNDX if folded.
 
 void
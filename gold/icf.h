@@ -35,6 +35,8 @@ namespace gold
 class Object;
 class Input_objects;
 class Symbol_table;
+class Workqueue;
+class Task_token;
 
 class Icf
 {
@@ -77,11 +79,36 @@ class Icf
 
   typedef std::multimap<Section_id, Extra_identity_info> Extra_identity_list;
 
+  // A fixed-size digest of a section's contents, used in place of the
+  // contents themselves when comparing sections.
+  struct Section_digest
+  {
+    unsigned char bytes[16];
+
+    bool
+    operator==(const Section_digest& d) const
+    { return memcmp(this->bytes, d.bytes, sizeof this->bytes) == 0; }
+  };
+
+  struct Section_digest_hash
+  {
+    size_t
+    operator()(const Section_digest& d) const
+    {
+      size_t h;
+      memcpy(&h, d.bytes, sizeof h);
+      return h;
+    }
+  };
+
   Icf()
   : id_section_(), section_id_(), kept_section_id_(),
     fptr_section_id_(),
     icf_ready_(false),
-    reloc_info_list_()
+    reloc_info_list_(), object_sections_(), section_addraligns_(),
+    section_sizes_(), is_secn_or_group_unique_(), section_digests_(),
+    tracked_section_ids_(), contents_hashed_(false), num_rounds_(0),
+    num_classes_(0), num_folded_(0), bytes_folded_(0)
   { }
 
   // Returns the kept folded identical section corresponding to
@@ -90,10 +117,35 @@ class Icf
   get_folded_section(Relobj* dup_obj, unsigned int dup_shndx);
 
   // Forms groups of identical sections where the first member
-  // of each group is the kept section during folding.
+  // of each group is the kept section during folding.  The sections
+  // are hashed by tasks queued on WORKQUEUE; ICF_BLOCKER is unblocked
+  // when the groups have been formed.
   void
   find_identical_sections(const Input_objects* input_objects,
-                          Symbol_table* symtab);
+                          Symbol_table* symtab, Workqueue* workqueue,
+                          Task_token* icf_blocker);
+
+  // Compute the digests of the candidate sections of the OBJECT_INDEX'th
+  // object.  This is called by an Icf_hash_task with the object locked.
+  void
+  hash_object_sections(Symbol_table* symtab, unsigned int object_index);
+
+  // Use the digests computed by the Icf_hash_tasks to form the groups
+  // of identical sections.  This returns true if another round of
+  // Icf_hash_tasks needs to be queued.  This is called by an
+  // Icf_match_task.
+  bool
+  match_hashed_sections(Symbol_table* symtab);
+
+  // Queue an Icf_hash_task for each object, followed by an
+  // Icf_match_task which unblocks ICF_BLOCKER.
+  void
+  queue_hash_tasks(Symbol_table* symtab, Workqueue* workqueue,
+                   Task_token* icf_blocker);
+
+  // Print statistics about ICF to stderr.
+  void
+  print_stats() const;
 
   // This is set when ICF has been run and the groups of
   // identical sections have been formed.
@@ -163,10 +215,43 @@ class Icf
 
  private:
 
+  // The candidate sections of a single object, which are numbered
+  // consecutively.
+  struct Object_sections
+  {
+    Object_sections(Relobj* obj, unsigned int first_id)
+      : object(obj), first(first_id), last(first_id), deferred()
+    { }
+
+    Relobj* object;
+    // The id of the first candidate section.
+    unsigned int first;
+    // One past the id of the last candidate section.
+    unsigned int last;
+    // Sections whose contents could not be hashed while only this
+    // object was locked, because they refer to merge sections in
+    // other objects.  These are hashed by the Icf_match_task.
+    std::vector<unsigned int> deferred;
+  };
+
   bool
   add_ehframe_links(Relobj* object, unsigned int ehframe_shndx,
 		    Reloc_info& ehframe_relocs);
 
+  // Compute the digest and tracked relocs of section SECTION_NUM.
+  bool
+  hash_section_contents(Symbol_table* symtab, unsigned int section_num,
+			bool can_read_other_objects);
+
+  // Form the groups of identical sections by partition refinement.
+  void
+  refine_sections(Symbol_table* symtab);
+
+  // Called when the groups of identical sections have been formed.
+  void
+  finish_identical_sections(Symbol_table* symtab, unsigned int num_iterations,
+			    bool converged);
+
   // Maps integers to sections.
   std::vector<Section_id> id_section_;
   // Does the reverse.
@@ -186,6 +271,39 @@ class Icf
   // Regions of other sections that should be considered part of
   // each section for ICF purposes.
   Extra_identity_list extra_identity_list_;
+
+  // The remaining members are only used while the groups of identical
+  // sections are being formed.
+
+  // The candidate sections of each object.
+  std::vector<Object_sections> object_sections_;
+  // The alignment of each section.
+  std::vector<uint64_t> section_addraligns_;
+  // The size of each section.
+  std::vector<uint64_t> section_sizes_;
+  // Whether a section or a group of identical sections is known to
+  // be unique.
+  std::vector<bool> is_secn_or_group_unique_;
+  // The digest of each section.  Before CONTENTS_HASHED_ is set this
+  // is the digest of the raw section contents; after, it covers the
+  // contents and all the relocs except the identity of the foldable
+  // sections they refer to, which is in TRACKED_SECTION_IDS_.
+  std::vector<Section_digest> section_digests_;
+  // For each section, the ids of the foldable sections referred to by
+  // its relocs.
+  std::vector<std::vector<unsigned int> > tracked_section_ids_;
+  // Whether the section contents and relocs have been hashed.
+  bool contents_hashed_;
+
+  // Statistics.
+
+  // The number of iterations, or of partition refinement rounds.
+  unsigned int num_rounds_;
+  // The number of classes of sections after partition refinement.
+  unsigned int num_classes_;
+  // The number of sections folded, and their total size.
+  unsigned int num_folded_;
+  uint64_t bytes_folded_;
 };
 
 // This function returns true if this section corresponds to a function that
@@ -41,6 +41,10 @@
 #ifdef HAVE_JANSSON
 #include <jansson.h>
 #endif
+#ifdef WITH_XXHASH
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#endif
 
 #include "parameters.h"
 #include "options.h"
@@ -57,8 +61,10 @@
 #include "object.h"
 #include "reloc.h"
 #include "descriptors.h"
+#include "gold-threads.h"
 #include "plugin.h"
 #include "incremental.h"
+#include "timer.h"
 #include "layout.h"
 
 namespace gold
@@ -242,18 +248,49 @@ Free_list::print_stats()
 	  program_name, Free_list::num_allocate_visits);
 }
 
-// A Hash_task computes the MD5 checksum of an array of char.
+// The fast build ID hash is the 128-bit XXH3 hash of xxHash.  The
+// hash is stored in the canonical big-endian order, so the build ID
+// does not depend on the host.  This has the interface of md5_buffer.
+
+#ifdef WITH_XXHASH
+
+static void*
+fast_hash_buffer(const char* buffer, size_t len, void* resblock)
+{
+  XXH128_canonical_t canonical;
+  XXH128_canonicalFromHash(&canonical, XXH3_128bits(buffer, len));
+  memcpy(resblock, canonical.digest, sizeof canonical.digest);
+  return resblock;
+}
+
+#else // !defined(WITH_XXHASH)
+
+// General_options::finalize rejects --build-id=fast.
+
+static void*
+fast_hash_buffer(const char*, size_t, void*)
+{
+  gold_unreachable();
+}
+
+#endif // !defined(WITH_XXHASH)
+
+// A Hash_task computes the checksum of an array of char, using
+// HASH_BUFFER, which is md5_buffer or fast_hash_buffer.
 
 class Hash_task : public Task
 {
  public:
+  typedef void* (*Hash_buffer)(const char*, size_t, void*);
+
   Hash_task(Output_file* of,
 	    size_t offset,
 	    size_t size,
 	    unsigned char* dst,
+	    Hash_buffer hash_buffer,
 	    Task_token* final_blocker)
     : of_(of), offset_(offset), size_(size), dst_(dst),
-      final_blocker_(final_blocker)
+      hash_buffer_(hash_buffer), final_blocker_(final_blocker)
   { }
 
   void
@@ -261,7 +298,8 @@ class Hash_task : public Task
   {
     const unsigned char* iv =
 	this->of_->get_input_view(this->offset_, this->size_);
-    md5_buffer(reinterpret_cast<const char*>(iv), this->size_, this->dst_);
+    this->hash_buffer_(reinterpret_cast<const char*>(iv), this->size_,
+		       this->dst_);
     this->of_->free_input_view(this->offset_, this->size_, iv);
   }
 
@@ -283,6 +321,7 @@ class Hash_task : public Task
   const size_t offset_;
   const size_t size_;
   unsigned char* const dst_;
+  const Hash_buffer hash_buffer_;
   Task_token* const final_blocker_;
 };
 
@@ -451,6 +490,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     added_eh_frame_data_(false),
     eh_frame_hdr_section_(NULL),
     gdb_index_data_(NULL),
+    relr_dyn_(NULL),
     build_id_note_(NULL),
     debug_abbrev_(NULL),
     debug_info_(NULL),
@@ -473,6 +513,8 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     script_output_section_data_list_(),
     segment_states_(NULL),
     relaxation_debug_check_(NULL),
+    relaxation_pass_(),
+    relaxation_passes_(),
     section_order_map_(),
     section_segment_map_(),
     input_section_position_(),
@@ -1623,8 +1665,8 @@ Layout::remove_eh_frame_for_plt(Output_data* plt, const unsigned char* cie_data,
   this->eh_frame_data_->remove_ehframe_for_plt(plt, cie_data, cie_length);
 }
 
-// Scan a .debug_info or .debug_types section, and add summary
-// information to the .gdb_index section.
+// Record a .debug_info or .debug_types section to be scanned for
+// summary information for the .gdb_index section.
 
 template<int size, bool big_endian>
 void
@@ -1650,9 +1692,18 @@ Layout::add_to_gdb_index(bool is_type_unit,
       os->set_after_input_sections();
     }
 
-  this->gdb_index_data_->scan_debug_info(is_type_unit, object, symbols,
-					 symbols_size, shndx, reloc_shndx,
-					 reloc_type);
+  this->gdb_index_data_->add_input_section(is_type_unit, object, symbols,
+					   symbols_size, shndx, reloc_shndx,
+					   reloc_type);
+}
+
+// Queue the tasks which scan the sections for the .gdb_index section.
+
+void
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (this->gdb_index_data_ != NULL)
+    this->gdb_index_data_->queue_scan_tasks(workqueue, blocker);
 }
 
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
@@ -3074,20 +3125,51 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   unsigned int shndx;
   int pass = 0;
 
-  // Take a snapshot of the section layout as needed.
-  if (target->may_relax())
+  // Take a snapshot of the section layout as needed.  The size of
+  // the .relr.dyn section depends on the addresses of the relocations,
+  // so it may also require laying out the sections more than once.
+  if (target->may_relax() || this->relr_dyn_ != NULL)
     this->prepare_for_relaxation();
 
   // Run the relaxation loop to lay out sections.
+  const bool record_passes = (parameters->options().stats()
+			      && (target->may_relax()
+				  || this->relr_dyn_ != NULL));
+  bool relayout;
   do
     {
+      Timer pass_timer;
+      if (record_passes)
+	{
+	  this->relaxation_pass_ = Relaxation_pass();
+	  pass_timer.start();
+	}
+
       off = this->relaxation_loop_body(pass, target, symtab, &load_seg,
 				       phdr_seg, segment_headers, file_header,
 				       &shndx);
       pass++;
+
+      if (record_passes)
+	{
+	  this->relaxation_pass_.layout_time =
+	    pass_timer.get_elapsed_time().wall;
+	  pass_timer.start();
+	}
+
+      relayout = (target->may_relax()
+		  && target->relax(pass, input_objects, symtab, this, task));
+      if (this->relr_dyn_ != NULL && this->relr_dyn_->update_size())
+	relayout = true;
+
+      if (record_passes)
+	{
+	  this->relaxation_pass_.relax_time =
+	    pass_timer.get_elapsed_time().wall;
+	  this->relaxation_passes_.push_back(this->relaxation_pass_);
+	}
     }
-  while (target->may_relax()
-	 && target->relax(pass, input_objects, symtab, this, task));
+  while (relayout);
 
   // If there is a load segment that contains the file and program headers,
   // provide a symbol __ehdr_start pointing there.
@@ -3452,7 +3534,7 @@ Layout::create_build_id()
   // set DESC to the note descriptor contents.
   size_t descsz;
   std::string desc;
-  if (strcmp(style, "md5") == 0)
+  if (strcmp(style, "md5") == 0 || strcmp(style, "fast") == 0)
     descsz = 128 / 8;
   else if ((strcmp(style, "sha1") == 0) || (strcmp(style, "tree") == 0))
     descsz = 160 / 8;
@@ -4426,6 +4508,154 @@ Layout::count_local_symbols(const Task* task,
     }
 }
 
+// The number of input local symbols at which we finalize the local
+// symbols of the input objects in several threads.
+
+static const uint64_t parallel_finalize_min_locals = 100000;
+
+// Finalize the local symbols of the input objects in several threads.
+// This is done in two passes.  First each object computes the values
+// of its local symbols and counts those which go into the output
+// symbol table.  Then, once the caller has worked out where the local
+// symbols of each object start, the objects set the indexes.  Objects
+// which can not compute their values ahead of time are left to the
+// caller.
+
+class Parallel_finalize_local_symbols : public Parallel_run
+{
+ public:
+  Parallel_finalize_local_symbols(const Input_objects* input_objects,
+				  Symbol_table* symtab)
+    : symtab_(symtab), objects_(input_objects->relobj_begin(),
+				input_objects->relobj_end()),
+      locals_(objects_.size()), pass_(PRECOMPUTE), next_object_(0), lock_(NULL)
+  { }
+
+  // Finalize the local symbols of the objects, assigning indexes
+  // starting at *PINDEX and file offsets starting at *POFF.  Update
+  // *PINDEX and *POFF to point past the local symbols.
+  void
+  finalize(int symsize, unsigned int* pindex, off_t* poff);
+
+ protected:
+  void
+  do_run(unsigned int);
+
+ private:
+  enum Pass
+  {
+    PRECOMPUTE,
+    FINALIZE
+  };
+
+  // Run pass PASS over the objects.
+  void
+  run_pass(Pass pass);
+
+  // What we know about the local symbols of an object.  Each entry
+  // is only written by the thread handling the object.
+  struct Object_locals
+  {
+    Object_locals()
+      : is_precomputed(false), has_gnu_output(false), count(0), index(0),
+	off(0)
+    { }
+
+    // Whether precompute_local_symbols succeeded.
+    bool is_precomputed;
+    // Whether any of the local symbols requires ELFOSABI_GNU.
+    bool has_gnu_output;
+    // The number of local symbols which go into the output symbol
+    // table.
+    unsigned int count;
+    // The index and file offset of the first of them.
+    unsigned int index;
+    off_t off;
+  };
+
+  Symbol_table* symtab_;
+  std::vector<Relobj*> objects_;
+  std::vector<Object_locals> locals_;
+  Pass pass_;
+  // The next object to handle, protected by LOCK_.
+  size_t next_object_;
+  Lock* lock_;
+};
+
+void
+Parallel_finalize_local_symbols::finalize(int symsize, unsigned int* pindex,
+					  off_t* poff)
+{
+  this->run_pass(PRECOMPUTE);
+
+  // Lay out the local symbols in input order.
+  unsigned int index = *pindex;
+  off_t off = *poff;
+  for (size_t i = 0; i < this->objects_.size(); ++i)
+    {
+      Object_locals& locals(this->locals_[i]);
+      if (!locals.is_precomputed)
+	{
+	  unsigned int next_index =
+	    this->objects_[i]->finalize_local_symbols(index, off,
+						      this->symtab_);
+	  off += (next_index - index) * symsize;
+	  index = next_index;
+	  continue;
+	}
+      locals.index = index;
+      locals.off = off;
+      index += locals.count;
+      off += locals.count * symsize;
+      if (locals.has_gnu_output)
+	this->symtab_->set_has_gnu_output();
+    }
+
+  this->run_pass(FINALIZE);
+
+  *pindex = index;
+  *poff = off;
+}
+
+void
+Parallel_finalize_local_symbols::run_pass(Pass pass)
+{
+  Lock lock;
+  this->lock_ = &lock;
+  this->pass_ = pass;
+  this->next_object_ = 0;
+  this->run(Parallel_run::thread_count(Parallel_run::MIDDLE_PHASE));
+  this->lock_ = NULL;
+}
+
+// Handle objects until there are none left.
+
+void
+Parallel_finalize_local_symbols::do_run(unsigned int)
+{
+  while (true)
+    {
+      size_t i;
+      {
+	Hold_lock hl(*this->lock_);
+	if (this->next_object_ >= this->objects_.size())
+	  return;
+	i = this->next_object_;
+	++this->next_object_;
+      }
+
+      Relobj* relobj = this->objects_[i];
+      Object_locals& locals(this->locals_[i]);
+      if (this->pass_ == PRECOMPUTE)
+	locals.is_precomputed =
+	  relobj->precompute_local_symbols(this->symtab_, &locals.count,
+					   &locals.has_gnu_output);
+      else if (locals.is_precomputed)
+	relobj->finalize_local_symbols(locals.index, locals.off,
+				       this->symtab_);
+    }
+}
+
 // Create the symbol table sections.  Here we also set the final
 // values of the symbols.  At this point all the loadable sections are
 // fully laid out.  SHNUM is the number of sections so far.
@@ -4475,14 +4705,42 @@ Layout::create_symtab_sections(const Input_objects* input_objects,
 	}
     }
 
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
-       ++p)
+  // With many local symbols, compute their values in several
+  // threads.  Incremental links keep the local symbols of unchanged
+  // objects where they were, so they do not use this.
+  uint64_t input_local_count = 0;
+  if (Parallel_run::thread_count(Parallel_run::MIDDLE_PHASE) > 1
+      && !parameters->incremental())
     {
-      unsigned int index = (*p)->finalize_local_symbols(local_symbol_index,
-							off, symtab);
-      off += (index - local_symbol_index) * symsize;
-      local_symbol_index = index;
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	input_local_count += (*p)->local_symbol_count();
+    }
+
+  if (input_local_count >= parallel_finalize_min_locals)
+    {
+      // The threads may look for relaxed input sections, so build the
+      // lookup maps first.
+      for (Section_list::const_iterator p = this->section_list_.begin();
+	   p != this->section_list_.end();
+	   ++p)
+	(*p)->prepare_lookup_maps();
+
+      Parallel_finalize_local_symbols pfls(input_objects, symtab);
+      pfls.finalize(symsize, &local_symbol_index, &off);
+    }
+  else
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  unsigned int index = (*p)->finalize_local_symbols(local_symbol_index,
+							    off, symtab);
+	  off += (index - local_symbol_index) * symsize;
+	  local_symbol_index = index;
+	}
     }
 
   unsigned int local_symcount = local_symbol_index;
@@ -4719,6 +4977,9 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
   unsigned int local_symcount = index;
   unsigned int forced_local_count = 0;
 
+  if (this->relr_dyn_ != NULL)
+    pversions->set_uses_dt_relr();
+
   index = symtab->set_dynsym_indexes(index, &forced_local_count,
 				     pdynamic_symbols, &this->dynpool_,
 				     pversions);
@@ -5216,6 +5477,16 @@ Layout::add_target_dynamic_tags(bool use_rel, const Output_data* plt_got,
 	}
     }
 
+  if (this->relr_dyn_ != NULL)
+    {
+      odyn->add_section_address(elfcpp::DT_RELR,
+				this->relr_dyn_->output_section());
+      odyn->add_section_size(elfcpp::DT_RELRSZ,
+			     this->relr_dyn_->output_section());
+      odyn->add_constant(elfcpp::DT_RELRENT,
+			 parameters->target().get_size() / 8);
+    }
+
   if (add_debug && !parameters->options().shared())
     {
       // The value of the DT_DEBUG tag is filled in by the dynamic
@@ -5224,6 +5495,16 @@ Layout::add_target_dynamic_tags(bool use_rel, const Output_data* plt_got,
     }
 }
 
+void
+Layout::add_relr_dyn_section(Output_data_relr_generic* relr)
+{
+  gold_assert(this->relr_dyn_ == NULL);
+  this->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+				elfcpp::SHF_ALLOC, relr,
+				ORDER_DYNAMIC_RELOCS, false);
+  this->relr_dyn_ = relr;
+}
+
 void
 Layout::add_target_specific_dynamic_tag(elfcpp::DT tag, unsigned int val)
 {
@@ -5787,6 +6068,18 @@ Layout::get_allocated_sections(Section_list* section_list) const
       section_list->push_back(*p);
 }
 
+// Store the merge sections for strings into SECTIONS.
+
+void
+Layout::get_merge_string_sections(
+    std::vector<Output_merge_base*>* sections) const
+{
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    (*p)->get_merge_string_sections(sections);
+}
+
 // Store the executable sections into the section list.
 
 void
@@ -5974,11 +6267,22 @@ Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
 	sha1_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
       else if (strcmp(style, "md5") == 0)
 	md5_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
+      else if (strcmp(style, "fast") == 0)
+	fast_hash_buffer(reinterpret_cast<const char*>(iv), output_file_size,
+			 ov);
       else
 	gold_unreachable();
 
       of->free_input_view(0, output_file_size, iv);
     }
+  else if (strcmp(parameters->options().build_id(), "fast") == 0)
+    {
+      // Non-overlapping substrings of the output file have been hashed.
+      // Compute the fast hash of the hashes.
+      fast_hash_buffer(reinterpret_cast<const char*>(array_of_hashes),
+		       size_of_hashes, ov);
+      delete[] array_of_hashes;
+    }
   else
     {
       // Non-overlapping substrings of the output file have been hashed.
@@ -6066,6 +6370,20 @@ Layout::print_stats() const
   this->sympool_.print_stats("output symbol name pool");
   this->dynpool_.print_stats("dynamic name pool");
 
+  if (this->relr_dyn_ != NULL)
+    this->relr_dyn_->print_stats();
+
+  for (size_t i = 0; i < this->relaxation_passes_.size(); ++i)
+    {
+      const Relaxation_pass& rp(this->relaxation_passes_[i]);
+      fprintf(stderr,
+	      _("%s: relaxation pass %u: layout %ld ms, relax %ld ms, "
+		"stub groups changed %u, sections scanned %u, skipped %u\n"),
+	      program_name, static_cast<unsigned int>(i + 1),
+	      rp.layout_time, rp.relax_time, rp.changed_groups,
+	      rp.scanned_sections, rp.skipped_sections);
+    }
+
   for (Section_list::const_iterator p = this->section_list_.begin();
        p != this->section_list_.end();
        ++p)
@@ -6187,6 +6505,9 @@ Write_after_input_sections_task::run(Workqueue*)
 // Build IDs can be computed as a "flat" sha1 or md5 of a string of bytes,
 // or as a "tree" where each chunk of the string is hashed and then those
 // hashes are put into a (much smaller) string which is hashed with sha1.
+// A "fast" build ID is a tree of XXH3 hashes, whatever the file size.
+// Like the other styles it is only computed once the whole file has
+// been written; the chunks are not hashed as the writes finish.
 // We compute a checksum over the entire file because that is simplest.
 
 void
@@ -6199,12 +6520,16 @@ Build_id_task_runner::run(Workqueue* workqueue, const Task*)
 			   : static_cast<size_t>(layout->output_file_size()));
   unsigned char* array_of_hashes = NULL;
   size_t size_of_hashes = 0;
+  const bool is_fast = strcmp(this->options_->build_id(), "fast") == 0;
 
-  if (strcmp(this->options_->build_id(), "tree") == 0
+  if ((is_fast || strcmp(this->options_->build_id(), "tree") == 0)
       && this->options_->build_id_chunk_size_for_treehash() > 0
       && filesize > 0
-      && (filesize >= this->options_->build_id_min_file_size_for_treehash()))
+      && (is_fast
+	  || (filesize
+	      >= this->options_->build_id_min_file_size_for_treehash())))
     {
+      // The MD5 and fast hashes are both 16 bytes.
       static const size_t MD5_OUTPUT_SIZE_IN_BYTES = 16;
       const size_t chunk_size =
 	  this->options_->build_id_chunk_size_for_treehash();
@@ -6221,6 +6546,9 @@ Build_id_task_runner::run(Workqueue* workqueue, const Task*)
 					 src_offset,
 					 size,
 					 dst,
+					 (is_fast
+					  ? fast_hash_buffer
+					  : md5_buffer),
 					 post_hash_tasks_blocker));
 	}
     }
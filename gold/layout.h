@@ -46,6 +46,7 @@ class Input_objects;
 class Mapfile;
 class Symbol_table;
 class Output_section_data;
+class Output_merge_base;
 class Output_section;
 class Output_section_headers;
 class Output_segment_headers;
@@ -53,6 +54,7 @@ class Output_file_header;
 class Output_segment;
 class Output_data;
 class Output_data_reloc_generic;
+class Output_data_relr_generic;
 class Output_data_dynamic;
 class Output_symtab_xindex;
 class Output_reduced_debug_abbrev_section;
@@ -684,8 +686,8 @@ class Layout
   remove_eh_frame_for_plt(Output_data* plt, const unsigned char* cie_data,
 			  size_t cie_length);
 
-  // Scan a .debug_info or .debug_types section, and add summary
-  // information to the .gdb_index section.
+  // Record a .debug_info or .debug_types section to be scanned for
+  // summary information for the .gdb_index section.
   template<int size, bool big_endian>
   void
   add_to_gdb_index(bool is_type_unit,
@@ -696,6 +698,11 @@ class Layout
 		   unsigned int reloc_shndx,
 		   unsigned int reloc_type);
 
+  // Queue the tasks which scan the sections recorded by
+  // add_to_gdb_index.  Each task unblocks BLOCKER when it is done.
+  void
+  queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker);
+
   // Handle a GNU stack note.  This is called once per input object
   // file.  SEEN_GNU_STACK is true if the object file has a
   // .note.GNU-stack section.  GNU_STACK_FLAGS is the section flags
@@ -957,6 +964,13 @@ class Layout
   void
   add_target_specific_dynamic_tag(elfcpp::DT tag, unsigned int val);
 
+  // Add the .relr.dyn section which holds the packed RELATIVE
+  // relocations for -z pack-relative-relocs.  This is called when
+  // the first relocation is packed, so that there is no .relr.dyn
+  // section and no DT_RELR tags if none are.
+  void
+  add_relr_dyn_section(Output_data_relr_generic* relr);
+
   // Compute and write out the build ID if needed.
   void
   write_build_id(Output_file*, unsigned char*, size_t) const;
@@ -994,6 +1008,10 @@ class Layout
   void
   get_executable_sections(Section_list*) const;
 
+  // Store the merge sections for strings into SECTIONS.
+  void
+  get_merge_string_sections(std::vector<Output_merge_base*>* sections) const;
+
   // Make a section for a linker script to hold data.
   Output_section*
   make_output_section_for_script(const char* name,
@@ -1041,6 +1059,21 @@ class Layout
   add_relax_output(Output_data* data)
   { this->relax_output_list_.push_back(data); }
 
+  // Record what the target relaxation hook did in the current pass,
+  // for --stats.  CHANGED_GROUPS is the number of stub groups whose
+  // size changed.  SCANNED_SECTIONS and SKIPPED_SECTIONS are the
+  // number of sections scanned for stubs, and the number skipped
+  // because nothing they refer to had moved.
+  void
+  record_relaxation_pass(unsigned int changed_groups,
+			 unsigned int scanned_sections,
+			 unsigned int skipped_sections)
+  {
+    this->relaxation_pass_.changed_groups = changed_groups;
+    this->relaxation_pass_.scanned_sections = scanned_sections;
+    this->relaxation_pass_.skipped_sections = skipped_sections;
+  }
+
   // Clear out (and free) everything added by add_relax_output.
   void
   reset_relax_output();
@@ -1286,6 +1319,24 @@ class Layout
   typedef Unordered_map<const Output_segment*, const Output_segment*>
     Segment_states;
 
+  // Statistics for one pass of the relaxation loop, for --stats.
+  struct Relaxation_pass
+  {
+    Relaxation_pass()
+      : layout_time(0), relax_time(0), changed_groups(0),
+	scanned_sections(0), skipped_sections(0)
+    { }
+
+    // Wall clock time in milliseconds spent laying out the sections,
+    // and in the target relaxation hook.
+    long layout_time;
+    long relax_time;
+    // The values passed to record_relaxation_pass.
+    unsigned int changed_groups;
+    unsigned int scanned_sections;
+    unsigned int skipped_sections;
+  };
+
   // Save states of current output segments.
   void
   save_segments(Segment_states*);
@@ -1456,6 +1507,8 @@ class Layout
   Output_section* eh_frame_hdr_section_;
   // The data for the .gdb_index section.
   Gdb_index* gdb_index_data_;
+  // The packed RELATIVE relocations for -z pack-relative-relocs.
+  Output_data_relr_generic* relr_dyn_;
   // The space for the build ID checksum if there is one.
   Output_section_data* build_id_note_;
   // The space for the package metadata JSON if there is one.
@@ -1508,6 +1561,10 @@ class Layout
   Segment_states* segment_states_;
   // A relaxation debug checker.  We only create one when in debugging mode.
   Relaxation_debug_check* relaxation_debug_check_;
+  // The statistics of the current relaxation pass, and of all the
+  // passes so far.  These are only collected for --stats.
+  Relaxation_pass relaxation_pass_;
+  std::vector<Relaxation_pass> relaxation_passes_;
   // Plugins specify section_ordering using this map.  This is set in
   // update_section_order in plugin.cc
   std::map<Section_id, unsigned int> section_order_map_;
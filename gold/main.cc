@@ -234,6 +234,10 @@ main(int argc, char** argv)
 
   if (parameters->options().section_ordering_file())
     layout.read_layout_from_file();
+  else if ((parameters->options().call_graph_ordering_file() != NULL
+	    || parameters->options().call_graph_profile_sort())
+	   && !parameters->options().relocatable())
+    layout.set_section_ordering_specified();
 
   // Load plugin libraries.
   if (command_line.options().has_plugins())
@@ -306,6 +310,10 @@ main(int argc, char** argv)
       fprintf(stderr, _("%s: output file size: %lld bytes\n"),
 	      program_name, static_cast<long long>(layout.output_file_size()));
       symtab.print_stats();
+      if (parameters->options().gc_sections())
+	symtab.gc()->print_stats();
+      if (parameters->options().icf_enabled())
+	symtab.icf()->print_stats();
       layout.print_stats();
       Gdb_index::print_stats();
       Free_list::print_stats();
@@ -25,6 +25,9 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "parameters.h"
+#include "gold-threads.h"
+#include "workqueue.h"
 #include "merge.h"
 #include "compressed_output.h"
 
@@ -170,6 +173,25 @@ Object_merge_map::get_output_offset(unsigned int shndx,
   return true;
 }
 
+// Sort the mappings of every input section.
+
+void
+Object_merge_map::sort_input_merge_maps()
+{
+  for (Section_merge_maps::iterator p = this->section_merge_maps_.begin();
+       p != this->section_merge_maps_.end();
+       ++p)
+    {
+      Input_merge_map* map = p->second;
+      if (!map->sorted)
+	{
+	  std::sort(map->entries.begin(), map->entries.end(),
+		    Input_merge_compare());
+	  map->sorted = true;
+	}
+    }
+}
+
 // Return whether this is the merge map for section SHNDX.
 
 const Output_section_data*
@@ -255,6 +277,102 @@ Output_merge_base::record_input_section(Relobj* relobj, unsigned int shndx)
   gold_assert(result.second);
 }
 
+// A Merge_task merges the pending input sections of merge sections
+// which come from one object.
+
+class Merge_task : public Task
+{
+ public:
+  typedef std::vector<std::pair<Output_merge_base*, unsigned int> > Inputs;
+
+  Merge_task(Relobj* object, Task_token* blocker)
+    : object_(object), inputs_(), blocker_(blocker)
+  { }
+
+  // Add pending input section INDEX of POMB.
+  void
+  add_input(Output_merge_base* pomb, unsigned int index)
+  { this->inputs_.push_back(std::make_pair(pomb, index)); }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return this->object_->is_locked() ? this->object_->token() : NULL; }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->object_->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    for (Inputs::const_iterator p = this->inputs_.begin();
+	 p != this->inputs_.end();
+	 ++p)
+      p->first->merge_pending_input(p->second);
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Merge_task " + this->object_->name(); }
+
+ private:
+  Relobj* object_;
+  Inputs inputs_;
+  Task_token* blocker_;
+};
+
+// Queue a Merge_task for each object with pending input sections, in
+// the order in which the objects are first seen.
+
+void
+Output_merge_base::queue_merge_tasks(
+    const std::vector<Output_merge_base*>& sections,
+    Workqueue* workqueue,
+    Task_token* blocker)
+{
+  typedef Unordered_map<const Relobj*, Merge_task*> Task_map;
+  Task_map task_map;
+  std::vector<Merge_task*> tasks;
+  Pending_inputs pending;
+  for (std::vector<Output_merge_base*>::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    {
+      pending.clear();
+      (*p)->get_pending_inputs(&pending);
+      for (Pending_inputs::const_iterator q = pending.begin();
+	   q != pending.end();
+	   ++q)
+	{
+	  std::pair<Task_map::iterator, bool> ins =
+	    task_map.insert(std::make_pair(q->first,
+					   static_cast<Merge_task*>(NULL)));
+	  if (ins.second)
+	    {
+	      ins.first->second = new Merge_task(q->first, blocker);
+	      tasks.push_back(ins.first->second);
+	    }
+	  ins.first->second->add_input(*p, q->second);
+	}
+    }
+
+  for (std::vector<Merge_task*>::const_iterator p = tasks.begin();
+       p != tasks.end();
+       ++p)
+    {
+      blocker->add_blocker();
+      workqueue->queue(*p);
+    }
+}
+
 // Class Output_merge_data.
 
 // Compute the hash code for a fixed-size constant.
@@ -431,13 +549,144 @@ Output_merge_data::do_print_merge_stats(const char* section_name)
 
 // Class Output_merge_string.
 
-// Add an input section to a merged string section.
+template<typename Char_type>
+Output_merge_string<Char_type>::Output_merge_string(uint64_t addralign)
+  : Output_merge_base(sizeof(Char_type), addralign), shards_(),
+    merged_strings_lists_(), optimize_(false), data_size_(0),
+    input_count_(0), input_size_(0)
+{
+  // Looking for suffixes is only worth it with -O2, and only possible
+  // if the strings need no more alignment than their characters.
+  if (parameters->options_valid()
+      && parameters->options().optimize() >= 2
+      && addralign <= sizeof(Char_type))
+    this->optimize_ = true;
+}
+
+template<typename Char_type>
+Output_merge_string<Char_type>::~Output_merge_string()
+{
+  for (typename std::vector<String_shard>::iterator p = this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    {
+      delete p->lock;
+      for (typename std::vector<Char_type*>::iterator q = p->buffers.begin();
+	   q != p->buffers.end();
+	   ++q)
+	delete[] *q;
+    }
+  for (typename Merged_strings_lists::iterator p =
+	 this->merged_strings_lists_.begin();
+       p != this->merged_strings_lists_.end();
+       ++p)
+    delete *p;
+}
+
+// Add an input section to a merged string section.  The strings are
+// added later, by merge_pending_input, so that the input sections can
+// be processed in parallel.  Here we only check that the section can
+// be merged.
 
 template<typename Char_type>
 bool
 Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 						     unsigned int shndx)
 {
+  gold_assert(this->data_size_ == 0);
+
+  section_size_type sec_len;
+  if (!object->section_is_compressed(shndx, &sec_len))
+    sec_len = convert_to_section_size_type(object->section_size(shndx));
+  if (sec_len % sizeof(Char_type) != 0)
+    {
+      object->error(_("mergeable string section length not multiple of "
+		      "character size"));
+      return false;
+    }
+
+  if (this->shards_.empty())
+    {
+      this->shards_.resize(shard_count);
+      for (unsigned int i = 0; i < shard_count; ++i)
+	this->shards_[i].lock = new Lock();
+    }
+
+  this->merged_strings_lists_.push_back(new Merged_strings_list(object,
+								shndx));
+
+  // For script processing, we keep the input sections.
+  if (this->keeps_input_sections())
+    record_input_section(object, shndx);
+
+  return true;
+}
+
+// Add the input sections whose strings have not been added yet.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::do_get_pending_inputs(Pending_inputs* pending)
+{
+  for (unsigned int i = 0; i < this->merged_strings_lists_.size(); ++i)
+    {
+      const Merged_strings_list* l = this->merged_strings_lists_[i];
+      if (!l->is_merged)
+	pending->push_back(std::make_pair(l->object, i));
+    }
+}
+
+// Copy a string into the buffers of a shard.
+
+template<typename Char_type>
+const Char_type*
+Output_merge_string<Char_type>::copy_string(String_shard* shard,
+					    const Char_type* s, size_t length)
+{
+  // The number of characters we allocate for a new buffer.
+  const size_t buffer_size = 16384;
+
+  Char_type* ret;
+  if (length + 1 > buffer_size)
+    {
+      // Put long strings in buffers of their own, before the current
+      // buffer.
+      ret = new Char_type[length + 1];
+      if (shard->buffers.empty())
+	shard->buffers.push_back(ret);
+      else
+	shard->buffers.insert(shard->buffers.end() - 1, ret);
+    }
+  else
+    {
+      if (length + 1 > shard->buffer_left)
+	{
+	  shard->buffers.push_back(new Char_type[buffer_size]);
+	  shard->buffer_left = buffer_size;
+	}
+      ret = shard->buffers.back() + (buffer_size - shard->buffer_left);
+      shard->buffer_left -= length + 1;
+    }
+  memcpy(ret, s, length * sizeof(Char_type));
+  ret[length] = 0;
+  return ret;
+}
+
+// Add the strings of pending input section INDEX.  This runs in a
+// Merge_task, possibly at the same time as other input sections of
+// this merge section.  The strings are hashed and sorted by shard
+// without a lock, and then each shard is locked once.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::do_merge_pending_input(unsigned int index)
+{
+  Merged_strings_list* merged_strings_list =
+    this->merged_strings_lists_[index];
+  gold_assert(!merged_strings_list->is_merged);
+  Relobj* object = merged_strings_list->object;
+  unsigned int shndx = merged_strings_list->shndx;
+
   section_size_type sec_len;
   bool is_new;
   uint64_t addralign = this->addralign();
@@ -450,16 +699,7 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   const Char_type* pend = p + sec_len / sizeof(Char_type);
   const Char_type* pend0 = pend;
 
-  if (sec_len % sizeof(Char_type) != 0)
-    {
-      object->error(_("mergeable string section length not multiple of "
-		      "character size"));
-      if (is_new)
-	delete[] pdata;
-      return false;
-    }
-
-  if (pend[-1] != 0)
+  if (pend > p && pend[-1] != 0)
     {
       gold_warning(_("%s: last entry in mergeable string section '%s' "
 		     "not null terminated"),
@@ -470,24 +710,12 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 	--pend0;
     }
 
-  Merged_strings_list* merged_strings_list =
-      new Merged_strings_list(object, shndx);
-  this->merged_strings_lists_.push_back(merged_strings_list);
   Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
-  // Count the number of non-null strings in the section and size the list.
+  // Find the strings.
+  std::vector<String_entry> strings;
+  std::vector<unsigned int> shard_counts(shard_count + 1, 0);
   size_t count = 0;
-  const Char_type* pt = p;
-  while (pt < pend0)
-    {
-      size_t len = string_length(pt);
-      if (len != 0)
-	++count;
-      pt += len + 1;
-    }
-  if (pend0 < pend)
-    ++count;
-  merged_strings.reserve(count + 1);
 
   // The index I is in bytes, not characters.
   section_size_type i = 0;
@@ -509,20 +737,74 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 	      != init_align_modulo))
 	  has_misaligned_strings = true;
 
-      Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
+      if (len != 0)
+	++count;
+
+      String_entry e;
+      e.string = p;
+      e.length = len;
+      e.hash_code = gold::string_hash<Char_type>(p, len);
+      e.first_seen = ((static_cast<uint64_t>(index) << 32)
+		      | strings.size());
+      e.offset = i;
+      ++shard_counts[shard_index(e.hash_code) + 1];
+      strings.push_back(e);
 
-      merged_strings.push_back(Merged_string(i, key));
       p += len + 1;
       i += (len + 1) * sizeof(Char_type);
     }
 
+  // Sort the strings by shard.
+  for (unsigned int j = 0; j < shard_count; ++j)
+    shard_counts[j + 1] += shard_counts[j];
+  std::vector<unsigned int> by_shard(strings.size());
+  {
+    std::vector<unsigned int> fill(shard_counts.begin(),
+				   shard_counts.end() - 1);
+    for (unsigned int j = 0; j < strings.size(); ++j)
+      by_shard[fill[shard_index(strings[j].hash_code)]++] = j;
+  }
+
+  merged_strings.reserve(strings.size() + 1);
+  for (unsigned int j = 0; j < strings.size(); ++j)
+    merged_strings.push_back(Merged_string(strings[j].offset, NULL));
+
+  for (unsigned int j = 0; j < shard_count; ++j)
+    {
+      if (shard_counts[j] == shard_counts[j + 1])
+	continue;
+      String_shard* shard = &this->shards_[j];
+      Hold_lock hl(*shard->lock);
+      for (unsigned int k = shard_counts[j]; k < shard_counts[j + 1]; ++k)
+	{
+	  String_entry* e = &strings[by_shard[k]];
+	  typename String_set::const_iterator f = shard->strings.find(e);
+	  String_entry* entry;
+	  if (f != shard->strings.end())
+	    {
+	      entry = *f;
+	      if (e->first_seen < entry->first_seen)
+		entry->first_seen = e->first_seen;
+	    }
+	  else
+	    {
+	      shard->entries.push_back(*e);
+	      entry = &shard->entries.back();
+	      entry->string = copy_string(shard, e->string, e->length);
+	      entry->offset = 0;
+	      shard->strings.insert(entry);
+	    }
+	  merged_strings[by_shard[k]].entry = entry;
+	}
+    }
+
   // Record the last offset in the input section so that we can
   // compute the length of the last string.
-  merged_strings.push_back(Merged_string(i, 0));
+  merged_strings.push_back(Merged_string(i, NULL));
 
-  this->input_count_ += count;
-  this->input_size_ += i;
+  merged_strings_list->input_count = count;
+  merged_strings_list->input_size = i;
+  merged_strings_list->is_merged = true;
 
   if (has_misaligned_strings)
     gold_warning(_("%s: section %s contains incorrectly aligned strings;"
@@ -530,14 +812,112 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 		 object->name().c_str(),
 		 object->section_name(shndx).c_str());
 
-  // For script processing, we keep the input sections.
-  if (this->keeps_input_sections())
-    record_input_section(object, shndx);
-
   if (is_new)
     delete[] pdata;
+}
 
-  return true;
+// Return whether S1 is a suffix of S2.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::is_suffix(const String_entry* s1,
+					  const String_entry* s2)
+{
+  if (s1->length > s2->length)
+    return false;
+  return memcmp(s1->string, s2->string + s2->length - s1->length,
+		s1->length * sizeof(Char_type)) == 0;
+}
+
+// Sort strings so that when one string is a suffix of another, the
+// shorter string comes immediately after the longer string.  This is a
+// reversed lexicographic sort on the reversed strings, as in
+// Stringpool.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::String_entry_suffix_less::operator()(
+    const String_entry* e1,
+    const String_entry* e2) const
+{
+  const size_t len1 = e1->length;
+  const size_t len2 = e2->length;
+  const size_t minlen = len1 < len2 ? len1 : len2;
+  const Char_type* p1 = e1->string + len1 - 1;
+  const Char_type* p2 = e2->string + len2 - 1;
+  for (size_t i = minlen; i > 0; --i, --p1, --p2)
+    {
+      if (*p1 != *p2)
+	return *p1 > *p2;
+    }
+  return len1 > len2;
+}
+
+// Set the offsets of the strings in the output section.  This gives
+// the same offsets as adding the strings to a Stringpool one at a
+// time, in the order of the input sections.
+
+template<typename Char_type>
+section_size_type
+Output_merge_string<Char_type>::set_string_offsets()
+{
+  const size_t charsize = sizeof(Char_type);
+  const uint64_t addralign = this->addralign();
+  section_offset_type offset = 0;
+
+  if (!this->optimize_)
+    {
+      // Lay out the strings in the order of their first occurrence.
+      for (unsigned int i = 0; i < this->merged_strings_lists_.size(); ++i)
+	{
+	  const Merged_strings& merged_strings =
+	    this->merged_strings_lists_[i]->merged_strings;
+	  for (unsigned int j = 0; j < merged_strings.size(); ++j)
+	    {
+	      String_entry* entry = merged_strings[j].entry;
+	      if (entry == NULL
+		  || entry->first_seen != ((static_cast<uint64_t>(i) << 32)
+					   | j))
+		continue;
+	      entry->offset = align_address(offset, addralign);
+	      offset = entry->offset + (entry->length + 1) * charsize;
+	    }
+	}
+      return offset;
+    }
+
+  std::vector<String_entry*> v;
+  for (typename std::vector<String_shard>::iterator p = this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    for (typename std::deque<String_entry>::iterator q = p->entries.begin();
+	 q != p->entries.end();
+	 ++q)
+      v.push_back(&*q);
+
+  std::sort(v.begin(), v.end(), String_entry_suffix_less());
+
+  section_offset_type last_offset = -1;
+  for (typename std::vector<String_entry*>::iterator last = v.end(),
+	 curr = v.begin();
+       curr != v.end();
+       last = curr++)
+    {
+      section_offset_type this_offset;
+      if (last != v.end()
+	  && ((((*curr)->length - (*last)->length) % addralign) == 0)
+	  && is_suffix(*curr, *last))
+	this_offset = (last_offset
+		       + ((*last)->length - (*curr)->length) * charsize);
+      else
+	{
+	  this_offset = align_address(offset, addralign);
+	  offset = this_offset + ((*curr)->length + 1) * charsize;
+	}
+      (*curr)->offset = this_offset;
+      last_offset = this_offset;
+    }
+  return offset;
 }
 
 // Finalize the mappings from the input sections to the output
@@ -547,7 +927,27 @@ template<typename Char_type>
 section_size_type
 Output_merge_string<Char_type>::finalize_merged_data()
 {
-  this->stringpool_.set_string_offsets();
+  // This may be called twice, if Layout::set_segment_offsets finds a
+  // better alignment.
+  if (this->merged_strings_lists_.empty())
+    return this->data_size_;
+
+  // Add the strings of any input sections which were not handled by a
+  // Merge_task.
+  for (unsigned int i = 0; i < this->merged_strings_lists_.size(); ++i)
+    {
+      Merged_strings_list* l = this->merged_strings_lists_[i];
+      if (l->is_merged)
+	continue;
+      // Lock the object so we can read from it.  This is only called
+      // single-threaded from Layout::finalize, so it is OK to lock.
+      // Unfortunately we have no way to pass in a Task token.
+      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+      Task_lock_obj<Object> tl(dummy_task, l->object);
+      this->do_merge_pending_input(i);
+    }
+
+  this->data_size_ = this->set_string_offsets();
 
   for (typename Merged_strings_lists::const_iterator l =
 	 this->merged_strings_lists_.begin();
@@ -571,19 +971,19 @@ Output_merge_string<Char_type>::finalize_merged_data()
 	    input_merge_map->add_mapping(last_input_offset, length,
                                          last_output_offset);
 	  last_input_offset = p->offset;
-	  if (p->stringpool_key != 0)
-	    last_output_offset =
-	        this->stringpool_.get_offset_from_key(p->stringpool_key);
+	  if (p->entry != NULL)
+	    last_output_offset = p->entry->offset;
 	}
+
+      this->input_count_ += (*l)->input_count;
+      this->input_size_ += (*l)->input_size;
       delete *l;
     }
 
-  // Save some memory.  This also ensures that this function will work
-  // if called twice, as may happen if Layout::set_segment_offsets
-  // finds a better alignment.
+  // Save some memory.
   this->merged_strings_lists_.clear();
 
-  return this->stringpool_.get_strtab_size();
+  return this->data_size_;
 }
 
 template<typename Char_type>
@@ -600,7 +1000,12 @@ template<typename Char_type>
 void
 Output_merge_string<Char_type>::do_write(Output_file* of)
 {
-  this->stringpool_.write(of, this->offset());
+  const section_size_type size = this->data_size();
+  if (size == 0)
+    return;
+  unsigned char* view = of->get_output_view(this->offset(), size);
+  this->do_write_to_buffer(view);
+  of->write_output_view(this->offset(), size, view);
 }
 
 // Write a merged string section to a buffer.
@@ -609,7 +1014,20 @@ template<typename Char_type>
 void
 Output_merge_string<Char_type>::do_write_to_buffer(unsigned char* buffer)
 {
-  this->stringpool_.write_to_buffer(buffer, this->data_size());
+  for (typename std::vector<String_shard>::const_iterator p =
+	 this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    for (typename std::deque<String_entry>::const_iterator q =
+	   p->entries.begin();
+	 q != p->entries.end();
+	 ++q)
+      {
+	const section_size_type len = (q->length + 1) * sizeof(Char_type);
+	gold_assert(static_cast<section_size_type>(q->offset) + len
+		    <= this->data_size_);
+	memcpy(buffer + q->offset, q->string, len);
+      }
 }
 
 // Return the name of the types of string to use with
@@ -632,14 +1050,14 @@ Output_merge_string<char>::string_name()
 
 template<>
 const char*
-Output_merge_string<uint16_t>::string_name()
+Output_merge_string<char16_t>::string_name()
 {
   return "16-bit strings";
 }
 
 template<>
 const char*
-Output_merge_string<uint32_t>::string_name()
+Output_merge_string<char32_t>::string_name()
 {
   return "32-bit strings";
 }
@@ -656,7 +1074,14 @@ Output_merge_string<Char_type>::do_print_merge_stats(const char* section_name)
 	  program_name, buf, this->input_size_);
   fprintf(stderr, _("%s: %s input strings: %zu\n"),
 	  program_name, buf, this->input_count_);
-  this->stringpool_.print_stats(buf);
+  size_t entries = 0;
+  for (typename std::vector<String_shard>::const_iterator p =
+	 this->shards_.begin();
+       p != this->shards_.end();
+       ++p)
+    entries += p->entries.size();
+  fprintf(stderr, _("%s: %s entries: %zu; shards: %zu\n"),
+	  program_name, buf, entries, this->shards_.size());
 }
 
 // Instantiate the templates we need.
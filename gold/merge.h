@@ -24,6 +24,8 @@
 #define GOLD_MERGE_H
 
 #include <climits>
+#include <cstring>
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -33,6 +35,10 @@
 namespace gold
 {
 
+class Workqueue;
+class Task_token;
+class Lock;
+
 // For each object with merge sections, we store an Object_merge_map.
 // This is used to map locations in input sections to a merged output
 // section.  The output section itself is not recorded here--it can be
@@ -72,6 +78,12 @@ class Object_merge_map
   const Output_section_data*
   find_merge_section(unsigned int shndx) const;
 
+  // Sort the mappings of every input section.  After this,
+  // get_output_offset does not change the maps, so several threads
+  // may call it at the same time.
+  void
+  sort_input_merge_maps();
+
   // Initialize an mapping from input offsets to output addresses for
   // section SHNDX.  STARTING_ADDRESS is the output address of the
   // merged section.
@@ -235,6 +247,29 @@ class Output_merge_base : public Output_section_data
     gold_assert(this->keeps_input_sections_);
     return this->input_sections_.end();
   }
+
+  // The input sections whose contents have not been merged yet, as
+  // pairs of the object and an index private to the merge section.
+  typedef std::vector<std::pair<Relobj*, unsigned int> > Pending_inputs;
+
+  // Add the pending input sections to *PENDING.
+  void
+  get_pending_inputs(Pending_inputs* pending)
+  { this->do_get_pending_inputs(pending); }
+
+  // Merge the contents of pending input section INDEX.  The object
+  // must be locked.  This may be called for different input sections
+  // at the same time.
+  void
+  merge_pending_input(unsigned int index)
+  { this->do_merge_pending_input(index); }
+
+  // Queue tasks on WORKQUEUE to merge the pending input sections of
+  // SECTIONS, one for each object.  Each task unblocks BLOCKER when it
+  // is done.
+  static void
+  queue_merge_tasks(const std::vector<Output_merge_base*>& sections,
+		    Workqueue* workqueue, Task_token* blocker);
  
  protected:
   // Return the output offset for an input offset.
@@ -253,6 +288,17 @@ class Output_merge_base : public Output_section_data
   do_set_keeps_input_sections()
   { this->keeps_input_sections_ = true; }
 
+  // This may be overridden by the child class.
+  virtual void
+  do_get_pending_inputs(Pending_inputs*)
+  { }
+
+  // This must be overridden by a child class which has pending input
+  // sections.
+  virtual void
+  do_merge_pending_input(unsigned int)
+  { gold_unreachable(); }
+
   // Record the merged input section for script processing.
   void
   record_input_section(Relobj* relobj, unsigned int shndx);
@@ -400,12 +446,9 @@ template<typename Char_type>
 class Output_merge_string : public Output_merge_base
 {
  public:
-  Output_merge_string(uint64_t addralign)
-    : Output_merge_base(sizeof(Char_type), addralign), stringpool_(addralign),
-      merged_strings_lists_(), input_count_(0), input_size_(0)
-  {
-    this->stringpool_.set_no_zero_null();
-  }
+  Output_merge_string(uint64_t addralign);
+
+  ~Output_merge_string();
 
  protected:
   // Add an input section.
@@ -438,16 +481,6 @@ class Output_merge_string : public Output_merge_base
   void
   do_print_merge_stats(const char* section_name);
 
-  // Writes the stringpool to a buffer.
-  void
-  stringpool_to_buffer(unsigned char* buffer, section_size_type buffer_size)
-  { this->stringpool_.write_to_buffer(buffer, buffer_size); }
-
-  // Clears all the data in the stringpool, to save on memory.
-  void
-  clear_stringpool()
-  { this->stringpool_.clear(); }
-
   // Whether this is a merge string section.
   virtual bool
   do_is_string()
@@ -457,26 +490,131 @@ class Output_merge_string : public Output_merge_base
   void
   do_set_keeps_input_sections()
   {
-    gold_assert(this->input_count_ == 0);
+    gold_assert(this->merged_strings_lists_.empty());
     Output_merge_base::do_set_keeps_input_sections();
   }
 
+  // Add the input sections whose strings have not been added yet.
+  void
+  do_get_pending_inputs(Pending_inputs*);
+
+  // Add the strings of an input section.
+  void
+  do_merge_pending_input(unsigned int index);
+
  private:
   // The name of the string type, for stats.
   const char*
   string_name();
 
+  // A unique string in the output section.
+  struct String_entry
+  {
+    // The string, which is null terminated.
+    const Char_type* string;
+    // The length of the string in characters.
+    size_t length;
+    // The hash code of the string.
+    size_t hash_code;
+    // The position of the first occurrence of the string in the
+    // input sections: the index of the input section in the high 32
+    // bits, and the index of the string in the section in the low 32
+    // bits.  Strings are laid out in the order of their first
+    // occurrence, as they would be if they were added one at a time.
+    uint64_t first_seen;
+    // The offset of the string in the output section.
+    section_offset_type offset;
+  };
+
+  struct String_entry_hash
+  {
+    size_t
+    operator()(const String_entry* e) const
+    { return e->hash_code; }
+  };
+
+  struct String_entry_eq
+  {
+    bool
+    operator()(const String_entry* e1, const String_entry* e2) const
+    {
+      return (e1->hash_code == e2->hash_code
+	      && e1->length == e2->length
+	      && memcmp(e1->string, e2->string,
+			e1->length * sizeof(Char_type)) == 0);
+    }
+  };
+
+  typedef Unordered_set<String_entry*, String_entry_hash, String_entry_eq>
+    String_set;
+
+  // The unique strings are split into shards by hash code, so that
+  // input sections can be added at the same time.  Each shard owns the
+  // copies of its strings.
+  struct String_shard
+  {
+    String_shard()
+      : lock(NULL), strings(), entries(), buffers(), buffer_left(0)
+    { }
+
+    // Lock held while adding strings to the shard.
+    Lock* lock;
+    // The strings in the shard.
+    String_set strings;
+    // The entries of STRINGS.  Elements of a deque do not move.
+    std::deque<String_entry> entries;
+    // Buffers holding the copies of the strings.
+    std::vector<Char_type*> buffers;
+    // The number of characters left in the last buffer.
+    size_t buffer_left;
+  };
+
+  // The number of shards.  This must be a power of two.
+  static const unsigned int shard_count = 64;
+
+  // Return the shard for a string with hash code HASH_CODE.
+  static unsigned int
+  shard_index(size_t hash_code)
+  {
+    uint32_t h = static_cast<uint32_t>(hash_code ^ (hash_code >> 16));
+    h *= 0x45d9f3bU;
+    return (h >> 16) & (shard_count - 1);
+  }
+
+  // Copy a string of LENGTH characters into the buffers of SHARD, and
+  // null terminate it.
+  static const Char_type*
+  copy_string(String_shard* shard, const Char_type* s, size_t length);
+
+  // Return whether S1 is a suffix of S2.
+  static bool
+  is_suffix(const String_entry* s1, const String_entry* s2);
+
+  // Sort order used to find strings which are suffixes of other
+  // strings.
+  struct String_entry_suffix_less
+  {
+    bool
+    operator()(const String_entry*, const String_entry*) const;
+  };
+
+  // Set the output offsets of the strings.  Returns the size of the
+  // section.
+  section_size_type
+  set_string_offsets();
+
   // As we see input sections, we build a mapping from object, section
   // index and offset to strings.
   struct Merged_string
   {
     // The offset in the input section.
     section_offset_type offset;
-    // The key in the Stringpool.
-    Stringpool::Key stringpool_key;
+    // The string, or NULL for the entry which records the end of the
+    // input section.
+    String_entry* entry;
 
-    Merged_string(section_offset_type offseta, Stringpool::Key stringpool_keya)
-      : offset(offseta), stringpool_key(stringpool_keya)
+    Merged_string(section_offset_type offseta, String_entry* entrya)
+      : offset(offseta), entry(entrya)
     { }
   };
 
@@ -488,21 +626,32 @@ class Output_merge_string : public Output_merge_base
     Relobj* object;
     // The input section in the input object.
     unsigned int shndx;
+    // Whether the strings have been added.
+    bool is_merged;
+    // The number of non-null strings in the input section.
+    size_t input_count;
+    // The size of the input section.
+    size_t input_size;
     // The list of merged strings.
     Merged_strings merged_strings;
 
     Merged_strings_list(Relobj* objecta, unsigned int shndxa)
-      : object(objecta), shndx(shndxa), merged_strings()
+      : object(objecta), shndx(shndxa), is_merged(false), input_count(0),
+	input_size(0), merged_strings()
     { }
   };
 
   typedef std::vector<Merged_strings_list*> Merged_strings_lists;
 
-  // As we see the strings, we add them to a Stringpool.
-  Stringpool_template<Char_type> stringpool_;
-  // Map from a location in an input object to an entry in the
-  // Stringpool.
+  // The shards holding the unique strings.  This is empty until the
+  // first input section is added.
+  std::vector<String_shard> shards_;
+  // Map from a location in an input object to a string.
   Merged_strings_lists merged_strings_lists_;
+  // Whether to look for strings which are suffixes of other strings.
+  bool optimize_;
+  // The size of the section, once the string offsets are set.
+  section_size_type data_size_;
   // The number of entries seen in input files.
   size_t input_count_;
   // The total size of input sections.
@@ -42,6 +42,7 @@
 #include "compressed_output.h"
 #include "incremental.h"
 #include "merge.h"
+#include "call-graph.h"
 
 namespace gold
 {
@@ -350,6 +351,23 @@ Relobj::copy_symbols_data(Symbols_data* gc_sd, Read_symbols_data* sd,
   gc_sd->symbol_names_size = sd->symbol_names_size;
 }
 
+// Free the data saved by copy_symbols_data.  After the second layout
+// pass, the section flags are read from the file instead.
+
+void
+Relobj::free_symbols_data()
+{
+  Symbols_data* gc_sd = this->sd_;
+  if (gc_sd == NULL)
+    return;
+  delete[] gc_sd->section_headers_data;
+  delete[] gc_sd->section_names_data;
+  delete[] gc_sd->symbols_data;
+  delete[] gc_sd->symbol_names_data;
+  delete gc_sd;
+  this->sd_ = NULL;
+}
+
 // This function determines if a particular section name must be included
 // in the link.  This is used during garbage collection to determine the
 // roots of the worklist.
@@ -414,6 +432,24 @@ Relobj::get_or_create_merge_map()
   return this->object_merge_map_;
 }
 
+void
+Relobj::sort_merge_map()
+{
+  if (this->object_merge_map_ != NULL)
+    this->object_merge_map_->sort_input_merge_maps();
+}
+
+// Free the data which is only used to relocate this object.
+
+void
+Relobj::release_link_state()
+{
+  delete this->object_merge_map_;
+  this->object_merge_map_ = NULL;
+  this->do_release_link_state();
+  this->link_arena_.release();
+}
+
 // Class Sized_relobj.
 
 // Iterate over local symbols, calling a visitor class V for each GOT offset
@@ -474,7 +510,9 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
     defined_count_(0),
     local_symbol_offset_(0),
     local_dynsym_offset_(0),
-    local_values_(),
+    local_values_(Arena_allocator<Symbol_value<size> >(this->link_arena())),
+    precomputed_locals_(),
+    has_precomputed_locals_(false),
     local_plt_offsets_(),
     kept_comdat_sections_(),
     has_eh_frame_(false),
@@ -2272,6 +2310,213 @@ Sized_relobj_file<size, big_endian>::set_local_plt_offset(
   gold_assert(ins.second);
 }
 
+// Add the edges of the .llvm.call-graph-profile sections of this
+// object to CALL_GRAPH.  Since LLVM 13 the section holds the weight of
+// each edge, and a pair of relocations gives the caller and the
+// callee.  Before that, each entry of the section held the symbol
+// indexes of the caller and the callee along with the weight.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_read_call_graph_profile(
+    const Symbol_table* symtab,
+    Call_graph* call_graph)
+{
+  const unsigned int shnum = this->shnum();
+  if (this->symtab_shndx_ == 0 || this->symtab_shndx_ == -1U)
+    return;
+
+  const unsigned char* pshdrs = this->get_view(this->elf_file_.shoff(),
+					       shnum * This::shdr_size,
+					       true, true);
+
+  // Find the profile sections, and the relocation sections which
+  // apply to them.
+  std::vector<unsigned int> profile_shndx;
+  const unsigned char* p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      if (shdr.get_sh_type() == elfcpp::SHT_LLVM_CALL_GRAPH_PROFILE)
+	profile_shndx.push_back(i);
+    }
+  if (profile_shndx.empty())
+    return;
+
+  std::vector<unsigned int> reloc_shndx(profile_shndx.size(), 0);
+  p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      if (shdr.get_sh_type() != elfcpp::SHT_REL
+	  && shdr.get_sh_type() != elfcpp::SHT_RELA)
+	continue;
+      unsigned int info = this->adjust_shndx(shdr.get_sh_info());
+      for (size_t j = 0; j < profile_shndx.size(); ++j)
+	if (profile_shndx[j] == info)
+	  reloc_shndx[j] = i;
+    }
+
+  // The symbol indexes of the callers and callees, and the weights.
+  std::vector<std::pair<unsigned int, unsigned int> > calls;
+  std::vector<uint64_t> weights;
+  for (size_t j = 0; j < profile_shndx.size(); ++j)
+    {
+      typename This::Shdr shdr(pshdrs + profile_shndx[j] * This::shdr_size);
+      section_size_type contents_size =
+	convert_to_section_size_type(shdr.get_sh_size());
+      const unsigned char* pcontents = this->get_view(shdr.get_sh_offset(),
+						      contents_size,
+						      true, false);
+      if (reloc_shndx[j] != 0)
+	{
+	  typename This::Shdr rshdr(pshdrs + reloc_shndx[j] * This::shdr_size);
+	  const unsigned int reloc_size =
+	    (rshdr.get_sh_type() == elfcpp::SHT_REL
+	     ? elfcpp::Elf_sizes<size>::rel_size
+	     : elfcpp::Elf_sizes<size>::rela_size);
+	  size_t count = contents_size / 8;
+	  if (rshdr.get_sh_size() / reloc_size != 2 * count)
+	    {
+	      gold_warning(_("%s: ignoring malformed call graph profile "
+			     "section %u"),
+			   this->name().c_str(), profile_shndx[j]);
+	      continue;
+	    }
+	  const unsigned char* prelocs =
+	    this->get_view(rshdr.get_sh_offset(), rshdr.get_sh_size(),
+			   true, false);
+	  for (size_t k = 0; k < count; ++k, prelocs += 2 * reloc_size)
+	    {
+	      // The r_info field is at the same offset in REL and RELA
+	      // relocations.
+	      elfcpp::Rel<size, big_endian> from(prelocs);
+	      elfcpp::Rel<size, big_endian> to(prelocs + reloc_size);
+	      calls.push_back(std::make_pair(
+		elfcpp::elf_r_sym<size>(from.get_r_info()),
+		elfcpp::elf_r_sym<size>(to.get_r_info())));
+	      weights.push_back(
+		elfcpp::Swap<64, big_endian>::readval(pcontents + 8 * k));
+	    }
+	}
+      else
+	{
+	  for (section_size_type off = 0;
+	       off + 16 <= contents_size;
+	       off += 16)
+	    {
+	      calls.push_back(std::make_pair(
+		elfcpp::Swap<32, big_endian>::readval(pcontents + off),
+		elfcpp::Swap<32, big_endian>::readval(pcontents + off + 4)));
+	      weights.push_back(
+		elfcpp::Swap<64, big_endian>::readval(pcontents + off + 8));
+	    }
+	}
+    }
+
+  // Find the sections which define the symbols.
+  typename This::Shdr symtabshdr(this,
+				 this->elf_file_.section_header(
+				   this->symtab_shndx_));
+  const unsigned int loccount = this->local_symbol_count_;
+  const unsigned char* plocsyms = this->get_view(symtabshdr.get_sh_offset(),
+						 loccount * This::sym_size,
+						 true, true);
+  const unsigned int symcount = loccount + this->symbols_.size();
+  for (size_t i = 0; i < calls.size(); ++i)
+    {
+      unsigned int symndx[2] = { calls[i].first, calls[i].second };
+      Section_id section[2];
+      bool found = true;
+      for (int j = 0; j < 2 && found; ++j)
+	{
+	  if (symndx[j] >= symcount)
+	    found = false;
+	  else if (symndx[j] < loccount)
+	    {
+	      elfcpp::Sym<size, big_endian> sym(plocsyms
+						+ symndx[j] * This::sym_size);
+	      bool is_ordinary;
+	      unsigned int shndx = this->adjust_sym_shndx(symndx[j],
+							  sym.get_st_shndx(),
+							  &is_ordinary);
+	      found = (is_ordinary
+		       && shndx != elfcpp::SHN_UNDEF
+		       && shndx < shnum);
+	      section[j] = Section_id(this, shndx);
+	    }
+	  else
+	    {
+	      const Symbol* gsym = this->global_symbol(symndx[j]);
+	      found = (gsym != NULL
+		       && Call_graph::symbol_section(symtab, gsym,
+						     &section[j]));
+	    }
+	}
+      if (found)
+	call_graph->add_edge(section[0], section[1], weights[i]);
+    }
+}
+
+// Tell CALL_GRAPH which sections define the local symbols of this
+// object.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_find_call_graph_local_symbols(
+    Call_graph* call_graph)
+{
+  if (this->symtab_shndx_ == 0 || this->symtab_shndx_ == -1U)
+    return;
+
+  typename This::Shdr symtabshdr(this,
+				 this->elf_file_.section_header(
+				   this->symtab_shndx_));
+  const unsigned int loccount = this->local_symbol_count_;
+  const unsigned char* psyms = this->get_view(symtabshdr.get_sh_offset(),
+					      loccount * This::sym_size,
+					      true, true);
+
+  const unsigned int strtab_shndx =
+    this->adjust_shndx(symtabshdr.get_sh_link());
+  section_size_type strtab_size;
+  const unsigned char* pnamesu = this->section_contents(strtab_shndx,
+							&strtab_size,
+							true);
+  const char* pnames = reinterpret_cast<const char*>(pnamesu);
+
+  const unsigned int shnum = this->shnum();
+  psyms += This::sym_size;
+  for (unsigned int i = 1; i < loccount; ++i, psyms += This::sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(psyms);
+      if (sym.get_st_type() == elfcpp::STT_SECTION
+	  || sym.get_st_name() >= strtab_size)
+	continue;
+      bool is_ordinary;
+      unsigned int shndx = this->adjust_sym_shndx(i, sym.get_st_shndx(),
+						  &is_ordinary);
+      if (!is_ordinary || shndx == elfcpp::SHN_UNDEF || shndx >= shnum)
+	continue;
+      call_graph->add_local_symbol(pnames + sym.get_st_name(),
+				   Section_id(this, shndx));
+    }
+}
+
+// Drop the local symbol values and the local GOT and PLT offsets,
+// once the object has been relocated.  The local symbols have
+// already been written out.  The memory of the containers which use
+// the link arena is freed when the caller releases the arena.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_release_link_state()
+{
+  Local_values(this->local_values_.get_allocator()).swap(this->local_values_);
+  Local_plt_offsets().swap(this->local_plt_offsets_);
+  this->free_local_got_offsets();
+}
+
 // First pass over the local symbols.  Here we add their names to
 // *POOL and *DYNPOOL, and we store the symbol value in
 // THIS->LOCAL_VALUES_.  This function is always called from a
@@ -2632,6 +2877,23 @@ Sized_relobj_file<size, big_endian>::do_finalize_local_symbols(
   const unsigned int loccount = this->local_symbol_count_;
   this->local_symbol_offset_ = off;
 
+  // If the values are already set, we only need to assign the
+  // indexes.
+  if (this->has_precomputed_locals_)
+    {
+      for (std::vector<unsigned int>::const_iterator p =
+	     this->precomputed_locals_.begin();
+	   p != this->precomputed_locals_.end();
+	   ++p)
+	{
+	  this->local_values_[*p].set_output_symtab_index(index);
+	  ++index;
+	}
+      std::vector<unsigned int>().swap(this->precomputed_locals_);
+      this->has_precomputed_locals_ = false;
+      return index;
+    }
+
   const bool relocatable = parameters->options().relocatable();
   const Output_sections& out_sections(this->output_sections());
   const std::vector<Address>& out_offsets(this->section_offsets());
@@ -2668,6 +2930,55 @@ Sized_relobj_file<size, big_endian>::do_finalize_local_symbols(
   return index;
 }
 
+// Set the final values of the local symbols ahead of
+// do_finalize_local_symbols, and record which of them need an output
+// symbol table index.  This does the same as do_finalize_local_symbols
+// apart from setting the indexes, which depend upon the objects
+// before this one.
+
+template<int size, bool big_endian>
+bool
+Sized_relobj_file<size, big_endian>::do_precompute_local_symbols(
+    const Symbol_table* symtab,
+    unsigned int* count,
+    bool* has_gnu_output)
+{
+  gold_assert(!this->has_precomputed_locals_);
+
+  const unsigned int loccount = this->local_symbol_count_;
+  const bool relocatable = parameters->options().relocatable();
+  const Output_sections& out_sections(this->output_sections());
+  const std::vector<Address>& out_offsets(this->section_offsets());
+
+  *has_gnu_output = false;
+  for (unsigned int i = 1; i < loccount; ++i)
+    {
+      Symbol_value<size>* lv = &this->local_values_[i];
+
+      Compute_final_local_value_status cflv_status =
+	this->compute_final_local_value_internal(i, lv, lv, relocatable,
+						 out_sections, out_offsets,
+						 symtab);
+      if (cflv_status != CFLV_OK)
+	continue;
+      bool has_output_symtab_entry;
+      if (lv->is_output_symtab_index_set())
+	has_output_symtab_entry = lv->has_output_symtab_entry();
+      else
+	{
+	  this->precomputed_locals_.push_back(i);
+	  has_output_symtab_entry = true;
+	}
+      if (lv->is_ifunc_symbol()
+	  && (has_output_symtab_entry || lv->needs_output_dynsym_entry()))
+	*has_gnu_output = true;
+    }
+
+  *count = this->precomputed_locals_.size();
+  this->has_precomputed_locals_ = true;
+  return true;
+}
+
 // Set the output dynamic symbol table indexes for the local variables.
 
 template<int size, bool big_endian>
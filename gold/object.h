@@ -23,11 +23,13 @@
 #ifndef GOLD_OBJECT_H
 #define GOLD_OBJECT_H
 
+#include <new>
 #include <string>
 #include <vector>
 
 #include "elfcpp.h"
 #include "elfcpp_file.h"
+#include "arena.h"
 #include "fileread.h"
 #include "target.h"
 #include "archive.h"
@@ -49,6 +51,7 @@ class Pluginobj;
 class Dynobj;
 class Object_merge_map;
 class Relocatable_relocs;
+class Call_graph;
 struct Symbols_data;
 
 template<typename Stringpool_char>
@@ -107,17 +110,51 @@ struct Symbol_location_info
   elfcpp::STT enclosing_symbol_type;
 };
 
+// A request to the target made while the relocs of an object are
+// read, saying what to do with one reloc when the relocs are
+// scanned.  The requests for all the objects are made in parallel,
+// and then carried out one object at a time, in input order, so
+// that the GOT and PLT entries and the dynamic relocs are created in
+// the same order as without threads.
+
+struct Reloc_request
+{
+  // The kinds of request which all targets understand.  A target may
+  // define its own kinds, starting at FIRST_TARGET_KIND.
+  enum
+  {
+    // Scan the reloc as usual.
+    SCAN,
+    // The first kind for the target.
+    FIRST_TARGET_KIND
+  };
+
+  Reloc_request(unsigned int i, unsigned int k)
+    : index(i), kind(k)
+  { }
+
+  // Index of the reloc in the reloc section.
+  unsigned int index;
+  // What to do with the reloc.
+  unsigned int kind;
+};
+
+typedef std::vector<Reloc_request> Reloc_requests;
+
 // Data about a single relocation section.  This is read in
 // read_relocs and processed in scan_relocs.
 
 struct Section_relocs
 {
   Section_relocs()
-    : contents(NULL)
+    : contents(NULL), scan_requests(NULL)
   { }
 
   ~Section_relocs()
-  { delete this->contents; }
+  {
+    delete this->contents;
+    delete this->scan_requests;
+  }
 
   // Index of reloc section.
   unsigned int reloc_shndx;
@@ -135,6 +172,10 @@ struct Section_relocs
   bool needs_special_offset_handling;
   // Whether the data section is allocated (has the SHF_ALLOC flag set).
   bool is_data_section_allocated;
+  // If not NULL, what to do with each reloc when scanning, as chosen
+  // by Sized_target::prescan_relocs.  Relocs with no request are
+  // dropped.
+  Reloc_requests* scan_requests;
 };
 
 // Relocations in an object file.  This is read in read_relocs and
@@ -242,9 +283,12 @@ class Got_offset_list
     this->got_next_ = NULL;
   }
 
-  // Set the offset for the GOT entry of type GOT_TYPE.
+  // Set the offset for the GOT entry of type GOT_TYPE.  If ARENA is
+  // not NULL, a new entry is allocated in it, and the list must then
+  // never be deleted.
   void
-  set_offset(unsigned int got_type, unsigned int got_offset, uint64_t addend)
+  set_offset(unsigned int got_type, unsigned int got_offset, uint64_t addend,
+	     Arena* arena = NULL)
   {
     if (this->got_type_ == -1U)
       {
@@ -262,7 +306,12 @@ class Got_offset_list
                 return;
               }
           }
-        Got_offset_list* g = new Got_offset_list(got_type, got_offset, addend);
+        Got_offset_list* g;
+        if (arena == NULL)
+          g = new Got_offset_list(got_type, got_offset, addend);
+        else
+          g = new(arena->allocate(sizeof(Got_offset_list)))
+            Got_offset_list(got_type, got_offset, addend);
         g->got_next_ = this->got_next_;
         this->got_next_ = g;
       }
@@ -799,6 +848,14 @@ class Object
       this->input_file_->file().clear_view_cache_marks();
   }
 
+  // Release the pages of the mapped views of the underlying file.
+  void
+  release_pages()
+  {
+    if (this->input_file_ != NULL)
+      this->input_file_->file().release_pages();
+  }
+
   // Get the number of global symbols defined by this object, and the
   // number of the symbols whose final definition came from this
   // object.
@@ -1145,6 +1202,7 @@ class Relobj : public Object
       output_sections_(),
       map_to_relocatable_relocs_(NULL),
       object_merge_map_(NULL),
+      link_arena_(),
       relocs_must_follow_section_writes_(false),
       sd_(NULL),
       reloc_counts_(NULL),
@@ -1173,6 +1231,12 @@ class Relobj : public Object
   set_symbols_data(Symbols_data* sd)
   { this->sd_ = sd; }
 
+  // Free the symbols data saved for the second layout pass, once that
+  // pass is done.  This is only done for --no-keep-memory;
+  // section_entsize may not be called afterward.
+  void
+  free_symbols_data();
+
   // During garbage collection, the Read_relocs pass for all objects 
   // is done before scanning the relocs.  In that case, this->rd_ is
   // used to store the information from Read_relocs for each object.
@@ -1193,6 +1257,24 @@ class Relobj : public Object
   read_relocs(Read_relocs_data* rd)
   { return this->do_read_relocs(rd); }
 
+  // Start reading in the background the parts of the file which the
+  // relocation tasks will need.  This is used for --readahead.
+  void
+  prefetch_sections()
+  { this->do_prefetch_sections(); }
+
+  // Add the edges of the call graph profile sections of this object
+  // to CALL_GRAPH.  This is used for --call-graph-profile-sort.
+  void
+  read_call_graph_profile(const Symbol_table* symtab, Call_graph* call_graph)
+  { this->do_read_call_graph_profile(symtab, call_graph); }
+
+  // Tell CALL_GRAPH which sections define the local symbols of this
+  // object.  This is used for --call-graph-ordering-file.
+  void
+  find_call_graph_local_symbols(Call_graph* call_graph)
+  { this->do_find_call_graph_local_symbols(call_graph); }
+
   // Process the relocs, during garbage collection only.
   void
   gc_process_relocs(Symbol_table* symtab, Layout* layout, Read_relocs_data* rd)
@@ -1274,6 +1356,18 @@ class Relobj : public Object
   finalize_local_symbols(unsigned int index, off_t off, Symbol_table* symtab)
   { return this->do_finalize_local_symbols(index, off, symtab); }
 
+  // Set the values of the local symbols ahead of finalize_local_symbols,
+  // which then only has to set the output symbol table indexes.  Set
+  // *COUNT to the number of local symbols which get an index, and set
+  // *HAS_GNU_OUTPUT if any of them requires ELFOSABI_GNU.  This may
+  // be called for several objects at once.  Returns false if the
+  // object does not support this, in which case finalize_local_symbols
+  // does all the work.
+  bool
+  precompute_local_symbols(const Symbol_table* symtab, unsigned int* count,
+			   bool* has_gnu_output)
+  { return this->do_precompute_local_symbols(symtab, count, has_gnu_output); }
+
   // Set the output dynamic symbol table indexes for the local variables.
   unsigned int
   set_local_dynsym_indexes(unsigned int index)
@@ -1308,6 +1402,14 @@ class Relobj : public Object
   relocate(const Symbol_table* symtab, const Layout* layout, Output_file* of)
   { return this->do_relocate(symtab, layout, of); }
 
+  // Free the data which is only used to relocate this object: the
+  // link arena, which holds the local symbol values and the local GOT
+  // offsets, the local PLT offsets and the merge mappings.  This is
+  // called for --no-keep-memory once the object has been relocated
+  // and the output sections have been written.
+  void
+  release_link_state();
+
   // Return whether an input section is being included in the link.
   bool
   is_section_included(unsigned int shndx) const
@@ -1342,6 +1444,11 @@ class Relobj : public Object
   Object_merge_map*
   get_or_create_merge_map();
 
+  // Prepare the merge mappings of this object for lookups from
+  // several threads at once.
+  void
+  sort_merge_map();
+
   template<int size>
   void
   initialize_input_to_output_map(unsigned int shndx,
@@ -1414,6 +1521,28 @@ class Relobj : public Object
   virtual void
   do_read_relocs(Read_relocs_data*) = 0;
 
+  // Prefetch the sections--may be implemented by child class.
+  virtual void
+  do_prefetch_sections()
+  { }
+
+  // Read the call graph profile--may be implemented by child class.
+  virtual void
+  do_read_call_graph_profile(const Symbol_table*, Call_graph*)
+  { }
+
+  // Free the data used to relocate the object--may be implemented by
+  // child class.
+  virtual void
+  do_release_link_state()
+  { }
+
+  // Find the local symbols for the call graph--may be implemented by
+  // child class.
+  virtual void
+  do_find_call_graph_local_symbols(Call_graph*)
+  { }
+
   // Process the relocs--implemented by child class.
   virtual void
   do_gc_process_relocs(Symbol_table*, Layout*, Read_relocs_data*) = 0;
@@ -1473,6 +1602,13 @@ class Relobj : public Object
   virtual unsigned int
   do_finalize_local_symbols(unsigned int, off_t, Symbol_table*) = 0;
 
+  // Set the values of the local symbols ahead of
+  // do_finalize_local_symbols.  This may be overridden by the child
+  // class.
+  virtual bool
+  do_precompute_local_symbols(const Symbol_table*, unsigned int*, bool*)
+  { return false; }
+
   // Set the output dynamic symbol table indexes for the local variables.
   virtual unsigned int
   do_set_local_dynsym_indexes(unsigned int) = 0;
@@ -1528,6 +1664,12 @@ class Relobj : public Object
   set_relocs_must_follow_section_writes()
   { this->relocs_must_follow_section_writes_ = true; }
 
+  // Return the arena for the data which is only used to relocate
+  // this object.  It is released by release_link_state.
+  Arena*
+  link_arena()
+  { return &this->link_arena_; }
+
   // Allocate the array for counting incremental relocations.
   void
   allocate_incremental_reloc_counts()
@@ -1587,6 +1729,8 @@ class Relobj : public Object
   // Mappings for merge sections.  This is managed by the code in the
   // Merge_map class.
   Object_merge_map* object_merge_map_;
+  // Storage for the data which is only used to relocate this object.
+  Arena link_arena_;
   // Whether we need to wait for output sections to be written before
   // we can apply relocations.
   bool relocs_must_follow_section_writes_;
@@ -2026,12 +2170,20 @@ class Sized_relobj : public Relobj
   static const Address invalid_address = static_cast<Address>(0) - 1;
 
   Sized_relobj(const std::string& name, Input_file* input_file)
-    : Relobj(name, input_file), local_got_offsets_(), section_offsets_()
+    : Relobj(name, input_file),
+      local_got_offsets_(0, Local_got_entry_key::hash(),
+			 Local_got_entry_key::equal_to(),
+			 Local_got_offsets_allocator(this->link_arena())),
+      section_offsets_()
   { }
 
   Sized_relobj(const std::string& name, Input_file* input_file,
 		    off_t offset)
-    : Relobj(name, input_file, offset), local_got_offsets_(), section_offsets_()
+    : Relobj(name, input_file, offset),
+      local_got_offsets_(0, Local_got_entry_key::hash(),
+			 Local_got_entry_key::equal_to(),
+			 Local_got_offsets_allocator(this->link_arena())),
+      section_offsets_()
   { }
 
   ~Sized_relobj()
@@ -2145,16 +2297,29 @@ class Sized_relobj : public Relobj
     Local_got_offsets::const_iterator p =
         this->local_got_offsets_.find(key);
     if (p != this->local_got_offsets_.end())
-      p->second->set_offset(got_type, got_offset, addend);
+      p->second->set_offset(got_type, got_offset, addend, this->link_arena());
     else
       {
-	Got_offset_list* g = new Got_offset_list(got_type, got_offset, addend);
+	Got_offset_list* g =
+	  new(this->link_arena()->allocate(sizeof(Got_offset_list)))
+	    Got_offset_list(got_type, got_offset, addend);
         std::pair<Local_got_offsets::iterator, bool> ins =
             this->local_got_offsets_.insert(std::make_pair(key, g));
         gold_assert(ins.second);
       }
   }
 
+  // Forget the GOT offsets of the local symbols.  They are in the link
+  // arena, so they are freed when it is released.
+  void
+  free_local_got_offsets()
+  {
+    Local_got_offsets(0, Local_got_entry_key::hash(),
+		      Local_got_entry_key::equal_to(),
+		      Local_got_offsets_allocator(this->link_arena()))
+      .swap(this->local_got_offsets_);
+  }
+
   // Return the word size of the object file.
   virtual int
   do_elfsize() const
@@ -2167,10 +2332,15 @@ class Sized_relobj : public Relobj
 
  private:
   // The GOT offsets of local symbols. This map also stores GOT offsets
-  // for tp-relative offsets for TLS symbols.
+  // for tp-relative offsets for TLS symbols.  The map and the
+  // Got_offset_list entries are allocated in the link arena.
+  typedef Arena_allocator<std::pair<const Local_got_entry_key,
+				    Got_offset_list*> >
+    Local_got_offsets_allocator;
   typedef Unordered_map<Local_got_entry_key, Got_offset_list*,
                         Local_got_entry_key::hash,
-                        Local_got_entry_key::equal_to> Local_got_offsets;
+                        Local_got_entry_key::equal_to,
+			Local_got_offsets_allocator> Local_got_offsets;
 
   // GOT offsets for local non-TLS symbols, and tp-relative offsets
   // for TLS symbols, indexed by local got entry key class.
@@ -2189,7 +2359,8 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
  public:
   typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
   typedef typename Sized_relobj<size, big_endian>::Symbols Symbols;
-  typedef std::vector<Symbol_value<size> > Local_values;
+  typedef std::vector<Symbol_value<size>,
+		      Arena_allocator<Symbol_value<size> > > Local_values;
 
   static const Address invalid_address = static_cast<Address>(0) - 1;
 
@@ -2446,6 +2617,22 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_read_relocs(Read_relocs_data*);
 
+  // Prefetch the sections used by the relocation tasks.
+  void
+  do_prefetch_sections();
+
+  // Read the call graph profile sections.
+  void
+  do_read_call_graph_profile(const Symbol_table*, Call_graph*);
+
+  // Free the local symbol values and the local GOT and PLT offsets.
+  void
+  do_release_link_state();
+
+  // Find the local symbols for the call graph.
+  void
+  do_find_call_graph_local_symbols(Call_graph*);
+
   // Process the relocs to find list of referenced sections. Used only
   // during garbage collection.
   void
@@ -2464,6 +2651,11 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   unsigned int
   do_finalize_local_symbols(unsigned int, off_t, Symbol_table*);
 
+  // Set the values of the local symbols ahead of
+  // do_finalize_local_symbols.
+  bool
+  do_precompute_local_symbols(const Symbol_table*, unsigned int*, bool*);
+
   // Set the offset where local dynamic symbol information will be stored.
   unsigned int
   do_set_local_dynsym_indexes(unsigned int);
@@ -2613,6 +2805,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 			 Views* pviews, unsigned int start_shndx,
 			 unsigned int end_shndx);
 
+  // Splits the sections of a large object into ranges which are
+  // relocated by several threads.
+  class Parallel_relocate;
+
   // Adjust this local symbol value.  Return false if the symbol
   // should be discarded from the output file.
   virtual bool
@@ -2898,6 +3094,11 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   off_t local_dynsym_offset_;
   // Values of local symbols.
   Local_values local_values_;
+  // The local symbols which need an output symbol table index, once
+  // their values were set by do_precompute_local_symbols.
+  std::vector<unsigned int> precomputed_locals_;
+  // Whether do_precompute_local_symbols was called.
+  bool has_precomputed_locals_;
   // PLT offsets for local symbols.
   Local_plt_offsets local_plt_offsets_;
   // Table mapping discarded comdat sections to corresponding kept sections.
@@ -1431,6 +1431,12 @@ General_options::finalize()
 			 "incremental link"));
 	  this->set_compress_debug_sections("none");
 	}
+      if (this->pack_relative_relocs())
+	{
+	  gold_warning(_("ignoring -z pack-relative-relocs for an "
+			 "incremental link"));
+	  this->set_pack_relative_relocs(false);
+	}
     }
 
 #ifndef HAVE_ZSTD
@@ -1442,6 +1448,14 @@ General_options::finalize()
     }
 #endif
 
+#ifndef WITH_XXHASH
+  if (strcmp(this->build_id(), "fast") == 0)
+    {
+      gold_error(_("--build-id=fast: gold is not built with xxhash support"));
+      this->set_build_id("none");
+    }
+#endif
+
   // --rosegment-gap implies --rosegment.
   if (this->user_set_rosegment_gap())
     this->set_rosegment(true);
@@ -698,6 +698,10 @@ class General_options
 	      N_("(aarch64 only) Do not apply link-time values "
 		 "for dynamic relocations"));
 
+  DEFINE_string(archive_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Cache the symbol maps of archives in DIRECTORY"),
+		N_("DIRECTORY"));
+
   DEFINE_bool(as_needed, options::TWO_DASHES, '\0', false,
 	      N_("Use DT_NEEDED only for shared libraries that are used"),
 	      N_("Use DT_NEEDED for all shared libraries"));
@@ -724,7 +728,8 @@ class General_options
 
   DEFINE_uint64(build_id_chunk_size_for_treehash,
 		options::TWO_DASHES, '\0', 2 << 20,
-		N_("Chunk size for '--build-id=tree'"), N_("SIZE"));
+		N_("Chunk size for '--build-id=tree' and '--build-id=fast'"),
+		N_("SIZE"));
 
   DEFINE_uint64(build_id_min_file_size_for_treehash, options::TWO_DASHES,
 		'\0', 40 << 20,
@@ -764,6 +769,16 @@ class General_options
 
   // c
 
+  DEFINE_string(call_graph_ordering_file, options::TWO_DASHES, '\0', NULL,
+		N_("Order functions by the weighted call graph in FILENAME, "
+		   "with lines of the form CALLER CALLEE WEIGHT"),
+		N_("FILENAME"));
+  DEFINE_bool(call_graph_profile_sort, options::TWO_DASHES, '\0', false,
+	      N_("Order functions by the call graph profile sections "
+		 "of the input files"),
+	      N_("Do not order functions by the call graph profile sections "
+		 "of the input files"));
+
   DEFINE_bool(check_sections, options::TWO_DASHES, '\0', true,
 	      N_("Check segment addresses for overlaps"),
 	      N_("Do not check segment addresses for overlaps"));
@@ -962,6 +977,14 @@ class General_options
 	      ("[none,all,safe]"), false,
 	      {"none", "all", "safe"});
 
+  DEFINE_enum(icf_algorithm, options::TWO_DASHES, '\0', "iterative",
+	      N_("ICF algorithm.  \'iterative\' compares sections up to"
+		 " --icf-iterations times; \'partition\' assumes candidate"
+		 " sections are identical and splits them until no more"
+		 " splits are possible"),
+	      ("[iterative,partition]"), false,
+	      {"iterative", "partition"});
+
   DEFINE_uint(icf_iterations, options::TWO_DASHES , '\0', 0,
 	      N_("Number of iterations of ICF (default 3)"), N_("COUNT"));
 
@@ -1025,6 +1048,11 @@ class General_options
 
   // l
 
+  DEFINE_bool(lazy_dynamic_symbols, options::TWO_DASHES, '\0', false,
+	      N_("Only add symbols from shared libraries when they are "
+		 "referenced"),
+	      N_("Add all symbols from shared libraries (default)"));
+
   DEFINE_special(library, options::TWO_DASHES, 'l',
 		 N_("Search for library LIBNAME"), N_("LIBNAME"));
 
@@ -1072,8 +1100,8 @@ class General_options
 	      N_("Page align data, make text readonly"));
 
   DEFINE_bool(no_keep_memory, options::TWO_DASHES, '\0', false,
-	      N_("Use less memory and more disk I/O "
-		 "(included only for compatibility with GNU ld)"), NULL);
+	      N_("Use less memory by freeing the data used to relocate "
+		 "each input file once it has been relocated"), NULL);
 
   DEFINE_bool_alias(no_undefined, defs, options::TWO_DASHES, '\0',
 		    N_("Report undefined symbols (even with --shared)"),
@@ -1110,6 +1138,11 @@ class General_options
 			 N_("Generate package metadata note"),
 			 N_("[=JSON]"));
 
+  DEFINE_uint64(parallel_relocate_min_size, options::TWO_DASHES, '\0',
+		4 << 20,
+		N_("Minimum size of the relocations of an input file for"
+		   " several threads to apply them"), N_("SIZE"));
+
   DEFINE_bool(pie, options::ONE_DASH, '\0', false,
 	      N_("Create a position independent executable"),
 	      N_("Do not create a position independent executable"));
@@ -1197,6 +1230,10 @@ class General_options
 
   // r
 
+  DEFINE_bool(readahead, options::TWO_DASHES, '\0', false,
+	      N_("Read input file data in the background before it is needed"),
+	      N_("Read input file data only when it is needed"));
+
   DEFINE_bool(relocatable, options::EXACTLY_ONE_DASH, 'r', false,
 	      N_("Generate relocatable output"), NULL);
 
@@ -1522,6 +1559,9 @@ class General_options
   DEFINE_bool(origin, options::DASH_Z, '\0', false,
 	      N_("Mark DSO to indicate that needs immediate $ORIGIN "
 		 "processing at runtime"), NULL);
+  DEFINE_bool(pack_relative_relocs, options::DASH_Z, '\0', false,
+	      N_("Pack relative relocations into a DT_RELR section"),
+	      N_("Do not pack relative relocations"));
   DEFINE_bool(relro, options::DASH_Z, '\0', DEFAULT_LD_Z_RELRO,
 	      N_("Where possible mark variables read-only after relocation"),
 	      N_("Don't mark variables read-only after relocation"));
@@ -45,6 +45,7 @@
 #include "merge.h"
 #include "descriptors.h"
 #include "layout.h"
+#include "gold-threads.h"
 #include "output.h"
 
 // For systems without mmap support.
@@ -1108,6 +1109,34 @@ Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::get_address() const
   return address;
 }
 
+// Return whether the output address of a relocation is known to be a
+// multiple of ALIGN.  Relaxation and stubs may move an input section
+// or output section data, but only to an offset which is a multiple
+// of its own alignment, so that is what we check against.
+
+template<bool dynamic, int size, bool big_endian>
+bool
+Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::address_is_aligned(
+    Address align) const
+{
+  if (this->shndx_ != INVALID_CODE)
+    {
+      Sized_relobj<size, big_endian>* relobj = this->u2_.relobj;
+      // A section which has no fixed offset, such as a merged section,
+      // may move its contents in any way.
+      if (relobj->output_section(this->shndx_) == NULL
+	  || relobj->get_output_section_offset(this->shndx_) == invalid_address
+	  || relobj->section_addralign(this->shndx_) < align)
+	return false;
+    }
+  else if (this->u2_.od != NULL)
+    {
+      if (this->u2_.od->addralign() < align)
+	return false;
+    }
+  return (this->address_ & (align - 1)) == 0;
+}
+
 // Write out the offset and info fields of a Rel or Rela relocation
 // entry.
 
@@ -1219,6 +1248,23 @@ Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::
   return 0;
 }
 
+// Fill in the sort key of a reloc, apart from the index.  This must
+// give the same order as compare above.
+
+template<bool dynamic, int size, bool big_endian>
+void
+Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::get_sort_key(
+    Output_reloc_sort_key<size>* key) const
+{
+  if (this->is_relative_)
+    key->symbol = 0;
+  else
+    key->symbol = static_cast<uint64_t>(this->get_symbol_index()) + 1;
+  key->address = this->get_address();
+  key->type = this->type_;
+  key->addend = 0;
+}
+
 // Write out a Rela relocation.
 
 template<bool dynamic, int size, bool big_endian>
@@ -1291,6 +1337,370 @@ Output_data_reloc_base<sh_type, dynamic, size, big_endian>::do_write(
   this->do_write_generic<Writer>(of);
 }
 
+// The minimum number of dynamic relocs for which sorting and writing
+// them is split up between threads.
+
+static const size_t parallel_sort_min_relocs = 50000;
+
+// Class Output_data_reloc_base::Parallel_sort.
+
+// This sorts the dynamic relocs and writes them to the output file.
+// The sort key of each reloc is computed first, and the keys are
+// sorted in separate runs which are then merged.  Since each key
+// includes the index of its reloc, the order does not depend upon
+// the number of threads.
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+class Output_data_reloc_base<sh_type, dynamic, size, big_endian>::Parallel_sort
+  : public Parallel_run
+{
+ public:
+  Parallel_sort(const Relocs* relocs, unsigned char* oview,
+		Write_reloc_function write_reloc, unsigned int thread_count)
+    : relocs_(relocs), oview_(oview), write_reloc_(write_reloc),
+      thread_count_(thread_count), phase_(COMPUTE_KEYS),
+      keys_(relocs->size()), merged_(), runs_()
+  { }
+
+  // Sort the relocs and write them out.
+  void
+  sort_and_write();
+
+ protected:
+  void
+  do_run(unsigned int);
+
+ private:
+  typedef Output_reloc_sort_key<size> Sort_key;
+
+  // The steps of the sort, each of which is done by several threads.
+  enum Phase
+  {
+    // Compute the sort key of each reloc.
+    COMPUTE_KEYS,
+    // Sort each run of keys.
+    SORT_RUNS,
+    // Merge pairs of sorted runs.
+    MERGE_RUNS,
+    // Write out the relocs in sorted order.
+    WRITE_RELOCS
+  };
+
+  // The first reloc of the part of the section handled by thread
+  // INDEX.
+  size_t
+  chunk_start(unsigned int index) const
+  { return this->keys_.size() * index / this->thread_count_; }
+
+  const Relocs* relocs_;
+  unsigned char* oview_;
+  Write_reloc_function write_reloc_;
+  unsigned int thread_count_;
+  Phase phase_;
+  // The sort keys.
+  std::vector<Sort_key> keys_;
+  // Where the runs are merged to.
+  std::vector<Sort_key> merged_;
+  // The boundaries of the sorted runs in KEYS_.
+  std::vector<size_t> runs_;
+};
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>::Parallel_sort::
+  sort_and_write()
+{
+  const unsigned int thread_count = this->thread_count_;
+
+  // Finding the address of a reloc in a merged section may sort the
+  // merge map of its object, so do that before the threads start.
+  if (thread_count > 1)
+    {
+      Relobj* last = NULL;
+      Unordered_set<Relobj*> sorted;
+      for (typename Relocs::const_iterator p = this->relocs_->begin();
+	   p != this->relocs_->end();
+	   ++p)
+	{
+	  Relobj* relobj = p->get_relobj();
+	  if (relobj != NULL
+	      && relobj != last
+	      && sorted.insert(relobj).second)
+	    relobj->sort_merge_map();
+	  last = relobj;
+	}
+    }
+
+  this->phase_ = COMPUTE_KEYS;
+  this->run(thread_count);
+
+  this->runs_.resize(thread_count + 1);
+  for (unsigned int i = 0; i <= thread_count; ++i)
+    this->runs_[i] = this->chunk_start(i);
+  this->phase_ = SORT_RUNS;
+  this->run(thread_count);
+
+  if (this->runs_.size() > 2)
+    this->merged_.resize(this->keys_.size());
+  this->phase_ = MERGE_RUNS;
+  while (this->runs_.size() > 2)
+    {
+      unsigned int run_count = this->runs_.size() - 1;
+      this->run((run_count + 1) / 2);
+      this->keys_.swap(this->merged_);
+
+      std::vector<size_t> runs;
+      for (unsigned int i = 0; i < run_count; i += 2)
+	runs.push_back(this->runs_[i]);
+      runs.push_back(this->runs_.back());
+      this->runs_.swap(runs);
+    }
+
+  this->phase_ = WRITE_RELOCS;
+  this->run(thread_count);
+}
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>::Parallel_sort::
+  do_run(unsigned int index)
+{
+  switch (this->phase_)
+    {
+    case COMPUTE_KEYS:
+      for (size_t i = this->chunk_start(index);
+	   i < this->chunk_start(index + 1);
+	   ++i)
+	{
+	  (*this->relocs_)[i].get_sort_key(&this->keys_[i]);
+	  this->keys_[i].index = i;
+	}
+      break;
+
+    case SORT_RUNS:
+      std::sort(this->keys_.begin() + this->runs_[index],
+		this->keys_.begin() + this->runs_[index + 1]);
+      break;
+
+    case MERGE_RUNS:
+      {
+	// Merge run 2 * INDEX with the run after it, if there is one.
+	const size_t last_run = this->runs_.size() - 1;
+	size_t first = this->runs_[2 * index];
+	size_t middle = this->runs_[std::min<size_t>(2 * index + 1, last_run)];
+	size_t last = this->runs_[std::min<size_t>(2 * index + 2, last_run)];
+	std::merge(this->keys_.begin() + first, this->keys_.begin() + middle,
+		   this->keys_.begin() + middle, this->keys_.begin() + last,
+		   this->merged_.begin() + first);
+      }
+      break;
+
+    case WRITE_RELOCS:
+      for (size_t i = this->chunk_start(index);
+	   i < this->chunk_start(index + 1);
+	   ++i)
+	this->write_reloc_(this->relocs_->begin() + this->keys_[i].index,
+			   this->oview_ + i * reloc_size);
+      break;
+
+    default:
+      gold_unreachable();
+    }
+}
+
+// Sort the relocations and write them to OVIEW.  A large number of
+// relocations is sorted and written by several threads.
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>::write_sorted_relocs(
+    unsigned char* oview,
+    Write_reloc_function write_reloc)
+{
+  unsigned int thread_count = 1;
+  if (this->relocs_.size() >= parallel_sort_min_relocs)
+    thread_count = Parallel_run::thread_count(Parallel_run::FINAL_PHASE);
+  Parallel_sort sorter(&this->relocs_, oview, write_reloc, thread_count);
+  sorter.sort_and_write();
+}
+
+// Class Output_data_relr_generic.
+
+bool
+Output_data_relr_generic::update_size()
+{
+  ++this->layout_passes_;
+  size_t unpacked = this->do_unpack_unaligned();
+  this->unpacked_count_ += unpacked;
+  size_t count = this->do_encoded_word_count();
+  if (count <= this->word_count_)
+    return unpacked > 0;
+  this->word_count_ = count;
+  return true;
+}
+
+// Set the entry size of the output section.
+
+void
+Output_data_relr_generic::do_adjust_output_section(Output_section* os)
+{
+  os->set_entsize(this->word_size_);
+}
+
+// Print statistics to stderr.
+
+void
+Output_data_relr_generic::print_stats() const
+{
+  uint64_t section_size = this->word_count_ * this->word_size_;
+  uint64_t saved_size = (static_cast<uint64_t>(this->relocation_count())
+			 * this->reloc_size_);
+  fprintf(stderr, _("%s: packed relative relocations: %zu\n"),
+	  program_name, this->relocation_count());
+  fprintf(stderr, _("%s: relative relocations unpacked after layout: %zu\n"),
+	  program_name, this->unpacked_count_);
+  fprintf(stderr, _("%s: .relr.dyn size: %llu\n"),
+	  program_name, static_cast<unsigned long long>(section_size));
+  fprintf(stderr, _("%s: .relr.dyn bytes saved: %lld\n"),
+	  program_name,
+	  (static_cast<long long>(saved_size)
+	   - static_cast<long long>(section_size)));
+  fprintf(stderr, _("%s: .relr.dyn layout passes: %u\n"),
+	  program_name, this->layout_passes_);
+}
+
+// Class Output_data_relr.
+
+// Add a relocation if it can be packed.  The relocation must be a
+// RELATIVE relocation of a word at a word-aligned address; the
+// dynamic linker does not apply an addend other than the contents of
+// the word, which the targets always fill in at link time.  The
+// section is added to the layout with the first relocation.
+
+template<int sh_type, int size, bool big_endian>
+bool
+Output_data_relr<sh_type, size, big_endian>::add(
+    const Output_reloc_type& reloc)
+{
+  const Output_reloc<elfcpp::SHT_REL, true, size, big_endian>& rel =
+    reloc.rel();
+  if (rel.type() != this->r_type_
+      || !rel.is_relative()
+      || rel.use_plt_offset()
+      || !rel.address_is_aligned(size / 8))
+    return false;
+  if (this->layout_ != NULL)
+    {
+      this->layout_->add_relr_dyn_section(this);
+      this->layout_ = NULL;
+    }
+  this->relocs_.push_back(reloc);
+  return true;
+}
+
+// Move the relocations which are not aligned at their current
+// addresses back to the ordinary dynamic reloc section.  The checks
+// in add should leave none, but the encoding must not depend on
+// them.
+
+template<int sh_type, int size, bool big_endian>
+size_t
+Output_data_relr<sh_type, size, big_endian>::do_unpack_unaligned()
+{
+  const Address word_size = size / 8;
+  typename std::vector<Output_reloc_type>::iterator out =
+    this->relocs_.begin();
+  for (typename std::vector<Output_reloc_type>::iterator p =
+	 this->relocs_.begin();
+       p != this->relocs_.end();
+       ++p)
+    {
+      if ((p->rel().get_address() & (word_size - 1)) != 0)
+	this->reloc_section_->add_unpacked_relr(*p);
+      else
+	*out++ = *p;
+    }
+  size_t count = this->relocs_.end() - out;
+  this->relocs_.erase(out, this->relocs_.end());
+  return count;
+}
+
+// Encode the relocations.  Each run starts with an address word,
+// which relocates the word at that address.  It is followed by bitmap
+// words with the low bit set; bit I of a bitmap word relocates the
+// I-th word after the words covered by the previous word.
+
+template<int sh_type, int size, bool big_endian>
+void
+Output_data_relr<sh_type, size, big_endian>::encode(
+    std::vector<Address>* words) const
+{
+  const Address word_size = size / 8;
+  const unsigned int bits = size - 1;
+
+  std::vector<Address> addresses;
+  addresses.reserve(this->relocs_.size());
+  for (typename std::vector<Output_reloc_type>::const_iterator p =
+	 this->relocs_.begin();
+       p != this->relocs_.end();
+       ++p)
+    addresses.push_back(p->rel().get_address());
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()),
+		  addresses.end());
+
+  size_t i = 0;
+  while (i < addresses.size())
+    {
+      words->push_back(addresses[i]);
+      Address base = addresses[i] + word_size;
+      ++i;
+      while (true)
+	{
+	  Address bitmap = 0;
+	  while (i < addresses.size())
+	    {
+	      Address delta = addresses[i] - base;
+	      if (delta >= bits * word_size)
+		break;
+	      bitmap |= static_cast<Address>(1) << (delta / word_size);
+	      ++i;
+	    }
+	  if (bitmap == 0)
+	    break;
+	  words->push_back((bitmap << 1) | 1);
+	  base += bits * word_size;
+	}
+    }
+}
+
+// Write out the section.  The encoding may be shorter than the size
+// chosen during layout; the rest is filled with empty bitmap words.
+
+template<int sh_type, int size, bool big_endian>
+void
+Output_data_relr<sh_type, size, big_endian>::do_write(Output_file* of)
+{
+  const off_t off = this->offset();
+  const section_size_type oview_size =
+    convert_to_section_size_type(this->data_size());
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+
+  std::vector<Address> words;
+  this->encode(&words);
+  gold_assert(words.size() * this->word_size_ <= oview_size);
+
+  unsigned char* pov = oview;
+  for (typename std::vector<Address>::const_iterator p = words.begin();
+       p != words.end();
+       ++p, pov += size / 8)
+    elfcpp::Swap<size, big_endian>::writeval(pov, *p);
+  for (; pov < oview + oview_size; pov += size / 8)
+    elfcpp::Swap<size, big_endian>::writeval(pov, 1);
+
+  of->write_output_view(off, oview_size, oview);
+}
+
 // Class Output_relocatable_relocs.
 
 template<int sh_type, int size, bool big_endian>
@@ -3545,7 +3955,8 @@ Output_section::Input_section_sort_section_name_compare
 
 void
 Output_section::update_section_layout(
-  const Section_layout_order* order_map)
+  const Section_layout_order* order_map,
+  unsigned int unordered_index)
 {
   for (Input_section_list::iterator p = this->input_sections_.begin();
        p != this->input_sections_.end();
@@ -3560,9 +3971,9 @@ Output_section::update_section_layout(
 	  unsigned int shndx = p->shndx();
 	  Section_layout_order::const_iterator it
 	    = order_map->find(Section_id(obj, shndx));
-	  if (it == order_map->end())
-	    continue;
-	  unsigned int section_order_index = it->second;
+	  unsigned int section_order_index = (it == order_map->end()
+					      ? unordered_index
+					      : it->second);
 	  if (section_order_index != 0)
 	    {
 	      p->set_section_order_index(section_order_index);
@@ -4028,6 +4439,19 @@ Output_section::print_merge_stats()
     p->print_merge_stats(this->name_);
 }
 
+// Add the merge sections for strings to SECTIONS.
+
+void
+Output_section::get_merge_string_sections(
+    std::vector<Output_merge_base*>* sections) const
+{
+  for (Input_section_list::const_iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    if (p->is_merge_section() && p->output_merge_base()->is_string())
+      sections->push_back(p->output_merge_base());
+}
+
 // Set a fixed layout for the section.  Used for incremental update links.
 
 void
@@ -5420,6 +5844,46 @@ template
 class Output_reloc<elfcpp::SHT_RELA, true, 64, true>;
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_reloc_base<elfcpp::SHT_REL, true, 32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_reloc_base<elfcpp::SHT_REL, true, 32, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_reloc_base<elfcpp::SHT_REL, true, 64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_reloc_base<elfcpp::SHT_REL, true, 64, true>;
+#endif
+
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_reloc_base<elfcpp::SHT_RELA, true, 32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_reloc_base<elfcpp::SHT_RELA, true, 32, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_reloc_base<elfcpp::SHT_RELA, true, 64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_reloc_base<elfcpp::SHT_RELA, true, 64, true>;
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 class Output_data_reloc<elfcpp::SHT_REL, false, 32, false>;
@@ -5540,6 +6004,46 @@ template
 class Output_relocatable_relocs<elfcpp::SHT_RELA, 64, true>;
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_relr<elfcpp::SHT_REL, 32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_relr<elfcpp::SHT_RELA, 32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_relr<elfcpp::SHT_REL, 32, true>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_relr<elfcpp::SHT_RELA, 32, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_relr<elfcpp::SHT_REL, 64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_relr<elfcpp::SHT_RELA, 64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_relr<elfcpp::SHT_REL, 64, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_relr<elfcpp::SHT_RELA, 64, true>;
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 class Output_data_group<32, false>;
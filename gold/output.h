@@ -48,6 +48,8 @@ template<int size, bool big_endian>
 class Sized_relobj;
 template<int size, bool big_endian>
 class Sized_relobj_file;
+template<int sh_type, int size, bool big_endian>
+class Output_data_relr;
 
 // This class represents the output file.
 
@@ -1119,6 +1121,43 @@ class Output_data_strtab : public Output_section_data
 template<int sh_type, bool dynamic, int size, bool big_endian>
 class Output_reloc;
 
+// The key used to sort dynamic relocs.  Comparing two keys gives the
+// same order as Output_reloc::sort_before, but finding the symbol
+// index and the address of a reloc is done only once, rather than for
+// each comparison.  Relocs which sort the same way keep the order in
+// which they were added.
+
+template<int size>
+struct Output_reloc_sort_key
+{
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Addend;
+
+  // 0 for a relative reloc, otherwise one more than the symbol index.
+  uint64_t symbol;
+  // The output address.
+  section_offset_type address;
+  // The reloc type.
+  unsigned int type;
+  // The addend, or 0 for a REL reloc.
+  Addend addend;
+  // The index of the reloc in the section.
+  size_t index;
+
+  bool
+  operator<(const Output_reloc_sort_key<size>& k) const
+  {
+    if (this->symbol != k.symbol)
+      return this->symbol < k.symbol;
+    if (this->address != k.address)
+      return this->address < k.address;
+    if (this->type != k.type)
+      return this->type < k.type;
+    if (this->addend != k.addend)
+      return this->addend < k.addend;
+    return this->index < k.index;
+  }
+};
+
 template<bool dynamic, int size, bool big_endian>
 class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
 {
@@ -1208,6 +1247,23 @@ class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
   is_symbolless() const
   { return this->is_symbolless_; }
 
+  // Return whether the addend should be the PLT offset.
+  bool
+  use_plt_offset() const
+  { return this->use_plt_offset_; }
+
+  // Return whether the output address of this reloc is known to be a
+  // multiple of ALIGN, which must be a power of two.  This may be
+  // called before the output sections have addresses, and while the
+  // object holding the reloc is locked.
+  bool
+  address_is_aligned(Address align) const;
+
+  // Return the reloc without the addend, which is this reloc.
+  const Output_reloc&
+  rel() const
+  { return *this; }
+
   // Return whether this is against a local section symbol.
   bool
   is_local_section_symbol() const
@@ -1275,6 +1331,10 @@ class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
 	      r2) const
   { return this->compare(r2) < 0; }
 
+  // Fill in the sort key of this reloc, apart from the index.
+  void
+  get_sort_key(Output_reloc_sort_key<size>* key) const;
+
   // Return the symbol index.
   unsigned int
   get_symbol_index() const;
@@ -1474,6 +1534,11 @@ class Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   get_relobj() const
   { return this->rel_.get_relobj(); }
 
+  // Return the reloc without the addend.
+  const Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>&
+  rel() const
+  { return this->rel_; }
+
   // Write the reloc entry to an output view.
   void
   write(unsigned char* pov) const;
@@ -1493,6 +1558,14 @@ class Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
       return this->addend_ < r2.addend_;
   }
 
+  // Fill in the sort key of this reloc, apart from the index.
+  void
+  get_sort_key(Output_reloc_sort_key<size>* key) const
+  {
+    this->rel_.get_sort_key(key);
+    key->addend = this->addend_;
+  }
+
  private:
   // The basic reloc.
   Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian> rel_;
@@ -1604,9 +1677,30 @@ class Output_data_reloc_base : public Output_data_reloc_generic
 
   // Construct the section.
   Output_data_reloc_base(bool sort_relocs)
-    : Output_data_reloc_generic(size, sort_relocs)
+    : Output_data_reloc_generic(size, sort_relocs), relocs_(), relr_(NULL)
   { }
 
+  // Put the RELATIVE relocations which RELR accepts into RELR, a
+  // DT_RELR section, rather than into this section.  This is used
+  // for -z pack-relative-relocs.
+  void
+  set_relr_section(Output_data_relr<sh_type, size, big_endian>* relr)
+  {
+    gold_assert(dynamic && this->relocs_.empty());
+    this->relr_ = relr;
+  }
+
+  // Add RELOC, which RELR accepted, to this section after all, as
+  // its final address is not aligned.  This is called between layout
+  // passes, and the size of this section is set again in the next one.
+  void
+  add_unpacked_relr(const Output_reloc_type& reloc)
+  {
+    gold_assert(dynamic && reloc.is_relative());
+    this->relocs_.push_back(reloc);
+    this->bump_relative_reloc_count();
+  }
+
  protected:
   // Write out the data.
   void
@@ -1625,21 +1719,22 @@ class Output_data_reloc_base : public Output_data_reloc_generic
     if (this->sort_relocs())
       {
 	gold_assert(dynamic);
-	std::sort(this->relocs_.begin(), this->relocs_.end(),
-		  Sort_relocs_comparison());
+	this->write_sorted_relocs(oview, Output_reloc_writer::write);
       }
-
-    unsigned char* pov = oview;
-    for (typename Relocs::const_iterator p = this->relocs_.begin();
-	 p != this->relocs_.end();
-	 ++p)
+    else
       {
-	Output_reloc_writer::write(p, pov);
-	pov += reloc_size;
+	unsigned char* pov = oview;
+	for (typename Relocs::const_iterator p = this->relocs_.begin();
+	     p != this->relocs_.end();
+	     ++p)
+	  {
+	    Output_reloc_writer::write(p, pov);
+	    pov += reloc_size;
+	  }
+
+	gold_assert(pov - oview == oview_size);
       }
 
-    gold_assert(pov - oview == oview_size);
-
     of->write_output_view(off, oview_size, oview);
 
     // We no longer need the relocation entries.
@@ -1650,6 +1745,12 @@ class Output_data_reloc_base : public Output_data_reloc_generic
   void
   do_adjust_output_section(Output_section* os);
 
+  // Set the final data size, which may have changed since the last
+  // layout pass if relocs were added by add_unpacked_relr.
+  void
+  set_final_data_size()
+  { this->set_data_size(this->relocs_.size() * reloc_size); }
+
   // Write to a map file.
   void
   do_print_to_mapfile(Mapfile* mapfile) const
@@ -1664,6 +1765,11 @@ class Output_data_reloc_base : public Output_data_reloc_generic
   void
   add(Output_data* od, const Output_reloc_type& reloc)
   {
+    if (this->relr_ != NULL && this->relr_->add(reloc))
+      {
+	od->add_dynamic_reloc();
+	return;
+      }
     this->relocs_.push_back(reloc);
     this->set_current_data_size(this->relocs_.size() * reloc_size);
     if (dynamic)
@@ -1678,16 +1784,22 @@ class Output_data_reloc_base : public Output_data_reloc_generic
  private:
   typedef std::vector<Output_reloc_type> Relocs;
 
-  // The class used to sort the relocations.
-  struct Sort_relocs_comparison
-  {
-    bool
-    operator()(const Output_reloc_type& r1, const Output_reloc_type& r2) const
-    { return r1.sort_before(r2); }
-  };
+  // A function which writes a reloc to an output view.
+  typedef void (*Write_reloc_function)(typename Relocs::const_iterator,
+				       unsigned char*);
+
+  // The class used to sort and write a large number of relocations
+  // in several threads.
+  class Parallel_sort;
+
+  // Sort the relocations and write them to OVIEW using WRITE_RELOC.
+  void
+  write_sorted_relocs(unsigned char* oview, Write_reloc_function write_reloc);
 
   // The relocations in this section.
   Relocs relocs_;
+  // The DT_RELR section for RELATIVE relocations, or NULL.
+  Output_data_relr<sh_type, size, big_endian>* relr_;
 };
 
 // The class which callers actually create.
@@ -2344,6 +2456,162 @@ class Output_data_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   }
 };
 
+// Output_data_relr_generic is a non-template base class for
+// Output_data_relr.  This gives Layout a way to hold a pointer to the
+// DT_RELR section, which it needs to lay out the sections again when
+// the section grows.
+
+class Output_data_relr_generic : public Output_section_data
+{
+ public:
+  Output_data_relr_generic(int size, unsigned int reloc_size)
+    : Output_section_data(Output_data::default_alignment_for_size(size)),
+      word_size_(size / 8), reloc_size_(reloc_size), word_count_(0),
+      layout_passes_(0), unpacked_count_(0)
+  { }
+
+  // Return the number of relocations in this section.
+  size_t
+  relocation_count() const
+  { return this->do_relocation_count(); }
+
+  // Encode the relocations at the current addresses of the output
+  // sections.  A relocation whose address turns out not to be aligned
+  // is moved back to the ordinary dynamic reloc section.  If that
+  // happens, or if the encoding does not fit in the section, grow the
+  // section as needed and return true; the sections must then be laid
+  // out again.  Relocations are never moved back into this section,
+  // and the section never shrinks, which guarantees that this
+  // eventually returns false.
+  bool
+  update_size();
+
+  // Print statistics to stderr.
+  void
+  print_stats() const;
+
+ protected:
+  // Return the number of relocations.
+  virtual size_t
+  do_relocation_count() const = 0;
+
+  // Move the relocations whose current addresses are not aligned to
+  // the ordinary dynamic reloc section, and return how many there
+  // were.
+  virtual size_t
+  do_unpack_unaligned() = 0;
+
+  // Return the number of words needed to encode the relocations at
+  // the current addresses.
+  virtual size_t
+  do_encoded_word_count() const = 0;
+
+  // Set the final data size.
+  void
+  set_final_data_size()
+  { this->set_data_size(this->word_count_ * this->word_size_); }
+
+  // Set the entry size.
+  void
+  do_adjust_output_section(Output_section* os);
+
+  // Write to a map file.
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** dynamic relocs")); }
+
+  // The size of a word in bytes.
+  unsigned int word_size_;
+
+ private:
+  // The size of a relocation in the ordinary dynamic reloc section.
+  unsigned int reloc_size_;
+  // The number of words in the section.
+  size_t word_count_;
+  // The number of times update_size was called.
+  unsigned int layout_passes_;
+  // The number of relocations moved back to the ordinary dynamic
+  // reloc section.
+  size_t unpacked_count_;
+};
+
+// Output_data_relr holds the RELATIVE relocations which are packed
+// into a DT_RELR section, .relr.dyn, for -z pack-relative-relocs.
+// The dynamic linker adds the load address to the word at each
+// address, so the word must already hold the link-time value.  The
+// section is a sorted list of words: an even word is an address to
+// relocate, and an odd word is a bitmap of which of the following
+// SIZE - 1 words to relocate.  SH_TYPE is the type of the ordinary
+// dynamic reloc section, to which the relocations which turn out not
+// to be aligned are moved back.
+
+template<int sh_type, int size, bool big_endian>
+class Output_data_relr : public Output_data_relr_generic
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  typedef Output_reloc<sh_type, true, size, big_endian> Output_reloc_type;
+  typedef Output_data_reloc_base<sh_type, true, size,
+				 big_endian> Reloc_section;
+
+  // R_TYPE is the RELATIVE relocation type of the target.  The
+  // section is added to LAYOUT when the first relocation is packed.
+  // RELOC_SECTION is the ordinary dynamic reloc section.
+  Output_data_relr(unsigned int r_type, Layout* layout,
+		   Reloc_section* reloc_section)
+    : Output_data_relr_generic(size,
+			       Reloc_types<sh_type, size,
+					   big_endian>::reloc_size),
+      r_type_(r_type), layout_(layout), reloc_section_(reloc_section),
+      relocs_()
+  { }
+
+  // Add RELOC if it can be packed.  Return false if it must go into
+  // the ordinary dynamic reloc section.
+  bool
+  add(const Output_reloc_type& reloc);
+
+  // Relocations in a relocatable output file are never packed.
+  bool
+  add(const Output_reloc<sh_type, false, size, big_endian>&)
+  { return false; }
+
+ protected:
+  size_t
+  do_relocation_count() const
+  { return this->relocs_.size(); }
+
+  size_t
+  do_unpack_unaligned();
+
+  size_t
+  do_encoded_word_count() const
+  {
+    std::vector<Address> words;
+    this->encode(&words);
+    return words.size();
+  }
+
+  // Write out the data.
+  void
+  do_write(Output_file*);
+
+ private:
+  // Encode the relocations at their current addresses into WORDS.
+  void
+  encode(std::vector<Address>* words) const;
+
+  // The RELATIVE relocation type of the target.
+  unsigned int r_type_;
+  // The layout to which this section is added, or NULL once it has
+  // been.
+  Layout* layout_;
+  // The ordinary dynamic reloc section.
+  Reloc_section* reloc_section_;
+  // The relocations.
+  std::vector<Output_reloc_type> relocs_;
+};
+
 // Output_relocatable_relocs represents a relocation section in a
 // relocatable link.  The actual data is written out in the target
 // hook relocate_relocs.  This just saves space for it.
@@ -3269,8 +3537,12 @@ class Output_section : public Output_data
 
   typedef std::map<Section_id, unsigned int> Section_layout_order;
 
+  // Set the order of the input sections from ORDER_MAP.  The input
+  // sections which are not in ORDER_MAP get UNORDERED_INDEX; if that
+  // is zero, they come first.
   void
-  update_section_layout(const Section_layout_order* order_map);
+  update_section_layout(const Section_layout_order* order_map,
+			unsigned int unordered_index = 0);
 
   // Update the output section flags based on input section flags.
   void
@@ -4028,6 +4300,15 @@ class Output_section : public Output_data
   const Output_relaxed_input_section*
   find_relaxed_input_section(const Relobj* object, unsigned int shndx) const;
 
+  // Build the lookup maps now if they are not valid, so that they may
+  // then be used by several threads at once.
+  void
+  prepare_lookup_maps() const
+  {
+    if (!this->lookup_maps_->is_valid())
+      this->build_lookup_maps();
+  }
+
   // Whether section offsets need adjustment due to relaxation.
   bool
   section_offsets_need_adjustment() const
@@ -4062,6 +4343,11 @@ class Output_section : public Output_data
   void
   print_merge_stats();
 
+  // Add the merge sections for strings in this output section to
+  // SECTIONS.
+  void
+  get_merge_string_sections(std::vector<Output_merge_base*>* sections) const;
+
   // Set a fixed layout for the section.  Used for incremental update links.
   void
   set_fixed_layout(uint64_t sh_addr, off_t sh_offset, off_t sh_size,
@@ -591,7 +591,7 @@ Add_symbols::locks(Task_locker* tl)
 // Add the symbols in the object to the symbol table.
 
 void
-Add_symbols::run(Workqueue*)
+Add_symbols::run(Workqueue* workqueue)
 {
   Pluginobj* pluginobj = this->object_->pluginobj();
   if (pluginobj != NULL)
@@ -637,6 +637,10 @@ Add_symbols::run(Workqueue*)
       delete this->sd_;
       this->sd_ = NULL;
       this->object_->release();
+
+      // When running with threads, the symbols may not have been
+      // added yet; start the tasks which will add them.
+      this->symtab_->queue_pending_symbols(workqueue);
     }
 }
 
@@ -839,7 +843,7 @@ Finish_group::locks(Task_locker* tl)
 // Loop over the archives until there are no new undefined symbols.
 
 void
-Finish_group::run(Workqueue*)
+Finish_group::run(Workqueue* workqueue)
 {
   size_t saw_undefined = this->saw_undefined_;
   while (saw_undefined != this->symtab_->saw_undefined())
@@ -857,6 +861,8 @@ Finish_group::run(Workqueue*)
 	}
     }
 
+  this->symtab_->queue_pending_symbols(workqueue);
+
   // Now that we're done with the archives, record the incremental
   // layout information.
   for (Input_group::const_iterator p = this->input_group_->begin();
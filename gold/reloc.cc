@@ -35,6 +35,7 @@
 #include "icf.h"
 #include "compressed_output.h"
 #include "incremental.h"
+#include "gold-threads.h"
 
 namespace gold
 {
@@ -66,6 +67,9 @@ Read_relocs::locks(Task_locker* tl)
 void
 Read_relocs::run(Workqueue* workqueue)
 {
+  if (parameters->options().readahead())
+    this->object_->prefetch_sections();
+
   Read_relocs_data* rd = new Read_relocs_data;
   this->object_->read_relocs(rd);
   this->object_->set_relocs_data(rd);
@@ -201,12 +205,29 @@ Scan_relocs::get_name() const
 
 // Relocate_task methods.
 
+// Return whether to free the data used to relocate each object once
+// it has been relocated.  This is done for --no-keep-memory, unless
+// the data is still needed after relocation.
+
+static bool
+release_link_state_after_relocate()
+{
+  return (parameters->options().no_keep_memory()
+	  && !parameters->options().relocatable()
+	  && !parameters->options().gdb_index()
+	  && !parameters->incremental());
+}
+
 // We may have to wait for the output sections to be written.
 
 Task_token*
 Relocate_task::is_runnable()
 {
-  if (this->object_->relocs_must_follow_section_writes()
+  // The output sections read the local symbol values and the merge
+  // mappings of the objects, so wait for them to be written before
+  // relocating an object whose data we are going to free.
+  if ((this->object_->relocs_must_follow_section_writes()
+       || release_link_state_after_relocate())
       && this->output_sections_blocker_->is_blocked())
     return this->output_sections_blocker_;
 
@@ -241,6 +262,10 @@ Relocate_task::run(Workqueue*)
   // This is normally the last thing we will do with an object, so
   // uncache all views.
   this->object_->clear_view_cache_marks();
+  if (parameters->options().readahead())
+    this->object_->release_pages();
+  if (release_link_state_after_relocate())
+    this->object_->release_link_state();
 
   this->object_->release();
 }
@@ -375,6 +400,104 @@ Sized_relobj_file<size, big_endian>::do_read_relocs(Read_relocs_data* rd)
       rd->local_symbols = this->get_lasting_view(symtabshdr.get_sh_offset(),
 						 locsize, true, true);
     }
+
+  // The relocs are scanned one object at a time, in input order, so
+  // that the GOT and PLT entries and the dynamic relocs are always
+  // created in the same order.  When using threads, the objects are
+  // read in parallel, so we take the chance to let the target decide
+  // what to do with each reloc.  The target records its decisions as
+  // requests, which the serial scan then carries out in order.
+  if (Parallel_run::thread_count(Parallel_run::MIDDLE_PHASE) > 1
+      && !parameters->options().relocatable())
+    {
+      Sized_target<size, big_endian>* target =
+	parameters->sized_target<size, big_endian>();
+      const unsigned char* local_symbols = (rd->local_symbols == NULL
+					    ? NULL
+					    : rd->local_symbols->data());
+      for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
+	   p != rd->relocs.end();
+	   ++p)
+	{
+	  if (!p->is_data_section_allocated)
+	    continue;
+	  Reloc_requests* scan_requests = new Reloc_requests();
+	  if (target->prescan_relocs(this, p->data_shndx, p->sh_type,
+				     p->contents->data(), p->reloc_count,
+				     this->local_symbol_count_,
+				     local_symbols, scan_requests))
+	    p->scan_requests = scan_requests;
+	  else
+	    delete scan_requests;
+	}
+    }
+}
+
+// Prefetch the section contents, the relocs and the symbol table,
+// which will be read by Scan_relocs and Relocate_task.  We do this
+// when reading the relocs, so the data is normally in memory by the
+// time the relocation tasks run.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_prefetch_sections()
+{
+  unsigned int shnum = this->shnum();
+  if (shnum == 0)
+    return;
+
+  const Output_sections& out_sections(this->output_sections());
+
+  const unsigned char* pshdrs = this->get_view(this->elf_file_.shoff(),
+					       shnum * This::shdr_size,
+					       true, true);
+
+  // Writing the local symbols reads the symbol table and its string
+  // table.  Section names are looked up in the section name string
+  // table.
+  unsigned int shstrndx = this->elf_file_.shstrndx();
+  unsigned int strtab_shndx = -1U;
+  if (this->symtab_shndx_ != 0)
+    {
+      typename This::Shdr symtabshdr(pshdrs
+				     + this->symtab_shndx_ * This::shdr_size);
+      strtab_shndx = this->adjust_shndx(symtabshdr.get_sh_link());
+    }
+
+  // The relocation tasks read the section headers again.
+  File_read::Prefetch_ranges ranges;
+  ranges.push_back(std::make_pair(static_cast<off_t>(this->elf_file_.shoff()),
+				  shnum * This::shdr_size));
+
+  const unsigned char* ps = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, ps += This::shdr_size)
+    {
+      typename This::Shdr shdr(ps);
+
+      unsigned int sh_type = shdr.get_sh_type();
+      if (sh_type == elfcpp::SHT_NOBITS || shdr.get_sh_size() == 0)
+	continue;
+
+      bool wanted;
+      if (sh_type == elfcpp::SHT_REL || sh_type == elfcpp::SHT_RELA)
+	{
+	  unsigned int shndx = this->adjust_shndx(shdr.get_sh_info());
+	  wanted = shndx < shnum && out_sections[shndx] != NULL;
+	}
+      else if (i == this->symtab_shndx_
+	       || i == strtab_shndx
+	       || i == shstrndx)
+	wanted = true;
+      else
+	wanted = out_sections[i] != NULL;
+
+      if (wanted)
+	ranges.push_back(std::make_pair(static_cast<off_t>(shdr.get_sh_offset()),
+					convert_to_section_size_type(
+					  shdr.get_sh_size())));
+    }
+
+  this->input_file()->file().prefetch(this->offset(), &ranges);
 }
 
 // Process the relocs to generate mappings from source sections to referenced
@@ -459,12 +582,24 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 	  // only scan allocated sections.  We may see a non-allocated
 	  // section here if we are emitting relocs.
 	  if (p->is_data_section_allocated)
-	    target->scan_relocs(symtab, layout, this, p->data_shndx,
-				p->sh_type, p->contents->data(),
-				p->reloc_count, p->output_section,
-				p->needs_special_offset_handling,
-				this->local_symbol_count_,
-				local_symbols);
+	    {
+	      if (p->scan_requests == NULL)
+		target->scan_relocs(symtab, layout, this, p->data_shndx,
+				    p->sh_type, p->contents->data(),
+				    p->reloc_count, p->output_section,
+				    p->needs_special_offset_handling,
+				    this->local_symbol_count_,
+				    local_symbols);
+	      else if (!p->scan_requests->empty())
+		target->scan_reloc_requests(symtab, layout, this,
+					    p->data_shndx, p->sh_type,
+					    p->contents->data(),
+					    *p->scan_requests,
+					    p->output_section,
+					    p->needs_special_offset_handling,
+					    this->local_symbol_count_,
+					    local_symbols);
+	    }
 	  if (parameters->options().emit_relocs())
 	    this->emit_relocs_scan(symtab, layout, local_symbols, p);
 	  if (layout->incremental_inputs() != NULL)
@@ -488,6 +623,8 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 
       delete p->contents;
       p->contents = NULL;
+      delete p->scan_requests;
+      p->scan_requests = NULL;
     }
 
   // For incremental links, finalize the allocation of relocations.
@@ -871,10 +1008,176 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
     Output_file* of,
     Views* pviews)
 {
+  // A very large object would keep one thread busy long after the
+  // others have run out of objects, so split its sections into ranges
+  // for several threads.  Each range writes only the views of its own
+  // sections.  While other workqueue threads are still relocating
+  // other objects there are no threads to spare, so this is only done
+  // when some are idle.
+  if (Parallel_run::available_threads(
+	  Parallel_run::thread_count(Parallel_run::FINAL_PHASE)) > 1
+      && parameters->target().relocate_sections_in_parallel()
+      && !parameters->options().relocatable()
+      && !parameters->options().emit_relocs()
+      && !parameters->incremental()
+      && !this->uses_split_stack())
+    {
+      Parallel_relocate pr(this, symtab, layout, pshdrs, of, pviews);
+      if (pr.reloc_size() >= parameters->options().parallel_relocate_min_size()
+	  && pr.range_count() > 1)
+	{
+	  pr.relocate();
+	  return;
+	}
+    }
+
   this->relocate_section_range(symtab, layout, pshdrs, of, pviews,
 			       1, this->shnum() - 1);
 }
 
+// Class Sized_relobj_file::Parallel_relocate.
+
+template<int size, bool big_endian>
+class Sized_relobj_file<size, big_endian>::Parallel_relocate
+  : public Parallel_run
+{
+ public:
+  Parallel_relocate(Sized_relobj_file<size, big_endian>* object,
+		    const Symbol_table* symtab, const Layout* layout,
+		    const unsigned char* pshdrs, Output_file* of,
+		    Views* pviews);
+
+  // Return the total size of the reloc sections.
+  uint64_t
+  reloc_size() const
+  { return this->reloc_size_; }
+
+  // Return the number of ranges.
+  size_t
+  range_count() const
+  { return this->ranges_.size(); }
+
+  // Relocate all the ranges.
+  void
+  relocate();
+
+ protected:
+  void
+  do_run(unsigned int);
+
+ private:
+  // The number of ranges to make for each thread.  Having more than
+  // one lets a thread which finishes early take over some of the work.
+  static const unsigned int ranges_per_thread = 4;
+
+  // The first and last section of a range.
+  typedef std::pair<unsigned int, unsigned int> Range;
+
+  Sized_relobj_file<size, big_endian>* object_;
+  const Symbol_table* symtab_;
+  const Layout* layout_;
+  const unsigned char* pshdrs_;
+  Output_file* of_;
+  Views* pviews_;
+  uint64_t reloc_size_;
+  unsigned int thread_count_;
+  std::vector<Range> ranges_;
+  // The next range to relocate, protected by LOCK_.
+  size_t next_range_;
+  Lock* lock_;
+};
+
+// Split the sections into ranges which hold about the same amount of
+// relocations.
+
+template<int size, bool big_endian>
+Sized_relobj_file<size, big_endian>::Parallel_relocate::Parallel_relocate(
+    Sized_relobj_file<size, big_endian>* object,
+    const Symbol_table* symtab, const Layout* layout,
+    const unsigned char* pshdrs, Output_file* of, Views* pviews)
+  : object_(object), symtab_(symtab), layout_(layout), pshdrs_(pshdrs),
+    of_(of), pviews_(pviews), reloc_size_(0),
+    thread_count_(Parallel_run::thread_count(Parallel_run::FINAL_PHASE)),
+    ranges_(), next_range_(0), lock_(NULL)
+{
+  const unsigned int shnum = object->shnum();
+  const unsigned char* p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      unsigned int sh_type = shdr.get_sh_type();
+      if (sh_type == elfcpp::SHT_REL || sh_type == elfcpp::SHT_RELA)
+	this->reloc_size_ += shdr.get_sh_size();
+    }
+
+  uint64_t range_size = (this->reloc_size_
+			 / (this->thread_count_ * ranges_per_thread));
+  unsigned int start = 1;
+  uint64_t size_so_far = 0;
+  p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      unsigned int sh_type = shdr.get_sh_type();
+      if (sh_type != elfcpp::SHT_REL && sh_type != elfcpp::SHT_RELA)
+	continue;
+      size_so_far += shdr.get_sh_size();
+      if (size_so_far > range_size)
+	{
+	  this->ranges_.push_back(Range(start, i));
+	  start = i + 1;
+	  size_so_far = 0;
+	}
+    }
+  if (start < shnum)
+    this->ranges_.push_back(Range(start, shnum - 1));
+}
+
+// Relocate the ranges.  While the threads run, they share the input
+// file, and they may look up output offsets in merged sections.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::Parallel_relocate::relocate()
+{
+  Lock lock;
+  this->lock_ = &lock;
+  this->next_range_ = 0;
+
+  this->object_->sort_merge_map();
+  File_read& file(this->object_->input_file()->file());
+  file.set_view_lock(&lock);
+
+  this->run(std::min(this->thread_count_,
+		     static_cast<unsigned int>(this->ranges_.size())));
+
+  file.set_view_lock(NULL);
+  this->lock_ = NULL;
+}
+
+// Relocate ranges until there are none left.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::Parallel_relocate::do_run(unsigned int)
+{
+  while (true)
+    {
+      Range range;
+      {
+	Hold_lock hl(*this->lock_);
+	if (this->next_range_ >= this->ranges_.size())
+	  return;
+	range = this->ranges_[this->next_range_];
+	++this->next_range_;
+      }
+      this->object_->relocate_section_range(this->symtab_, this->layout_,
+					    this->pshdrs_, this->of_,
+					    this->pviews_, range.first,
+					    range.second);
+    }
+}
+
 // Relocate section data for the range of sections START_SHNDX through
 // END_SHNDX.
 
@@ -1619,24 +1922,48 @@ void
 Sized_relobj_file<32, false>::do_read_relocs(Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+void
+Sized_relobj_file<32, false>::do_prefetch_sections();
+#endif
+
 #ifdef HAVE_TARGET_32_BIG
 template
 void
 Sized_relobj_file<32, true>::do_read_relocs(Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_32_BIG
+template
+void
+Sized_relobj_file<32, true>::do_prefetch_sections();
+#endif
+
 #ifdef HAVE_TARGET_64_LITTLE
 template
 void
 Sized_relobj_file<64, false>::do_read_relocs(Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_64_LITTLE
+template
+void
+Sized_relobj_file<64, false>::do_prefetch_sections();
+#endif
+
 #ifdef HAVE_TARGET_64_BIG
 template
 void
 Sized_relobj_file<64, true>::do_read_relocs(Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_64_BIG
+template
+void
+Sized_relobj_file<64, true>::do_prefetch_sections();
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 void
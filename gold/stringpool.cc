@@ -24,11 +24,13 @@
 
 #include <cstring>
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include <uchar.h>
 
 #include "output.h"
 #include "parameters.h"
+#include "gold-threads.h"
 #include "stringpool.h"
 
 namespace gold
@@ -36,8 +38,12 @@ namespace gold
 
 template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::Stringpool_template(uint64_t addralign)
-  : string_set_(), key_to_offset_(), strings_(), strtab_size_(0),
-    zero_null_(true), optimize_(false), offset_(sizeof(Stringpool_char)),
+  : arena_(),
+    string_set_(0, Stringpool_hash(), Stringpool_eq(),
+		String_set_allocator(&this->arena_)),
+    key_to_offset_(), key_count_(0), strings_(), strtab_size_(0),
+    zero_null_(true), optimize_(false), is_string_table_(true),
+    offset_(sizeof(Stringpool_char)),
     addralign_(addralign)
 {
   if (parameters->options_valid()
@@ -56,7 +62,9 @@ Stringpool_template<Stringpool_char>::clear()
     delete[] reinterpret_cast<char*>(*p);
   this->strings_.clear();
   this->key_to_offset_.clear();
+  this->key_count_ = 0;
   this->string_set_.clear();
+  this->arena_.release();
 }
 
 template<typename Stringpool_char>
@@ -74,7 +82,8 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::reserve(unsigned int n)
 {
-  this->key_to_offset_.reserve(n);
+  if (this->is_string_table_)
+    this->key_to_offset_.reserve(n);
 
 #if defined(HAVE_UNORDERED_MAP)
   this->string_set_.rehash(this->string_set_.size() + n);
@@ -89,7 +98,9 @@ Stringpool_template<Stringpool_char>::reserve(unsigned int n)
 #endif
 
   // This is the generic "reserve" code, if no #ifdef above triggers.
-  String_set_type new_string_set(this->string_set_.size() + n);
+  String_set_type new_string_set(this->string_set_.size() + n,
+				 Stringpool_hash(), Stringpool_eq(),
+				 this->string_set_.get_allocator());
   new_string_set.insert(this->string_set_.begin(), this->string_set_.end());
   this->string_set_.swap(new_string_set);
 }
@@ -134,7 +145,7 @@ Stringpool_template<Stringpool_char>::Stringpool_eq::operator()(
 // Hash function.  The length is in characters, not bytes.
 
 template<typename Stringpool_char>
-size_t
+uint32_t
 Stringpool_template<Stringpool_char>::string_hash(const Stringpool_char* s,
 						  size_t length)
 {
@@ -223,6 +234,10 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::new_key_offset(size_t length)
 {
+  ++this->key_count_;
+  if (!this->is_string_table_)
+    return;
+
   section_offset_type offset;
   if (this->zero_null_ && length == 0)
     offset = 0;
@@ -238,22 +253,26 @@ Stringpool_template<Stringpool_char>::new_key_offset(size_t length)
 
 template<typename Stringpool_char>
 const Stringpool_char*
-Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
-						      size_t length,
-						      bool copy,
-						      Key* pkey)
+Stringpool_template<Stringpool_char>::add_with_hash(const Stringpool_char* s,
+						    size_t length,
+						    uint32_t hash_code,
+						    bool copy,
+						    Key* pkey)
 {
   typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
 
   // We add 1 so that 0 is always invalid.
-  const Key k = this->key_to_offset_.size() + 1;
+  const Key k = this->key_count_ + 1;
 
   if (!copy)
     {
       // When we don't need to copy the string, we can call insert
       // directly.
 
-      std::pair<Hashkey, Hashval> element(Hashkey(s, length), k);
+      // Insert a const value_type, so that no node is allocated if
+      // the string is already present.
+      const typename String_set_type::value_type element(
+	  Hashkey(s, length, hash_code), k);
 
       Insert_type ins = this->string_set_.insert(element);
 
@@ -280,7 +299,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
+  Hashkey hk(s, length, hash_code);
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p != this->string_set_.end())
     {
@@ -295,7 +314,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // The contents of the string stay the same, so we don't need to
   // adjust hk.hash_code or hk.length.
 
-  std::pair<Hashkey, Hashval> element(hk, k);
+  const typename String_set_type::value_type element(hk, k);
 
   Insert_type ins = this->string_set_.insert(element);
   gold_assert(ins.second);
@@ -321,6 +340,24 @@ Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
   return p->first.string;
 }
 
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::find_with_hash(const Stringpool_char* s,
+						     size_t length,
+						     uint32_t hash_code,
+						     Key* pkey) const
+{
+  Hashkey hk(s, length, hash_code);
+  typename String_set_type::const_iterator p = this->string_set_.find(hk);
+  if (p == this->string_set_.end())
+    return NULL;
+
+  if (pkey != NULL)
+    *pkey = p->second;
+
+  return p->first.string;
+}
+
 // Comparison routine used when sorting into an ELF strtab.  We want
 // to sort this so that when one string is a suffix of another, we
 // always see the shorter string immediately after the longer string.
@@ -369,6 +406,211 @@ Stringpool_template<Stringpool_char>::is_suffix(const Stringpool_char* s1,
   return memcmp(s1, s2 + len2 - len1, len1 * sizeof(Stringpool_char)) == 0;
 }
 
+// The smallest number of strings for which we sort using several
+// threads.
+
+static const size_t parallel_sort_min_strings = 100000;
+
+// Class Stringpool_template::Parallel_sort.
+
+// This sorts the strings of a Stringpool into the order used by
+// Stringpool_sort_comparison, using several threads.  The strings are
+// first distributed into buckets by their last two characters, which
+// are the most significant for the comparison.  The buckets are then
+// sorted separately.  Since the comparison is a total order on
+// distinct strings, the result is the same as sorting with std::sort.
+
+template<typename Stringpool_char>
+class Stringpool_template<Stringpool_char>::Parallel_sort : public Parallel_run
+{
+ public:
+  Parallel_sort(const Stringpool_template<Stringpool_char>* pool,
+		std::vector<Stringpool_sort_info>* v,
+		unsigned int thread_count)
+    : pool_(pool), v_(v), thread_count_(thread_count), phase_(COUNT),
+      keys_(v->size()), positions_(thread_count * bucket_count, 0),
+      bucket_start_(bucket_count + 1), first_bucket_(thread_count + 1),
+      sorted_(v->size()), shares_suffix_(NULL)
+  { }
+
+  // Sort the strings.  Set (*SHARES_SUFFIX)[I] to whether string I can
+  // share the end of string I - 1.
+  void
+  sort(std::vector<unsigned char>* shares_suffix);
+
+ protected:
+  void
+  do_run(unsigned int);
+
+ private:
+  // The number of buckets.  Each of the last two characters of a
+  // string has a key from 0 to 256, with 0 for no character.
+  static const unsigned int bucket_count = 257 * 257;
+
+  // The steps of the sort, each of which is done by all the threads.
+  enum Phase
+  {
+    // Compute the bucket of each string.
+    COUNT,
+    // Move each string into its bucket.
+    DISTRIBUTE,
+    // Sort the buckets.
+    SORT_BUCKETS,
+    // Look for strings which are suffixes of the previous string.
+    FIND_SUFFIXES
+  };
+
+  // Return the key of character C.  Characters are compared as
+  // Stringpool_char values, so this preserves their order.
+  static unsigned int
+  char_key(Stringpool_char c)
+  {
+    long long v = (static_cast<long long>(c)
+		   - static_cast<long long>(
+		       std::numeric_limits<Stringpool_char>::min()));
+    return v < 255 ? v + 1 : 256;
+  }
+
+  // Return the bucket of a string.  The strings are sorted into
+  // decreasing order of bucket.
+  static unsigned int
+  bucket(const Stringpool_sort_info& p)
+  {
+    const Stringpool_char* s = p->first.string;
+    size_t len = p->first.length;
+    unsigned int last = len > 0 ? char_key(s[len - 1]) : 0;
+    unsigned int prev = len > 1 ? char_key(s[len - 2]) : 0;
+    return last * 257 + prev;
+  }
+
+  // The first string of the part of V_ handled by thread INDEX.
+  size_t
+  chunk_start(unsigned int index) const
+  { return this->v_->size() * index / this->thread_count_; }
+
+  const Stringpool_template<Stringpool_char>* pool_;
+  std::vector<Stringpool_sort_info>* v_;
+  unsigned int thread_count_;
+  Phase phase_;
+  // The bucket of each string in V_.
+  std::vector<unsigned int> keys_;
+  // The number of strings in each bucket for each thread, and then
+  // the position in SORTED_ of the next string for each thread.
+  std::vector<size_t> positions_;
+  // The position in SORTED_ of the Ith bucket in sorted order.
+  std::vector<size_t> bucket_start_;
+  // The first bucket in sorted order sorted by each thread.
+  std::vector<unsigned int> first_bucket_;
+  // The sorted strings.
+  std::vector<Stringpool_sort_info> sorted_;
+  // Where to record the strings which are suffixes.
+  std::vector<unsigned char>* shares_suffix_;
+};
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::Parallel_sort::sort(
+    std::vector<unsigned char>* shares_suffix)
+{
+  const size_t count = this->v_->size();
+  const unsigned int thread_count = this->thread_count_;
+
+  this->phase_ = COUNT;
+  this->run(thread_count);
+
+  // Turn the counts into positions, with the buckets in decreasing
+  // order.
+  size_t pos = 0;
+  for (unsigned int i = 0; i < bucket_count; ++i)
+    {
+      unsigned int b = bucket_count - 1 - i;
+      this->bucket_start_[i] = pos;
+      for (unsigned int t = 0; t < thread_count; ++t)
+	{
+	  size_t n = this->positions_[t * bucket_count + b];
+	  this->positions_[t * bucket_count + b] = pos;
+	  pos += n;
+	}
+    }
+  this->bucket_start_[bucket_count] = pos;
+  gold_assert(pos == count);
+
+  this->phase_ = DISTRIBUTE;
+  this->run(thread_count);
+
+  // Give each thread buckets holding about the same number of strings.
+  unsigned int b = 0;
+  for (unsigned int t = 0; t < thread_count; ++t)
+    {
+      while (b < bucket_count && this->bucket_start_[b] < this->chunk_start(t))
+	++b;
+      this->first_bucket_[t] = b;
+    }
+  this->first_bucket_[thread_count] = bucket_count;
+
+  this->phase_ = SORT_BUCKETS;
+  this->run(thread_count);
+
+  this->v_->swap(this->sorted_);
+
+  shares_suffix->resize(count);
+  this->shares_suffix_ = shares_suffix;
+  this->phase_ = FIND_SUFFIXES;
+  this->run(thread_count);
+}
+
+// Do the work of thread INDEX for the current phase.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::Parallel_sort::do_run(unsigned int index)
+{
+  const size_t start = this->chunk_start(index);
+  const size_t end = this->chunk_start(index + 1);
+  std::vector<Stringpool_sort_info>& v(*this->v_);
+  size_t* positions = &this->positions_[index * bucket_count];
+
+  switch (this->phase_)
+    {
+    case COUNT:
+      for (size_t i = start; i < end; ++i)
+	{
+	  unsigned int key = bucket(v[i]);
+	  this->keys_[i] = key;
+	  ++positions[key];
+	}
+      break;
+
+    case DISTRIBUTE:
+      for (size_t i = start; i < end; ++i)
+	this->sorted_[positions[this->keys_[i]]++] = v[i];
+      break;
+
+    case SORT_BUCKETS:
+      for (unsigned int b = this->first_bucket_[index];
+	   b < this->first_bucket_[index + 1];
+	   ++b)
+	{
+	  size_t bstart = this->bucket_start_[b];
+	  size_t bend = this->bucket_start_[b + 1];
+	  if (bend - bstart > 1)
+	    std::sort(this->sorted_.begin() + bstart,
+		      this->sorted_.begin() + bend,
+		      Stringpool_sort_comparison());
+	}
+      break;
+
+    case FIND_SUFFIXES:
+      for (size_t i = start; i < end; ++i)
+	(*this->shares_suffix_)[i] =
+	  i > 0 && this->pool_->can_share_suffix(v[i], v[i - 1]);
+      break;
+
+    default:
+      gold_unreachable();
+    }
+}
+
 // Turn the stringpool into an ELF strtab: determine the offsets of
 // each string in the table.
 
@@ -376,6 +618,8 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::set_string_offsets()
 {
+  gold_assert(this->is_string_table_);
+
   if (this->strtab_size_ != 0)
     {
       // We've already computed the offsets.
@@ -409,33 +653,41 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
            ++p)
         v.push_back(Stringpool_sort_info(p));
 
-      std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
+      // For a large string table, such as the .strtab of a big C++
+      // program, sort and look for suffixes using several threads.
+      // SHARES_SUFFIX[I] is then whether V[I] can share the end of
+      // V[I - 1].
+      std::vector<unsigned char> shares_suffix;
+      unsigned int thread_count =
+	Parallel_run::thread_count(Parallel_run::MIDDLE_PHASE);
+      if (thread_count > 1 && count >= parallel_sort_min_strings)
+	{
+	  Parallel_sort ps(this, &v, thread_count);
+	  ps.sort(&shares_suffix);
+	}
+      else
+	std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
 
       section_offset_type last_offset = -1;
-      for (typename std::vector<Stringpool_sort_info>::iterator last = v.end(),
-             curr = v.begin();
-           curr != v.end();
-           last = curr++)
+      for (size_t i = 0; i < count; ++i)
         {
+	  const Stringpool_sort_info& curr(v[i]);
 	  section_offset_type this_offset;
-          if (this->zero_null_ && (*curr)->first.string[0] == 0)
+          if (this->zero_null_ && curr->first.string[0] == 0)
             this_offset = 0;
-          else if (last != v.end()
-                   && ((((*curr)->first.length - (*last)->first.length)
-			% this->addralign_) == 0)
-                   && is_suffix((*curr)->first.string,
-				(*curr)->first.length,
-                                (*last)->first.string,
-				(*last)->first.length))
+          else if (i > 0
+		   && (shares_suffix.empty()
+		       ? this->can_share_suffix(curr, v[i - 1])
+		       : shares_suffix[i] != 0))
             this_offset = (last_offset
-			   + (((*last)->first.length - (*curr)->first.length)
+			   + ((v[i - 1]->first.length - curr->first.length)
 			      * charsize));
           else
             {
               this_offset = align_address(offset, this->addralign_);
-              offset = this_offset + ((*curr)->first.length + 1) * charsize;
+              offset = this_offset + (curr->first.length + 1) * charsize;
             }
-	  this->key_to_offset_[(*curr)->second - 1] = this_offset;
+	  this->key_to_offset_[curr->second - 1] = this_offset;
 	  last_offset = this_offset;
         }
     }
@@ -456,12 +708,13 @@ Stringpool_template<Stringpool_char>::get_offset(const Stringpool_char* s)
 
 template<typename Stringpool_char>
 section_offset_type
-Stringpool_template<Stringpool_char>::get_offset_with_length(
+Stringpool_template<Stringpool_char>::get_offset_with_hash(
     const Stringpool_char* s,
-    size_t length) const
+    size_t length,
+    uint32_t hash_code) const
 {
   gold_assert(this->strtab_size_ != 0);
-  Hashkey hk(s, length);
+  Hashkey hk(s, length, hash_code);
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p != this->string_set_.end())
     return this->key_to_offset_[p->second - 1];
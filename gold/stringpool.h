@@ -24,6 +24,8 @@
 #include <list>
 #include <vector>
 
+#include "arena.h"
+
 #ifndef GOLD_STRINGPOOL_H
 #define GOLD_STRINGPOOL_H
 
@@ -212,6 +214,17 @@ class Stringpool_template
   set_optimize()
   { this->optimize_ = true; }
 
+  // Indicate that this string pool will never be turned into a string
+  // table, so that the string offsets need not be recorded.  This is
+  // used for pools which only canonicalize strings, such as the names
+  // in the symbol table.
+  void
+  set_no_string_table()
+  {
+    gold_assert(this->string_set_.empty());
+    this->is_string_table_ = false;
+  }
+
   // Add the string S to the pool.  This returns a canonical permanent
   // pointer to the string in the pool.  If COPY is true, the string
   // is copied into permanent storage.  If PKEY is not NULL, this sets
@@ -227,7 +240,14 @@ class Stringpool_template
   // Add string S of length LEN characters to the pool.  If COPY is
   // true, S need not be null terminated.
   const Stringpool_char*
-  add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
+  add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey)
+  { return this->add_with_hash(s, len, string_hash(s, len), copy, pkey); }
+
+  // Add string S of length LEN characters, whose hash code as
+  // returned by string_hash is HASH_CODE, to the pool.
+  const Stringpool_char*
+  add_with_hash(const Stringpool_char* s, size_t len, uint32_t hash_code,
+		bool copy, Key* pkey);
 
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
@@ -235,6 +255,12 @@ class Stringpool_template
   const Stringpool_char*
   find(const Stringpool_char* s, Key* pkey) const;
 
+  // Likewise, for a string S of length LEN characters whose hash code
+  // is HASH_CODE.
+  const Stringpool_char*
+  find_with_hash(const Stringpool_char* s, size_t len, uint32_t hash_code,
+		 Key* pkey) const;
+
   // Turn the stringpool into a string table: determine the offsets of
   // all the strings.  After this is called, no more strings may be
   // added to the stringpool.
@@ -255,13 +281,20 @@ class Stringpool_template
   // Get the offset of string S, with length LENGTH characters, in the
   // string table.
   section_offset_type
-  get_offset_with_length(const Stringpool_char* s, size_t length) const;
+  get_offset_with_length(const Stringpool_char* s, size_t length) const
+  { return this->get_offset_with_hash(s, length, string_hash(s, length)); }
+
+  // Get the offset of string S, with length LENGTH characters and hash
+  // code HASH_CODE, in the string table.
+  section_offset_type
+  get_offset_with_hash(const Stringpool_char* s, size_t length,
+		       uint32_t hash_code) const;
 
   // Get the offset of the string with key K.
   section_offset_type
   get_offset_from_key(Key k) const
   {
-    gold_assert(k <= this->key_to_offset_.size());
+    gold_assert(this->is_string_table_ && k <= this->key_to_offset_.size());
     return this->key_to_offset_[k - 1];
   }
 
@@ -289,6 +322,15 @@ class Stringpool_template
   void
   print_stats(const char*) const;
 
+  // Compute the hash code which the pool uses for a string.  LENGTH is
+  // the length of the string in characters.  This is the low 32 bits
+  // of gold::string_hash, which for a char string is the hash code
+  // used by the dynamic linker for DT_GNU_HASH.  Callers which see
+  // the same string several times, such as the symbol table, may
+  // compute it once and pass it to add_with_hash.
+  static uint32_t
+  string_hash(const Stringpool_char* s, size_t length);
+
  private:
   Stringpool_template(const Stringpool_template&);
   Stringpool_template& operator=(const Stringpool_template&);
@@ -297,11 +339,6 @@ class Stringpool_template
   static bool
   string_equal(const Stringpool_char*, const Stringpool_char*);
 
-  // Compute a hash code for a string.  LENGTH is the length of the
-  // string in characters.
-  static size_t
-  string_hash(const Stringpool_char*, size_t length);
-
   // We store the actual data in a list of these buffers.
   struct Stringdata
   {
@@ -331,12 +368,14 @@ class Stringpool_template
   // explicitly into the key so that we can do a find()/insert()
   // sequence without having to recompute the hash.  Computing the
   // hash code is a significant user of CPU time in the linker.
+  // The length and the hash code are stored in 32 bits to keep the
+  // hash table nodes small.
   struct Hashkey
   {
     const Stringpool_char* string;
     // Length is in characters, not bytes.
-    size_t length;
-    size_t hash_code;
+    uint32_t length;
+    uint32_t hash_code;
 
     // This goes in an STL container, so we need a default
     // constructor.
@@ -347,20 +386,34 @@ class Stringpool_template
     // Note that these constructors are relatively expensive, because
     // they compute the hash code.
     explicit Hashkey(const Stringpool_char* s)
-      : string(s), length(string_length(s)), hash_code(string_hash(s, length))
+      : string(s), length(key_length(string_length(s))),
+	hash_code(string_hash(s, length))
     { }
 
     Hashkey(const Stringpool_char* s, size_t len)
-      : string(s), length(len), hash_code(string_hash(s, len))
+      : string(s), length(key_length(len)), hash_code(string_hash(s, len))
     { }
+
+    Hashkey(const Stringpool_char* s, size_t len, uint32_t hash)
+      : string(s), length(key_length(len)), hash_code(hash)
+    { }
+
+    // Return LEN as the length to store, checking that it fits.
+    static uint32_t
+    key_length(size_t len)
+    {
+      gold_assert(len == static_cast<uint32_t>(len));
+      return len;
+    }
   };
 
   // Hash function.  This is trivial, since we have already computed
-  // the hash.
+  // the hash.  It is declared not to throw so that the hash table
+  // does not store a second copy of the hash code in each node.
   struct Stringpool_hash
   {
     size_t
-    operator()(const Hashkey& hk) const
+    operator()(const Hashkey& hk) const noexcept
     { return hk.hash_code; }
   };
 
@@ -371,12 +424,17 @@ class Stringpool_template
     operator()(const Hashkey&, const Hashkey&) const;
   };
 
-  // The hash table is a map from strings to Keys.
+  // The hash table is a map from strings to Keys.  The nodes are
+  // allocated in ARENA_ rather than one at a time, since there is one
+  // for each string and they are freed all at once.
 
   typedef Key Hashval;
 
+  typedef Arena_node_allocator<std::pair<const Hashkey, Hashval> >
+    String_set_allocator;
+
   typedef Unordered_map<Hashkey, Hashval, Stringpool_hash,
-			Stringpool_eq> String_set_type;
+			Stringpool_eq, String_set_allocator> String_set_type;
 
   // Comparison routine used when sorting into a string table.
 
@@ -388,6 +446,22 @@ class Stringpool_template
     operator()(const Stringpool_sort_info&, const Stringpool_sort_info&) const;
   };
 
+  // Sorts the strings and finds the suffixes using several threads.
+  // This is defined in stringpool.cc.
+  class Parallel_sort;
+
+  // Return whether the string CURR can share the end of the string
+  // LAST, which comes before it in the sorted order.
+  bool
+  can_share_suffix(const Stringpool_sort_info& curr,
+		   const Stringpool_sort_info& last) const
+  {
+    return (((last->first.length - curr->first.length)
+	     % this->addralign_) == 0
+	    && is_suffix(curr->first.string, curr->first.length,
+			 last->first.string, last->first.length));
+  }
+
   // Keys map to offsets via a Chunked_vector.  We only use the
   // offsets if we turn this into an string table section.
   typedef Chunked_vector<section_offset_type> Key_to_offset;
@@ -395,10 +469,15 @@ class Stringpool_template
   // List of Stringdata structures.
   typedef std::list<Stringdata*> Stringdata_list;
 
+  // Storage for the nodes of STRING_SET_.
+  Arena arena_;
   // Mapping from const char* to namepool entry.
   String_set_type string_set_;
-  // Mapping from Key to string table offset.
+  // Mapping from Key to string table offset.  This is empty if
+  // IS_STRING_TABLE_ is false.
   Key_to_offset key_to_offset_;
+  // The number of keys which have been used.
+  Key key_count_;
   // List of buffers.
   Stringdata_list strings_;
   // Size of string table.
@@ -407,6 +486,8 @@ class Stringpool_template
   bool zero_null_;
   // Whether to optimize the string table.
   bool optimize_;
+  // Whether this pool may be turned into a string table.
+  bool is_string_table_;
   // offset of the next string.
   section_offset_type offset_;
   // The alignment of strings in the stringpool.
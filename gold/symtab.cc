@@ -25,6 +25,7 @@
 #include <cstring>
 #include <stdint.h>
 #include <algorithm>
+#include <new>
 #include <set>
 #include <string>
 #include <utility>
@@ -37,6 +38,7 @@
 #include "output.h"
 #include "target.h"
 #include "workqueue.h"
+#include "gold-threads.h"
 #include "symtab.h"
 #include "script.h"
 #include "plugin.h"
@@ -51,16 +53,16 @@ namespace gold
 // u1_, u2_ and source_.
 
 void
-Symbol::init_fields(const char* name, const char* version,
+Symbol::init_fields(const char* name, uint32_t name_hash, const char* version,
 		    elfcpp::STT type, elfcpp::STB binding,
 		    elfcpp::STV visibility, unsigned char nonvis)
 {
   this->name_ = name;
   this->version_ = version;
+  this->name_hash_ = name_hash;
   this->symtab_index_ = 0;
   this->dynsym_index_ = 0;
-  this->got_offsets_.init();
-  this->plt_offset_ = -1U;
+  this->got_plt_offsets_ = NULL;
   this->type_ = type;
   this->binding_ = binding;
   this->visibility_ = visibility;
@@ -114,12 +116,14 @@ Symbol::demangled_name() const
 
 template<int size, bool big_endian>
 void
-Symbol::init_base_object(const char* name, const char* version, Object* object,
+Symbol::init_base_object(const char* name, uint32_t name_hash,
+			 const char* version, Object* object,
 			 const elfcpp::Sym<size, big_endian>& sym,
 			 unsigned int st_shndx, bool is_ordinary)
 {
-  this->init_fields(name, version, sym.get_st_type(), sym.get_st_bind(),
-		    sym.get_st_visibility(), sym.get_st_nonvis());
+  this->init_fields(name, name_hash, version, sym.get_st_type(),
+		    sym.get_st_bind(), sym.get_st_visibility(),
+		    sym.get_st_nonvis());
   this->u1_.object = object;
   this->u2_.shndx = st_shndx;
   this->is_ordinary_shndx_ = is_ordinary;
@@ -139,7 +143,8 @@ Symbol::init_base_output_data(const char* name, const char* version,
 			      unsigned char nonvis, bool offset_is_from_end,
 			      bool is_predefined)
 {
-  this->init_fields(name, version, type, binding, visibility, nonvis);
+  this->init_fields(name, Stringpool::string_hash(name, strlen(name)),
+		    version, type, binding, visibility, nonvis);
   this->u1_.output_data = od;
   this->u2_.offset_is_from_end = offset_is_from_end;
   this->source_ = IN_OUTPUT_DATA;
@@ -159,7 +164,8 @@ Symbol::init_base_output_segment(const char* name, const char* version,
 				 Segment_offset_base offset_base,
 				 bool is_predefined)
 {
-  this->init_fields(name, version, type, binding, visibility, nonvis);
+  this->init_fields(name, Stringpool::string_hash(name, strlen(name)),
+		    version, type, binding, visibility, nonvis);
   this->u1_.output_segment = os;
   this->u2_.offset_base = offset_base;
   this->source_ = IN_OUTPUT_SEGMENT;
@@ -177,7 +183,8 @@ Symbol::init_base_constant(const char* name, const char* version,
 			   elfcpp::STV visibility, unsigned char nonvis,
 			   bool is_predefined)
 {
-  this->init_fields(name, version, type, binding, visibility, nonvis);
+  this->init_fields(name, Stringpool::string_hash(name, strlen(name)),
+		    version, type, binding, visibility, nonvis);
   this->source_ = IS_CONSTANT;
   this->in_reg_ = true;
   this->in_real_elf_ = true;
@@ -192,7 +199,8 @@ Symbol::init_base_undefined(const char* name, const char* version,
 			    elfcpp::STT type, elfcpp::STB binding,
 			    elfcpp::STV visibility, unsigned char nonvis)
 {
-  this->init_fields(name, version, type, binding, visibility, nonvis);
+  this->init_fields(name, Stringpool::string_hash(name, strlen(name)),
+		    version, type, binding, visibility, nonvis);
   this->dynsym_index_ = -1U;
   this->source_ = IS_UNDEFINED;
   this->in_reg_ = true;
@@ -215,12 +223,13 @@ Symbol::allocate_base_common(Output_data* od)
 template<int size>
 template<bool big_endian>
 void
-Sized_symbol<size>::init_object(const char* name, const char* version,
-				Object* object,
+Sized_symbol<size>::init_object(const char* name, uint32_t name_hash,
+				const char* version, Object* object,
 				const elfcpp::Sym<size, big_endian>& sym,
 				unsigned int st_shndx, bool is_ordinary)
 {
-  this->init_base_object(name, version, object, sym, st_shndx, is_ordinary);
+  this->init_base_object(name, name_hash, version, object, sym, st_shndx,
+			 is_ordinary);
   this->value_ = sym.get_st_value();
   this->symsize_ = sym.get_st_size();
 }
@@ -574,17 +583,450 @@ Symbol::set_undefined()
 
 Symbol_table::Symbol_table(unsigned int count,
                            const Version_script_info& version_script)
-  : saw_undefined_(0), offset_(0), has_gnu_output_(false), table_(count),
-    namepool_(), forwarders_(), commons_(), tls_commons_(), small_commons_(),
-    large_commons_(), forced_locals_(), warnings_(),
+  : saw_undefined_(0), new_undefined_symbols_(), offset_(0), has_gnu_output_(false),
+    pending_lock_(new Lock()), has_pending_symbols_(false), forwarders_(),
+    forwarders_lock_(new Lock()), lazy_dynobjs_(), lazy_names_(),
+    is_importing_lazy_symbols_(false), commons_(), tls_commons_(),
+    small_commons_(), large_commons_(), forced_locals_(), warnings_(),
     version_script_(version_script), gc_(NULL), icf_(NULL),
     target_symbols_()
 {
-  namepool_.reserve(count);
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      Symbol_table_shard* shard = &this->shards_[i];
+      reserve_unordered_map(&shard->table, count / shard_count);
+      shard->namepool.set_no_string_table();
+      shard->namepool.reserve(count / shard_count);
+      shard->lock = new Lock();
+    }
 }
 
 Symbol_table::~Symbol_table()
 {
+  for (unsigned int i = 0; i < shard_count; ++i)
+    delete this->shards_[i].lock;
+  delete this->pending_lock_;
+  delete this->forwarders_lock_;
+}
+
+// Class Symbol_table::Pending_symbols.
+
+// When running with threads, the global symbols from a relocatable
+// object are checked in order by the task which reads the object, and
+// then added to the symbol table by separate tasks, one per shard.
+// Symbols for the same shard are added in the order in which the
+// objects were read, so symbol resolution is the same as when adding
+// them directly.  Since the file is unlocked before the symbols are
+// added, we keep a copy of the symbols and their names.
+
+class Symbol_table::Pending_symbols
+{
+ public:
+  Pending_symbols()
+    : refcount_(0)
+  { }
+
+  virtual
+  ~Pending_symbols()
+  { }
+
+  // Add the symbols for SHARD, whose index is SHARD_INDEX, to SYMTAB.
+  // Return the number of symbols added.
+  size_t
+  add_to_shard(Symbol_table* symtab, Symbol_table_shard* shard,
+	       unsigned int shard_index)
+  { return this->do_add_to_shard(symtab, shard, shard_index); }
+
+  // Return whether there are any symbols for the shard SHARD_INDEX.
+  bool
+  has_symbols(unsigned int shard_index) const
+  { return this->do_has_symbols(shard_index); }
+
+  // Record that this is on another shard queue.  The caller must hold
+  // the pending lock.
+  void
+  add_ref()
+  { ++this->refcount_; }
+
+  // Record that this has been removed from a shard queue.  Return
+  // true if it is not on any other queue, and can be deleted.  The
+  // caller must hold the pending lock.
+  bool
+  release()
+  {
+    gold_assert(this->refcount_ > 0);
+    return --this->refcount_ == 0;
+  }
+
+  // Return whether this is on any shard queue.
+  bool
+  is_queued() const
+  { return this->refcount_ > 0; }
+
+ protected:
+  virtual size_t
+  do_add_to_shard(Symbol_table*, Symbol_table_shard*, unsigned int) = 0;
+
+  virtual bool
+  do_has_symbols(unsigned int) const = 0;
+
+ private:
+  // The number of shard queues which hold this.
+  unsigned int refcount_;
+};
+
+// The sized version of Pending_symbols.
+
+template<int size, bool big_endian>
+class Symbol_table::Sized_pending_symbols
+  : public Symbol_table::Pending_symbols
+{
+ public:
+  typedef typename Sized_relobj_file<size, big_endian>::Symbols Symbols;
+
+  Sized_pending_symbols(Sized_relobj_file<size, big_endian>* relobj,
+			const char* sym_names, size_t sym_name_size,
+			Symbols* sympointers)
+    : relobj_(relobj), sym_names_(sym_names, sym_name_size),
+      sympointers_(sympointers)
+  { }
+
+  // Record the symbol at P, which is global symbol SYMNDX in the
+  // object, for the shard SHARD_INDEX.  The other arguments are as
+  // for Symbol_table::add_relobj_symbol.
+  void
+  add(unsigned int shard_index, unsigned int symndx,
+      const unsigned char* p, size_t namelen, uint32_t name_hash,
+      bool has_version, unsigned int st_shndx, bool is_ordinary,
+      unsigned int orig_st_shndx, bool is_defined_in_discarded_section)
+  {
+    Pending_symbol ps;
+    memcpy(ps.sym, p, sym_size);
+    ps.symndx = symndx;
+    ps.namelen = namelen;
+    ps.name_hash = name_hash;
+    ps.st_shndx = st_shndx;
+    ps.orig_st_shndx = orig_st_shndx;
+    ps.is_ordinary = is_ordinary;
+    ps.has_version = has_version;
+    ps.is_defined_in_discarded_section = is_defined_in_discarded_section;
+    this->symbols_[shard_index].push_back(ps);
+  }
+
+ protected:
+  size_t
+  do_add_to_shard(Symbol_table*, Symbol_table_shard*, unsigned int);
+
+  bool
+  do_has_symbols(unsigned int shard_index) const
+  { return !this->symbols_[shard_index].empty(); }
+
+ private:
+  static const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  // A symbol waiting to be added.
+  struct Pending_symbol
+  {
+    // The symbol, as adjusted by add_from_relobj.
+    unsigned char sym[sym_size];
+    // The index of the symbol in the object's global symbols.
+    unsigned int symndx;
+    // The length of the name, not including any version.
+    unsigned int namelen;
+    // The hash code of the name.
+    uint32_t name_hash;
+    unsigned int st_shndx;
+    unsigned int orig_st_shndx;
+    bool is_ordinary;
+    // Whether the name is followed by '@' and a version.
+    bool has_version;
+    bool is_defined_in_discarded_section;
+  };
+
+  // The object.
+  Sized_relobj_file<size, big_endian>* relobj_;
+  // A copy of the symbol names.
+  std::string sym_names_;
+  // Where to store the symbols, indexed by SYMNDX.
+  Symbols* sympointers_;
+  // The symbols for each shard, in the order in which they appear in
+  // the object.
+  std::vector<Pending_symbol> symbols_[shard_count];
+};
+
+template<int size, bool big_endian>
+size_t
+Symbol_table::Sized_pending_symbols<size, big_endian>::do_add_to_shard(
+    Symbol_table* symtab,
+    Symbol_table_shard* shard,
+    unsigned int shard_index)
+{
+  const std::vector<Pending_symbol>& symbols(this->symbols_[shard_index]);
+  for (typename std::vector<Pending_symbol>::const_iterator p =
+	 symbols.begin();
+       p != symbols.end();
+       ++p)
+    {
+      elfcpp::Sym<size, big_endian> sym(p->sym);
+      const char* name = this->sym_names_.data() + sym.get_st_name();
+      const char* ver = p->has_version ? name + p->namelen : NULL;
+      Sized_symbol<size>* res =
+	symtab->add_relobj_symbol(shard, this->relobj_, name, p->namelen,
+				  p->name_hash, ver, sym, p->st_shndx,
+				  p->is_ordinary,
+				  p->orig_st_shndx,
+				  p->is_defined_in_discarded_section);
+      (*this->sympointers_)[p->symndx] = res;
+    }
+  return symbols.size();
+}
+
+// A task which adds the pending symbols for one shard of the symbol
+// table.
+
+class Add_shard_symbols : public Task
+{
+ public:
+  Add_shard_symbols(Symbol_table* symtab, unsigned int shard)
+    : symtab_(symtab), shard_(shard)
+  { }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->symtab_->add_shard_symbols(this->shard_); }
+
+  std::string
+  get_name() const
+  { return "Add_shard_symbols"; }
+
+ private:
+  Symbol_table* symtab_;
+  unsigned int shard_;
+};
+
+// Return the index of the shard for a name with hash code NAME_HASH.
+// The low bits of string_hash are not well distributed, so we mix in
+// the high bits.  The hash code is only 32 bits, so the result, and
+// hence the order of the output symbols, is the same on every host.
+
+unsigned int
+Symbol_table::shard_index(uint32_t name_hash)
+{
+  uint32_t h = name_hash;
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+  return h % shard_count;
+}
+
+// Return the shard for a name with hash code NAME_HASH, first adding
+// any symbols which are waiting to be added to it.
+
+Symbol_table::Symbol_table_shard*
+Symbol_table::sync_shard(uint32_t name_hash)
+{
+  Symbol_table_shard* shard = this->get_shard(name_hash);
+  if (this->has_pending_symbols_)
+    this->add_shard_symbols(shard, false);
+  return shard;
+}
+
+// Return whether the symbols from relocatable objects may be added by
+// separate tasks.  We only do this when resolving a symbol can not
+// look at symbols with other names.
+
+bool
+Symbol_table::can_queue_symbols() const
+{
+  const General_options& options(parameters->options());
+  return (options.threads()
+	  && !options.any_wrap()
+	  && !options.has_plugins()
+	  && !options.detect_odr_violations()
+	  && !parameters->incremental()
+	  && !parameters->target().has_make_symbol()
+	  && !parameters->target().has_resolve()
+	  && this->weak_aliases_.empty());
+}
+
+// Queue the symbols in PENDING on the shards for which it has
+// symbols.
+
+void
+Symbol_table::queue_symbols(Pending_symbols* pending)
+{
+  {
+    Hold_lock hl(*this->pending_lock_);
+    for (unsigned int i = 0; i < shard_count; ++i)
+      {
+	if (pending->has_symbols(i))
+	  {
+	    this->shards_[i].pending.push_back(pending);
+	    pending->add_ref();
+	  }
+      }
+  }
+  if (!pending->is_queued())
+    delete pending;
+  else
+    this->has_pending_symbols_ = true;
+}
+
+// Queue a task for each shard which has pending symbols and does not
+// already have a task.
+
+void
+Symbol_table::queue_pending_symbols(Workqueue* workqueue)
+{
+  if (!this->has_pending_symbols_)
+    return;
+
+  std::vector<unsigned int> shards;
+  {
+    Hold_lock hl(*this->pending_lock_);
+    for (unsigned int i = 0; i < shard_count; ++i)
+      {
+	Symbol_table_shard* shard = &this->shards_[i];
+	if (!shard->pending.empty() && !shard->task_queued)
+	  {
+	    shard->task_queued = true;
+	    shards.push_back(i);
+	  }
+      }
+  }
+
+  for (std::vector<unsigned int>::const_iterator p = shards.begin();
+       p != shards.end();
+       ++p)
+    workqueue->queue_soon(new Add_shard_symbols(this, *p));
+}
+
+// Add the pending symbols for shard SHARD.  This is called by
+// Add_shard_symbols.
+
+void
+Symbol_table::add_shard_symbols(unsigned int shard)
+{
+  gold_assert(shard < shard_count);
+  this->add_shard_symbols(&this->shards_[shard], true);
+}
+
+// Add the pending symbols for SHARD, in order.  FROM_TASK is true if
+// we are called by Add_shard_symbols, in which case we clear the
+// flag saying that a task is queued once the queue is empty.
+
+void
+Symbol_table::add_shard_symbols(Symbol_table_shard* shard, bool from_task)
+{
+  if (!shard->lock->try_acquire())
+    {
+      shard->lock->acquire();
+      ++shard->lock_waits;
+    }
+
+  const unsigned int shard_index = shard - this->shards_;
+  while (true)
+    {
+      Pending_symbols* pending;
+      {
+	Hold_lock hl(*this->pending_lock_);
+	if (shard->pending.empty())
+	  {
+	    if (from_task)
+	      shard->task_queued = false;
+	    break;
+	  }
+	pending = shard->pending.front();
+	shard->pending.pop_front();
+      }
+
+      shard->queued_symbols += pending->add_to_shard(this, shard,
+						     shard_index);
+      ++shard->queued_batches;
+
+      bool done;
+      {
+	Hold_lock hl(*this->pending_lock_);
+	done = pending->release();
+      }
+      if (done)
+	delete pending;
+    }
+
+  shard->lock->release();
+}
+
+// Wait for all pending symbols to be added, and then move the symbols
+// which were recorded in each shard to the lists for the whole table.
+// The shards are always processed in the same order, so the lists do
+// not depend on whether the symbols were added in parallel.
+
+void
+Symbol_table::add_pending_symbols()
+{
+  if (this->has_pending_symbols_)
+    {
+      for (unsigned int i = 0; i < shard_count; ++i)
+	this->add_shard_symbols(&this->shards_[i], false);
+      this->has_pending_symbols_ = false;
+    }
+
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      Symbol_table_shard* shard = &this->shards_[i];
+
+      this->commons_.insert(this->commons_.end(), shard->commons.begin(),
+			    shard->commons.end());
+      shard->commons.clear();
+      this->tls_commons_.insert(this->tls_commons_.end(),
+				shard->tls_commons.begin(),
+				shard->tls_commons.end());
+      shard->tls_commons.clear();
+      this->small_commons_.insert(this->small_commons_.end(),
+				  shard->small_commons.begin(),
+				  shard->small_commons.end());
+      shard->small_commons.clear();
+      this->large_commons_.insert(this->large_commons_.end(),
+				  shard->large_commons.begin(),
+				  shard->large_commons.end());
+      shard->large_commons.clear();
+      this->forced_locals_.insert(this->forced_locals_.end(),
+				  shard->forced_locals.begin(),
+				  shard->forced_locals.end());
+      shard->forced_locals.clear();
+
+      for (std::vector<Symbol*>::const_iterator p = shard->gc_symbols.begin();
+	   p != shard->gc_symbols.end();
+	   ++p)
+	this->gc_mark_symbol(*p);
+      shard->gc_symbols.clear();
+
+      this->saw_undefined_ += shard->saw_undefined;
+      shard->saw_undefined = 0;
+      this->new_undefined_symbols_.insert(this->new_undefined_symbols_.end(),
+					  shard->new_undefined_symbols.begin(),
+					  shard->new_undefined_symbols.end());
+      shard->new_undefined_symbols.clear();
+    }
+}
+
+// Canonicalize a symbol name for use in the hash table.
+
+const char*
+Symbol_table::canonicalize_name(const char* name)
+{
+  size_t len = strlen(name);
+  uint32_t name_hash = Stringpool::string_hash(name, len);
+  Symbol_table_shard* shard = this->sync_shard(name_hash);
+  return shard->namepool.add_with_hash(name, len, name_hash, true, NULL);
 }
 
 // The symbol table key equality function.  This is called with
@@ -673,13 +1115,14 @@ Symbol_table::gc_mark_symbol(Symbol* sym)
 }
 
 // When doing garbage collection, keep symbols that have been seen in
-// dynamic objects.
-inline void 
-Symbol_table::gc_mark_dyn_syms(Symbol* sym)
+// dynamic objects.  The symbols are marked by add_pending_symbols.
+
+void
+Symbol_table::gc_mark_dyn_syms(Symbol_table_shard* shard, Symbol* sym)
 {
   if (sym->in_dyn() && sym->source() == Symbol::FROM_OBJECT
       && !sym->object()->is_dynamic())
-    this->gc_mark_symbol(sym);
+    shard->gc_symbols.push_back(sym);
 }
 
 // Make TO a symbol which forwards to FROM.
@@ -689,7 +1132,10 @@ Symbol_table::make_forwarder(Symbol* from, Symbol* to)
 {
   gold_assert(from != to);
   gold_assert(!from->is_forwarder() && !to->is_forwarder());
-  this->forwarders_[from] = to;
+  {
+    Hold_lock hl(*this->forwarders_lock_);
+    this->forwarders_[from] = to;
+  }
   from->set_forwarder();
 }
 
@@ -710,26 +1156,42 @@ Symbol_table::resolve_forwards(const Symbol* from) const
 Symbol*
 Symbol_table::lookup(const char* name, const char* version) const
 {
+  size_t len = strlen(name);
+  uint32_t name_hash = Stringpool::string_hash(name, len);
+  const Symbol_table_shard* shard =
+    &this->shards_[Symbol_table::shard_index(name_hash)];
+
   Stringpool::Key name_key;
-  name = this->namepool_.find(name, &name_key);
+  name = shard->namepool.find_with_hash(name, len, name_hash, &name_key);
   if (name == NULL)
     return NULL;
 
   Stringpool::Key version_key = 0;
   if (version != NULL)
     {
-      version = this->namepool_.find(version, &version_key);
+      version = shard->namepool.find(version, &version_key);
       if (version == NULL)
 	return NULL;
     }
 
-  Symbol_table_key key(name_key, version_key);
-  Symbol_table::Symbol_table_type::const_iterator p = this->table_.find(key);
-  if (p == this->table_.end())
+  Symbol_table_key key(symbol_table_key(name_key, version_key));
+  Symbol_table::Symbol_table_type::const_iterator p = shard->table.find(key);
+  if (p == shard->table.end())
     return NULL;
   return p->second;
 }
 
+// Look up a symbol by name, after adding any symbols with that name
+// which are still pending.
+
+Symbol*
+Symbol_table::lookup(const char* name, const char* version)
+{
+  this->sync_shard(Stringpool::string_hash(name, strlen(name)));
+  const Symbol_table* symtab = this;
+  return symtab->lookup(name, version);
+}
+
 // Resolve a Symbol with another Symbol.  This is only used in the
 // unusual case where there are references to both an unversioned
 // symbol and a symbol with a version, and we then discover that that
@@ -738,7 +1200,8 @@ Symbol_table::lookup(const char* name, const char* version) const
 
 template<int size, bool big_endian>
 void
-Symbol_table::resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from)
+Symbol_table::resolve(Symbol_table_shard* shard, Sized_symbol<size>* to,
+		      const Sized_symbol<size>* from)
 {
   unsigned char buf[elfcpp::Elf_sizes<size>::sym_size];
   elfcpp::Sym_write<size, big_endian> esym(buf);
@@ -756,7 +1219,7 @@ Symbol_table::resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from)
   if (from->in_dyn())
     to->set_in_dyn();
   if (parameters->options().gc_sections())
-    this->gc_mark_dyn_syms(to);
+    this->gc_mark_dyn_syms(shard, to);
 }
 
 // Record that a symbol is forced to be local by a version script or
@@ -776,12 +1239,30 @@ Symbol_table::force_local(Symbol* sym)
   this->forced_locals_.push_back(sym);
 }
 
-// Adjust NAME for wrapping, and update *NAME_KEY if necessary.  This
-// is only called for undefined symbols, when at least one --wrap
-// option was used.
+// Likewise, for a symbol in SHARD.  The symbol is moved to
+// forced_locals_ by add_pending_symbols.
+
+void
+Symbol_table::force_local(Symbol_table_shard* shard, Symbol* sym)
+{
+  if (!sym->is_defined() && !sym->is_common())
+    return;
+  if (sym->is_forced_local())
+    {
+      // We already got this one.
+      return;
+    }
+  sym->set_is_forced_local();
+  shard->forced_locals.push_back(sym);
+}
+
+// Adjust NAME for wrapping, and update *NAME_KEY and *PSHARD if
+// necessary.  This is only called for undefined symbols, when at
+// least one --wrap option was used.
 
 const char*
-Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
+Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key,
+			  Symbol_table_shard** pshard)
 {
   // For some targets, we need to ignore a specific character when
   // wrapping, and add it back later.
@@ -801,10 +1282,13 @@ Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
       s += "__wrap_";
       s += name;
 
-      // This will give us both the old and new name in NAMEPOOL_, but
-      // that is OK.  Only the versions we need will wind up in the
-      // real string table in the output file.
-      return this->namepool_.add(s.c_str(), true, name_key);
+      // This will give us both the old and new name in the name
+      // pools, but that is OK.  Only the versions we need will wind
+      // up in the real string table in the output file.
+      uint32_t name_hash = Stringpool::string_hash(s.data(), s.length());
+      *pshard = this->sync_shard(name_hash);
+      return (*pshard)->namepool.add_with_hash(s.data(), s.length(),
+					       name_hash, true, name_key);
     }
 
   const char* const real_prefix = "__real_";
@@ -817,7 +1301,10 @@ Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
       if (prefix != '\0')
 	s += prefix;
       s += name + real_prefix_length;
-      return this->namepool_.add(s.c_str(), true, name_key);
+      uint32_t name_hash = Stringpool::string_hash(s.data(), s.length());
+      *pshard = this->sync_shard(name_hash);
+      return (*pshard)->namepool.add_with_hash(s.data(), s.length(),
+					       name_hash, true, name_key);
     }
 
   return name;
@@ -831,7 +1318,8 @@ Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
 
 template<int size, bool big_endian>
 void
-Symbol_table::define_default_version(Sized_symbol<size>* sym,
+Symbol_table::define_default_version(Symbol_table_shard* shard,
+				     Sized_symbol<size>* sym,
 				     bool default_is_new,
 				     Symbol_table_type::iterator pdef)
 {
@@ -899,7 +1387,7 @@ Symbol_table::define_default_version(Sized_symbol<size>* sym,
 	{
 	  const Sized_symbol<size>* symdef;
 	  symdef = this->get_sized_symbol<size>(pdef->second);
-	  Symbol_table::resolve<size, big_endian>(sym, symdef);
+	  Symbol_table::resolve<size, big_endian>(shard, sym, symdef);
 	  this->make_forwarder(pdef->second, sym);
 	  pdef->second = sym;
 	  sym->set_is_default();
@@ -939,9 +1427,11 @@ Symbol_table::define_default_version(Sized_symbol<size>* sym,
 
 template<int size, bool big_endian>
 Sized_symbol<size>*
-Symbol_table::add_from_object(Object* object,
+Symbol_table::add_from_object(Symbol_table_shard* shard,
+			      Object* object,
 			      const char* name,
 			      Stringpool::Key name_key,
+			      uint32_t name_hash,
 			      const char* version,
 			      Stringpool::Key version_key,
 			      bool is_default_version,
@@ -964,7 +1454,7 @@ Symbol_table::add_from_object(Object* object,
   if (orig_st_shndx == elfcpp::SHN_UNDEF
       && parameters->options().any_wrap())
     {
-      const char* wrap_name = this->wrap_symbol(name, &name_key);
+      const char* wrap_name = this->wrap_symbol(name, &name_key, &shard);
       if (wrap_name != name)
 	{
 	  // If we see a reference to malloc with version GLIBC_2.0,
@@ -975,22 +1465,27 @@ Symbol_table::add_from_object(Object* object,
 	  version = NULL;
 	  version_key = 0;
 	  name = wrap_name;
+	  name_hash = Stringpool::string_hash(name, strlen(name));
 	}
     }
 
+  // Insert a const value_type, so that no node is allocated if the
+  // symbol is already present.
   Symbol* const snull = NULL;
+  const Symbol_table_type::value_type entry(symbol_table_key(name_key,
+							     version_key),
+					    snull);
   std::pair<typename Symbol_table_type::iterator, bool> ins =
-    this->table_.insert(std::make_pair(std::make_pair(name_key, version_key),
-				       snull));
+    shard->table.insert(entry);
 
   std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-    std::make_pair(this->table_.end(), false);
+    std::make_pair(shard->table.end(), false);
   if (is_default_version)
     {
       const Stringpool::Key vnull_key = 0;
-      insdefault = this->table_.insert(std::make_pair(std::make_pair(name_key,
-								     vnull_key),
-						      snull));
+      const Symbol_table_type::value_type default_entry(
+	  symbol_table_key(name_key, vnull_key), snull);
+      insdefault = shard->table.insert(default_entry);
     }
 
   // ins.first: an iterator, which is a pointer to a pair.
@@ -1000,6 +1495,7 @@ Symbol_table::add_from_object(Object* object,
 
   Sized_symbol<size>* ret = NULL;
   bool was_undefined_in_reg;
+  bool was_strong_undefined;
   bool was_common;
   if (!ins.second)
     {
@@ -1011,6 +1507,8 @@ Symbol_table::add_from_object(Object* object,
       const unsigned int ret_shndx = ret->shndx(&ret_is_ordinary);
 
       was_undefined_in_reg = ret->is_undefined() && ret->in_reg();
+      was_strong_undefined = (ret->is_undefined()
+			      && ret->binding() != elfcpp::STB_WEAK);
       // Commons from plugins are just placeholders.
       was_common = ret->is_common() && ret->object()->pluginobj() == NULL;
 
@@ -1066,10 +1564,11 @@ Symbol_table::add_from_object(Object* object,
 		      object, version, is_default_version);
 
       if (parameters->options().gc_sections())
-        this->gc_mark_dyn_syms(ret);
+        this->gc_mark_dyn_syms(shard, ret);
 
       if (is_default_version)
-	this->define_default_version<size, big_endian>(ret, insdefault.second,
+	this->define_default_version<size, big_endian>(shard, ret,
+						       insdefault.second,
 						       insdefault.first);
       else
 	{
@@ -1092,11 +1591,11 @@ Symbol_table::add_from_object(Object* object,
 	      // the unversioned symbol the default versioned symbol.
 	      const Stringpool::Key vnull_key = 0;
 	      if (erase_default_version)
-		this->table_.erase(std::make_pair(name_key, vnull_key));
+		shard->table.erase(symbol_table_key(name_key, vnull_key));
 	      else if (ret->object() == object)
 		{
 		  ret->set_is_not_default();
-		  this->table_.erase(std::make_pair(name_key, vnull_key));
+		  shard->table.erase(symbol_table_key(name_key, vnull_key));
 		}
 	    }
 	}
@@ -1135,6 +1634,8 @@ Symbol_table::add_from_object(Object* object,
 	  else
 	    {
 	      was_undefined_in_reg = ret->is_undefined() && ret->in_reg();
+	      was_strong_undefined = (ret->is_undefined()
+				      && ret->binding() != elfcpp::STB_WEAK);
 	      // Commons from plugins are just placeholders.
 	      was_common = (ret->is_common()
 			    && ret->object()->pluginobj() == NULL);
@@ -1142,7 +1643,7 @@ Symbol_table::add_from_object(Object* object,
 	      this->resolve(ret, sym, st_shndx, is_ordinary, orig_st_shndx,
 			    object, version, is_default_version);
 	      if (parameters->options().gc_sections())
-		this->gc_mark_dyn_syms(ret);
+		this->gc_mark_dyn_syms(shard, ret);
 	      ins.first->second = ret;
 	    }
 	}
@@ -1150,12 +1651,16 @@ Symbol_table::add_from_object(Object* object,
       if (ret == NULL)
 	{
 	  was_undefined_in_reg = false;
+	  was_strong_undefined = false;
 	  was_common = false;
 
 	  Sized_target<size, big_endian>* target =
 	    parameters->sized_target<size, big_endian>();
 	  if (!target->has_make_symbol())
-	    ret = new Sized_symbol<size>();
+	    {
+	      void* p = shard->arena.allocate(sizeof(Sized_symbol<size>));
+	      ret = new(p) Sized_symbol<size>();
+	    }
 	  else
 	    {
 	      ret = target->make_symbol(name, sym.get_st_type(), object,
@@ -1165,19 +1670,20 @@ Symbol_table::add_from_object(Object* object,
 		  // This means that we don't want a symbol table
 		  // entry after all.
 		  if (!is_default_version)
-		    this->table_.erase(ins.first);
+		    shard->table.erase(ins.first);
 		  else
 		    {
-		      this->table_.erase(insdefault.first);
+		      shard->table.erase(insdefault.first);
 		      // Inserting INSDEFAULT invalidated INS.
-		      this->table_.erase(std::make_pair(name_key,
-							version_key));
+		      shard->table.erase(symbol_table_key(name_key,
+							  version_key));
 		    }
 		  return NULL;
 		}
 	    }
 
-	  ret->init_object(name, version, object, sym, st_shndx, is_ordinary);
+	  ret->init_object(name, name_hash, version, object, sym, st_shndx,
+			   is_ordinary);
 
 	  ins.first->second = ret;
 	  if (is_default_version)
@@ -1198,11 +1704,18 @@ Symbol_table::add_from_object(Object* object,
   // because undefined symbols only in dynamic objects should't trigger rescans.
   if (!was_undefined_in_reg && ret->is_undefined() && ret->in_reg())
     {
-      ++this->saw_undefined_;
+      ++shard->saw_undefined;
       if (parameters->options().has_plugins())
 	parameters->options().plugins()->new_undefined_symbol(ret);
     }
 
+  // Record every symbol which becomes a strong undefined symbol, as
+  // only these can cause another archive member to be included.
+  if (!was_strong_undefined
+      && ret->is_undefined()
+      && ret->binding() != elfcpp::STB_WEAK)
+    shard->new_undefined_symbols.push_back(ret);
+
   // Keep track of common symbols, to speed up common symbol
   // allocation.  Don't record commons from plugin objects;
   // we need to wait until we see the real symbol in the
@@ -1210,15 +1723,15 @@ Symbol_table::add_from_object(Object* object,
   if (!was_common && ret->is_common() && ret->object()->pluginobj() == NULL)
     {
       if (ret->type() == elfcpp::STT_TLS)
-	this->tls_commons_.push_back(ret);
+	shard->tls_commons.push_back(ret);
       else if (!is_ordinary
 	       && st_shndx == parameters->target().small_common_shndx())
-	this->small_commons_.push_back(ret);
+	shard->small_commons.push_back(ret);
       else if (!is_ordinary
 	       && st_shndx == parameters->target().large_common_shndx())
-	this->large_commons_.push_back(ret);
+	shard->large_commons.push_back(ret);
       else
-	this->commons_.push_back(ret);
+	shard->commons.push_back(ret);
     }
 
   // If we're not doing a relocatable link, then any symbol with
@@ -1229,12 +1742,15 @@ Symbol_table::add_from_object(Object* object,
 	  || ret->binding() == elfcpp::STB_GNU_UNIQUE
 	  || ret->binding() == elfcpp::STB_WEAK)
       && !parameters->options().relocatable())
-    this->force_local(ret);
+    this->force_local(shard, ret);
 
   return ret;
 }
 
-// Add all the symbols in a relocatable object to the hash table.
+// Add all the symbols in a relocatable object to the hash table.  The
+// symbols are checked here, in order, while the object is locked.
+// When running with threads, they are then added to the symbol table
+// by separate tasks, one per shard.
 
 template<int size, bool big_endian>
 void
@@ -1256,6 +1772,32 @@ Symbol_table::add_from_relobj(
 
   const bool just_symbols = relobj->just_symbols();
 
+  // Add any symbols with the same names from lazily read dynamic
+  // objects first, before any of the symbols of this object are
+  // added, so that symbol resolution sees them in the order in which
+  // the objects were read.
+  if (!this->lazy_dynobjs_.empty())
+    {
+      const unsigned char* p = syms;
+      for (size_t i = 0; i < count; ++i, p += sym_size)
+	{
+	  elfcpp::Sym<size, big_endian> sym(p);
+	  unsigned int st_name = sym.get_st_name();
+	  if (st_name >= sym_name_size)
+	    continue;
+	  const char* name = sym_names + st_name;
+	  const char* ver = strchr(name, '@');
+	  this->import_lazy_symbols(name,
+				    ver != NULL ? ver - name : strlen(name));
+	}
+    }
+
+  Sized_pending_symbols<size, big_endian>* pending = NULL;
+  if (count > 0 && this->can_queue_symbols())
+    pending = new Sized_pending_symbols<size, big_endian>(relobj, sym_names,
+							  sym_name_size,
+							  sympointers);
+
   const unsigned char* p = syms;
   for (size_t i = 0; i < count; ++i, p += sym_size)
     {
@@ -1304,102 +1846,56 @@ Symbol_table::add_from_relobj(
 	}
 
       // In an object file, an '@' in the name separates the symbol
-      // name from the version name.  If there are two '@' characters,
-      // this is the default version.
+      // name from the version name.
       const char* ver = strchr(name, '@');
-      Stringpool::Key ver_key = 0;
-      int namelen = 0;
-      // IS_DEFAULT_VERSION: is the version default?
-      // IS_FORCED_LOCAL: is the symbol forced local?
-      bool is_default_version = false;
-      bool is_forced_local = false;
 
       // FIXME: For incremental links, we don't store version information,
       // so we need to ignore version symbols for now.
       if (parameters->incremental_update() && ver != NULL)
-	{
-	  namelen = ver - name;
-	  ver = NULL;
-	}
+	ver = NULL;
 
+      size_t namelen;
       if (ver != NULL)
-        {
-          // The symbol name is of the form foo@VERSION or foo@@VERSION
-          namelen = ver - name;
-          ++ver;
-	  if (*ver == '@')
-	    {
-	      is_default_version = true;
-	      ++ver;
-	    }
-	  ver = this->namepool_.add(ver, true, &ver_key);
-        }
-      // We don't want to assign a version to an undefined symbol,
-      // even if it is listed in the version script.  FIXME: What
-      // about a common symbol?
+	namelen = ver - name;
       else
-	{
-	  namelen = strlen(name);
-	  if (!this->version_script_.empty()
-	      && st_shndx != elfcpp::SHN_UNDEF)
-	    {
-	      // The symbol name did not have a version, but the
-	      // version script may assign a version anyway.
-	      std::string version;
-	      bool is_global;
-	      if (this->version_script_.get_symbol_version(name, &version,
-							   &is_global))
-		{
-		  if (!is_global)
-		    is_forced_local = true;
-		  else if (!version.empty())
-		    {
-		      ver = this->namepool_.add_with_length(version.c_str(),
-							    version.length(),
-							    true,
-							    &ver_key);
-		      is_default_version = true;
-		    }
-		}
-	    }
-	}
+	namelen = strlen(name);
 
-      elfcpp::Sym<size, big_endian>* psym = &sym;
+      const unsigned char* psym = p;
       unsigned char symbuf[sym_size];
-      elfcpp::Sym<size, big_endian> sym2(symbuf);
       if (just_symbols)
 	{
 	  memcpy(symbuf, p, sym_size);
-	  elfcpp::Sym_write<size, big_endian> sw(symbuf);
+	  psym = symbuf;
 	  if (orig_st_shndx != elfcpp::SHN_UNDEF
 	      && is_ordinary
 	      && relobj->e_type() == elfcpp::ET_REL)
 	    {
 	      // Symbol values in relocatable object files are section
-	      // relative.  This is normally what we want, but since here
-	      // we are converting the symbol to absolute we need to add
-	      // the section address.  The section address in an object
-	      // file is normally zero, but people can use a linker
-	      // script to change it.
+	      // relative.  This is normally what we want, but since
+	      // add_relobj_symbol will convert the symbol to absolute
+	      // we need to add the section address.  The section
+	      // address in an object file is normally zero, but people
+	      // can use a linker script to change it.
+	      elfcpp::Sym_write<size, big_endian> sw(symbuf);
 	      sw.put_st_value(sym.get_st_value()
 			      + relobj->section_address(orig_st_shndx));
 	    }
-	  st_shndx = elfcpp::SHN_ABS;
-	  is_ordinary = false;
-	  psym = &sym2;
 	}
 
       // Fix up visibility if object has no-export set.
       if (relobj->no_export()
-	  && (orig_st_shndx != elfcpp::SHN_UNDEF || !is_ordinary))
+	  && (orig_st_shndx != elfcpp::SHN_UNDEF
+	      || !is_ordinary
+	      || just_symbols))
         {
 	  // We may have copied symbol already above.
-	  if (psym != &sym2)
+	  if (psym != symbuf)
 	    {
 	      memcpy(symbuf, p, sym_size);
-	      psym = &sym2;
+	      psym = symbuf;
 	    }
 
+	  elfcpp::Sym<size, big_endian> sym2(symbuf);
 	  elfcpp::STV visibility = sym2.get_st_visibility();
 	  if (visibility == elfcpp::STV_DEFAULT
 	      || visibility == elfcpp::STV_PROTECTED)
@@ -1410,38 +1906,138 @@ Symbol_table::add_from_relobj(
 	    }
         }
 
-      Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+      // The hash code of the name picks the shard, and is then used
+      // for the name pool and for the symbol itself.
+      uint32_t name_hash = Stringpool::string_hash(name, namelen);
+
+      if (pending != NULL)
+	{
+	  pending->add(Symbol_table::shard_index(name_hash), i, psym,
+		       namelen, name_hash, ver != NULL, st_shndx, is_ordinary,
+		       orig_st_shndx, is_defined_in_discarded_section);
+	  continue;
+	}
 
-      Sized_symbol<size>* res;
-      res = this->add_from_object(relobj, name, name_key, ver, ver_key,
-				  is_default_version, *psym, st_shndx,
-				  is_ordinary, orig_st_shndx);
+      Symbol_table_shard* shard = this->sync_shard(name_hash);
 
-      if (res == NULL)
-	continue;
-      
-      if (is_forced_local)
-	this->force_local(res);
-
-      // Do not treat this symbol as garbage if this symbol will be
-      // exported to the dynamic symbol table.  This is true when
-      // building a shared library or using --export-dynamic and
-      // the symbol is externally visible.
-      if (parameters->options().gc_sections()
-	  && res->is_externally_visible()
-	  && !res->is_from_dynobj()
-          && (parameters->options().shared()
-	      || parameters->options().export_dynamic()
-	      || parameters->options().in_dynamic_list(res->name())))
-        this->gc_mark_symbol(res);
-
-      if (is_defined_in_discarded_section)
-	res->set_is_defined_in_discarded_section();
-
-      (*sympointers)[i] = res;
+      elfcpp::Sym<size, big_endian> esym(psym);
+      (*sympointers)[i] =
+	this->add_relobj_symbol(shard, relobj, name, namelen, name_hash, ver,
+				esym, st_shndx, is_ordinary, orig_st_shndx,
+				is_defined_in_discarded_section);
+    }
+
+  if (pending != NULL)
+    this->queue_symbols(pending);
+}
+
+// Add one global symbol from RELOBJ to SHARD.  NAME is the name of
+// the symbol in the object, of which the first NAMELEN characters are
+// the symbol name; if VER is not NULL, it points to the '@' which
+// starts the version.  SYM has already been adjusted for
+// --just-symbols and --exclude-libs.  This may be called from a
+// separate task, so it must only change SHARD.
+
+template<int size, bool big_endian>
+Sized_symbol<size>*
+Symbol_table::add_relobj_symbol(
+    Symbol_table_shard* shard,
+    Sized_relobj_file<size, big_endian>* relobj,
+    const char* name,
+    size_t namelen,
+    uint32_t name_hash,
+    const char* ver,
+    const elfcpp::Sym<size, big_endian>& sym,
+    unsigned int st_shndx,
+    bool is_ordinary,
+    unsigned int orig_st_shndx,
+    bool is_defined_in_discarded_section)
+{
+  Stringpool::Key ver_key = 0;
+  // IS_DEFAULT_VERSION: is the version default?
+  // IS_FORCED_LOCAL: is the symbol forced local?
+  bool is_default_version = false;
+  bool is_forced_local = false;
+
+  if (ver != NULL)
+    {
+      // The symbol name is of the form foo@VERSION or foo@@VERSION.
+      // If there are two '@' characters, this is the default version.
+      ++ver;
+      if (*ver == '@')
+	{
+	  is_default_version = true;
+	  ++ver;
+	}
+      ver = shard->namepool.add(ver, true, &ver_key);
+    }
+  // We don't want to assign a version to an undefined symbol,
+  // even if it is listed in the version script.  FIXME: What
+  // about a common symbol?
+  else
+    {
+      if (!this->version_script_.empty()
+	  && st_shndx != elfcpp::SHN_UNDEF)
+	{
+	  // The symbol name did not have a version, but the
+	  // version script may assign a version anyway.
+	  std::string version;
+	  bool is_global;
+	  if (this->version_script_.get_symbol_version(name, &version,
+						       &is_global))
+	    {
+	      if (!is_global)
+		is_forced_local = true;
+	      else if (!version.empty())
+		{
+		  ver = shard->namepool.add_with_length(version.c_str(),
+							version.length(),
+							true,
+							&ver_key);
+		  is_default_version = true;
+		}
+	    }
+	}
     }
+
+  if (relobj->just_symbols())
+    {
+      st_shndx = elfcpp::SHN_ABS;
+      is_ordinary = false;
+    }
+
+  Stringpool::Key name_key;
+  name = shard->namepool.add_with_hash(name, namelen, name_hash, true,
+				       &name_key);
+
+  Sized_symbol<size>* res;
+  res = this->add_from_object(shard, relobj, name, name_key, name_hash,
+			      ver, ver_key,
+			      is_default_version, sym, st_shndx,
+			      is_ordinary, orig_st_shndx);
+
+  if (res == NULL)
+    return NULL;
+
+  if (is_forced_local)
+    this->force_local(shard, res);
+
+  // Do not treat this symbol as garbage if this symbol will be
+  // exported to the dynamic symbol table.  This is true when
+  // building a shared library or using --export-dynamic and
+  // the symbol is externally visible.
+  if (parameters->options().gc_sections()
+      && res->is_externally_visible()
+      && !res->is_from_dynobj()
+      && (parameters->options().shared()
+	  || parameters->options().export_dynamic()
+	  || parameters->options().in_dynamic_list(res->name())))
+    shard->gc_symbols.push_back(res);
+
+  if (is_defined_in_discarded_section)
+    res->set_is_defined_in_discarded_section();
+
+  return res;
 }
 
 // Add a symbol from a plugin-claimed file.
@@ -1457,13 +2053,18 @@ Symbol_table::add_from_pluginobj(
   unsigned int st_shndx = sym->get_st_shndx();
   bool is_ordinary = st_shndx < elfcpp::SHN_LORESERVE;
 
+  size_t namelen = strlen(name);
+  this->import_lazy_symbols(name, namelen);
+  uint32_t name_hash = Stringpool::string_hash(name, namelen);
+  Symbol_table_shard* shard = this->sync_shard(name_hash);
+
   Stringpool::Key ver_key = 0;
   bool is_default_version = false;
   bool is_forced_local = false;
 
   if (ver != NULL)
     {
-      ver = this->namepool_.add(ver, true, &ver_key);
+      ver = shard->namepool.add(ver, true, &ver_key);
     }
   // We don't want to assign a version to an undefined symbol,
   // even if it is listed in the version script.  FIXME: What
@@ -1484,7 +2085,7 @@ Symbol_table::add_from_pluginobj(
 		is_forced_local = true;
 	      else if (!version.empty())
                 {
-                  ver = this->namepool_.add_with_length(version.c_str(),
+                  ver = shard->namepool.add_with_length(version.c_str(),
                                                         version.length(),
                                                         true,
                                                         &ver_key);
@@ -1495,18 +2096,19 @@ Symbol_table::add_from_pluginobj(
     }
 
   Stringpool::Key name_key;
-  name = this->namepool_.add(name, true, &name_key);
+  name = shard->namepool.add_with_hash(name, namelen, name_hash, true,
+				       &name_key);
 
   Sized_symbol<size>* res;
-  res = this->add_from_object(obj, name, name_key, ver, ver_key,
-		              is_default_version, *sym, st_shndx,
-			      is_ordinary, st_shndx);
+  res = this->add_from_object(shard, obj, name, name_key, name_hash,
+			      ver, ver_key, is_default_version, *sym,
+			      st_shndx, is_ordinary, st_shndx);
 
   if (res == NULL)
     return NULL;
 
   if (is_forced_local)
-    this->force_local(res);
+    this->force_local(shard, res);
 
   return res;
 }
@@ -1524,6 +2126,7 @@ Symbol_table::add_from_dynobj(
     const unsigned char* versym,
     size_t versym_size,
     const std::vector<const char*>* version_map,
+    const std::vector<bool>* is_deferred,
     typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
     size_t* defined)
 {
@@ -1548,6 +2151,10 @@ Symbol_table::add_from_dynobj(
       return;
     }
 
+  // Weak aliases may refer to symbols in any shard, so we add the
+  // symbols from dynamic objects directly, after any pending symbols.
+  this->add_pending_symbols();
+
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
   // We keep a list of all STT_OBJECT symbols, so that we can resolve
@@ -1564,167 +2171,294 @@ Symbol_table::add_from_dynobj(
   const unsigned char* vs = versym;
   for (size_t i = 0; i < count; ++i, p += sym_size, vs += 2)
     {
-      elfcpp::Sym<size, big_endian> sym(p);
-
       if (sympointers != NULL)
 	(*sympointers)[i] = NULL;
 
-      // Ignore symbols with local binding or that have
-      // internal or hidden visibility.
-      if (sym.get_st_bind() == elfcpp::STB_LOCAL
-          || sym.get_st_visibility() == elfcpp::STV_INTERNAL
-          || sym.get_st_visibility() == elfcpp::STV_HIDDEN)
+      if (is_deferred != NULL && (*is_deferred)[i])
 	continue;
 
-      // A protected symbol in a shared library must be treated as a
-      // normal symbol when viewed from outside the shared library.
-      // Implement this by overriding the visibility here.
-      // Likewise, an IFUNC symbol in a shared library must be treated
-      // as a normal FUNC symbol.
-      elfcpp::Sym<size, big_endian>* psym = &sym;
-      unsigned char symbuf[sym_size];
-      elfcpp::Sym<size, big_endian> sym2(symbuf);
-      if (sym.get_st_visibility() == elfcpp::STV_PROTECTED
-	  || sym.get_st_type() == elfcpp::STT_GNU_IFUNC)
-	{
-	  memcpy(symbuf, p, sym_size);
-	  elfcpp::Sym_write<size, big_endian> sw(symbuf);
-	  if (sym.get_st_visibility() == elfcpp::STV_PROTECTED)
-	    sw.put_st_other(elfcpp::STV_DEFAULT, sym.get_st_nonvis());
-	  if (sym.get_st_type() == elfcpp::STT_GNU_IFUNC)
-	    sw.put_st_info(sym.get_st_bind(), elfcpp::STT_FUNC);
-	  psym = &sym2;
-	}
+      Sized_symbol<size>* res =
+	this->add_dynobj_symbol(dynobj, i, p, sym_names, sym_name_size,
+				versym == NULL ? NULL : vs, version_map,
+				true, defined, &object_symbols);
 
-      unsigned int st_name = psym->get_st_name();
-      if (st_name >= sym_name_size)
+      if (res != NULL && sympointers != NULL)
+	(*sympointers)[i] = res;
+    }
+
+  this->record_weak_aliases(&object_symbols);
+}
+
+// Add the symbols of DYNOBJ with the indexes in INDEXES, which
+// add_from_dynobj skipped.  Adding a STT_OBJECT symbol may record
+// weak aliases, which are looked at when resolving symbols in any
+// shard, so in that case we first wait for any pending symbols.
+
+template<int size, bool big_endian>
+void
+Symbol_table::add_lazy_dynobj_symbols(
+    Sized_dynobj<size, big_endian>* dynobj,
+    const std::vector<unsigned int>& indexes,
+    const unsigned char* syms,
+    const char* sym_names,
+    size_t sym_name_size,
+    const unsigned char* versym,
+    const std::vector<const char*>* version_map,
+    size_t* defined)
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  for (std::vector<unsigned int>::const_iterator p = indexes.begin();
+       p != indexes.end();
+       ++p)
+    {
+      elfcpp::Sym<size, big_endian> sym(syms + *p * sym_size);
+      if (sym.get_st_type() == elfcpp::STT_OBJECT)
 	{
-	  dynobj->error(_("bad symbol name offset %u at %zu"),
-			st_name, i);
-	  continue;
+	  this->add_pending_symbols();
+	  break;
 	}
+    }
 
-      const char* name = sym_names + st_name;
+  std::vector<Sized_symbol<size>*> object_symbols;
+  for (std::vector<unsigned int>::const_iterator p = indexes.begin();
+       p != indexes.end();
+       ++p)
+    this->add_dynobj_symbol(dynobj, *p, syms + *p * sym_size, sym_names,
+			    sym_name_size,
+			    versym == NULL ? NULL : versym + *p * 2,
+			    version_map, false, defined, &object_symbols);
 
-      bool is_ordinary;
-      unsigned int st_shndx = dynobj->adjust_sym_shndx(i, psym->get_st_shndx(),
-						       &is_ordinary);
+  if (!object_symbols.empty())
+    this->record_weak_aliases(&object_symbols);
+}
 
-      if (st_shndx != elfcpp::SHN_UNDEF)
-	++*defined;
+// Add the I'th symbol of DYNOBJ, at P, to the symbol table.
 
-      Sized_symbol<size>* res;
+template<int size, bool big_endian>
+Sized_symbol<size>*
+Symbol_table::add_dynobj_symbol(
+    Sized_dynobj<size, big_endian>* dynobj,
+    size_t i,
+    const unsigned char* p,
+    const char* sym_names,
+    size_t sym_name_size,
+    const unsigned char* vs,
+    const std::vector<const char*>* version_map,
+    bool import_lazy,
+    size_t* defined,
+    std::vector<Sized_symbol<size>*>* object_symbols)
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
-      if (versym == NULL)
-	{
-	  Stringpool::Key name_key;
-	  name = this->namepool_.add(name, true, &name_key);
-	  res = this->add_from_object(dynobj, name, name_key, NULL, 0,
-				      false, *psym, st_shndx, is_ordinary,
-				      st_shndx);
-	}
-      else
-	{
-	  // Read the version information.
+  elfcpp::Sym<size, big_endian> sym(p);
+
+  // Ignore symbols with local binding or that have
+  // internal or hidden visibility.
+  if (sym.get_st_bind() == elfcpp::STB_LOCAL
+      || sym.get_st_visibility() == elfcpp::STV_INTERNAL
+      || sym.get_st_visibility() == elfcpp::STV_HIDDEN)
+    return NULL;
+
+  // A protected symbol in a shared library must be treated as a
+  // normal symbol when viewed from outside the shared library.
+  // Implement this by overriding the visibility here.
+  // Likewise, an IFUNC symbol in a shared library must be treated
+  // as a normal FUNC symbol.
+  elfcpp::Sym<size, big_endian>* psym = &sym;
+  unsigned char symbuf[sym_size];
+  elfcpp::Sym<size, big_endian> sym2(symbuf);
+  if (sym.get_st_visibility() == elfcpp::STV_PROTECTED
+      || sym.get_st_type() == elfcpp::STT_GNU_IFUNC)
+    {
+      memcpy(symbuf, p, sym_size);
+      elfcpp::Sym_write<size, big_endian> sw(symbuf);
+      if (sym.get_st_visibility() == elfcpp::STV_PROTECTED)
+	sw.put_st_other(elfcpp::STV_DEFAULT, sym.get_st_nonvis());
+      if (sym.get_st_type() == elfcpp::STT_GNU_IFUNC)
+	sw.put_st_info(sym.get_st_bind(), elfcpp::STT_FUNC);
+      psym = &sym2;
+    }
+
+  unsigned int st_name = psym->get_st_name();
+  if (st_name >= sym_name_size)
+    {
+      dynobj->error(_("bad symbol name offset %u at %zu"),
+		    st_name, i);
+      return NULL;
+    }
+
+  const char* name = sym_names + st_name;
+  size_t namelen = strlen(name);
+
+  if (import_lazy && !this->lazy_dynobjs_.empty())
+    this->import_lazy_symbols(name, namelen);
+
+  uint32_t name_hash = Stringpool::string_hash(name, namelen);
+  Symbol_table_shard* shard = this->sync_shard(name_hash);
+
+  bool is_ordinary;
+  unsigned int st_shndx = dynobj->adjust_sym_shndx(i, psym->get_st_shndx(),
+						   &is_ordinary);
+
+  if (st_shndx != elfcpp::SHN_UNDEF)
+    ++*defined;
+
+  Sized_symbol<size>* res;
+
+  if (vs == NULL)
+    {
+      Stringpool::Key name_key;
+      name = shard->namepool.add_with_hash(name, namelen, name_hash, true,
+					   &name_key);
+      res = this->add_from_object(shard, dynobj, name, name_key,
+				  name_hash, NULL, 0, false, *psym,
+				  st_shndx, is_ordinary, st_shndx);
+    }
+  else
+    {
+      // Read the version information.
 
-	  unsigned int v = elfcpp::Swap<16, big_endian>::readval(vs);
+      unsigned int v = elfcpp::Swap<16, big_endian>::readval(vs);
 
-	  bool hidden = (v & elfcpp::VERSYM_HIDDEN) != 0;
-	  v &= elfcpp::VERSYM_VERSION;
+      bool hidden = (v & elfcpp::VERSYM_HIDDEN) != 0;
+      v &= elfcpp::VERSYM_VERSION;
 
-	  // The Sun documentation says that V can be VER_NDX_LOCAL,
-	  // or VER_NDX_GLOBAL, or a version index.  The meaning of
-	  // VER_NDX_LOCAL is defined as "Symbol has local scope."
-	  // The old GNU linker will happily generate VER_NDX_LOCAL
-	  // for an undefined symbol.  I don't know what the Sun
-	  // linker will generate.
+      // The Sun documentation says that V can be VER_NDX_LOCAL,
+      // or VER_NDX_GLOBAL, or a version index.  The meaning of
+      // VER_NDX_LOCAL is defined as "Symbol has local scope."
+      // The old GNU linker will happily generate VER_NDX_LOCAL
+      // for an undefined symbol.  I don't know what the Sun
+      // linker will generate.
 
-	  if (v == static_cast<unsigned int>(elfcpp::VER_NDX_LOCAL)
-	      && st_shndx != elfcpp::SHN_UNDEF)
+      if (v == static_cast<unsigned int>(elfcpp::VER_NDX_LOCAL)
+	  && st_shndx != elfcpp::SHN_UNDEF)
+	{
+	  // This symbol should not be visible outside the object.
+	  return NULL;
+	}
+
+      // At this point we are definitely going to add this symbol.
+      Stringpool::Key name_key;
+      name = shard->namepool.add_with_hash(name, namelen, name_hash, true,
+					   &name_key);
+
+      if (v == static_cast<unsigned int>(elfcpp::VER_NDX_LOCAL)
+	  || v == static_cast<unsigned int>(elfcpp::VER_NDX_GLOBAL))
+	{
+	  // This symbol does not have a version.
+	  res = this->add_from_object(shard, dynobj, name, name_key,
+				      name_hash, NULL, 0, false, *psym,
+				      st_shndx, is_ordinary, st_shndx);
+	}
+      else
+	{
+	  if (v >= version_map->size())
 	    {
-	      // This symbol should not be visible outside the object.
-	      continue;
+	      dynobj->error(_("versym for symbol %zu out of range: %u"),
+			    i, v);
+	      return NULL;
 	    }
 
-	  // At this point we are definitely going to add this symbol.
-	  Stringpool::Key name_key;
-	  name = this->namepool_.add(name, true, &name_key);
-
-	  if (v == static_cast<unsigned int>(elfcpp::VER_NDX_LOCAL)
-	      || v == static_cast<unsigned int>(elfcpp::VER_NDX_GLOBAL))
+	  const char* version = (*version_map)[v];
+	  if (version == NULL)
 	    {
-	      // This symbol does not have a version.
-	      res = this->add_from_object(dynobj, name, name_key, NULL, 0,
-					  false, *psym, st_shndx, is_ordinary,
-					  st_shndx);
+	      dynobj->error(_("versym for symbol %zu has no name: %u"),
+			    i, v);
+	      return NULL;
 	    }
+
+	  Stringpool::Key version_key;
+	  version = shard->namepool.add(version, true, &version_key);
+
+	  // If this is an absolute symbol, and the version name
+	  // and symbol name are the same, then this is the
+	  // version definition symbol.  These symbols exist to
+	  // support using -u to pull in particular versions.  We
+	  // do not want to record a version for them.
+	  if (st_shndx == elfcpp::SHN_ABS
+	      && !is_ordinary
+	      && name_key == version_key)
+	    res = this->add_from_object(shard, dynobj, name, name_key,
+					name_hash, NULL, 0, false, *psym,
+					st_shndx, is_ordinary, st_shndx);
 	  else
 	    {
-	      if (v >= version_map->size())
-		{
-		  dynobj->error(_("versym for symbol %zu out of range: %u"),
-				i, v);
-		  continue;
-		}
+	      const bool is_default_version =
+		!hidden && st_shndx != elfcpp::SHN_UNDEF;
+	      res = this->add_from_object(shard, dynobj, name, name_key,
+					  name_hash, version, version_key,
+					  is_default_version, *psym,
+					  st_shndx, is_ordinary, st_shndx);
+	    }
+	}
+    }
 
-	      const char* version = (*version_map)[v];
-	      if (version == NULL)
-		{
-		  dynobj->error(_("versym for symbol %zu has no name: %u"),
-				i, v);
-		  continue;
-		}
+  if (res == NULL)
+    return NULL;
+
+  // Note that it is possible that RES was overridden by an
+  // earlier object, in which case it can't be aliased here.
+  if (st_shndx != elfcpp::SHN_UNDEF
+      && is_ordinary
+      && psym->get_st_type() == elfcpp::STT_OBJECT
+      && res->source() == Symbol::FROM_OBJECT
+      && res->object() == dynobj)
+    object_symbols->push_back(res);
+
+  // If the symbol has protected visibility in the dynobj,
+  // mark it as such if it was not overridden.
+  if (res->source() == Symbol::FROM_OBJECT
+      && res->object() == dynobj
+      && sym.get_st_visibility() == elfcpp::STV_PROTECTED)
+    res->set_is_protected();
+
+  return res;
+}
+
+// Return whether we have seen a global symbol named NAME.
+
+bool
+Symbol_table::is_known_symbol_name(const char* name) const
+{
+  size_t len = strlen(name);
+  uint32_t name_hash = Stringpool::string_hash(name, len);
+  const Symbol_table_shard* shard =
+    &this->shards_[Symbol_table::shard_index(name_hash)];
+  Stringpool::Key name_key;
+  return shard->namepool.find_with_hash(name, len, name_hash,
+					&name_key) != NULL;
+}
 
-	      Stringpool::Key version_key;
-	      version = this->namepool_.add(version, true, &version_key);
-
-	      // If this is an absolute symbol, and the version name
-	      // and symbol name are the same, then this is the
-	      // version definition symbol.  These symbols exist to
-	      // support using -u to pull in particular versions.  We
-	      // do not want to record a version for them.
-	      if (st_shndx == elfcpp::SHN_ABS
-		  && !is_ordinary
-		  && name_key == version_key)
-		res = this->add_from_object(dynobj, name, name_key, NULL, 0,
-					    false, *psym, st_shndx, is_ordinary,
-					    st_shndx);
-	      else
-		{
-		  const bool is_default_version =
-		    !hidden && st_shndx != elfcpp::SHN_UNDEF;
-		  res = this->add_from_object(dynobj, name, name_key, version,
-					      version_key, is_default_version,
-					      *psym, st_shndx,
-					      is_ordinary, st_shndx);
-		}
-	    }
-	}
+// Add the symbols named NAME from the lazily read dynamic objects.
+// This is called before a name is first added to the symbol table,
+// so that the symbols from the dynamic objects are added before it,
+// as they would have been if we had added all their symbols when
+// reading them.
 
-      if (res == NULL)
-	continue;
+void
+Symbol_table::import_lazy_symbols(const char* name, size_t namelen)
+{
+  if (this->lazy_dynobjs_.empty())
+    return;
 
-      // Note that it is possible that RES was overridden by an
-      // earlier object, in which case it can't be aliased here.
-      if (st_shndx != elfcpp::SHN_UNDEF
-	  && is_ordinary
-	  && psym->get_st_type() == elfcpp::STT_OBJECT
-	  && res->source() == Symbol::FROM_OBJECT
-	  && res->object() == dynobj)
-	object_symbols.push_back(res);
-
-      // If the symbol has protected visibility in the dynobj,
-      // mark it as such if it was not overridden.
-      if (res->source() == Symbol::FROM_OBJECT
-          && res->object() == dynobj
-          && sym.get_st_visibility() == elfcpp::STV_PROTECTED)
-        res->set_is_protected();
+  this->lazy_names_.push_back(std::make_pair(name, namelen));
+  if (this->is_importing_lazy_symbols_)
+    return;
 
-      if (sympointers != NULL)
-	(*sympointers)[i] = res;
+  this->is_importing_lazy_symbols_ = true;
+  for (size_t i = 0; i < this->lazy_names_.size(); ++i)
+    {
+      std::pair<const char*, size_t> n(this->lazy_names_[i]);
+      uint32_t hash = Dynobj::gnu_hash(n.first, n.second);
+      for (std::vector<Dynobj*>::const_iterator p =
+	     this->lazy_dynobjs_.begin();
+	   p != this->lazy_dynobjs_.end();
+	   ++p)
+	(*p)->import_lazy_symbols(this, n.first, n.second, hash);
     }
-
-  this->record_weak_aliases(&object_symbols);
+  this->lazy_names_.clear();
+  this->is_importing_lazy_symbols_ = false;
 }
 
 // Add a symbol from a incremental object file.
@@ -1743,13 +2477,17 @@ Symbol_table::add_from_incrobj(
   Stringpool::Key ver_key = 0;
   bool is_default_version = false;
 
+  size_t namelen = strlen(name);
+  uint32_t name_hash = Stringpool::string_hash(name, namelen);
+  Symbol_table_shard* shard = this->sync_shard(name_hash);
   Stringpool::Key name_key;
-  name = this->namepool_.add(name, true, &name_key);
+  name = shard->namepool.add_with_hash(name, namelen, name_hash, true,
+				       &name_key);
 
   Sized_symbol<size>* res;
-  res = this->add_from_object(obj, name, name_key, ver, ver_key,
-		              is_default_version, *sym, st_shndx,
-			      is_ordinary, st_shndx);
+  res = this->add_from_object(shard, obj, name, name_key, name_hash,
+			      ver, ver_key, is_default_version, *sym,
+			      st_shndx, is_ordinary, st_shndx);
 
   return res;
 }
@@ -1857,6 +2595,14 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
   *resolve_oldsym = false;
   *poldsym = NULL;
 
+  // The caller may change the lists of symbols, so wait for any
+  // pending symbols to be added first.
+  this->add_pending_symbols();
+  size_t namelen = strlen(*pname);
+  this->import_lazy_symbols(*pname, namelen);
+  uint32_t name_hash = Stringpool::string_hash(*pname, namelen);
+  Symbol_table_shard* shard = this->get_shard(name_hash);
+
   // If the caller didn't give us a version, see if we get one from
   // the version script.
   std::string v;
@@ -1880,9 +2626,9 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
   Sized_symbol<size>* sym;
 
   bool add_to_table = false;
-  typename Symbol_table_type::iterator add_loc = this->table_.end();
+  typename Symbol_table_type::iterator add_loc = shard->table.end();
   bool add_def_to_table = false;
-  typename Symbol_table_type::iterator add_def_loc = this->table_.end();
+  typename Symbol_table_type::iterator add_def_loc = shard->table.end();
 
   if (only_if_ref)
     {
@@ -1907,7 +2653,7 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
 
       *pname = oldsym->name();
       if (is_default_version)
-	*pversion = this->namepool_.add(*pversion, true, NULL);
+	*pversion = shard->namepool.add(*pversion, true, NULL);
       else
 	*pversion = oldsym->version();
     }
@@ -1915,27 +2661,28 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
     {
       // Canonicalize NAME and VERSION.
       Stringpool::Key name_key;
-      *pname = this->namepool_.add(*pname, true, &name_key);
+      *pname = shard->namepool.add_with_hash(*pname, namelen, name_hash, true,
+					     &name_key);
 
       Stringpool::Key version_key = 0;
       if (*pversion != NULL)
-	*pversion = this->namepool_.add(*pversion, true, &version_key);
+	*pversion = shard->namepool.add(*pversion, true, &version_key);
 
       Symbol* const snull = NULL;
+      const Symbol_table_type::value_type entry(symbol_table_key(name_key,
+								 version_key),
+						snull);
       std::pair<typename Symbol_table_type::iterator, bool> ins =
-	this->table_.insert(std::make_pair(std::make_pair(name_key,
-							  version_key),
-					   snull));
+	shard->table.insert(entry);
 
       std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-	std::make_pair(this->table_.end(), false);
+	std::make_pair(shard->table.end(), false);
       if (is_default_version)
 	{
 	  const Stringpool::Key vnull = 0;
-	  insdefault =
-	    this->table_.insert(std::make_pair(std::make_pair(name_key,
-							      vnull),
-					       snull));
+	  const Symbol_table_type::value_type default_entry(
+	      symbol_table_key(name_key, vnull), snull);
+	  insdefault = shard->table.insert(default_entry);
 	}
 
       if (!ins.second)
@@ -1948,7 +2695,7 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
 	    {
 	      Sized_symbol<size>* soldsym =
 		this->get_sized_symbol<size>(oldsym);
-	      this->define_default_version<size, big_endian>(soldsym,
+	      this->define_default_version<size, big_endian>(shard, soldsym,
 							     insdefault.second,
 							     insdefault.first);
 	    }
@@ -2549,6 +3296,7 @@ template<int size>
 void
 Symbol_table::add_undefined_symbol_from_command_line(const char* name)
 {
+  this->import_lazy_symbols(name, strlen(name));
   if (this->lookup(name) != NULL)
     return;
 
@@ -2589,6 +3337,7 @@ Symbol_table::add_undefined_symbol_from_command_line(const char* name)
   sym->init_undefined(name, version, 0, elfcpp::STT_NOTYPE, elfcpp::STB_GLOBAL,
 		      elfcpp::STV_DEFAULT, 0);
   ++this->saw_undefined_;
+  this->new_undefined_symbols_.push_back(sym);
 }
 
 // Set the dynamic symbol indexes.  INDEX is the index of the first
@@ -2603,6 +3352,10 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
 				 Stringpool* dynpool,
 				 Versions* versions)
 {
+  // The dynamic symbol table is being laid out, so we are done adding
+  // symbols from lazily read dynamic objects.
+  this->lazy_dynobjs_.clear();
+
   // First process all the symbols which have been forced to be local,
   // as they must appear before all global symbols.
   unsigned int forced_local_count = 0;
@@ -2621,7 +3374,8 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
           sym->set_dynsym_index(index);
           ++index;
           ++forced_local_count;
-	  dynpool->add(sym->name(), false, NULL);
+	  dynpool->add_with_hash(sym->name(), strlen(sym->name()),
+				 sym->name_hash(), false, NULL);
 	  if (sym->type() == elfcpp::STT_GNU_IFUNC)
 	    this->set_has_gnu_output();
         }
@@ -2632,78 +3386,92 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
   if (parameters->target().has_custom_set_dynsym_indexes())
     {
       std::vector<Symbol*> dyn_symbols;
-      for (Symbol_table_type::iterator p = this->table_.begin();
-           p != this->table_.end();
-           ++p)
-        {
-          Symbol* sym = p->second;
-          if (sym->is_forced_local())
-	    continue;
-          if (!sym->should_add_dynsym_entry(this))
-            sym->set_dynsym_index(-1U);
-          else
+      for (unsigned int i = 0; i < shard_count; ++i)
+	{
+	  Symbol_table_type& table(this->shards_[i].table);
+	  for (Symbol_table_type::iterator p = table.begin();
+	       p != table.end();
+	       ++p)
 	    {
-	      dyn_symbols.push_back(sym);
-	      if (sym->type() == elfcpp::STT_GNU_IFUNC
-		  || (sym->binding() == elfcpp::STB_GNU_UNIQUE
-		      && parameters->options().gnu_unique()))
-		this->set_has_gnu_output();
+	      Symbol* sym = p->second;
+	      if (sym->is_forced_local())
+		continue;
+	      if (!sym->should_add_dynsym_entry(this))
+		sym->set_dynsym_index(-1U);
+	      else
+		{
+		  dyn_symbols.push_back(sym);
+		  if (sym->type() == elfcpp::STT_GNU_IFUNC
+		      || (sym->binding() == elfcpp::STB_GNU_UNIQUE
+			  && parameters->options().gnu_unique()))
+		    this->set_has_gnu_output();
+		}
 	    }
-        }
+	}
 
       return parameters->target().set_dynsym_indexes(&dyn_symbols, index, syms,
                                                      dynpool, versions, this);
     }
 
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Symbol* sym = p->second;
-
-      if (sym->is_forced_local())
-        continue;
+      Symbol_table_type& table(this->shards_[i].table);
+      for (Symbol_table_type::iterator p = table.begin();
+	   p != table.end();
+	   ++p)
+	{
+	  Symbol* sym = p->second;
 
-      // Note that SYM may already have a dynamic symbol index, since
-      // some symbols appear more than once in the symbol table, with
-      // and without a version.
+	  if (sym->is_forced_local())
+	    continue;
 
-      if (!sym->should_add_dynsym_entry(this))
-	sym->set_dynsym_index(-1U);
-      else if (!sym->has_dynsym_index())
-	{
-	  sym->set_dynsym_index(index);
-	  ++index;
-	  syms->push_back(sym);
-	  dynpool->add(sym->name(), false, NULL);
-	  if (sym->type() == elfcpp::STT_GNU_IFUNC
-	      || (sym->binding() == elfcpp::STB_GNU_UNIQUE
-		  && parameters->options().gnu_unique()))
-	    this->set_has_gnu_output();
+	  // Note that SYM may already have a dynamic symbol index, since
+	  // some symbols appear more than once in the symbol table, with
+	  // and without a version.
 
-	  // Record any version information, except those from
-	  // as-needed libraries not seen to be needed.  Note that the
-	  // is_needed state for such libraries can change in this loop.
-	  if (sym->version() != NULL)
+	  if (!sym->should_add_dynsym_entry(this))
+	    sym->set_dynsym_index(-1U);
+	  else if (!sym->has_dynsym_index())
 	    {
-	      if (!sym->is_from_dynobj()
-		  || !sym->object()->as_needed()
-		  || sym->object()->is_needed())
-		versions->record_version(this, dynpool, sym);
-	      else
+	      sym->set_dynsym_index(index);
+	      ++index;
+	      syms->push_back(sym);
+	      dynpool->add_with_hash(sym->name(), strlen(sym->name()),
+				     sym->name_hash(), false, NULL);
+	      if (sym->type() == elfcpp::STT_GNU_IFUNC
+		  || (sym->binding() == elfcpp::STB_GNU_UNIQUE
+		      && parameters->options().gnu_unique()))
+		this->set_has_gnu_output();
+
+	      // Record any version information, except those from
+	      // as-needed libraries not seen to be needed.  Note that the
+	      // is_needed state for such libraries can change in this loop.
+	      if (sym->version() != NULL)
 		{
-		  if (parameters->options().warn_drop_version())
-		    gold_warning(_("discarding version information for "
-				   "%s@%s, defined in unused shared library %s "
-				   "(linked with --as-needed)"),
-				 sym->name(), sym->version(),
-				 sym->object()->name().c_str());
-		  sym->clear_version();
+		  if (!sym->is_from_dynobj()
+		      || !sym->object()->as_needed()
+		      || sym->object()->is_needed())
+		    versions->record_version(this, dynpool, sym);
+		  else
+		    {
+		      if (parameters->options().warn_drop_version())
+			gold_warning(_("discarding version information for "
+				       "%s@%s, defined in unused shared "
+				       "library %s (linked with --as-needed)"),
+				     sym->name(), sym->version(),
+				     sym->object()->name().c_str());
+		      sym->clear_version();
+		    }
 		}
 	    }
 	}
     }
 
+  // Packed relative relocations need a dynamic linker which
+  // supports them.
+  if (versions->uses_dt_relr())
+    versions->add_dt_relr_need(dynpool);
+
   // Finish up the versions.  In some cases this may add new dynamic
   // symbols.
   index = versions->finalize(this, index, syms);
@@ -2716,7 +3484,8 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
       (*p)->set_dynsym_index(index);
       ++index;
       syms->push_back(*p);
-      dynpool->add((*p)->name(), false, NULL);
+      dynpool->add_with_hash((*p)->name(), strlen((*p)->name()),
+			     (*p)->name_hash(), false, NULL);
     }
 
   return index;
@@ -2789,7 +3558,8 @@ Symbol_table::add_to_final_symtab(Symbol* sym, Stringpool* pool,
 {
   sym->set_symtab_index(*pindex);
   if (sym->version() == NULL || !parameters->options().relocatable())
-    pool->add(sym->name(), false, NULL);
+    pool->add_with_hash(sym->name(), strlen(sym->name()), sym->name_hash(),
+			false, NULL);
   else
     pool->add(sym->versioned_name(), true, NULL);
   ++*pindex;
@@ -2829,18 +3599,22 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
     }
 
   // Now do all the remaining symbols.
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Symbol* sym = p->second;
-      if (this->sized_finalize_symbol<size>(sym))
+      Symbol_table_type& table(this->shards_[i].table);
+      for (Symbol_table_type::iterator p = table.begin();
+	   p != table.end();
+	   ++p)
 	{
-	  this->add_to_final_symtab<size>(sym, pool, &index, &off);
-	  if (sym->type() == elfcpp::STT_GNU_IFUNC
-	      || (sym->binding() == elfcpp::STB_GNU_UNIQUE
-		  && parameters->options().gnu_unique()))
-	    this->set_has_gnu_output();
+	  Symbol* sym = p->second;
+	  if (this->sized_finalize_symbol<size>(sym))
+	    {
+	      this->add_to_final_symtab<size>(sym, pool, &index, &off);
+	      if (sym->type() == elfcpp::STT_GNU_IFUNC
+		  || (sym->binding() == elfcpp::STB_GNU_UNIQUE
+		      && parameters->options().gnu_unique()))
+		this->set_has_gnu_output();
+	    }
 	}
     }
 
@@ -3118,6 +3892,52 @@ Symbol_table::write_globals(const Stringpool* sympool,
     }
 }
 
+// The minimum number of output symbols for which writing the global
+// symbols is split up between threads.
+
+static const uint64_t parallel_write_globals_min_symbols = 100000;
+
+// Class Symbol_table::Parallel_write_globals.
+
+// This writes the global symbols of the shards of the symbol table in
+// several threads.  Thread I writes the shards I, I + N, and so on,
+// where N is the number of threads.  The output index of each symbol
+// was set by finalize, so the shards do not depend upon each other.
+
+template<int size, bool big_endian>
+class Symbol_table::Parallel_write_globals : public Parallel_run
+{
+ public:
+  Parallel_write_globals(const Symbol_table* symtab,
+			 const Stringpool* sympool, const Stringpool* dynpool,
+			 unsigned char* psyms, unsigned char* dynamic_view,
+			 Write_globals_shard* shard_output,
+			 unsigned int thread_count)
+    : symtab_(symtab), sympool_(sympool), dynpool_(dynpool),
+      psyms_(psyms), dynamic_view_(dynamic_view), shard_output_(shard_output),
+      thread_count_(thread_count)
+  { }
+
+ protected:
+  void
+  do_run(unsigned int index)
+  {
+    for (unsigned int i = index; i < shard_count; i += this->thread_count_)
+      this->symtab_->sized_write_globals_shard<size, big_endian>(
+	  i, this->sympool_, this->dynpool_, this->psyms_,
+	  this->dynamic_view_, &this->shard_output_[i]);
+  }
+
+ private:
+  const Symbol_table* symtab_;
+  const Stringpool* sympool_;
+  const Stringpool* dynpool_;
+  unsigned char* psyms_;
+  unsigned char* dynamic_view_;
+  Write_globals_shard* shard_output_;
+  unsigned int thread_count_;
+};
+
 // Write out the global symbols.
 
 template<int size, bool big_endian>
@@ -3128,8 +3948,6 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 				  Output_symtab_xindex* dynsym_xindex,
 				  Output_file* of) const
 {
-  const Target& target = parameters->target();
-
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
   const unsigned int output_count = this->output_count_;
@@ -3151,14 +3969,121 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
   else
     dynamic_view = of->get_output_view(this->dynamic_offset_, dynamic_size);
 
-  for (Symbol_table_type::const_iterator p = this->table_.begin();
-       p != this->table_.end();
+  // Each shard of the symbol table is written separately.  Large
+  // symbol tables are written by several threads.
+  Write_globals_shard shard_output[shard_count];
+  unsigned int thread_count = 1;
+  if (static_cast<uint64_t>(output_count) + dynamic_count
+      >= parallel_write_globals_min_symbols)
+    {
+      thread_count = Parallel_run::thread_count(Parallel_run::FINAL_PHASE);
+      if (thread_count > shard_count)
+	thread_count = shard_count;
+    }
+  Parallel_write_globals<size, big_endian> writer(this, sympool, dynpool,
+						  psyms, dynamic_view,
+						  shard_output, thread_count);
+  writer.run(thread_count);
+
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      const Write_globals_shard& out(shard_output[i]);
+      for (size_t j = 0; j < out.symtab_xindex.size(); ++j)
+	symtab_xindex->add(out.symtab_xindex[j].first,
+			   out.symtab_xindex[j].second);
+      for (size_t j = 0; j < out.dynsym_xindex.size(); ++j)
+	dynsym_xindex->add(out.dynsym_xindex[j].first,
+			   out.dynsym_xindex[j].second);
+      for (size_t j = 0; j < out.undefined_dynobj_symbols.size(); ++j)
+	gold_undefined_symbol(out.undefined_dynobj_symbols[j]);
+    }
+
+  // Write the target-specific symbols.
+  for (std::vector<Symbol*>::const_iterator p = this->target_symbols_.begin();
+       p != this->target_symbols_.end();
+       ++p)
+    {
+      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(*p);
+
+      unsigned int sym_index = sym->symtab_index();
+      unsigned int dynsym_index;
+      if (dynamic_view == NULL)
+	dynsym_index = -1U;
+      else
+	dynsym_index = sym->dynsym_index();
+
+      unsigned int shndx;
+      switch (sym->source())
+	{
+	case Symbol::IS_CONSTANT:
+	  shndx = elfcpp::SHN_ABS;
+	  break;
+	case Symbol::IS_UNDEFINED:
+	  shndx = elfcpp::SHN_UNDEF;
+	  break;
+	default:
+	  gold_unreachable();
+	}
+
+      if (sym_index != -1U)
+	{
+	  sym_index -= first_global_index;
+	  gold_assert(sym_index < output_count);
+	  unsigned char* ps = psyms + (sym_index * sym_size);
+	  this->sized_write_symbol<size, big_endian>(sym, sym->value(), shndx,
+						     sym->binding(), sympool,
+						     ps);
+	}
+
+      if (dynsym_index != -1U)
+	{
+	  dynsym_index -= first_dynamic_global_index;
+	  gold_assert(dynsym_index < dynamic_count);
+	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
+	  this->sized_write_symbol<size, big_endian>(sym, sym->value(), shndx,
+						     sym->binding(), dynpool,
+						     pd);
+	}
+    }
+
+  of->write_output_view(this->offset_, oview_size, psyms);
+  if (dynamic_view != NULL)
+    of->write_output_view(this->dynamic_offset_, dynamic_size, dynamic_view);
+}
+
+// Write out the global symbols in shard SHARD of the symbol table.
+// Anything which must be done in order is recorded in OUT.
+
+template<int size, bool big_endian>
+void
+Symbol_table::sized_write_globals_shard(unsigned int shard,
+					const Stringpool* sympool,
+					const Stringpool* dynpool,
+					unsigned char* psyms,
+					unsigned char* dynamic_view,
+					Write_globals_shard* out) const
+{
+  const Target& target = parameters->target();
+
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  const unsigned int output_count = this->output_count_;
+  const unsigned int first_global_index = this->first_global_index_;
+  const unsigned int dynamic_count = this->dynamic_count_;
+  const unsigned int first_dynamic_global_index =
+    this->first_dynamic_global_index_;
+
+  const Symbol_table_type& table(this->shards_[shard].table);
+  for (Symbol_table_type::const_iterator p = table.begin();
+       p != table.end();
        ++p)
     {
-      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
+      Sized_symbol<size>* sym =
+	static_cast<Sized_symbol<size>*>(p->second);
 
       // Possibly warn about unresolved symbols in shared libraries.
-      this->warn_about_undefined_dynobj_symbol(sym);
+      if (this->should_warn_about_undefined_dynobj_symbol(sym))
+	out->undefined_dynobj_symbols.push_back(sym);
 
       unsigned int sym_index = sym->symtab_index();
       unsigned int dynsym_index;
@@ -3229,28 +4154,31 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 		  {
 		    Relobj* relobj = static_cast<Relobj*>(symobj);
 		    Output_section* os = relobj->output_section(in_shndx);
-                    if (this->is_section_folded(relobj, in_shndx))
-                      {
-                        // This global symbol must be written out even though
-                        // it is folded.
-                        // Get the os of the section it is folded onto.
-                        Section_id folded =
-                             this->icf_->get_folded_section(relobj, in_shndx);
-                        gold_assert(folded.first !=NULL);
-                        Relobj* folded_obj = 
-                          reinterpret_cast<Relobj*>(folded.first);
-                        os = folded_obj->output_section(folded.second);  
-                        gold_assert(os != NULL);
-                      }
+		    if (this->is_section_folded(relobj, in_shndx))
+		      {
+			// This global symbol must be written out even
+			// though it is folded.
+			// Get the os of the section it is folded onto.
+			Section_id folded =
+			  this->icf_->get_folded_section(relobj,
+							 in_shndx);
+			gold_assert(folded.first !=NULL);
+			Relobj* folded_obj = 
+			  reinterpret_cast<Relobj*>(folded.first);
+			os = folded_obj->output_section(folded.second);  
+			gold_assert(os != NULL);
+		      }
 		    gold_assert(os != NULL);
 		    shndx = os->out_shndx();
 
 		    if (shndx >= elfcpp::SHN_LORESERVE)
 		      {
 			if (sym_index != -1U)
-			  symtab_xindex->add(sym_index, shndx);
+			  out->symtab_xindex.push_back(
+			      std::make_pair(sym_index, shndx));
 			if (dynsym_index != -1U)
-			  dynsym_xindex->add(dynsym_index, shndx);
+			  out->dynsym_xindex.push_back(
+			      std::make_pair(dynsym_index, shndx));
 			shndx = elfcpp::SHN_XINDEX;
 		      }
 
@@ -3271,9 +4199,11 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 	    if (shndx >= elfcpp::SHN_LORESERVE)
 	      {
 		if (sym_index != -1U)
-		  symtab_xindex->add(sym_index, shndx);
+		  out->symtab_xindex.push_back(std::make_pair(sym_index,
+							      shndx));
 		if (dynsym_index != -1U)
-		  dynsym_xindex->add(dynsym_index, shndx);
+		  out->dynsym_xindex.push_back(std::make_pair(dynsym_index,
+							      shndx));
 		shndx = elfcpp::SHN_XINDEX;
 	      }
 
@@ -3325,64 +4255,13 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 	  dynsym_index -= first_dynamic_global_index;
 	  gold_assert(dynsym_index < dynamic_count);
 	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
-						     binding, dynpool, pd);
-          // Allow a target to adjust dynamic symbol value.
-          parameters->target().adjust_dyn_symbol(sym, pd);
-	}
-    }
-
-  // Write the target-specific symbols.
-  for (std::vector<Symbol*>::const_iterator p = this->target_symbols_.begin();
-       p != this->target_symbols_.end();
-       ++p)
-    {
-      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(*p);
-
-      unsigned int sym_index = sym->symtab_index();
-      unsigned int dynsym_index;
-      if (dynamic_view == NULL)
-	dynsym_index = -1U;
-      else
-	dynsym_index = sym->dynsym_index();
-
-      unsigned int shndx;
-      switch (sym->source())
-	{
-	case Symbol::IS_CONSTANT:
-	  shndx = elfcpp::SHN_ABS;
-	  break;
-	case Symbol::IS_UNDEFINED:
-	  shndx = elfcpp::SHN_UNDEF;
-	  break;
-	default:
-	  gold_unreachable();
-	}
-
-      if (sym_index != -1U)
-	{
-	  sym_index -= first_global_index;
-	  gold_assert(sym_index < output_count);
-	  unsigned char* ps = psyms + (sym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, sym->value(), shndx,
-						     sym->binding(), sympool,
-						     ps);
-	}
-
-      if (dynsym_index != -1U)
-	{
-	  dynsym_index -= first_dynamic_global_index;
-	  gold_assert(dynsym_index < dynamic_count);
-	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, sym->value(), shndx,
-						     sym->binding(), dynpool,
-						     pd);
+	  this->sized_write_symbol<size, big_endian>(sym, dynsym_value,
+						     shndx, binding,
+						     dynpool, pd);
+	  // Allow a target to adjust dynamic symbol value.
+	  parameters->target().adjust_dyn_symbol(sym, pd);
 	}
     }
-
-  of->write_output_view(this->offset_, oview_size, psyms);
-  if (dynamic_view != NULL)
-    of->write_output_view(this->dynamic_offset_, dynamic_size, dynamic_view);
 }
 
 // Write out the symbol SYM, in section SHNDX, to P.  POOL is the
@@ -3400,7 +4279,9 @@ Symbol_table::sized_write_symbol(
 {
   elfcpp::Sym_write<size, big_endian> osym(p);
   if (sym->version() == NULL || !parameters->options().relocatable())
-    osym.put_st_name(pool->get_offset(sym->name()));
+    osym.put_st_name(pool->get_offset_with_hash(sym->name(),
+						strlen(sym->name()),
+						sym->name_hash()));
   else
     osym.put_st_name(pool->get_offset(sym->versioned_name()));
   osym.put_st_value(value);
@@ -3434,8 +4315,8 @@ Symbol_table::sized_write_symbol(
 // are OK.  This heuristic avoids problems on GNU/Linux, in which -ldl
 // can have undefined references satisfied by ld-linux.so.
 
-inline void
-Symbol_table::warn_about_undefined_dynobj_symbol(Symbol* sym) const
+inline bool
+Symbol_table::should_warn_about_undefined_dynobj_symbol(Symbol* sym) const
 {
   bool dummy;
   if (sym->source() == Symbol::FROM_OBJECT
@@ -3449,8 +4330,9 @@ Symbol_table::warn_about_undefined_dynobj_symbol(Symbol* sym) const
       // A very ugly cast.
       Dynobj* dynobj = static_cast<Dynobj*>(sym->object());
       if (!dynobj->has_unknown_needed_entries())
-        gold_undefined_symbol(sym);
+	return true;
     }
+  return false;
 }
 
 // Write out a section symbol.  Return the update offset.
@@ -3532,14 +4414,41 @@ Symbol_table::sized_write_section_symbol(const Output_section* os,
 void
 Symbol_table::print_stats() const
 {
+  size_t entries = 0;
+  size_t buckets = 0;
+  size_t symbol_bytes = 0;
+  size_t symbol_blocks = 0;
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      entries += this->shards_[i].table.size();
+      symbol_bytes += this->shards_[i].arena.allocated();
+      symbol_blocks += this->shards_[i].arena.block_count();
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += this->shards_[i].table.bucket_count();
+#endif
+    }
 #if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: symbol table entries: %zu; buckets: %zu\n"),
-	  program_name, this->table_.size(), this->table_.bucket_count());
+	  program_name, entries, buckets);
 #else
   fprintf(stderr, _("%s: symbol table entries: %zu\n"),
-	  program_name, this->table_.size());
+	  program_name, entries);
 #endif
-  this->namepool_.print_stats("symbol table stringpool");
+  fprintf(stderr, _("%s: symbol storage: %zu bytes in %zu blocks\n"),
+	  program_name, symbol_bytes, symbol_blocks);
+
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      const Symbol_table_shard* shard = &this->shards_[i];
+      fprintf(stderr,
+	      _("%s: symbol table shard %u: entries: %zu; "
+		"queued symbols: %zu; queued objects: %zu; lock waits: %zu\n"),
+	      program_name, i, shard->table.size(), shard->queued_symbols,
+	      shard->queued_batches, shard->lock_waits);
+      char name[50];
+      snprintf(name, sizeof name, "symbol table shard %u stringpool", i);
+      shard->namepool.print_stats(name);
+    }
 }
 
 // We check for ODR violations by looking for symbols with the same
@@ -3897,8 +4806,21 @@ Symbol_table::add_from_dynobj<32, false>(
     const unsigned char* versym,
     size_t versym_size,
     const std::vector<const char*>* version_map,
+    const std::vector<bool>* is_deferred,
     Sized_relobj_file<32, false>::Symbols* sympointers,
     size_t* defined);
+
+template
+void
+Symbol_table::add_lazy_dynobj_symbols<32, false>(
+    Sized_dynobj<32, false>* dynobj,
+    const std::vector<unsigned int>& indexes,
+    const unsigned char* syms,
+    const char* sym_names,
+    size_t sym_name_size,
+    const unsigned char* versym,
+    const std::vector<const char*>* version_map,
+    size_t* defined);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -3913,8 +4835,21 @@ Symbol_table::add_from_dynobj<32, true>(
     const unsigned char* versym,
     size_t versym_size,
     const std::vector<const char*>* version_map,
+    const std::vector<bool>* is_deferred,
     Sized_relobj_file<32, true>::Symbols* sympointers,
     size_t* defined);
+
+template
+void
+Symbol_table::add_lazy_dynobj_symbols<32, true>(
+    Sized_dynobj<32, true>* dynobj,
+    const std::vector<unsigned int>& indexes,
+    const unsigned char* syms,
+    const char* sym_names,
+    size_t sym_name_size,
+    const unsigned char* versym,
+    const std::vector<const char*>* version_map,
+    size_t* defined);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -3929,8 +4864,21 @@ Symbol_table::add_from_dynobj<64, false>(
     const unsigned char* versym,
     size_t versym_size,
     const std::vector<const char*>* version_map,
+    const std::vector<bool>* is_deferred,
     Sized_relobj_file<64, false>::Symbols* sympointers,
     size_t* defined);
+
+template
+void
+Symbol_table::add_lazy_dynobj_symbols<64, false>(
+    Sized_dynobj<64, false>* dynobj,
+    const std::vector<unsigned int>& indexes,
+    const unsigned char* syms,
+    const char* sym_names,
+    size_t sym_name_size,
+    const unsigned char* versym,
+    const std::vector<const char*>* version_map,
+    size_t* defined);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -3945,8 +4893,21 @@ Symbol_table::add_from_dynobj<64, true>(
     const unsigned char* versym,
     size_t versym_size,
     const std::vector<const char*>* version_map,
+    const std::vector<bool>* is_deferred,
     Sized_relobj_file<64, true>::Symbols* sympointers,
     size_t* defined);
+
+template
+void
+Symbol_table::add_lazy_dynobj_symbols<64, true>(
+    Sized_dynobj<64, true>* dynobj,
+    const std::vector<unsigned int>& indexes,
+    const unsigned char* syms,
+    const char* sym_names,
+    size_t sym_name_size,
+    const unsigned char* versym,
+    const std::vector<const char*>* version_map,
+    size_t* defined);
 #endif
 
 #ifdef HAVE_TARGET_32_LITTLE
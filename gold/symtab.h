@@ -26,6 +26,7 @@
 #ifndef GOLD_SYMTAB_H
 #define GOLD_SYMTAB_H
 
+#include <deque>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,6 +35,7 @@
 #include "parameters.h"
 #include "stringpool.h"
 #include "object.h"
+#include "arena.h"
 
 namespace gold
 {
@@ -60,6 +62,7 @@ class Output_file;
 class Output_symtab_xindex;
 class Garbage_collection;
 class Icf;
+class Lock;
 
 // The base class of an entry in the symbol table.  The symbol table
 // can have a lot of entries, so we don't want this class too big.
@@ -108,6 +111,12 @@ class Symbol
   name() const
   { return this->name_; }
 
+  // Return the hash code of the symbol name, as computed by
+  // Stringpool::string_hash.  This is also the DT_GNU_HASH hash code.
+  uint32_t
+  name_hash() const
+  { return this->name_hash_; }
+
   // Return the (ANSI) demangled version of the name, if
   // parameters.demangle() is true.  Otherwise, return the name.  This
   // is intended to be used only for logging errors, so it's not
@@ -429,13 +438,19 @@ class Symbol
   // For a TLS symbol, this GOT entry will hold its tp-relative offset.
   bool
   has_got_offset(unsigned int got_type, uint64_t addend = 0) const
-  { return this->got_offsets_.get_offset(got_type, addend) != -1U; }
+  {
+    return (this->got_plt_offsets_ != NULL
+	    && (this->got_plt_offsets_->got_offsets.get_offset(got_type, addend)
+		!= -1U));
+  }
 
   // Return the offset into the GOT section of this symbol.
   unsigned int
   got_offset(unsigned int got_type, uint64_t addend = 0) const
   {
-    unsigned int got_offset = this->got_offsets_.get_offset(got_type, addend);
+    gold_assert(this->got_plt_offsets_ != NULL);
+    unsigned int got_offset =
+      this->got_plt_offsets_->got_offsets.get_offset(got_type, addend);
     gold_assert(got_offset != -1U);
     return got_offset;
   }
@@ -444,24 +459,34 @@ class Symbol
   void
   set_got_offset(unsigned int got_type, unsigned int got_offset,
 		 uint64_t addend = 0)
-  { this->got_offsets_.set_offset(got_type, got_offset, addend); }
+  {
+    this->got_plt_offsets()->got_offsets.set_offset(got_type, got_offset,
+						    addend);
+  }
 
-  // Return the GOT offset list.
+  // Return the GOT offset list, or NULL if there are no GOT entries.
   const Got_offset_list*
   got_offset_list() const
-  { return this->got_offsets_.get_list(); }
+  {
+    if (this->got_plt_offsets_ == NULL)
+      return NULL;
+    return this->got_plt_offsets_->got_offsets.get_list();
+  }
 
   // Return whether this symbol has an entry in the PLT section.
   bool
   has_plt_offset() const
-  { return this->plt_offset_ != -1U; }
+  {
+    return (this->got_plt_offsets_ != NULL
+	    && this->got_plt_offsets_->plt_offset != -1U);
+  }
 
   // Return the offset into the PLT section of this symbol.
   unsigned int
   plt_offset() const
   {
     gold_assert(this->has_plt_offset());
-    return this->plt_offset_;
+    return this->got_plt_offsets_->plt_offset;
   }
 
   // Set the PLT offset of this symbol.
@@ -469,7 +494,7 @@ class Symbol
   set_plt_offset(unsigned int plt_offset)
   {
     gold_assert(plt_offset != -1U);
-    this->plt_offset_ = plt_offset;
+    this->got_plt_offsets()->plt_offset = plt_offset;
   }
 
   // Return whether this dynamic symbol needs a special value in the
@@ -924,9 +949,10 @@ class Symbol
   Symbol()
   { memset(static_cast<void*>(this), 0, sizeof *this); }
 
-  // Initialize the general fields.
+  // Initialize the general fields.  NAME_HASH is the hash code of
+  // NAME.
   void
-  init_fields(const char* name, const char* version,
+  init_fields(const char* name, uint32_t name_hash, const char* version,
 	      elfcpp::STT type, elfcpp::STB binding,
 	      elfcpp::STV visibility, unsigned char nonvis);
 
@@ -935,9 +961,9 @@ class Symbol
   // index rather than a special code.
   template<int size, bool big_endian>
   void
-  init_base_object(const char* name, const char* version, Object* object,
-		   const elfcpp::Sym<size, big_endian>&, unsigned int st_shndx,
-		   bool is_ordinary);
+  init_base_object(const char* name, uint32_t name_hash, const char* version,
+		   Object* object, const elfcpp::Sym<size, big_endian>&,
+		   unsigned int st_shndx, bool is_ordinary);
 
   // Initialize fields for an Output_data.
   void
@@ -990,6 +1016,33 @@ class Symbol
   Symbol(const Symbol&);
   Symbol& operator=(const Symbol&);
 
+  // The GOT and PLT entries of a symbol.
+  struct Got_plt_offsets
+  {
+    Got_plt_offsets()
+      : got_offsets(), plt_offset(-1U)
+    { }
+
+    // The GOT section entries for this symbol.  A symbol may have
+    // more than one GOT offset (e.g., when mixing modules compiled
+    // with two different TLS models), but will usually have at most
+    // one.
+    Got_offset_list got_offsets;
+    // If this symbol has an entry in the PLT section, then this is
+    // the offset from the start of the PLT section.  This is -1U if
+    // there is no PLT entry.
+    unsigned int plt_offset;
+  };
+
+  // Return the GOT and PLT entries, allocating them if necessary.
+  Got_plt_offsets*
+  got_plt_offsets()
+  {
+    if (this->got_plt_offsets_ == NULL)
+      this->got_plt_offsets_ = new Got_plt_offsets();
+    return this->got_plt_offsets_;
+  }
+
   // Symbol name (expected to point into a Stringpool).
   const char* name_;
   // Symbol version (expected to point into a Stringpool).  This may
@@ -1015,6 +1068,16 @@ class Symbol
     Output_segment* output_segment;
   } u1_;
 
+  // The GOT and PLT entries for this symbol, or NULL if there are
+  // none.  Most symbols have no GOT or PLT entry at all, so this is
+  // only allocated when the first entry is added.
+  Got_plt_offsets* got_plt_offsets_;
+
+  // The hash code of the symbol name.  This is computed once, when
+  // the name is added to the symbol table, and reused for the output
+  // string tables and the GNU hash table.
+  uint32_t name_hash_;
+
   union
   {
     // This is used if SOURCE_ == FROM_OBJECT.
@@ -1043,16 +1106,6 @@ class Symbol
   // non-zero value during Layout::finalize.
   unsigned int dynsym_index_;
 
-  // If this symbol has an entry in the PLT section, then this is the
-  // offset from the start of the PLT section.  This is -1U if there
-  // is no PLT entry.
-  unsigned int plt_offset_;
-
-  // The GOT section entries for this symbol.  A symbol may have more
-  // than one GOT offset (e.g., when mixing modules compiled with two
-  // different TLS models), but will usually have at most one.
-  Got_offset_list got_offsets_;
-
   // Symbol type (bits 0 to 3).
   elfcpp::STT type_ : 4;
   // Symbol binding (bits 4 to 7).
@@ -1136,14 +1189,15 @@ class Sized_symbol : public Symbol
   Sized_symbol()
   { }
 
-  // Initialize fields from an ELF symbol in OBJECT.  ST_SHNDX is the
-  // section index, IS_ORDINARY is whether it is a normal section
-  // index rather than a special code.
+  // Initialize fields from an ELF symbol in OBJECT.  NAME_HASH is
+  // the hash code of NAME.  ST_SHNDX is the section index,
+  // IS_ORDINARY is whether it is a normal section index rather than
+  // a special code.
   template<bool big_endian>
   void
-  init_object(const char* name, const char* version, Object* object,
-	      const elfcpp::Sym<size, big_endian>&, unsigned int st_shndx,
-	      bool is_ordinary);
+  init_object(const char* name, uint32_t name_hash, const char* version,
+	      Object* object, const elfcpp::Sym<size, big_endian>&,
+	      unsigned int st_shndx, bool is_ordinary);
 
   // Initialize fields for an Output_data.
   void
@@ -1464,11 +1518,6 @@ class Symbol_table
   void
   gc_mark_symbol(Symbol* sym);
 
-  // During garbage collection, this keeps sections that correspond to 
-  // symbols seen in dynamic objects.
-  inline void
-  gc_mark_dyn_syms(Symbol* sym);
-
   // Add COUNT external symbols from the relocatable object RELOBJ to
   // the symbol table.  SYMS is the symbols, SYMNDX_OFFSET is the
   // offset in the symbol table of the first symbol, SYM_NAMES is
@@ -1495,7 +1544,9 @@ class Symbol_table
   // Add COUNT dynamic symbols from the dynamic object DYNOBJ to the
   // symbol table.  SYMS is the symbols.  SYM_NAMES is their names.
   // SYM_NAME_SIZE is the size of SYM_NAMES.  The other parameters are
-  // symbol version data.
+  // symbol version data.  If IS_DEFERRED is not NULL, the symbols for
+  // which it is true are skipped; they may be added later by
+  // add_lazy_dynobj_symbols.
   template<int size, bool big_endian>
   void
   add_from_dynobj(Sized_dynobj<size, big_endian>* dynobj,
@@ -1503,9 +1554,44 @@ class Symbol_table
 		  const char* sym_names, size_t sym_name_size,
 		  const unsigned char* versym, size_t versym_size,
 		  const std::vector<const char*>*,
+		  const std::vector<bool>* is_deferred,
 		  typename Sized_relobj_file<size, big_endian>::Symbols*,
 		  size_t* defined);
 
+  // Add the dynamic symbols of DYNOBJ whose indexes are in INDEXES,
+  // which must be sorted.  These are symbols which add_from_dynobj
+  // skipped.  The other parameters are as for add_from_dynobj.  This
+  // adds the number of defined symbols to *DEFINED.
+  template<int size, bool big_endian>
+  void
+  add_lazy_dynobj_symbols(Sized_dynobj<size, big_endian>* dynobj,
+			  const std::vector<unsigned int>& indexes,
+			  const unsigned char* syms,
+			  const char* sym_names, size_t sym_name_size,
+			  const unsigned char* versym,
+			  const std::vector<const char*>*,
+			  size_t* defined);
+
+  // Record that DYNOBJ has symbols which were not added to the symbol
+  // table, for --lazy-dynamic-symbols.  From now on, when we see a
+  // symbol name for the first time, we ask DYNOBJ for its symbols
+  // with that name.
+  void
+  add_lazy_dynobj(Dynobj* dynobj)
+  { this->lazy_dynobjs_.push_back(dynobj); }
+
+  // Return whether we have seen a global symbol named NAME.  This may
+  // return true for names which are only used as versions.
+  bool
+  is_known_symbol_name(const char* name) const;
+
+  // Add the symbols named NAME, which is NAMELEN characters long and
+  // need not be null terminated, from the dynamic objects which were
+  // recorded by add_lazy_dynobj.  These are added in the order in
+  // which the dynamic objects were read.
+  void
+  import_lazy_symbols(const char* name, size_t namelen);
+
   // Add one external symbol from the incremental object OBJ to the symbol
   // table.  Returns a pointer to the resolved symbol in the symbol table.
   template<int size, bool big_endian>
@@ -1570,6 +1656,11 @@ class Symbol_table
   Symbol*
   lookup(const char*, const char* version = NULL) const;
 
+  // Look up a symbol, first adding any symbols which are still
+  // waiting to be added to the symbol table.
+  Symbol*
+  lookup(const char*, const char* version = NULL);
+
   // Return the real symbol associated with the forwarder symbol FROM.
   Symbol*
   resolve_forwards(const Symbol* from) const;
@@ -1583,10 +1674,41 @@ class Symbol_table
   const Sized_symbol<size>*
   get_sized_symbol(const Symbol*) const;
 
-  // Return the count of undefined symbols seen.
+  // Return the count of undefined symbols seen.  This waits for all
+  // pending symbols to be added.
   size_t
-  saw_undefined() const
-  { return this->saw_undefined_; }
+  saw_undefined()
+  {
+    this->add_pending_symbols();
+    return this->saw_undefined_;
+  }
+
+  // Return the symbols which have become strong undefined symbols, in
+  // the order in which they were recorded.  An archive member can only
+  // newly satisfy a reference to one of these symbols.  This waits
+  // for all pending symbols to be added.
+  const std::vector<Symbol*>&
+  new_undefined_symbols()
+  {
+    this->add_pending_symbols();
+    return this->new_undefined_symbols_;
+  }
+
+  // Queue tasks to add the symbols which were read from relocatable
+  // objects but have not yet been added to the symbol table.  This is
+  // called by the tasks which read symbols when running with threads.
+  void
+  queue_pending_symbols(Workqueue*);
+
+  // Add the pending symbols for symbol table shard SHARD.  This is
+  // called by the tasks queued by queue_pending_symbols.
+  void
+  add_shard_symbols(unsigned int shard);
+
+  // Wait for all pending symbols to be added to the symbol table.
+  // This must be called before walking the whole table.
+  void
+  add_pending_symbols();
 
   void
   set_has_gnu_output()
@@ -1604,8 +1726,7 @@ class Symbol_table
 
   // Canonicalize a symbol name for use in the hash table.
   const char*
-  canonicalize_name(const char* name)
-  { return this->namepool_.add(name, true, NULL); }
+  canonicalize_name(const char* name);
 
   // Possibly issue a warning for a reference to SYM at LOCATION which
   // is in OBJ.
@@ -1705,12 +1826,17 @@ class Symbol_table
   void
   for_all_symbols(F f) const
   {
-    for (Symbol_table_type::const_iterator p = this->table_.begin();
-         p != this->table_.end();
-         ++p)
+    for (unsigned int i = 0; i < shard_count; ++i)
       {
-	Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
-	f(sym);
+	const Symbol_table_type& table(this->shards_[i].table);
+	for (Symbol_table_type::const_iterator p = table.begin();
+	     p != table.end();
+	     ++p)
+	  {
+	    Sized_symbol<size>* sym =
+	      static_cast<Sized_symbol<size>*>(p->second);
+	    f(sym);
+	  }
       }
   }
 
@@ -1741,13 +1867,18 @@ class Symbol_table
 
   // The type of the symbol hash table.
 
-  typedef std::pair<Stringpool::Key, Stringpool::Key> Symbol_table_key;
+  // The key values are Stringpool keys.  These are small sequential
+  // numbers, so we store them in 32 bits to keep the hash table
+  // nodes small.
+  typedef std::pair<uint32_t, uint32_t> Symbol_table_key;
 
-  // The hash function.  The key values are Stringpool keys.
+  // The hash function.  This is cheap enough that the hash table
+  // does not need to store the hash code of each entry, so it is
+  // declared not to throw.
   struct Symbol_table_hash
   {
     inline size_t
-    operator()(const Symbol_table_key& key) const
+    operator()(const Symbol_table_key& key) const noexcept
     {
       return key.first ^ key.second;
     }
@@ -1759,8 +1890,96 @@ class Symbol_table
     operator()(const Symbol_table_key&, const Symbol_table_key&) const;
   };
 
+  // The nodes are allocated in the arena of the shard.
+  typedef Arena_node_allocator<std::pair<const Symbol_table_key, Symbol*> >
+    Symbol_table_allocator;
+
   typedef Unordered_map<Symbol_table_key, Symbol*, Symbol_table_hash,
-			Symbol_table_eq> Symbol_table_type;
+			Symbol_table_eq, Symbol_table_allocator>
+    Symbol_table_type;
+
+  // Return the hash table key for NAME_KEY and VERSION_KEY.  The
+  // Stringpool keys are checked to fit in the 32 bits we keep.
+  static Symbol_table_key
+  symbol_table_key(Stringpool::Key name_key, Stringpool::Key version_key)
+  {
+    gold_assert(name_key == static_cast<uint32_t>(name_key)
+		&& version_key == static_cast<uint32_t>(version_key));
+    return Symbol_table_key(name_key, version_key);
+  }
+
+  // The type of the list of symbols which have been forced local.
+  typedef std::vector<Symbol*> Forced_locals;
+
+  // Symbols read from a relocatable object which are waiting to be
+  // added to the symbol table.  These are defined in symtab.cc.
+  class Pending_symbols;
+  template<int size, bool big_endian>
+  class Sized_pending_symbols;
+
+  // The number of shards in the symbol table.  A symbol is always
+  // stored in the shard selected by the hash code of its name, so
+  // symbols with different names can be added by different threads.
+  // This is a constant, rather than being based on the number of
+  // threads, so that the output does not depend on the thread count.
+  static const unsigned int shard_count = 16;
+
+  // One shard of the symbol table.
+  struct Symbol_table_shard
+  {
+    Symbol_table_shard()
+      : arena(),
+	table(0, Symbol_table_hash(), Symbol_table_eq(),
+	      Symbol_table_allocator(&this->arena)),
+	namepool(), lock(NULL), pending(), task_queued(false),
+	commons(), tls_commons(), small_commons(), large_commons(),
+	forced_locals(), gc_symbols(), saw_undefined(0),
+	new_undefined_symbols(), queued_symbols(0), queued_batches(0),
+	lock_waits(0)
+    { }
+
+    // Storage for the symbols created for this shard by
+    // add_from_object, and for the nodes of TABLE.  These are carved
+    // out of large blocks rather than allocated one at a time, which
+    // saves the malloc overhead of each one and keeps the symbols of
+    // an object close together in memory.  They are never freed
+    // individually.
+    Arena arena;
+    // The hash table of symbols in this shard.
+    Symbol_table_type table;
+    // The names and versions of the symbols in this shard.
+    Stringpool namepool;
+    // Lock held while modifying this shard.
+    Lock* lock;
+    // Symbols waiting to be added to this shard, in the order in
+    // which they were read.  This is protected by pending_lock_.
+    std::deque<Pending_symbols*> pending;
+    // Whether a task has been queued to add the pending symbols.
+    // This is protected by pending_lock_.
+    bool task_queued;
+    // Symbols found while adding symbols to this shard, which are
+    // moved to the corresponding Symbol_table lists by
+    // add_pending_symbols.  Keeping them here until then means that
+    // the lists are in the same order whether or not the symbols
+    // were added in parallel.
+    Commons_type commons;
+    Commons_type tls_commons;
+    Commons_type small_commons;
+    Commons_type large_commons;
+    Forced_locals forced_locals;
+    // Symbols to mark for garbage collection.
+    std::vector<Symbol*> gc_symbols;
+    // Count of new undefined symbols.
+    size_t saw_undefined;
+    // Symbols which have become strong undefined symbols.
+    std::vector<Symbol*> new_undefined_symbols;
+    // Statistics for --stats: the number of symbols and the number of
+    // objects which were added through the pending queue, and the
+    // number of times the lock was already held when we wanted it.
+    size_t queued_symbols;
+    size_t queued_batches;
+    size_t lock_waits;
+  };
 
   typedef Unordered_map<const char*,
                         Unordered_set<Symbol_location, Symbol_location_hash> >
@@ -1770,19 +1989,82 @@ class Symbol_table
   void
   make_forwarder(Symbol* from, Symbol* to);
 
+  // Return the shard for a symbol whose name has the hash code
+  // NAME_HASH, as computed by Stringpool::string_hash.  This does not
+  // wait for pending symbols.
+  Symbol_table_shard*
+  get_shard(uint32_t name_hash)
+  { return &this->shards_[Symbol_table::shard_index(name_hash)]; }
+
+  // Return the index of the shard for a symbol whose name has the
+  // hash code NAME_HASH.
+  static unsigned int
+  shard_index(uint32_t name_hash);
+
+  // Return the shard for a symbol whose name has the hash code
+  // NAME_HASH, after adding any symbols which are waiting to be added
+  // to it.
+  Symbol_table_shard*
+  sync_shard(uint32_t name_hash);
+
+  // Add the pending symbols for SHARD.  FROM_TASK is true if this is
+  // called by a task queued by queue_pending_symbols.
+  void
+  add_shard_symbols(Symbol_table_shard* shard, bool from_task);
+
+  // Queue the symbols in PENDING to be added to the symbol table.
+  void
+  queue_symbols(Pending_symbols* pending);
+
+  // Whether the symbols from relocatable objects may be added in
+  // parallel.
+  bool
+  can_queue_symbols() const;
+
   // Add a symbol.
   template<int size, bool big_endian>
   Sized_symbol<size>*
-  add_from_object(Object*, const char* name, Stringpool::Key name_key,
+  add_from_object(Symbol_table_shard*, Object*,
+		  const char* name, Stringpool::Key name_key,
+		  uint32_t name_hash,
 		  const char* version, Stringpool::Key version_key,
 		  bool def, const elfcpp::Sym<size, big_endian>& sym,
 		  unsigned int st_shndx, bool is_ordinary,
 		  unsigned int orig_st_shndx);
 
+  // Add the I'th symbol of the dynamic object DYNOBJ, at P, to the
+  // symbol table.  VS points to its version, or is NULL.  If
+  // IMPORT_LAZY is true, first add any symbols with the same name
+  // from lazily read dynamic objects.  STT_OBJECT definitions are
+  // added to OBJECT_SYMBOLS for record_weak_aliases.  Returns NULL if
+  // the symbol was not added.
+  template<int size, bool big_endian>
+  Sized_symbol<size>*
+  add_dynobj_symbol(Sized_dynobj<size, big_endian>* dynobj, size_t i,
+		    const unsigned char* p, const char* sym_names,
+		    size_t sym_name_size, const unsigned char* vs,
+		    const std::vector<const char*>* version_map,
+		    bool import_lazy, size_t* defined,
+		    std::vector<Sized_symbol<size>*>* object_symbols);
+
+  // Add one global symbol from a relocatable object.  This is called
+  // after the symbol has been checked by add_from_relobj, possibly
+  // from a separate task.
+  template<int size, bool big_endian>
+  Sized_symbol<size>*
+  add_relobj_symbol(Symbol_table_shard*,
+		    Sized_relobj_file<size, big_endian>* relobj,
+		    const char* name, size_t namelen, uint32_t name_hash,
+		    const char* ver,
+		    const elfcpp::Sym<size, big_endian>& sym,
+		    unsigned int st_shndx, bool is_ordinary,
+		    unsigned int orig_st_shndx,
+		    bool is_defined_in_discarded_section);
+
   // Define a default symbol.
   template<int size, bool big_endian>
   void
-  define_default_version(Sized_symbol<size>*, bool,
+  define_default_version(Symbol_table_shard*, Sized_symbol<size>*, bool,
 			 Symbol_table_type::iterator);
 
   // Resolve symbols.
@@ -1797,16 +2079,28 @@ class Symbol_table
 
   template<int size, bool big_endian>
   void
-  resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from);
+  resolve(Symbol_table_shard*, Sized_symbol<size>* to,
+	  const Sized_symbol<size>* from);
 
   // Record that a symbol is forced to be local by a version script or
   // by visibility.
   void
   force_local(Symbol*);
 
-  // Adjust NAME and *NAME_KEY for wrapping.
+  // Likewise, for a symbol in SHARD.
+  void
+  force_local(Symbol_table_shard* shard, Symbol*);
+
+  // During garbage collection, this keeps sections that correspond to
+  // symbols seen in dynamic objects.  SHARD is the shard of SYM.
+  void
+  gc_mark_dyn_syms(Symbol_table_shard* shard, Symbol* sym);
+
+  // Adjust NAME and *NAME_KEY for wrapping, and set *PSHARD to the
+  // shard for the new name.
   const char*
-  wrap_symbol(const char* name, Stringpool::Key* name_key);
+  wrap_symbol(const char* name, Stringpool::Key* name_key,
+	      Symbol_table_shard** pshard);
 
   // Whether we should override a symbol, based on flags in
   // resolve.cc.
@@ -1950,6 +2244,38 @@ class Symbol_table
 		      Output_symtab_xindex*, Output_symtab_xindex*,
 		      Output_file*) const;
 
+  // What writing the global symbols of one shard leaves for
+  // sized_write_globals to do afterward.  This is done in shard order
+  // so that the output does not depend upon the number of threads.
+  struct Write_globals_shard
+  {
+    Write_globals_shard()
+      : symtab_xindex(), dynsym_xindex(), undefined_dynobj_symbols()
+    { }
+
+    // Entries for the SHT_SYMTAB_SHNDX sections of the symbol table
+    // and the dynamic symbol table, as pairs of symbol index and
+    // section index.
+    std::vector<std::pair<unsigned int, unsigned int> > symtab_xindex;
+    std::vector<std::pair<unsigned int, unsigned int> > dynsym_xindex;
+    // Undefined symbols from dynamic objects to warn about.
+    std::vector<Symbol*> undefined_dynobj_symbols;
+  };
+
+  // The class which writes the shards in several threads.
+  template<int size, bool big_endian>
+  class Parallel_write_globals;
+
+  // Write the global symbols in shard SHARD to PSYMS and, if it is
+  // not NULL, DYNAMIC_VIEW.  This may be called for several shards at
+  // once.
+  template<int size, bool big_endian>
+  void
+  sized_write_globals_shard(unsigned int shard, const Stringpool* sympool,
+			    const Stringpool* dynpool, unsigned char* psyms,
+			    unsigned char* dynamic_view,
+			    Write_globals_shard*) const;
+
   // Write out a symbol to P.
   template<int size, bool big_endian>
   void
@@ -1958,9 +2284,10 @@ class Symbol_table
 		     unsigned int shndx, elfcpp::STB,
 		     const Stringpool*, unsigned char* p) const;
 
-  // Possibly warn about an undefined symbol from a dynamic object.
-  void
-  warn_about_undefined_dynobj_symbol(Symbol*) const;
+  // Return whether to warn about an undefined symbol from a dynamic
+  // object.
+  bool
+  should_warn_about_undefined_dynobj_symbol(Symbol*) const;
 
   // Write out a section symbol, specialized for size and endianness.
   template<int size, bool big_endian>
@@ -1968,9 +2295,6 @@ class Symbol_table
   sized_write_section_symbol(const Output_section*, Output_symtab_xindex*,
 			     Output_file*, off_t) const;
 
-  // The type of the list of symbols which have been forced local.
-  typedef std::vector<Symbol*> Forced_locals;
-
   // A map from symbols with COPY relocs to the dynamic objects where
   // they are defined.
   typedef Unordered_map<const Symbol*, Dynobj*> Copied_symbol_dynobjs;
@@ -1978,6 +2302,9 @@ class Symbol_table
   // We increment this every time we see a new undefined symbol, for
   // use in archive groups.
   size_t saw_undefined_;
+  // Every symbol which has become a strong undefined symbol, for use
+  // when selecting archive members.
+  std::vector<Symbol*> new_undefined_symbols_;
   // The index of the first global symbol in the output file.
   unsigned int first_global_index_;
   // The file offset within the output symtab section where we should
@@ -1995,16 +2322,33 @@ class Symbol_table
   unsigned int dynamic_count_;
   // Set if a STT_GNU_IFUNC or STB_GNU_UNIQUE symbol will be output.
   bool has_gnu_output_;
-  // The symbol hash table.
-  Symbol_table_type table_;
-  // A pool of symbol names.  This is used for all global symbols.
-  // Entries in the hash table point into this pool.
-  Stringpool namepool_;
+  // The symbol hash table, divided into shards.  Each shard has its
+  // own pool of symbol names, which is used for all global symbols in
+  // the shard.  Entries in the hash table point into that pool.
+  Symbol_table_shard shards_[shard_count];
+  // Lock for the pending symbol queues in shards_.
+  Lock* pending_lock_;
+  // Whether any symbols have been queued since the last call to
+  // add_pending_symbols.  This is only changed by the tasks which
+  // read symbols, which run one at a time.
+  bool has_pending_symbols_;
   // Forwarding symbols.
   Unordered_map<const Symbol*, Symbol*> forwarders_;
+  // Lock for forwarders_, which may be changed while adding symbols
+  // in parallel.
+  Lock* forwarders_lock_;
   // Weak aliases.  A symbol in this list points to the next alias.
   // The aliases point to each other in a circular list.
   Unordered_map<Symbol*, Symbol*> weak_aliases_;
+  // Dynamic objects with symbols which have not yet been added to the
+  // table, for --lazy-dynamic-symbols, in the order they were read.
+  std::vector<Dynobj*> lazy_dynobjs_;
+  // Names still to look up in lazy_dynobjs_, and whether we are
+  // looking them up.  Names found while adding symbols from
+  // lazy_dynobjs_ are queued here, so that the symbols for one name
+  // are added together.
+  std::vector<std::pair<const char*, size_t> > lazy_names_;
+  bool is_importing_lazy_symbols_;
   // We don't expect there to be very many common symbols, so we keep
   // a list of them.  When we find a common symbol we add it to this
   // list.  It is possible that by the time we process the list the
@@ -113,6 +113,126 @@ scan_relocs(
     }
 }
 
+// This function implements the generic part of deciding what to do
+// with the relocs before they are scanned, for
+// Sized_target::prescan_relocs.  The Scan class must provide a
+// static function prescan_local() which sets *KIND to the
+// Reloc_request kind for a reloc against a local symbol, or returns
+// false if scan_relocs above would do nothing with the reloc.
+// Relocs against global symbols are always scanned, as how they are
+// handled depends upon what earlier objects did with the symbol.
+// The requests are appended to SCAN_REQUESTS in reloc order.
+
+template<int size, bool big_endian, typename Scan, typename Classify_reloc>
+inline void
+prescan_relocs(
+    Sized_relobj_file<size, big_endian>* object,
+    unsigned int data_shndx,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    size_t local_count,
+    const unsigned char* plocal_syms,
+    std::vector<Reloc_request>* scan_requests)
+{
+  typedef typename Classify_reloc::Reltype Reltype;
+  const int reloc_size = Classify_reloc::reloc_size;
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+
+  for (size_t i = 0; i < reloc_count; ++i, prelocs += reloc_size)
+    {
+      Reltype reloc(prelocs);
+      unsigned int r_sym = Classify_reloc::get_r_sym(&reloc);
+      unsigned int kind = Reloc_request::SCAN;
+      if (r_sym < local_count && plocal_syms != NULL)
+	{
+	  unsigned int r_type = Classify_reloc::get_r_type(&reloc);
+	  typename elfcpp::Sym<size, big_endian> lsym(plocal_syms
+						      + r_sym * sym_size);
+	  if (!Scan::prescan_local(object, data_shndx, reloc, r_type, lsym,
+				   &kind))
+	    continue;
+	}
+      scan_requests->push_back(Reloc_request(i, kind));
+    }
+}
+
+// This function implements the generic part of carrying out the
+// requests made by prescan_relocs, for
+// Sized_target::scan_reloc_requests.  A SCAN request is handled as
+// in scan_relocs.  For any other request against a local symbol which
+// is not being discarded, the Scan class function local_request() is
+// called.  PRELOCS points to all the relocs of the section.
+
+template<int size, bool big_endian, typename Target_type,
+	 typename Scan, typename Classify_reloc>
+inline void
+scan_reloc_requests(
+    Symbol_table* symtab,
+    Layout* layout,
+    Target_type* target,
+    Sized_relobj_file<size, big_endian>* object,
+    unsigned int data_shndx,
+    const unsigned char* prelocs,
+    const std::vector<Reloc_request>& scan_requests,
+    Output_section* output_section,
+    bool needs_special_offset_handling,
+    size_t local_count,
+    const unsigned char* plocal_syms)
+{
+  typedef typename Classify_reloc::Reltype Reltype;
+  const int reloc_size = Classify_reloc::reloc_size;
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  Scan scan;
+
+  for (std::vector<Reloc_request>::const_iterator p = scan_requests.begin();
+       p != scan_requests.end();
+       ++p)
+    {
+      Reltype reloc(prelocs + p->index * reloc_size);
+
+      if (needs_special_offset_handling
+	  && !output_section->is_input_address_mapped(object, data_shndx,
+						      reloc.get_r_offset()))
+	continue;
+
+      unsigned int r_sym = Classify_reloc::get_r_sym(&reloc);
+      unsigned int r_type = Classify_reloc::get_r_type(&reloc);
+
+      if (r_sym < local_count)
+	{
+	  gold_assert(plocal_syms != NULL);
+	  typename elfcpp::Sym<size, big_endian> lsym(plocal_syms
+						      + r_sym * sym_size);
+	  unsigned int shndx = lsym.get_st_shndx();
+	  bool is_ordinary;
+	  shndx = object->adjust_sym_shndx(r_sym, shndx, &is_ordinary);
+	  // As in scan_relocs, ignore relocs against local symbols in
+	  // sections we are discarding.
+	  bool is_discarded = (is_ordinary
+			       && shndx != elfcpp::SHN_UNDEF
+			       && !object->is_section_included(shndx)
+			       && !symtab->is_section_folded(object, shndx));
+	  if (p->kind == Reloc_request::SCAN)
+	    scan.local(symtab, layout, target, object, data_shndx,
+		       output_section, reloc, r_type, lsym, is_discarded);
+	  else if (!is_discarded)
+	    scan.local_request(symtab, layout, target, object, data_shndx,
+			       output_section, reloc, r_type, lsym, p->kind);
+	}
+      else
+	{
+	  gold_assert(p->kind == Reloc_request::SCAN);
+	  Symbol* gsym = object->global_symbol(r_sym);
+	  gold_assert(gsym != NULL);
+	  if (gsym->is_forwarder())
+	    gsym = symtab->resolve_forwards(gsym);
+
+	  scan.global(symtab, layout, target, object, data_shndx,
+		      output_section, reloc, r_type, gsym);
+	}
+    }
+}
+
 // Behavior for relocations to discarded comdat sections.
 
 enum Comdat_behavior
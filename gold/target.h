@@ -51,6 +51,7 @@ class Sized_relobj_file;
 class Relocatable_relocs;
 template<int size, bool big_endian>
 struct Relocate_info;
+struct Reloc_request;
 class Reloc_symbol_changes;
 class Symbol;
 template<int size>
@@ -514,6 +515,12 @@ class Target
   should_include_section(elfcpp::Elf_Word sh_type) const
   { return this->do_should_include_section(sh_type); }
 
+  // Return whether relocate_section may be called for different
+  // sections of one input object at the same time.
+  bool
+  relocate_sections_in_parallel() const
+  { return this->do_relocate_sections_in_parallel(); }
+
   // Finalize the target-specific properties in the .note.gnu.property section.
   void
   finalize_gnu_properties(Layout* layout) const
@@ -828,6 +835,11 @@ class Target
   do_should_include_section(elfcpp::Elf_Word) const
   { return true; }
 
+  // This may be overridden by the child class.
+  virtual bool
+  do_relocate_sections_in_parallel() const
+  { return false; }
+
   // Finalize the target-specific properties in the .note.gnu.property section.
   virtual void
   do_finalize_gnu_properties(Layout*) const
@@ -925,6 +937,46 @@ class Sized_target : public Target
 	      size_t local_symbol_count,
 	      const unsigned char* plocal_symbols) = 0;
 
+  // Decide what to do with the relocs for a section before they are
+  // scanned.  This appends to SCAN_REQUESTS a Reloc_request for each
+  // reloc which scan_reloc_requests must see, in the original order.
+  // Relocs which can not require a GOT or PLT entry, a dynamic
+  // relocation, or any other change to the target state get no
+  // request.  The parameters are like scan_relocs.  This is called
+  // for several objects at the same time, before the relocs are
+  // scanned in input order, so it must not change any shared state.
+  // It returns false if the target does not support requests, in
+  // which case scan_relocs is called for all the relocs.
+  virtual bool
+  prescan_relocs(Sized_relobj_file<size, big_endian>*,
+		 unsigned int /* data_shndx */,
+		 unsigned int /* sh_type */,
+		 const unsigned char* /* prelocs */,
+		 size_t /* reloc_count */,
+		 size_t /* local_symbol_count */,
+		 const unsigned char* /* plocal_symbols */,
+		 std::vector<Reloc_request>* /* scan_requests */)
+  { return false; }
+
+  // Carry out the requests made by prescan_relocs for a section.
+  // This is called one object at a time, in input order, so it may
+  // create GOT and PLT entries and dynamic relocs.  The parameters
+  // are like scan_relocs; PRELOCS points to all the relocs of the
+  // section.
+  virtual void
+  scan_reloc_requests(Symbol_table*,
+		      Layout*,
+		      Sized_relobj_file<size, big_endian>*,
+		      unsigned int /* data_shndx */,
+		      unsigned int /* sh_type */,
+		      const unsigned char* /* prelocs */,
+		      const std::vector<Reloc_request>& /* scan_requests */,
+		      Output_section*,
+		      bool /* needs_special_offset_handling */,
+		      size_t /* local_symbol_count */,
+		      const unsigned char* /* plocal_symbols */)
+  { gold_unreachable(); }
+
   // Relocate section data.  SH_TYPE is the type of the relocation
   // section, SHT_REL or SHT_RELA.  PRELOCS points to the relocation
   // information.  RELOC_COUNT is the number of relocs.
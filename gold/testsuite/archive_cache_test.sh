@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# archive_cache_test.sh -- test --archive-cache
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that a link which uses the
+# archive maps saved by --archive-cache produces the same output as
+# the link which saved them, and that a saved map is not used once
+# its archive has changed.
+
+check()
+{
+    if ! grep -q "$2" "$1"; then
+	echo "Did not find expected statistics in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+if ! cmp -s archive_cache_1 archive_cache_2; then
+    echo "--archive-cache changes the output"
+    exit 1
+fi
+
+if ! cmp -s archive_cache_1 archive_cache_3; then
+    echo "--archive-cache changes the output after the archive changed"
+    exit 1
+fi
+
+# The first link starts with an empty cache, although an archive named
+# twice on the command line hits the entry saved for its first use.
+# The second link finds everything, and the third one must reject the
+# stale entry of the archive which was touched.
+check archive_cache_1.stderr "archive map cache hits: [0-9]*; misses: [1-9]"
+check archive_cache_2.stderr "archive map cache hits: [1-9][0-9]*; misses: 0$"
+check archive_cache_3.stderr "archive map cache hits: [0-9]*; misses: 1$"
+
+exit 0
@@ -0,0 +1,49 @@
+#!/bin/sh
+
+# build_id_fast_test.sh -- test --build-id=fast
+
+# Copyright (C) 2008-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that --build-id=fast produces
+# a 128-bit build ID, and that the build ID does not depend on whether
+# the chunks of the output file are hashed in parallel.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check build_id_fast_serial.stdout "Build ID: [0-9a-f]\{32\}$"
+
+if ! cmp -s build_id_fast_serial.stdout build_id_fast_threads.stdout; then
+    echo "--build-id=fast with --threads differs:"
+    diff build_id_fast_serial.stdout build_id_fast_threads.stdout
+    exit 1
+fi
+
+exit 0
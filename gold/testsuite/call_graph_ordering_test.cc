@@ -0,0 +1,68 @@
+// call_graph_ordering_test.cc -- a test case for gold
+
+// Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// The goal of this program is to verify that --call-graph-ordering-file
+// places the functions which call each other next to each other, and
+// the functions which are not in the call graph after them.
+// hot_a is a local symbol, which is found by name in the symbol table
+// of this object.
+
+extern "C"
+{
+
+int cold_x(int);
+int cold_y(int);
+int warm(int);
+int hot_b(int);
+
+int
+cold_x(int i)
+{ return i * 3 + 1; }
+
+static int
+hot_a(int i)
+{ return i + 7; }
+
+int
+cold_y(int i)
+{ return i * 5 + 2; }
+
+int
+warm(int i)
+{ return i - 1; }
+
+int
+hot_b(int i)
+{ return hot_a(i) * 2; }
+
+}
+
+int
+main(int argc, char**)
+{
+  int s = 0;
+  for (int i = 0; i < 1000; ++i)
+    s += hot_b(i);
+  s += warm(argc);
+  if (argc > 5)
+    s += cold_x(argc) + cold_y(argc);
+  return s == 0;
+}
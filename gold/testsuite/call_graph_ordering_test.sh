@@ -0,0 +1,63 @@
+#!/bin/sh
+
+# call_graph_ordering_test.sh -- test --call-graph-ordering-file
+
+# Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that --call-graph-ordering-file
+# clusters the functions of the call graph, callers first, and places
+# the functions which are not in the graph after them in input order.
+# File call_graph_ordering_test.cc is in this test.
+
+set -e
+
+check()
+{
+    awk "
+BEGIN { saw1 = 0; saw2 = 0; err = 0; }
+/ $2\$/ { saw1 = 1; }
+/ $3\$/ {
+     saw2 = 1;
+     if (!saw1)
+       {
+	  printf \"layout of $2 and $3 is not right\\n\";
+	  err = 1;
+	  exit 1;
+       }
+    }
+END {
+      if (!saw1 && !err)
+        {
+	  printf \"did not see $2\\n\";
+	  exit 1;
+	}
+      if (!saw2 && !err)
+	{
+	  printf \"did not see $3\\n\";
+	  exit 1;
+	}
+    }" $1
+}
+
+check call_graph_ordering_test.stdout "main" "hot_b"
+check call_graph_ordering_test.stdout "hot_b" "hot_a"
+check call_graph_ordering_test.stdout "hot_a" "warm"
+check call_graph_ordering_test.stdout "warm" "cold_x"
+check call_graph_ordering_test.stdout "cold_x" "cold_y"
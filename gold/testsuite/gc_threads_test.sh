@@ -0,0 +1,54 @@
+#!/bin/sh
+
+# gc_threads_test.sh -- test --gc-sections with several mark tasks
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that marking the live
+# sections for --gc-sections in several threads keeps the same
+# sections as marking them in one thread.  gc_threads_test.c has a
+# tree of 20000 functions called from main, and 10000 functions
+# which are never called.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"; then
+        echo "--gc-sections with threads changes the output:"
+        echo "   $1 and $2 differ"
+        exit 1
+    fi
+}
+
+check_same gc_threads_serial gc_threads_threads
+check_same gc_comdat_test gc_comdat_test_threads
+check_same gc_tls_test gc_tls_test_threads
+check_same gc_orphan_section_test gc_orphan_section_test_threads
+
+if ! grep -q " gct_19999$" gc_threads_serial.stdout; then
+    echo "Garbage collection should not discard gct_19999"
+    exit 1
+fi
+
+if grep -q " gct_20000$" gc_threads_serial.stdout; then
+    echo "Garbage collection failed to collect gct_20000"
+    exit 1
+fi
+
+exit 0
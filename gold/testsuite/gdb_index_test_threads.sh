@@ -0,0 +1,55 @@
+#!/bin/sh
+
+# gdb_index_test_threads.sh -- test --gdb-index with --threads
+
+# Copyright (C) 2012-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that the .gdb_index section
+# does not depend on whether the objects are scanned in parallel.
+# gdb_index_test.o and gdb_index_test_3_nomain.o are linked both with
+# and without --threads.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output:"
+	echo "   $2"
+	echo ""
+	echo "Actual error output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+STDOUT=gdb_index_test_serial.stdout
+
+# Look for symbols from both objects.
+
+check $STDOUT "^\[ *[0-9]*\] main:"
+check $STDOUT "^\[ *[0-9]*\] check_int:"
+
+if ! cmp -s gdb_index_test_serial.stdout gdb_index_test_threads.stdout; then
+    echo ".gdb_index with --threads differs:"
+    diff gdb_index_test_serial.stdout gdb_index_test_threads.stdout
+    exit 1
+fi
+
+exit 0
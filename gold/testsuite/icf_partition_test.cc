@@ -0,0 +1,54 @@
+// icf_partition_test.cc -- a test case for gold
+
+// Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// The goal of this program is to verify that --icf-algorithm=partition
+// folds mutually recursive functions.  is_even_1 and is_even_2 are
+// identical only if is_odd_1 and is_odd_2 are, and the other way
+// around, so comparing the functions one pair at a time never finds
+// that either pair is identical.
+
+int is_odd_1(int);
+int is_odd_2(int);
+
+int is_even_1(int n)
+{
+  return n == 0 ? 1 : is_odd_1(n - 1);
+}
+
+int is_odd_1(int n)
+{
+  return n == 0 ? 0 : is_even_1(n - 1);
+}
+
+int is_even_2(int n)
+{
+  return n == 0 ? 1 : is_odd_2(n - 1);
+}
+
+int is_odd_2(int n)
+{
+  return n == 0 ? 0 : is_even_2(n - 1);
+}
+
+int main()
+{
+  return is_even_1(4) + is_even_2(5) == 1 ? 0 : 1;
+}
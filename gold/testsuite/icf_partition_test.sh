@@ -0,0 +1,39 @@
+#!/bin/sh
+
+# icf_partition_test.sh -- test --icf-algorithm=partition
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that --icf-algorithm=partition
+# folds mutually recursive functions.
+
+check()
+{
+    func_addr_1=`grep " $2(int)" $1 | awk '{print $1}'`
+    func_addr_2=`grep " $3(int)" $1 | awk '{print $1}'`
+    if [ -z "$func_addr_1" ] || [ "$func_addr_1" != "$func_addr_2" ]
+    then
+        echo "Identical Code Folding failed to fold" $2 "and" $3
+	exit 1
+    fi
+}
+
+check icf_partition_test.stdout "is_even_1" "is_even_2"
+check icf_partition_test.stdout "is_odd_1" "is_odd_2"
@@ -0,0 +1,49 @@
+#!/bin/sh
+
+# icf_threads_test.sh -- test --icf with --threads
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that the sections folded by
+# icf do not depend on whether the sections are hashed in parallel.
+# icf_test.o is linked both with and without --threads.
+
+set -e
+
+# Print the names of the text sections discarded in map file $1.
+folded()
+{
+    sed -n '/^Discarded input sections/,/^Memory map/p' $1 \
+	| grep '^ \.text\.' || true
+}
+
+folded icf_test.map > icf_threads_test.serial
+folded icf_threads_test.map > icf_threads_test.threads
+
+if ! test -s icf_threads_test.serial; then
+    echo "Identical Code Folding did not fold any sections"
+    exit 1
+fi
+
+if ! cmp -s icf_threads_test.serial icf_threads_test.threads; then
+    echo "Identical Code Folding with --threads folded different sections:"
+    diff icf_threads_test.serial icf_threads_test.threads
+    exit 1
+fi
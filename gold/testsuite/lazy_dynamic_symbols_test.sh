@@ -0,0 +1,50 @@
+#!/bin/sh
+
+# lazy_dynamic_symbols_test.sh -- test --lazy-dynamic-symbols
+
+# Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that adding the symbols of
+# shared libraries only when they are referenced gives the same
+# dynamic symbols as adding all of them.  The test program uses
+# variables with several names, all of which must be exported when
+# the variable is copied into the executable.
+
+syms()
+{
+    awk '$1 ~ /^[0-9]+:$/ { print $4, $5, $6, $7, $8 }' "$1" | sort
+}
+
+syms lazy_dynamic_symbols_eager.stdout > lazy_dynamic_symbols_eager.syms
+syms lazy_dynamic_symbols_lazy.stdout > lazy_dynamic_symbols_lazy.syms
+
+if ! cmp -s lazy_dynamic_symbols_eager.syms lazy_dynamic_symbols_lazy.syms;
+then
+    echo "--lazy-dynamic-symbols changes the dynamic symbols:"
+    diff lazy_dynamic_symbols_eager.syms lazy_dynamic_symbols_lazy.syms
+    exit 1
+fi
+
+if ! ./lazy_dynamic_symbols_lazy; then
+    echo "lazy_dynamic_symbols_lazy failed"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# no_keep_memory_test.sh -- test --no-keep-memory
+
+# Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that freeing the data used to
+# relocate each object once it has been relocated does not change the
+# output, including the GOT entries and dynamic relocs which refer to
+# local symbols.  The second pair also frees the symbols data kept for
+# the second layout pass of --gc-sections and --icf.
+
+if ! cmp -s no_keep_memory_ref.so no_keep_memory.so; then
+    echo "--no-keep-memory changes the output"
+    exit 1
+fi
+
+if ! cmp -s no_keep_memory_gc_ref.so no_keep_memory_gc.so; then
+    echo "--no-keep-memory changes the output with --gc-sections --icf"
+    exit 1
+fi
+
+exit 0
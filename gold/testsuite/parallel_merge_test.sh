@@ -0,0 +1,48 @@
+#!/bin/sh
+
+# parallel_merge_test.sh -- test merging string sections in several threads
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that merging the 8-bit, 16-bit
+# and 32-bit string sections of two objects in several threads gives
+# the same output as merging them in one thread, with and without -O2.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"; then
+        echo "merging strings in several threads changes the output:"
+        echo "   $1 and $2 differ"
+        exit 1
+    fi
+}
+
+check_same parallel_merge_serial.so parallel_merge_threads.so
+check_same parallel_merge_serial_O2.so parallel_merge_threads_O2.so
+
+# The test is only useful if all three kinds of strings were merged.
+for s in "merged strings" "merged 16-bit strings" "merged 32-bit strings"; do
+    if ! grep -q "$s entries" parallel_merge_serial.so.stderr; then
+	echo "no $s in parallel_merge_serial.so"
+	exit 1
+    fi
+done
+
+exit 0
@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# parallel_sort_test.sh -- test sorting dynamic relocs in several threads
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that sorting the dynamic relocs
+# of a section with many relocs in several threads gives the same
+# output as sorting them in one thread.
+
+if ! cmp -s parallel_sort_serial.so parallel_sort_threads.so; then
+    echo "sorting the dynamic relocs in several threads changes the output"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# parallel_strtab_test.sh -- test sorting string tables in several threads
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that sorting the 120000 names
+# of .strtab and .dynstr in several threads to find shared suffixes
+# gives the same output as sorting them in one thread, with and
+# without -O2.  It also checks that -O2 shares the suffixes.
+
+check_same()
+{
+    if ! cmp -s "$1" "$2"; then
+        echo "sorting the string tables in several threads changes the output:"
+        echo "   $1 and $2 differ"
+        exit 1
+    fi
+}
+
+check_same parallel_strtab_serial.so parallel_strtab_threads.so
+check_same parallel_strtab_serial_O2.so parallel_strtab_threads_O2.so
+
+# Print the size of section $2 in the readelf -SW output $1.
+section_size()
+{
+    size=`sed -e 's/^ *\[ *[0-9]*\]//' "$1" \
+	  | awk -v name="$2" '$1 == name { print $5 }'`
+    if test -n "$size"; then
+	printf "%d\n" "0x$size"
+    fi
+}
+
+size=`section_size parallel_strtab.stdout .strtab`
+size_O2=`section_size parallel_strtab_O2.stdout .strtab`
+if test -z "$size" || test -z "$size_O2" || test "$size_O2" -ge "$size"; then
+    echo "-O2 did not share the suffixes of .strtab:"
+    echo "   size without -O2: $size, with -O2: $size_O2"
+    exit 1
+fi
+
+exit 0
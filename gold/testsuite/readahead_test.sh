@@ -0,0 +1,39 @@
+#!/bin/sh
+
+# readahead_test.sh -- test --readahead
+
+# Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that prefetching the input
+# files does not change the output file, and that --stats reports
+# that the reads of the relocation tasks were prefetched.
+
+if ! cmp -s readahead_off readahead_on; then
+    echo "--readahead changes the output"
+    exit 1
+fi
+
+if ! grep -q "readahead hits: [1-9][0-9]*; misses: " readahead_on.stderr; then
+    echo "--stats does not report any readahead hits:"
+    cat readahead_on.stderr
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,78 @@
+/* relr_test.c -- test -z pack-relative-relocs
+
+   Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   The pointers in TABLE are relocated by packed relative relocations.
+   Some are adjacent, some are a little more than a bitmap apart, and
+   some are far apart, so that the DT_RELR section needs both address
+   entries and bitmap entries.  */
+
+#include <stdio.h>
+
+static int data[200];
+
+static void
+fn (void)
+{
+}
+
+int *table[200] =
+{
+  &data[0], &data[1], &data[2], 0, &data[4], 0, 0, &data[7],
+  [62] = &data[62], [63] = &data[63], [64] = &data[64],
+  [126] = &data[126], [127] = &data[127],
+  [199] = &data[199]
+};
+
+void (*fnptr) (void) = fn;
+
+int *got_data (void) __attribute__ ((noinline));
+
+int *
+got_data (void)
+{
+  return &data[5];
+}
+
+int
+main (void)
+{
+  int i;
+
+  for (i = 0; i < 200; ++i)
+    if (table[i] != 0 && table[i] != &data[i])
+      {
+	fprintf (stderr, "table[%d] is %p, not %p\n", i, (void *) table[i],
+		 (void *) &data[i]);
+	return 1;
+      }
+  if (fnptr != fn)
+    {
+      fprintf (stderr, "fnptr is wrong\n");
+      return 1;
+    }
+  if (got_data () != &data[5])
+    {
+      fprintf (stderr, "got_data is wrong\n");
+      return 1;
+    }
+  printf ("PASS\n");
+  return 0;
+}
@@ -0,0 +1,60 @@
+#!/bin/sh
+
+# relr_test.sh -- test -z pack-relative-relocs
+
+# Copyright (C) 2010-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that -z pack-relative-relocs
+# moves the relative relocations into a DT_RELR section, and that the
+# program still runs.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_missing()
+{
+    if grep -q "$2" "$1"
+    then
+	echo "Found unexpected output:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check relr_test.stdout "(RELR) "
+check relr_test.stdout "(RELRSZ) "
+check relr_test.stdout "(RELRENT) *8 (bytes)"
+check_missing relr_test.stdout "R_X86_64_RELATIVE"
+check relr_test_run.stdout "^PASS$"
+
+exit 0
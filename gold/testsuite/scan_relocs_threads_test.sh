@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# scan_relocs_threads_test.sh -- test scanning relocs with threads
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that filtering the relocs of
+# several objects in parallel before they are scanned gives the same
+# GOT, PLT and dynamic relocs as scanning all of them in one thread.
+
+if ! cmp -s scan_relocs_serial.so scan_relocs_threads.so; then
+    echo "filtering relocs in several threads changes the output"
+    exit 1
+fi
+
+exit 0
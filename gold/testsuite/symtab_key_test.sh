@@ -0,0 +1,46 @@
+#!/bin/sh
+
+# symtab_key_test.sh -- test symbol resolution
+
+# Copyright (C) 2007-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that symbols are still
+# resolved correctly now that they are stored in blocks owned by the
+# symbol table, keyed by 32-bit Stringpool keys, and that their GOT
+# offsets are allocated when the first GOT entry is added.
+
+check()
+{
+    if ! grep -q "^$2\$" "$1"; then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check symtab_key_test.stdout "sk_get: 2"
+check symtab_key_test.stdout "sk_get@V1: 1"
+check symtab_key_test.stdout "sk_tls: 5 5"
+check symtab_key_test.stdout "sk_data: 4 1"
+
+exit 0
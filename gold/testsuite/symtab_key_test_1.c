@@ -0,0 +1,53 @@
+/* symtab_key_test_1.c -- test symbol resolution in gold.
+
+   Copyright (C) 2007-2024 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* The shared library of symtab_key_test.  It defines two versions of
+   sk_get, and uses the TLS variable sk_tls with the global dynamic
+   model, while symtab_key_test_2.c uses it with the initial exec
+   model, so that sk_tls has two kinds of GOT entries.  */
+
+int sk_get_v1 (void);
+int sk_get_v2 (void);
+int sk_tls_gd (void);
+
+__asm__ (".symver sk_get_v1,sk_get@V1");
+__asm__ (".symver sk_get_v2,sk_get@@V2");
+
+__thread int sk_tls = 3;
+int sk_data = 4;
+
+int
+sk_get_v1 (void)
+{
+  return 1;
+}
+
+int
+sk_get_v2 (void)
+{
+  return 2;
+}
+
+int
+sk_tls_gd (void)
+{
+  return sk_tls;
+}
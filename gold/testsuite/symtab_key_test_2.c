@@ -0,0 +1,41 @@
+/* symtab_key_test_2.c -- test symbol resolution in gold.
+
+   Copyright (C) 2007-2024 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* The initial exec accesses to sk_tls in the shared library of
+   symtab_key_test.  */
+
+extern __thread int sk_tls __attribute__ ((tls_model ("initial-exec")));
+extern int sk_data;
+
+int sk_tls_ie (void);
+int *sk_data_address (void);
+
+int
+sk_tls_ie (void)
+{
+  return sk_tls;
+}
+
+int *
+sk_data_address (void)
+{
+  return &sk_data;
+}
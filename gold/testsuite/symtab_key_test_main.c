@@ -0,0 +1,49 @@
+/* symtab_key_test_main.c -- test symbol resolution in gold.
+
+   Copyright (C) 2007-2024 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* Check that each reference to the shared library of symtab_key_test
+   resolves to the right definition: the default and the non-default
+   version of sk_get, and the TLS and data symbols which are reached
+   through several GOT entries.  */
+
+#include <stdio.h>
+
+extern int sk_get (void);
+extern int sk_get_old (void);
+extern int sk_tls_gd (void);
+extern int sk_tls_ie (void);
+extern int *sk_data_address (void);
+extern __thread int sk_tls;
+extern int sk_data;
+
+__asm__ (".symver sk_get_old,sk_get@V1");
+
+int
+main (void)
+{
+  printf ("sk_get: %d\n", sk_get ());
+  printf ("sk_get@V1: %d\n", sk_get_old ());
+  sk_tls = 5;
+  printf ("sk_tls: %d %d\n", sk_tls_gd (), sk_tls_ie ());
+  printf ("sk_data: %d %d\n", *sk_data_address (),
+	  sk_data_address () == &sk_data);
+  return 0;
+}
@@ -0,0 +1,25 @@
+	.text
+	.type	lf, @function
+lf:
+	ret
+	.size	lf, .-lf
+	.type	f, @function
+f:
+	call	lf
+	call	*lf@GOTPCREL(%rip)
+	movq	lv1@GOTPCREL(%rip), %rax
+	addq	lv2@GOTPCREL(%rip), %rax
+	movabsq	$lv3@GOT, %rcx
+	movabsq	$lv1@GOTOFF, %rdx
+	leaq	_GLOBAL_OFFSET_TABLE_(%rip), %rdx
+	ret
+	.size	f, .-f
+	.data
+	.align 8
+lv1:
+	.quad	lf
+lv2:
+	.quad	lv1
+lv3:
+	.quad	0
+	.section	.note.GNU-stack,"",@progbits
@@ -0,0 +1,52 @@
+#!/bin/sh
+
+# x86_64_scan_relocs_threads.sh -- test scanning relocs against local
+# symbols with threads
+
+# Copyright (C) 2009-2024 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The goal of this program is to verify that the requests made in
+# several threads for the relocs against local symbols give the same
+# GOT and dynamic relocs as scanning the relocs in one thread.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+if ! cmp -s x86_64_scan_relocs_serial.so x86_64_scan_relocs_threads.so; then
+    echo "scanning relocs in several threads changes the output"
+    exit 1
+fi
+
+# Each of the two objects needs three GOT entries and two words in
+# .data, each with an R_X86_64_RELATIVE reloc.
+check x86_64_scan_relocs_threads.stdout \
+  "Relocation section '.rela.dyn' at offset 0x[0-9a-f]* contains 10 entries"
+
+exit 0
@@ -306,6 +306,7 @@ Workqueue::find_and_run_task(int thread_number)
 
     ++this->running_;
   }
+  Parallel_run::adjust_busy_threads(1);
 
   while (t != NULL)
     {
@@ -360,6 +361,7 @@ Workqueue::find_and_run_task(int thread_number)
 
       t = next;
     }
+  Parallel_run::adjust_busy_threads(-1);
 
   return true;
 }
@@ -631,6 +631,31 @@ class Target_x86_64 : public Sized_target<size, false>
 	      size_t local_symbol_count,
 	      const unsigned char* plocal_symbols);
 
+  // Decide what to do with the relocations before they are scanned.
+  bool
+  prescan_relocs(Sized_relobj_file<size, false>* object,
+		 unsigned int data_shndx,
+		 unsigned int sh_type,
+		 const unsigned char* prelocs,
+		 size_t reloc_count,
+		 size_t local_symbol_count,
+		 const unsigned char* plocal_symbols,
+		 std::vector<Reloc_request>* scan_requests);
+
+  // Carry out the requests made by prescan_relocs.
+  void
+  scan_reloc_requests(Symbol_table* symtab,
+		      Layout* layout,
+		      Sized_relobj_file<size, false>* object,
+		      unsigned int data_shndx,
+		      unsigned int sh_type,
+		      const unsigned char* prelocs,
+		      const std::vector<Reloc_request>& scan_requests,
+		      Output_section* output_section,
+		      bool needs_special_offset_handling,
+		      size_t local_symbol_count,
+		      const unsigned char* plocal_symbols);
+
   // Finalize the sections.
   void
   do_finalize_sections(Layout*, const Input_objects*, Symbol_table*);
@@ -730,6 +755,12 @@ class Target_x86_64 : public Sized_target<size, false>
   do_plt_address_for_local(const Relobj* relobj, unsigned int symndx) const
   { return this->plt_section()->address_for_local(relobj, symndx); }
 
+  // Relocating a section only reads the target state, so the sections
+  // of a large object may be relocated by several threads.
+  bool
+  do_relocate_sections_in_parallel() const
+  { return true; }
+
   // This function should be defined in targets that can use relocation
   // types to determine (implemented in local_reloc_may_be_function_pointer
   // and global_reloc_may_be_function_pointer)
@@ -883,6 +914,28 @@ class Target_x86_64 : public Sized_target<size, false>
     static inline int
     get_reference_flags(unsigned int r_type);
 
+    // The kinds of Reloc_request made by prescan_local.
+    enum
+    {
+      // Add a relative dynamic reloc for an absolute reloc.
+      LOCAL_RELATIVE_REQUEST = Reloc_request::FIRST_TARGET_KIND,
+      // Create the GOT section, but no GOT entry.
+      GOT_SECTION_REQUEST,
+      // Create a GOT entry for the local symbol.
+      LOCAL_GOT_REQUEST
+    };
+
+    // Set *KIND to the kind of request to make for a reloc of type
+    // R_TYPE against LSYM, or return false if local() does nothing
+    // for it.  This is used by prescan_relocs, so it must not change
+    // any shared state.
+    static inline bool
+    prescan_local(Sized_relobj_file<size, false>* object,
+		  unsigned int data_shndx,
+		  const elfcpp::Rela<size, false>& reloc, unsigned int r_type,
+		  const elfcpp::Sym<size, false>& lsym,
+		  unsigned int* kind);
+
     inline void
     local(Symbol_table* symtab, Layout* layout, Target_x86_64* target,
 	  Sized_relobj_file<size, false>* object,
@@ -892,6 +945,17 @@ class Target_x86_64 : public Sized_target<size, false>
 	  const elfcpp::Sym<size, false>& lsym,
 	  bool is_discarded);
 
+    // Carry out a request made by prescan_local.
+    inline void
+    local_request(Symbol_table* symtab, Layout* layout,
+		  Target_x86_64* target,
+		  Sized_relobj_file<size, false>* object,
+		  unsigned int data_shndx,
+		  Output_section* output_section,
+		  const elfcpp::Rela<size, false>& reloc, unsigned int r_type,
+		  const elfcpp::Sym<size, false>& lsym,
+		  unsigned int kind);
+
     inline void
     global(Symbol_table* symtab, Layout* layout, Target_x86_64* target,
 	   Sized_relobj_file<size, false>* object,
@@ -932,6 +996,24 @@ class Target_x86_64 : public Sized_target<size, false>
     void
     check_non_pic(Relobj*, unsigned int r_type, Symbol*);
 
+    // Return whether a GOT reloc against a local symbol which is not
+    // an IFUNC symbol will be converted so that it needs no GOT entry.
+    static inline bool
+    local_got_can_be_converted(Sized_relobj_file<size, false>* object,
+			       unsigned int data_shndx,
+			       const elfcpp::Rela<size, false>& reloc,
+			       unsigned int r_type);
+
+    // Create a GOT entry for a local symbol, with its dynamic reloc.
+    inline void
+    local_got_entry(Layout* layout, Target_x86_64* target,
+		    Sized_relobj_file<size, false>* object,
+		    Output_data_got<64, false>* got,
+		    const elfcpp::Rela<size, false>& reloc,
+		    unsigned int r_type,
+		    const elfcpp::Sym<size, false>& lsym,
+		    bool is_ifunc);
+
     inline bool
     possible_function_pointer_reloc(Sized_relobj_file<size, false>* src_obj,
                                     unsigned int src_indx,
@@ -1447,6 +1529,14 @@ Target_x86_64<size>::rela_dyn_section(Layout* layout)
       layout->add_output_section_data(".rela.dyn", elfcpp::SHT_RELA,
 				      elfcpp::SHF_ALLOC, this->rela_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<elfcpp::SHT_RELA, size, false>* relr =
+	    new Output_data_relr<elfcpp::SHT_RELA, size, false>(
+		elfcpp::R_X86_64_RELATIVE, layout, this->rela_dyn_);
+	  this->rela_dyn_->set_relr_section(relr);
+	}
     }
   return this->rela_dyn_;
 }
@@ -3142,6 +3232,116 @@ Target_x86_64<size>::Scan::reloc_needs_plt_for_ifunc(
   return flags != 0;
 }
 
+// Return whether a GOT reloc of type R_TYPE against a local symbol
+// which is not an IFUNC symbol will be converted by
+// Relocate::relocate so that it needs no GOT entry.  That is done
+// for
+//   mov foo@GOTPCREL(%rip), %reg
+// which becomes
+//   lea foo(%rip), %reg
+
+template<int size>
+inline bool
+Target_x86_64<size>::Scan::local_got_can_be_converted(
+    Sized_relobj_file<size, false>* object,
+    unsigned int data_shndx,
+    const elfcpp::Rela<size, false>& reloc,
+    unsigned int r_type)
+{
+  size_t r_offset = reloc.get_r_offset();
+  if (parameters->incremental()
+      || !(((r_type == elfcpp::R_X86_64_GOTPCREL
+	     || r_type == elfcpp::R_X86_64_GOTPCRELX
+	     || r_type == elfcpp::R_X86_64_REX_GOTPCRELX)
+	    && r_offset >= 2)
+	   || (r_type == elfcpp::R_X86_64_CODE_4_GOTPCRELX
+	       && r_offset >= 4))
+      || reloc.get_r_addend() != -4)
+    return false;
+
+  section_size_type stype;
+  const unsigned char* view = object->section_contents(data_shndx,
+						       &stype, true);
+  if (r_type == elfcpp::R_X86_64_CODE_4_GOTPCRELX
+      && view[r_offset - 4] != 0xd5)
+    return false;
+
+  return view[r_offset - 2] == 0x8b;
+}
+
+// Set *KIND to the kind of Reloc_request to make for a reloc of type
+// R_TYPE against the local symbol LSYM, or return false if
+// Scan::local does nothing for the reloc.  Relocs against a local
+// STT_GNU_IFUNC symbol, which may need a PLT entry whatever the reloc,
+// and relocs which are not common enough to be worth a request of
+// their own, are simply scanned.
+
+template<int size>
+inline bool
+Target_x86_64<size>::Scan::prescan_local(
+    Sized_relobj_file<size, false>* object,
+    unsigned int data_shndx,
+    const elfcpp::Rela<size, false>& reloc,
+    unsigned int r_type,
+    const elfcpp::Sym<size, false>& lsym,
+    unsigned int* kind)
+{
+  *kind = Reloc_request::SCAN;
+
+  if (lsym.get_st_type() == elfcpp::STT_GNU_IFUNC)
+    return true;
+
+  switch (r_type)
+    {
+    case elfcpp::R_X86_64_NONE:
+    case elfcpp::R_X86_64_GNU_VTINHERIT:
+    case elfcpp::R_X86_64_GNU_VTENTRY:
+    case elfcpp::R_X86_64_PC64:
+    case elfcpp::R_X86_64_PC32:
+    case elfcpp::R_X86_64_PC16:
+    case elfcpp::R_X86_64_PC8:
+    case elfcpp::R_X86_64_PLT32:
+      return false;
+
+    case elfcpp::R_X86_64_64:
+      if (!parameters->options().output_is_position_independent())
+	return false;
+      *kind = LOCAL_RELATIVE_REQUEST;
+      return true;
+
+    case elfcpp::R_X86_64_32:
+    case elfcpp::R_X86_64_32S:
+    case elfcpp::R_X86_64_16:
+    case elfcpp::R_X86_64_8:
+      // These only need a dynamic relocation.
+      return parameters->options().output_is_position_independent();
+
+    case elfcpp::R_X86_64_GOTPC32:
+    case elfcpp::R_X86_64_GOTOFF64:
+    case elfcpp::R_X86_64_GOTPC64:
+    case elfcpp::R_X86_64_PLTOFF64:
+      *kind = GOT_SECTION_REQUEST;
+      return true;
+
+    case elfcpp::R_X86_64_GOT64:
+    case elfcpp::R_X86_64_GOT32:
+    case elfcpp::R_X86_64_GOTPCREL64:
+    case elfcpp::R_X86_64_GOTPCREL:
+    case elfcpp::R_X86_64_GOTPCRELX:
+    case elfcpp::R_X86_64_REX_GOTPCRELX:
+    case elfcpp::R_X86_64_CODE_4_GOTPCRELX:
+    case elfcpp::R_X86_64_GOTPLT64:
+      if (local_got_can_be_converted(object, data_shndx, reloc, r_type))
+	*kind = GOT_SECTION_REQUEST;
+      else
+	*kind = LOCAL_GOT_REQUEST;
+      return true;
+
+    default:
+      return true;
+    }
+}
+
 // Scan a relocation for a local symbol.
 
 template<int size>
@@ -3286,68 +3486,15 @@ Target_x86_64<size>::Scan::local(Symbol_table* symtab,
 	// mov foo@GOTPCREL(%rip), %reg
 	// to lea foo(%rip), %reg.
 	// in Relocate::relocate.
-	size_t r_offset = reloc.get_r_offset();
-	if (!parameters->incremental()
-	    && (((r_type == elfcpp::R_X86_64_GOTPCREL
-		  || r_type == elfcpp::R_X86_64_GOTPCRELX
-		  || r_type == elfcpp::R_X86_64_REX_GOTPCRELX)
-		 && r_offset >= 2)
-		|| (r_type == elfcpp::R_X86_64_CODE_4_GOTPCRELX
-		    && r_offset >= 4))
-	    && reloc.get_r_addend() == -4
-	    && !is_ifunc)
-	  {
-	    section_size_type stype;
-	    const unsigned char* view = object->section_contents(data_shndx,
-								 &stype, true);
-	    if (r_type == elfcpp::R_X86_64_CODE_4_GOTPCRELX
-		&& view[r_offset - 4] != 0xd5)
-	      goto need_got;
-
-	    if (view[r_offset - 2] == 0x8b)
-	      break;
-	  }
-
-need_got:
+	if (!is_ifunc
+	    && this->local_got_can_be_converted(object, data_shndx, reloc,
+						r_type))
+	  break;
 
 	// The symbol requires a GOT entry.
-	unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
+	this->local_got_entry(layout, target, object, got, reloc, r_type,
+			      lsym, is_ifunc);
 
-	// For a STT_GNU_IFUNC symbol we want the PLT offset.  That
-	// lets function pointers compare correctly with shared
-	// libraries.  Otherwise we would need an IRELATIVE reloc.
-	bool is_new;
-	if (is_ifunc)
-	  is_new = got->add_local_plt(object, r_sym, GOT_TYPE_STANDARD);
-	else
-	  is_new = got->add_local(object, r_sym, GOT_TYPE_STANDARD);
-	if (is_new)
-	  {
-	    // If we are generating a shared object, we need to add a
-	    // dynamic relocation for this symbol's GOT entry.
-	    if (parameters->options().output_is_position_independent())
-	      {
-		Reloc_section* rela_dyn = target->rela_dyn_section(layout);
-		// R_X86_64_RELATIVE assumes a 64-bit relocation.
-		if (r_type != elfcpp::R_X86_64_GOT32)
-		  {
-		    unsigned int got_offset =
-		      object->local_got_offset(r_sym, GOT_TYPE_STANDARD);
-		    rela_dyn->add_local_relative(object, r_sym,
-						 elfcpp::R_X86_64_RELATIVE,
-						 got, got_offset, 0, is_ifunc);
-		  }
-		else
-		  {
-		    this->check_non_pic(object, r_type, NULL);
-
-		    gold_assert(lsym.get_st_type() != elfcpp::STT_SECTION);
-		    rela_dyn->add_local(
-			object, r_sym, r_type, got,
-			object->local_got_offset(r_sym, GOT_TYPE_STANDARD), 0);
-		  }
-	      }
-	  }
 	// For GOTPLT64, we'd normally want a PLT section, but since
 	// we know this is a local symbol, no PLT is needed.
       }
@@ -3509,6 +3656,106 @@ need_got:
     }
 }
 
+// Create a GOT entry for the local symbol of RELOC.  If we are
+// generating a shared object, this also adds a dynamic relocation for
+// the GOT entry.
+
+template<int size>
+inline void
+Target_x86_64<size>::Scan::local_got_entry(
+    Layout* layout,
+    Target_x86_64<size>* target,
+    Sized_relobj_file<size, false>* object,
+    Output_data_got<64, false>* got,
+    const elfcpp::Rela<size, false>& reloc,
+    unsigned int r_type,
+    const elfcpp::Sym<size, false>& lsym,
+    bool is_ifunc)
+{
+  unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
+
+  // For a STT_GNU_IFUNC symbol we want the PLT offset.  That
+  // lets function pointers compare correctly with shared
+  // libraries.  Otherwise we would need an IRELATIVE reloc.
+  bool is_new;
+  if (is_ifunc)
+    is_new = got->add_local_plt(object, r_sym, GOT_TYPE_STANDARD);
+  else
+    is_new = got->add_local(object, r_sym, GOT_TYPE_STANDARD);
+  if (!is_new || !parameters->options().output_is_position_independent())
+    return;
+
+  Reloc_section* rela_dyn = target->rela_dyn_section(layout);
+  // R_X86_64_RELATIVE assumes a 64-bit relocation.
+  if (r_type != elfcpp::R_X86_64_GOT32)
+    {
+      unsigned int got_offset =
+	object->local_got_offset(r_sym, GOT_TYPE_STANDARD);
+      rela_dyn->add_local_relative(object, r_sym,
+				   elfcpp::R_X86_64_RELATIVE,
+				   got, got_offset, 0, is_ifunc);
+    }
+  else
+    {
+      this->check_non_pic(object, r_type, NULL);
+
+      gold_assert(lsym.get_st_type() != elfcpp::STT_SECTION);
+      rela_dyn->add_local(object, r_sym, r_type, got,
+			  object->local_got_offset(r_sym, GOT_TYPE_STANDARD),
+			  0);
+    }
+}
+
+// Carry out a request made by prescan_local for a reloc against a
+// local symbol.  This does what Scan::local would do for the reloc,
+// without deciding again what that is.
+
+template<int size>
+inline void
+Target_x86_64<size>::Scan::local_request(Symbol_table* symtab,
+					 Layout* layout,
+					 Target_x86_64<size>* target,
+					 Sized_relobj_file<size, false>* object,
+					 unsigned int data_shndx,
+					 Output_section* output_section,
+					 const elfcpp::Rela<size, false>& reloc,
+					 unsigned int r_type,
+					 const elfcpp::Sym<size, false>& lsym,
+					 unsigned int kind)
+{
+  switch (kind)
+    {
+    case LOCAL_RELATIVE_REQUEST:
+      {
+	unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
+	Reloc_section* rela_dyn = target->rela_dyn_section(layout);
+	rela_dyn->add_local_relative(object, r_sym,
+				     (size == 32
+				      ? elfcpp::R_X86_64_RELATIVE64
+				      : elfcpp::R_X86_64_RELATIVE),
+				     output_section, data_shndx,
+				     reloc.get_r_offset(),
+				     reloc.get_r_addend(), false);
+      }
+      break;
+
+    case GOT_SECTION_REQUEST:
+      target->got_section(symtab, layout);
+      break;
+
+    case LOCAL_GOT_REQUEST:
+      {
+	Output_data_got<64, false>* got = target->got_section(symtab, layout);
+	this->local_got_entry(layout, target, object, got, reloc, r_type,
+			      lsym, false);
+      }
+      break;
+
+    default:
+      gold_unreachable();
+    }
+}
+
 
 // Report an unsupported relocation against a global symbol.
 
@@ -4131,6 +4378,75 @@ Target_x86_64<size>::scan_relocs(Symbol_table* symtab,
     plocal_symbols);
 }
 
+// Decide what to do with the relocations for a section before they
+// are scanned.
+
+template<int size>
+bool
+Target_x86_64<size>::prescan_relocs(Sized_relobj_file<size, false>* object,
+				    unsigned int data_shndx,
+				    unsigned int sh_type,
+				    const unsigned char* prelocs,
+				    size_t reloc_count,
+				    size_t local_symbol_count,
+				    const unsigned char* plocal_symbols,
+				    std::vector<Reloc_request>* scan_requests)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, false>
+      Classify_reloc;
+
+  // Leave the error for scan_relocs.
+  if (sh_type == elfcpp::SHT_REL)
+    return false;
+
+  gold::prescan_relocs<size, false, Scan, Classify_reloc>(
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    local_symbol_count,
+    plocal_symbols,
+    scan_requests);
+  return true;
+}
+
+// Carry out the requests made by prescan_relocs.
+
+template<int size>
+void
+Target_x86_64<size>::scan_reloc_requests(
+    Symbol_table* symtab,
+    Layout* layout,
+    Sized_relobj_file<size, false>* object,
+    unsigned int data_shndx,
+    unsigned int sh_type,
+    const unsigned char* prelocs,
+    const std::vector<Reloc_request>& scan_requests,
+    Output_section* output_section,
+    bool needs_special_offset_handling,
+    size_t local_symbol_count,
+    const unsigned char* plocal_symbols)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, false>
+      Classify_reloc;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::scan_reloc_requests<size, false, Target_x86_64<size>, Scan,
+			    Classify_reloc>(
+    symtab,
+    layout,
+    this,
+    object,
+    data_shndx,
+    prelocs,
+    scan_requests,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols);
+}
+
 // Finalize the sections.
 
 template<int size>